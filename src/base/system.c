@@ -2123,6 +2123,22 @@ int fs_storage_path(const char *appname, char *path, int max)
 #endif
 }
 
+int fs_executable_path(char *path, int max)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	DWORD size = GetModuleFileNameA(NULL, path, max);
+	return size > 0 && size < (DWORD)max ? 0 : -1;
+#elif defined(CONF_PLATFORM_LINUX)
+	ssize_t size = readlink("/proc/self/exe", path, max - 1);
+	if(size < 0)
+		return -1;
+	path[size] = 0;
+	return 0;
+#else
+	return -1;
+#endif
+}
+
 int fs_makedir_rec_for(const char *path)
 {
 	char buffer[1024 * 2];
@@ -3514,6 +3530,63 @@ PROCESS shell_execute(const char *file)
 #endif
 }
 
+PROCESS shell_execute_args(const char *file, const char **arguments, int num_arguments)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	SHELLEXECUTEINFOA info;
+	char *parameters;
+	char *dst;
+	int size = 1;
+	int i;
+	for(i = 0; i < num_arguments; i++)
+		size += 2 * str_length(arguments[i]) + 3;
+	parameters = (char *)malloc(size);
+	parameters[0] = 0;
+	for(i = 0; i < num_arguments; i++)
+	{
+		if(i > 0)
+			str_append(parameters, " ", size);
+		str_append(parameters, "\"", size);
+		dst = parameters + str_length(parameters);
+		str_escape(&dst, arguments[i], parameters + size);
+		str_append(parameters, "\"", size);
+	}
+
+	mem_zero(&info, sizeof(SHELLEXECUTEINFOA));
+	info.cbSize = sizeof(SHELLEXECUTEINFOA);
+	info.lpVerb = "open";
+	info.lpFile = file;
+	info.lpParameters = parameters;
+	info.nShow = SW_SHOWMINNOACTIVE;
+	info.fMask = SEE_MASK_NOCLOSEPROCESS;
+	ShellExecuteEx(&info);
+	free(parameters);
+	return info.hProcess;
+#elif defined(CONF_FAMILY_UNIX)
+	char **argv;
+	pid_t pid;
+	int i;
+	argv = (char **)malloc((num_arguments + 2) * sizeof(*argv));
+	argv[0] = (char *)file;
+	for(i = 0; i < num_arguments; i++)
+		argv[i + 1] = (char *)arguments[i];
+	argv[num_arguments + 1] = NULL;
+	pid = fork();
+	if(pid == -1)
+	{
+		free(argv);
+		return 0;
+	}
+	if(pid == 0)
+	{
+		execv(file, argv);
+		_exit(1);
+	}
+	free(argv);
+	return pid;
+#endif
+}
+
 int kill_process(PROCESS process)
 {
 #if defined(CONF_FAMILY_WINDOWS)
@@ -3525,6 +3598,17 @@ int kill_process(PROCESS process)
 #endif
 }
 
+int is_process_alive(PROCESS process)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	DWORD exit_code;
+	return GetExitCodeProcess(process, &exit_code) && exit_code == STILL_ACTIVE;
+#elif defined(CONF_FAMILY_UNIX)
+	int status;
+	return waitpid(process, &status, WNOHANG) == 0;
+#endif
+}
+
 int open_link(const char *link)
 {
 	char aBuf[512];
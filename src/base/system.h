@@ -904,7 +904,8 @@ NETSOCKET net_udp_create(NETADDR bindaddr);
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size);
 
 #define VLEN 128
-#define PACKETSIZE 1400
+/* leaves room for the header of tunnelled game packets */
+#define PACKETSIZE 1500
 typedef struct
 {
 #ifdef CONF_PLATFORM_LINUX
@@ -1768,6 +1769,18 @@ int fs_makedir_rec_for(const char *path);
 */
 int fs_storage_path(const char *appname, char *path, int max);
 
+/*
+	Function: fs_executable_path
+		Fetches the absolute path of the running executable.
+
+	Returns:
+		Returns 0 on success. Negative value on failure.
+
+	Remarks:
+		- Only supported on Linux and Windows
+*/
+int fs_executable_path(char *path, int max);
+
 /*
 	Function: fs_is_dir
 		Checks if directory exists
@@ -2271,6 +2284,20 @@ typedef pid_t PROCESS;
 */
 PROCESS shell_execute(const char *file);
 
+/*
+	Function: shell_execute_args
+		Executes a given file with arguments.
+
+	Parameters:
+		file - the file to execute
+		arguments - the arguments, without the file itself
+		num_arguments - the number of arguments
+
+	Returns:
+		handle/pid of the new process, 0 on error
+*/
+PROCESS shell_execute_args(const char *file, const char **arguments, int num_arguments);
+
 /*
 	Function: kill_process
 		Sends kill signal to a process.
@@ -2284,6 +2311,22 @@ PROCESS shell_execute(const char *file);
 */
 int kill_process(PROCESS process);
 
+/*
+	Function: is_process_alive
+		Checks whether a process started with <shell_execute_args> still runs.
+
+	Parameters:
+		process - handle/pid of the process
+
+	Returns:
+		0 - The process exited
+		1 - The process is running
+
+	Remarks:
+		- On UNIX the exited process is reaped, don't <kill_process> it afterwards
+*/
+int is_process_alive(PROCESS process);
+
 /*
 	Function: os_is_winxp_or_lower
 		Checks whether the program runs on Windows XP or lower.
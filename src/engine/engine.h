@@ -32,6 +32,9 @@ public:
 	virtual void Init() = 0;
 	virtual void InitLogfile() = 0;
 	virtual void AddJob(std::shared_ptr<IJob> pJob) = 0;
+	int NumQueuedJobs() const { return m_JobPool.NumQueued(); }
+	void SetNumJobThreads(int NumThreads) { m_JobPool.SetNumThreads(NumThreads); }
+	void GetJobStats(CJobPool::CStats *pStats) const { m_JobPool.GetStats(pStats); }
 	static void RunJobBlocking(IJob *pJob);
 };
 
@@ -115,7 +115,7 @@ public:
 		{
 			str_format(msgbuf, sizeof(msgbuf), "%s: %s", ClientName(pMsg->m_ClientID), pMsg->m_pMessage);
 			pMsg->m_pMessage = msgbuf;
-			pMsg->m_ClientID = VANILLA_MAX_CLIENTS - 1;
+			pMsg->m_ClientID = IdMapSize(ClientID) - 1;
 		}
 
 		if(IsSixup(ClientID))
@@ -151,17 +151,34 @@ public:
 		return SendMsg(&Packer, Flags, ClientID);
 	}
 
-	bool Translate(int &Target, int Client)
+	enum
+	{
+		// the id map of a client has room for this many ids
+		MAX_ID_MAP = MAX_CLIENTS > DDNET_MAX_CLIENTS ? DDNET_MAX_CLIENTS : VANILLA_MAX_CLIENTS,
+	};
+
+	// the number of ids the client knows, ids are mapped into these if there
+	// are more clients
+	int IdMapSize(int Client)
 	{
+		int MaxClients = MAX_CLIENTS > DDNET_MAX_CLIENTS ? DDNET_MAX_CLIENTS : MAX_CLIENTS;
 		if(IsSixup(Client))
-			return true;
+			return MaxClients;
 		CClientInfo Info;
 		GetClientInfo(Client, &Info);
 		if(Info.m_DDNetVersion >= VERSION_DDNET_OLD)
+			return MaxClients;
+		return VANILLA_MAX_CLIENTS;
+	}
+
+	bool Translate(int &Target, int Client)
+	{
+		int MapSize = IdMapSize(Client);
+		if(MapSize == MAX_CLIENTS)
 			return true;
 		int *pMap = GetIdMap(Client);
 		bool Found = false;
-		for(int i = 0; i < VANILLA_MAX_CLIENTS; i++)
+		for(int i = 0; i < MapSize; i++)
 		{
 			if(Target == pMap[i])
 			{
@@ -175,13 +192,10 @@ public:
 
 	bool ReverseTranslate(int &Target, int Client)
 	{
-		if(IsSixup(Client))
-			return true;
-		CClientInfo Info;
-		GetClientInfo(Client, &Info);
-		if(Info.m_DDNetVersion >= VERSION_DDNET_OLD)
+		int MapSize = IdMapSize(Client);
+		if(MapSize == MAX_CLIENTS)
 			return true;
-		Target = clamp(Target, 0, VANILLA_MAX_CLIENTS - 1);
+		Target = clamp(Target, 0, MapSize - 1);
 		int *pMap = GetIdMap(Client);
 		if(pMap[Target] == -1)
 			return false;
@@ -200,7 +214,9 @@ public:
 
 	virtual int SnapNewID() = 0;
 	virtual void SnapFreeID(int ID) = 0;
-	virtual void *SnapNewItem(int Type, int ID, int Size) = 0;
+	// UnchangedSince is the tick since which the item has been the same in
+	// every snapshot of the snapping client, lets the delta skip comparing it
+	virtual void *SnapNewItem(int Type, int ID, int Size, int UnchangedSince = -1) = 0;
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
@@ -243,6 +259,10 @@ public:
 
 	virtual void SetErrorShutdown(const char *pReason) = 0;
 	virtual void ExpireServerInfo() = 0;
+	// clears the bandwidth accounting of a destroyed room
+	virtual void ResetRoomBandwidth(int Room) = 0;
+
+	virtual class CMetrics *Metrics() = 0;
 
 	virtual void SendMsgRaw(int ClientID, const void *pData, int Size, int Flags) = 0;
 
@@ -261,6 +281,17 @@ public:
 	virtual int GetAxiomId(int ClientID) = 0;
 };
 
+// game specific part of a client entry in the master server info
+struct CServerInfoPlayer
+{
+	char m_aSkinName[64];
+	bool m_UseCustomColor;
+	int m_ColorBody;
+	int m_ColorFeet;
+	bool m_Afk;
+	int m_Team;
+};
+
 class IGameServer : public IInterface
 {
 	MACRO_INTERFACE("gameserver", 0)
@@ -326,8 +357,10 @@ public:
 
 	// PvP
 	virtual bool CheckDisruptiveLeave(int ClientID) = 0;
+	virtual int GetDDRaceTeam(int ClientID) = 0;
 
-	virtual void OnUpdatePlayerServerInfo(class CJsonStringWriter *pJSonWriter, int Id) = 0;
+	// returns false if the client has no game specific info
+	virtual bool OnUpdatePlayerServerInfo(CServerInfoPlayer *pInfo, int Id) = 0;
 };
 
 extern IGameServer *CreateGameServer();
@@ -0,0 +1,221 @@
+#include "bandwidth.h"
+
+#include <engine/console.h>
+#include <engine/storage.h>
+
+#include <game/generated/protocol.h>
+
+#include <algorithm>
+
+void CBandwidthCounters::Reset()
+{
+	mem_zero(m_aSnapItemBytes, sizeof(m_aSnapItemBytes));
+	mem_zero(m_aDeltaItemBytes, sizeof(m_aDeltaItemBytes));
+	mem_zero(m_aSysMsgBytes, sizeof(m_aSysMsgBytes));
+	mem_zero(m_aGameMsgBytes, sizeof(m_aGameMsgBytes));
+}
+
+void CBandwidthCounters::Add(const CBandwidthCounters &Other)
+{
+	for(int i = 0; i < NUM_SNAP_TYPES; i++)
+	{
+		m_aSnapItemBytes[i] += Other.m_aSnapItemBytes[i];
+		m_aDeltaItemBytes[i] += Other.m_aDeltaItemBytes[i];
+	}
+	for(int i = 0; i < NUM_MSG_TYPES; i++)
+	{
+		m_aSysMsgBytes[i] += Other.m_aSysMsgBytes[i];
+		m_aGameMsgBytes[i] += Other.m_aGameMsgBytes[i];
+	}
+}
+
+void CBandwidthCounters::AddMsg(bool System, int MsgID, int Bytes)
+{
+	int Index = (MsgID >= 0 && MsgID < NUM_MSG_TYPES - 1) ? MsgID : NUM_MSG_TYPES - 1;
+	if(System)
+		m_aSysMsgBytes[Index] += Bytes;
+	else
+		m_aGameMsgBytes[Index] += Bytes;
+}
+
+int64 CBandwidthCounters::SnapTotal() const
+{
+	int64 Total = 0;
+	for(int64 Bytes : m_aSnapItemBytes)
+		Total += Bytes;
+	return Total;
+}
+
+int64 CBandwidthCounters::DeltaTotal() const
+{
+	int64 Total = 0;
+	for(int64 Bytes : m_aDeltaItemBytes)
+		Total += Bytes;
+	return Total;
+}
+
+int64 CBandwidthCounters::MsgTotal() const
+{
+	int64 Total = 0;
+	for(int i = 0; i < NUM_MSG_TYPES; i++)
+		Total += m_aSysMsgBytes[i] + m_aGameMsgBytes[i];
+	return Total;
+}
+
+static const char *SnapTypeName(int Index)
+{
+	static CNetObjHandler s_NetObjHandler;
+	if(Index < CSnapshot::STATS_NUM_NETOBJ_TYPES)
+		return s_NetObjHandler.GetObjName(Index);
+	if(Index < CSnapshot::STATS_OTHER)
+		return "(extended)";
+	return "(other)";
+}
+
+static const char *GameMsgName(int Index)
+{
+	static CNetObjHandler s_NetObjHandler;
+	if(Index == CBandwidthCounters::NUM_MSG_TYPES - 1)
+		return "(other)";
+	return s_NetObjHandler.GetMsgName(Index);
+}
+
+CBandwidthStats::CBandwidthStats()
+{
+	Reset();
+}
+
+void CBandwidthStats::Reset()
+{
+	m_Global.Reset();
+	for(auto &Counters : m_aClients)
+		Counters.Reset();
+	for(auto &Counters : m_aRooms)
+		Counters.Reset();
+	m_Current.Reset();
+	m_StartTime = time_get();
+	m_LastDump = m_StartTime;
+}
+
+void CBandwidthStats::CommitSnap(int ClientID, int Room)
+{
+	m_aClients[ClientID].Add(m_Current);
+	if(Room >= 0 && Room < MAX_CLIENTS)
+		m_aRooms[Room].Add(m_Current);
+	m_Global.Add(m_Current);
+	m_Current.Reset();
+}
+
+void CBandwidthStats::OnSendMsg(int ClientID, int Room, bool System, int MsgID, int Bytes)
+{
+	m_aClients[ClientID].AddMsg(System, MsgID, Bytes);
+	if(Room >= 0 && Room < MAX_CLIENTS)
+		m_aRooms[Room].AddMsg(System, MsgID, Bytes);
+	m_Global.AddMsg(System, MsgID, Bytes);
+}
+
+void CBandwidthStats::PrintCounters(IConsole *pConsole, const char *pScope, const CBandwidthCounters &Counters) const
+{
+	char aBuf[256];
+	const int64 Seconds = maximum((int64)1, (time_get() - m_StartTime) / time_freq());
+	str_format(aBuf, sizeof(aBuf), "%s: %lld seconds, snap items=%lld delta=%lld messages=%lld bytes",
+		pScope, Seconds, Counters.SnapTotal(), Counters.DeltaTotal(), Counters.MsgTotal());
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", aBuf);
+
+	// snapshot item types, biggest delta share first
+	int aOrder[CBandwidthCounters::NUM_SNAP_TYPES];
+	for(int i = 0; i < CBandwidthCounters::NUM_SNAP_TYPES; i++)
+		aOrder[i] = i;
+	std::sort(aOrder, aOrder + CBandwidthCounters::NUM_SNAP_TYPES, [&](int a, int b) {
+		return Counters.m_aDeltaItemBytes[a] > Counters.m_aDeltaItemBytes[b];
+	});
+	for(int Index : aOrder)
+	{
+		if(!Counters.m_aSnapItemBytes[Index] && !Counters.m_aDeltaItemBytes[Index])
+			continue;
+		str_format(aBuf, sizeof(aBuf), "  item %s (%d): snap=%lld delta=%lld delta/s=%lld",
+			SnapTypeName(Index), Index, Counters.m_aSnapItemBytes[Index], Counters.m_aDeltaItemBytes[Index], Counters.m_aDeltaItemBytes[Index] / Seconds);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", aBuf);
+	}
+
+	for(int i = 0; i < CBandwidthCounters::NUM_MSG_TYPES; i++)
+	{
+		if(Counters.m_aSysMsgBytes[i])
+		{
+			str_format(aBuf, sizeof(aBuf), "  sys msg %d: %lld bytes/s=%lld", i, Counters.m_aSysMsgBytes[i], Counters.m_aSysMsgBytes[i] / Seconds);
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", aBuf);
+		}
+	}
+	for(int i = 0; i < CBandwidthCounters::NUM_MSG_TYPES; i++)
+	{
+		if(Counters.m_aGameMsgBytes[i])
+		{
+			str_format(aBuf, sizeof(aBuf), "  game msg %s (%d): %lld bytes/s=%lld", GameMsgName(i), i, Counters.m_aGameMsgBytes[i], Counters.m_aGameMsgBytes[i] / Seconds);
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", aBuf);
+		}
+	}
+}
+
+void CBandwidthStats::PrintGlobal(IConsole *pConsole) const
+{
+	PrintCounters(pConsole, "global", m_Global);
+}
+
+void CBandwidthStats::PrintClient(IConsole *pConsole, int ClientID) const
+{
+	char aScope[32];
+	str_format(aScope, sizeof(aScope), "client %d", ClientID);
+	PrintCounters(pConsole, aScope, m_aClients[ClientID]);
+}
+
+void CBandwidthStats::PrintRoom(IConsole *pConsole, int Room) const
+{
+	char aScope[32];
+	str_format(aScope, sizeof(aScope), "room %d", Room);
+	PrintCounters(pConsole, aScope, m_aRooms[Room]);
+}
+
+void CBandwidthStats::DumpCounters(IOHANDLE File, int64 Time, const char *pScope, int ID, const CBandwidthCounters &Counters) const
+{
+	char aBuf[256];
+	for(int i = 0; i < CBandwidthCounters::NUM_SNAP_TYPES; i++)
+	{
+		if(!Counters.m_aSnapItemBytes[i] && !Counters.m_aDeltaItemBytes[i])
+			continue;
+		str_format(aBuf, sizeof(aBuf), "%lld,%s,%d,item,%s,%lld,%lld\n", Time, pScope, ID, SnapTypeName(i), Counters.m_aSnapItemBytes[i], Counters.m_aDeltaItemBytes[i]);
+		io_write(File, aBuf, str_length(aBuf));
+	}
+	for(int i = 0; i < CBandwidthCounters::NUM_MSG_TYPES; i++)
+	{
+		if(Counters.m_aSysMsgBytes[i])
+		{
+			str_format(aBuf, sizeof(aBuf), "%lld,%s,%d,sysmsg,%d,%lld,\n", Time, pScope, ID, i, Counters.m_aSysMsgBytes[i]);
+			io_write(File, aBuf, str_length(aBuf));
+		}
+		if(Counters.m_aGameMsgBytes[i])
+		{
+			str_format(aBuf, sizeof(aBuf), "%lld,%s,%d,gamemsg,%s,%lld,\n", Time, pScope, ID, GameMsgName(i), Counters.m_aGameMsgBytes[i]);
+			io_write(File, aBuf, str_length(aBuf));
+		}
+	}
+}
+
+void CBandwidthStats::DumpCsv(IStorage *pStorage, const char *pFilename, int Interval)
+{
+	const int64 Now = time_get();
+	if(Interval <= 0 || Now < m_LastDump + Interval * time_freq())
+		return;
+	m_LastDump = Now;
+
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_APPEND, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	const int64 Timestamp = time_timestamp();
+	DumpCounters(File, Timestamp, "global", -1, m_Global);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		DumpCounters(File, Timestamp, "client", i, m_aClients[i]);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		DumpCounters(File, Timestamp, "room", i, m_aRooms[i]);
+	io_close(File);
+}
@@ -0,0 +1,81 @@
+#ifndef ENGINE_SERVER_BANDWIDTH_H
+#define ENGINE_SERVER_BANDWIDTH_H
+
+#include <base/system.h>
+
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+
+class IConsole;
+class IStorage;
+
+// outgoing byte counters by snapshot item type and message id
+class CBandwidthCounters
+{
+public:
+	enum
+	{
+		NUM_SNAP_TYPES = CSnapshot::STATS_NUM_TYPES,
+		// the last message bucket collects ids that don't fit, e.g. uuid messages
+		NUM_MSG_TYPES = 64,
+	};
+
+	int64 m_aSnapItemBytes[NUM_SNAP_TYPES];
+	int64 m_aDeltaItemBytes[NUM_SNAP_TYPES];
+	int64 m_aSysMsgBytes[NUM_MSG_TYPES];
+	int64 m_aGameMsgBytes[NUM_MSG_TYPES];
+
+	CBandwidthCounters() { Reset(); }
+	void Reset();
+	void Add(const CBandwidthCounters &Other);
+	void AddMsg(bool System, int MsgID, int Bytes);
+	int64 SnapTotal() const;
+	int64 DeltaTotal() const;
+	int64 MsgTotal() const;
+};
+
+// per-client, per-room and global outgoing bandwidth accounting
+class CBandwidthStats
+{
+	CBandwidthCounters m_Global;
+	CBandwidthCounters m_aClients[MAX_CLIENTS];
+	CBandwidthCounters m_aRooms[MAX_CLIENTS];
+
+	// scratch counters of the snapshot currently being built
+	CBandwidthCounters m_Current;
+
+	int64 m_StartTime;
+	int64 m_LastDump;
+
+	void PrintCounters(IConsole *pConsole, const char *pScope, const CBandwidthCounters &Counters) const;
+	void DumpCounters(IOHANDLE File, int64 Time, const char *pScope, int ID, const CBandwidthCounters &Counters) const;
+
+public:
+	CBandwidthStats();
+
+	void Reset();
+	void ResetClient(int ClientID) { m_aClients[ClientID].Reset(); }
+	// the room is destroyed, its id is reused by the next room
+	void ResetRoom(int Room) { m_aRooms[Room].Reset(); }
+
+	// pass these to `CSnapshotBuilder::SetStats` and `CSnapshotDelta::SetStats`
+	// before building the snapshot of a client, then commit it
+	int64 *SnapItemStats() { return m_Current.m_aSnapItemBytes; }
+	int64 *DeltaItemStats() { return m_Current.m_aDeltaItemBytes; }
+	void CommitSnap(int ClientID, int Room);
+
+	void OnSendMsg(int ClientID, int Room, bool System, int MsgID, int Bytes);
+
+	const CBandwidthCounters &Global() const { return m_Global; }
+	const CBandwidthCounters &Client(int ClientID) const { return m_aClients[ClientID]; }
+	const CBandwidthCounters &Room(int Room) const { return m_aRooms[Room]; }
+
+	void PrintGlobal(IConsole *pConsole) const;
+	void PrintClient(IConsole *pConsole, int ClientID) const;
+	void PrintRoom(IConsole *pConsole, int Room) const;
+
+	// appends the counters to a csv file every `Interval` seconds
+	void DumpCsv(IStorage *pStorage, const char *pFilename, int Interval);
+};
+
+#endif
@@ -46,10 +46,17 @@ public:
 	virtual void Disconnect() = 0;
 
 	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements
+	// prepared statements are cached per connection, preparing the same query again reuses it
 	//
 	// returns true on failure
 	virtual bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize) = 0;
 
+	// runs a statement without placeholders and results, e.g. "BEGIN" or "SAVEPOINT"
+	// connection has to be established, resets the current prepared statement
+	//
+	// returns true on failure
+	virtual bool Execute(const char *pQuery, char *pError, int ErrorSize) = 0;
+
 	// PrepareStatement has to be called beforehand,
 	virtual void BindString(int Idx, const char *pString) = 0;
 	virtual void BindBlob(int Idx, unsigned char *pBlob, int Size) = 0;
@@ -1,6 +1,7 @@
 #include "connection_pool.h"
 #include "connection.h"
 
+#include <base/math.h>
 #include <engine/console.h>
 
 // helper struct to hold thread data
@@ -54,11 +55,10 @@ CSqlExecData::CSqlExecData(
 }
 
 CDbConnectionPool::CDbConnectionPool() :
-	m_NumElem(),
-	FirstElem(0),
-	LastElem(0)
+	m_WriteBatchSize(1),
+	m_Shutdown(false),
+	m_NumRunningWorkers(0)
 {
-	thread_init_and_detach(CDbConnectionPool::Worker, this, "database worker thread");
 }
 
 CDbConnectionPool::~CDbConnectionPool()
@@ -68,6 +68,7 @@ CDbConnectionPool::~CDbConnectionPool()
 void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
 {
 	const char *ModeDesc[] = {"Read", "Write", "WriteBackup"};
+	std::unique_lock Lock(m_DbConnectionsLock);
 	for(unsigned int i = 0; i < m_aapDbConnections[DatabaseMode].size(); i++)
 	{
 		m_aapDbConnections[DatabaseMode][i]->Print(pConsole, ModeDesc[DatabaseMode]);
@@ -78,17 +79,47 @@ void CDbConnectionPool::RegisterDatabase(std::unique_ptr<IDbConnection> pDatabas
 {
 	if(DatabaseMode < 0 || NUM_MODES <= DatabaseMode)
 		return;
+	std::unique_lock Lock(m_DbConnectionsLock);
 	m_aapDbConnections[DatabaseMode].push_back(std::move(pDatabase));
 }
 
+void CDbConnectionPool::Start(int NumReadWorkers, int NumWriteWorkers, int WriteBatchSize)
+{
+	dbg_assert(m_vpWorkers.empty(), "database workers already started");
+	m_WriteBatchSize = maximum(WriteBatchSize, 1);
+	for(int i = 0; i < NumReadWorkers + NumWriteWorkers; i++)
+	{
+		std::unique_ptr<CWorker> pWorker = std::make_unique<CWorker>();
+		pWorker->m_pPool = this;
+		pWorker->m_Queue = i < NumReadWorkers ? QUEUE_READ : QUEUE_WRITE;
+		m_NumRunningWorkers++;
+		thread_init_and_detach(CDbConnectionPool::Worker, pWorker.get(), pWorker->m_Queue == QUEUE_READ ? "database read worker" : "database write worker");
+		m_vpWorkers.push_back(std::move(pWorker));
+	}
+}
+
+void CDbConnectionPool::Enqueue(int Queue, std::unique_ptr<CSqlExecData> pData)
+{
+	static const char *s_apQueueNames[] = {"read", "write"};
+	CQueue &TaskQueue = m_aQueues[Queue];
+	{
+		std::unique_lock Lock(TaskQueue.m_Lock);
+		TaskQueue.m_vpTasks.push_back(std::move(pData));
+		if(TaskQueue.m_vpTasks.size() >= TaskQueue.m_WarnSize)
+		{
+			dbg_msg("sql", "%d tasks waiting in the %s queue", (int)TaskQueue.m_vpTasks.size(), s_apQueueNames[Queue]);
+			TaskQueue.m_WarnSize *= 2;
+		}
+	}
+	TaskQueue.m_Cv.notify_one();
+}
+
 void CDbConnectionPool::Execute(
 	FRead pFunc,
 	std::unique_ptr<const ISqlData> pThreadData,
 	const char *pName)
 {
-	m_aTasks[FirstElem++].reset(new CSqlExecData(pFunc, std::move(pThreadData), pName));
-	FirstElem %= sizeof(m_aTasks) / sizeof(m_aTasks[0]);
-	m_NumElem.Signal();
+	Enqueue(QUEUE_READ, std::make_unique<CSqlExecData>(pFunc, std::move(pThreadData), pName));
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -96,17 +127,31 @@ void CDbConnectionPool::ExecuteWrite(
 	std::unique_ptr<const ISqlData> pThreadData,
 	const char *pName)
 {
-	m_aTasks[FirstElem++].reset(new CSqlExecData(pFunc, std::move(pThreadData), pName));
-	FirstElem %= sizeof(m_aTasks) / sizeof(m_aTasks[0]);
-	m_NumElem.Signal();
+	Enqueue(QUEUE_WRITE, std::make_unique<CSqlExecData>(pFunc, std::move(pThreadData), pName));
+}
+
+int CDbConnectionPool::NumQueued() const
+{
+	int NumQueued = 0;
+	for(const CQueue &Queue : m_aQueues)
+	{
+		std::unique_lock Lock(Queue.m_Lock);
+		NumQueued += Queue.m_vpTasks.size();
+	}
+	return NumQueued;
 }
 
 void CDbConnectionPool::OnShutdown()
 {
 	m_Shutdown.store(true);
-	m_NumElem.Signal();
+	for(CQueue &Queue : m_aQueues)
+	{
+		// take the lock so no worker misses the notification between its check and wait
+		std::unique_lock Lock(Queue.m_Lock);
+		Queue.m_Cv.notify_all();
+	}
 	int i = 0;
-	while(m_Shutdown.load())
+	while(m_NumRunningWorkers.load() > 0)
 	{
 		if(i > 600)
 		{
@@ -124,100 +169,201 @@ void CDbConnectionPool::OnShutdown()
 
 void CDbConnectionPool::Worker(void *pUser)
 {
-	CDbConnectionPool *pThis = (CDbConnectionPool *)pUser;
-	pThis->Worker();
+	CWorker *pWorker = (CWorker *)pUser;
+	pWorker->m_pPool->Worker(pWorker);
 }
 
-void CDbConnectionPool::Worker()
+void CDbConnectionPool::Worker(CWorker *pWorker)
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	int WriteServer = 0;
-	while(1)
+	CQueue &Queue = m_aQueues[pWorker->m_Queue];
+	const int BatchSize = pWorker->m_Queue == QUEUE_WRITE ? m_WriteBatchSize : 1;
+	std::vector<std::unique_ptr<CSqlExecData>> vpTasks;
+	while(true)
 	{
-		m_NumElem.Wait();
-		auto pThreadData = std::move(m_aTasks[LastElem++]);
-		// work through all database jobs after OnShutdown is called before exiting the thread
-		if(pThreadData == nullptr)
 		{
-			m_Shutdown.store(false);
-			return;
+			std::unique_lock Lock(Queue.m_Lock);
+			Queue.m_Cv.wait(Lock, [&] { return !Queue.m_vpTasks.empty() || m_Shutdown.load(); });
+			// work through all database jobs after OnShutdown is called before exiting the thread
+			if(Queue.m_vpTasks.empty())
+				break;
+			while(!Queue.m_vpTasks.empty() && (int)vpTasks.size() < BatchSize)
+			{
+				vpTasks.push_back(std::move(Queue.m_vpTasks.front()));
+				Queue.m_vpTasks.pop_front();
+			}
+			if(Queue.m_vpTasks.empty())
+				Queue.m_WarnSize = QUEUE_WARN_SIZE;
 		}
-		LastElem %= sizeof(m_aTasks) / sizeof(m_aTasks[0]);
-		bool Success = false;
-		switch(pThreadData->m_Mode)
+
+		SyncConnections(pWorker);
+		if(pWorker->m_Queue == QUEUE_READ)
 		{
-		case CSqlExecData::READ_ACCESS:
+			for(auto &pTask : vpTasks)
+				Complete(pTask.get(), ExecRead(pWorker, pTask.get()));
+		}
+		else
 		{
-			for(int i = 0; i < (int)m_aapDbConnections[Mode::READ].size(); i++)
-			{
-				int CurServer = (ReadServer + i) % (int)m_aapDbConnections[Mode::READ].size();
-				if(ExecSqlFunc(m_aapDbConnections[Mode::READ][CurServer].get(), pThreadData.get(), false))
-				{
-					ReadServer = CurServer;
-					dbg_msg("sql", "%s done on read database %d", pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
-			}
+			ExecWriteBatch(pWorker, vpTasks);
+		}
+		vpTasks.clear();
+	}
+
+	// the copies have to be gone before the mysql library is shut down
+	for(auto &vpConnections : pWorker->m_aapDbConnections)
+		vpConnections.clear();
+	m_NumRunningWorkers--;
+}
+
+void CDbConnectionPool::SyncConnections(CWorker *pWorker)
+{
+	// databases are only ever added, copy the new ones
+	std::unique_lock Lock(m_DbConnectionsLock);
+	for(int Mode = 0; Mode < NUM_MODES; Mode++)
+	{
+		std::vector<std::unique_ptr<IDbConnection>> &vpOwn = pWorker->m_aapDbConnections[Mode];
+		for(size_t i = vpOwn.size(); i < m_aapDbConnections[Mode].size(); i++)
+			vpOwn.emplace_back(m_aapDbConnections[Mode][i]->Copy());
+	}
+}
+
+bool CDbConnectionPool::ExecRead(CWorker *pWorker, CSqlExecData *pData)
+{
+	std::vector<std::unique_ptr<IDbConnection>> &vpServers = pWorker->m_aapDbConnections[Mode::READ];
+	for(int i = 0; i < (int)vpServers.size(); i++)
+	{
+		int CurServer = (pWorker->m_ReadServer + i) % (int)vpServers.size();
+		if(ExecSqlFunc(vpServers[CurServer].get(), pData, false))
+		{
+			pWorker->m_ReadServer = CurServer;
+			dbg_msg("sql", "%s done on read database %d", pData->m_pName, CurServer);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CDbConnectionPool::ExecWrite(CWorker *pWorker, CSqlExecData *pData)
+{
+	std::vector<std::unique_ptr<IDbConnection>> &vpServers = pWorker->m_aapDbConnections[Mode::WRITE];
+	for(int i = 0; i < (int)vpServers.size(); i++)
+	{
+		int CurServer = (pWorker->m_WriteServer + i) % (int)vpServers.size();
+		if(ExecSqlFunc(vpServers[CurServer].get(), pData, false))
+		{
+			pWorker->m_WriteServer = CurServer;
+			dbg_msg("sql", "%s done on write database %d", pData->m_pName, CurServer);
+			return true;
+		}
+	}
+	std::vector<std::unique_ptr<IDbConnection>> &vpBackups = pWorker->m_aapDbConnections[Mode::WRITE_BACKUP];
+	for(int i = 0; i < (int)vpBackups.size(); i++)
+	{
+		if(ExecSqlFunc(vpBackups[i].get(), pData, true))
+		{
+			dbg_msg("sql", "%s done on write backup database %d", pData->m_pName, i);
+			return true;
 		}
-		break;
-		case CSqlExecData::WRITE_ACCESS:
+	}
+	return false;
+}
+
+void CDbConnectionPool::ExecWriteBatch(CWorker *pWorker, std::vector<std::unique_ptr<CSqlExecData>> &vpData)
+{
+	// a batch shares one transaction on the last working write database,
+	// every write gets a savepoint so a failing one doesn't take the others down
+	std::vector<bool> vDone(vpData.size(), false);
+	bool Committed = false;
+	std::vector<std::unique_ptr<IDbConnection>> &vpServers = pWorker->m_aapDbConnections[Mode::WRITE];
+	if(vpData.size() > 1 && !vpServers.empty())
+	{
+		const int CurServer = pWorker->m_WriteServer % (int)vpServers.size();
+		IDbConnection *pConnection = vpServers[CurServer].get();
+		char aError[256] = "error message not initialized";
+		if(pConnection->Connect(aError, sizeof(aError)))
 		{
-			for(int i = 0; i < (int)m_aapDbConnections[Mode::WRITE].size(); i++)
+			dbg_msg("sql", "failed connecting to db: %s", aError);
+		}
+		else
+		{
+			bool Failed = pConnection->Execute("BEGIN", aError, sizeof(aError));
+			for(size_t i = 0; i < vpData.size() && !Failed; i++)
 			{
-				int CurServer = (WriteServer + i) % (int)m_aapDbConnections[Mode::WRITE].size();
-				if(ExecSqlFunc(m_aapDbConnections[Mode::WRITE][i].get(), pThreadData.get(), false))
+				if(pConnection->Execute("SAVEPOINT batch_write", aError, sizeof(aError)))
 				{
-					WriteServer = CurServer;
-					dbg_msg("sql", "%s done on write database %d", pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
+					Failed = true;
 				}
-			}
-			if(!Success)
-			{
-				for(int i = 0; i < (int)m_aapDbConnections[Mode::WRITE_BACKUP].size(); i++)
+				else if(!RunSqlFunc(pConnection, vpData[i].get(), false, aError, sizeof(aError)))
+				{
+					vDone[i] = true;
+					Failed = pConnection->Execute("RELEASE SAVEPOINT batch_write", aError, sizeof(aError));
+				}
+				else
 				{
-					if(ExecSqlFunc(m_aapDbConnections[Mode::WRITE_BACKUP][i].get(), pThreadData.get(), true))
-					{
-						dbg_msg("sql", "%s done on write backup database %d", pThreadData->m_pName, i);
-						Success = true;
-						break;
-					}
+					dbg_msg("sql", "%s failed: %s", vpData[i]->m_pName, aError);
+					Failed = pConnection->Execute("ROLLBACK TO SAVEPOINT batch_write", aError, sizeof(aError)) ||
+						 pConnection->Execute("RELEASE SAVEPOINT batch_write", aError, sizeof(aError));
 				}
 			}
+			if(!Failed && !pConnection->Execute("COMMIT", aError, sizeof(aError)))
+			{
+				Committed = true;
+				dbg_msg("sql", "batch of %d writes done on write database %d", (int)vpData.size(), CurServer);
+			}
+			else
+			{
+				dbg_msg("sql", "batch of %d writes failed: %s", (int)vpData.size(), aError);
+				pConnection->Execute("ROLLBACK", aError, sizeof(aError));
+			}
+			pConnection->Disconnect();
 		}
-		break;
-		}
+	}
+
+	// retry everything that didn't make it one by one, including the backups
+	for(size_t i = 0; i < vpData.size(); i++)
+	{
+		bool Success = Committed && vDone[i];
 		if(!Success)
-			dbg_msg("sql", "%s failed on all databases", pThreadData->m_pName);
-		if(pThreadData->m_pThreadData->m_pResult != nullptr)
 		{
-			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
-			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
+			Success = ExecWrite(pWorker, vpData[i].get());
+			if(!Success)
+				dbg_msg("sql", "%s failed on all databases", vpData[i]->m_pName);
 		}
+		Complete(vpData[i].get(), Success);
 	}
 }
 
-bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, bool Failure)
+void CDbConnectionPool::Complete(CSqlExecData *pData, bool Success)
 {
-	char aError[256] = "error message not initialized";
-	if(pConnection->Connect(aError, sizeof(aError)))
+	if(pData->m_Mode == CSqlExecData::READ_ACCESS && !Success)
+		dbg_msg("sql", "%s failed on all databases", pData->m_pName);
+	if(pData->m_pThreadData->m_pResult != nullptr)
 	{
-		dbg_msg("sql", "failed connecting to db: %s", aError);
-		return false;
+		pData->m_pThreadData->m_pResult->m_Success = Success;
+		pData->m_pThreadData->m_pResult->m_Completed.store(true);
 	}
-	bool Success = false;
+}
+
+bool CDbConnectionPool::RunSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, bool Failure, char *pError, int ErrorSize)
+{
 	switch(pData->m_Mode)
 	{
 	case CSqlExecData::READ_ACCESS:
-		Success = !pData->m_Ptr.m_pReadFunc(pConnection, pData->m_pThreadData.get(), aError, sizeof(aError));
-		break;
+		return pData->m_Ptr.m_pReadFunc(pConnection, pData->m_pThreadData.get(), pError, ErrorSize);
 	case CSqlExecData::WRITE_ACCESS:
-		Success = !pData->m_Ptr.m_pWriteFunc(pConnection, pData->m_pThreadData.get(), Failure, aError, sizeof(aError));
-		break;
+		return pData->m_Ptr.m_pWriteFunc(pConnection, pData->m_pThreadData.get(), Failure, pError, ErrorSize);
+	}
+	return true;
+}
+
+bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, bool Failure)
+{
+	char aError[256] = "error message not initialized";
+	if(pConnection->Connect(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed connecting to db: %s", aError);
+		return false;
 	}
+	bool Success = !RunSqlFunc(pConnection, pData, Failure, aError, sizeof(aError));
 	pConnection->Disconnect();
 	if(!Success)
 	{
@@ -2,8 +2,10 @@
 #define ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 
 #include <atomic>
-#include <base/tl/threading.h>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 class IDbConnection;
@@ -56,30 +58,80 @@ public:
 
 	void RegisterDatabase(std::unique_ptr<IDbConnection> pDatabase, Mode DatabaseMode);
 
+	// starts the worker threads, each works on its own copies of the
+	// registered databases. Queued writes are committed in transactions of
+	// up to `WriteBatchSize` writes.
+	void Start(int NumReadWorkers, int NumWriteWorkers, int WriteBatchSize);
+
 	void Execute(
 		FRead pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
 	// writes to WRITE_BACKUP server in case of failure
+	// write functions must not control transactions themselves, they may
+	// run inside a batch
 	void ExecuteWrite(
 		FWrite pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
 		const char *pName);
 
+	// number of tasks waiting for a worker
+	int NumQueued() const;
+
 	void OnShutdown();
 
 private:
+	enum
+	{
+		QUEUE_READ,
+		QUEUE_WRITE,
+		NUM_QUEUES,
+
+		// log a warning when a queue grows past this, and each doubling
+		QUEUE_WARN_SIZE = 512,
+	};
+
+	struct CQueue
+	{
+		mutable std::mutex m_Lock;
+		std::condition_variable m_Cv;
+		std::deque<std::unique_ptr<struct CSqlExecData>> m_vpTasks;
+		size_t m_WarnSize = QUEUE_WARN_SIZE;
+	};
+
+	struct CWorker
+	{
+		CDbConnectionPool *m_pPool;
+		int m_Queue;
+		// own copies of the registered databases, one connection can't be
+		// shared between threads
+		std::vector<std::unique_ptr<IDbConnection>> m_aapDbConnections[NUM_MODES];
+		// remember last working server and try to connect to it first
+		int m_ReadServer = 0;
+		int m_WriteServer = 0;
+	};
+
+	std::mutex m_DbConnectionsLock;
 	std::vector<std::unique_ptr<IDbConnection>> m_aapDbConnections[NUM_MODES];
 
-	static void Worker(void *pUser);
-	void Worker();
-	bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, bool Failure);
+	CQueue m_aQueues[NUM_QUEUES];
+	std::vector<std::unique_ptr<CWorker>> m_vpWorkers;
+	int m_WriteBatchSize;
 
 	std::atomic_bool m_Shutdown;
-	CSemaphore m_NumElem;
-	int FirstElem;
-	int LastElem;
-	std::unique_ptr<struct CSqlExecData> m_aTasks[512];
+	std::atomic_int m_NumRunningWorkers;
+
+	void Enqueue(int Queue, std::unique_ptr<struct CSqlExecData> pData);
+
+	static void Worker(void *pUser);
+	void Worker(CWorker *pWorker);
+	void SyncConnections(CWorker *pWorker);
+	bool ExecRead(CWorker *pWorker, struct CSqlExecData *pData);
+	bool ExecWrite(CWorker *pWorker, struct CSqlExecData *pData);
+	void ExecWriteBatch(CWorker *pWorker, std::vector<std::unique_ptr<struct CSqlExecData>> &vpData);
+	bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, bool Failure);
+	bool RunSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, bool Failure, char *pError, int ErrorSize);
+	static void Complete(struct CSqlExecData *pData, bool Success);
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
@@ -7,7 +7,9 @@
 #include <engine/console.h>
 
 #include <atomic>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 enum
@@ -78,6 +80,7 @@ public:
 	virtual void Disconnect();
 
 	virtual bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize);
+	virtual bool Execute(const char *pQuery, char *pError, int ErrorSize);
 
 	virtual void BindString(int Idx, const char *pString);
 	virtual void BindBlob(int Idx, unsigned char *pBlob, int Size);
@@ -117,10 +120,22 @@ private:
 		float f;
 	};
 
+	enum
+	{
+		MAX_CACHED_STATEMENTS = 64,
+	};
+
 	bool m_NewQuery = false;
 	bool m_HaveConnection = false;
 	MYSQL m_Mysql;
-	std::unique_ptr<MYSQL_STMT, CStmtDeleter> m_pStmt = nullptr;
+	// current statement, either the scratch statement or a cached one
+	MYSQL_STMT *m_pStmt = nullptr;
+	// for queries that are only run once, e.g. during setup
+	std::unique_ptr<MYSQL_STMT, CStmtDeleter> m_pScratchStmt = nullptr;
+	// prepared statements only live as long as the server connection, which
+	// may silently be replaced by the automatic reconnect
+	std::map<std::string, std::unique_ptr<MYSQL_STMT, CStmtDeleter>> m_Statements;
+	unsigned long m_StatementsThreadID = 0;
 	std::vector<MYSQL_BIND> m_aStmtParameters;
 	std::vector<UParameterExtra> m_aStmtParameterExtras;
 
@@ -168,6 +183,9 @@ CMysqlConnection::CMysqlConnection(
 
 CMysqlConnection::~CMysqlConnection()
 {
+	m_pStmt = nullptr;
+	m_Statements.clear();
+	m_pScratchStmt = nullptr;
 	mysql_close(&m_Mysql);
 	g_MysqlNumConnections -= 1;
 }
@@ -179,17 +197,18 @@ void CMysqlConnection::StoreErrorMysql(const char *pContext)
 
 void CMysqlConnection::StoreErrorStmt(const char *pContext)
 {
-	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:stmt:%d): %s", pContext, mysql_stmt_errno(m_pStmt.get()), mysql_stmt_error(m_pStmt.get()));
+	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:stmt:%d): %s", pContext, mysql_stmt_errno(m_pStmt), mysql_stmt_error(m_pStmt));
 }
 
 bool CMysqlConnection::PrepareAndExecuteStatement(const char *pStmt)
 {
-	if(mysql_stmt_prepare(m_pStmt.get(), pStmt, str_length(pStmt)))
+	m_pStmt = m_pScratchStmt.get();
+	if(mysql_stmt_prepare(m_pStmt, pStmt, str_length(pStmt)))
 	{
 		StoreErrorStmt("prepare");
 		return true;
 	}
-	if(mysql_stmt_execute(m_pStmt.get()))
+	if(mysql_stmt_execute(m_pStmt))
 	{
 		StoreErrorStmt("execute");
 		return true;
@@ -237,7 +256,7 @@ bool CMysqlConnection::ConnectImpl()
 {
 	if(m_HaveConnection)
 	{
-		if(m_pStmt && mysql_stmt_free_result(m_pStmt.get()))
+		if(m_pStmt && mysql_stmt_free_result(m_pStmt))
 		{
 			StoreErrorStmt("free_result");
 			dbg_msg("mysql", "can't free last result %s", m_aErrorDetail);
@@ -245,16 +264,28 @@ bool CMysqlConnection::ConnectImpl()
 		if(!mysql_select_db(&m_Mysql, m_aDatabase))
 		{
 			// Success.
+			if(mysql_thread_id(&m_Mysql) != m_StatementsThreadID)
+			{
+				// reconnected in the background, the server forgot our statements
+				m_pStmt = nullptr;
+				m_Statements.clear();
+				m_StatementsThreadID = mysql_thread_id(&m_Mysql);
+			}
 			return false;
 		}
 		StoreErrorMysql("select_db");
 		dbg_msg("mysql", "ping error, trying to reconnect %s", m_aErrorDetail);
+		m_pStmt = nullptr;
+		m_Statements.clear();
+		m_pScratchStmt = nullptr;
 		mysql_close(&m_Mysql);
 		mem_zero(&m_Mysql, sizeof(m_Mysql));
 		mysql_init(&m_Mysql);
 	}
 
 	m_pStmt = nullptr;
+	m_Statements.clear();
+	m_pScratchStmt = nullptr;
 	unsigned int OptConnectTimeout = 60;
 	unsigned int OptReadTimeout = 60;
 	unsigned int OptWriteTimeout = 120;
@@ -271,8 +302,9 @@ bool CMysqlConnection::ConnectImpl()
 		return true;
 	}
 	m_HaveConnection = true;
+	m_StatementsThreadID = mysql_thread_id(&m_Mysql);
 
-	m_pStmt = std::unique_ptr<MYSQL_STMT, CStmtDeleter>(mysql_stmt_init(&m_Mysql));
+	m_pScratchStmt = std::unique_ptr<MYSQL_STMT, CStmtDeleter>(mysql_stmt_init(&m_Mysql));
 
 	// Apparently MYSQL_SET_CHARSET_NAME is not enough
 	if(PrepareAndExecuteStatement("SET CHARACTER SET utf8mb4"))
@@ -332,14 +364,48 @@ void CMysqlConnection::Disconnect()
 
 bool CMysqlConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
 {
-	if(mysql_stmt_prepare(m_pStmt.get(), pStmt, str_length(pStmt)))
+	if(m_pStmt)
+		mysql_stmt_free_result(m_pStmt);
+	m_pStmt = nullptr;
+
+	auto It = m_Statements.find(pStmt);
+	if(It != m_Statements.end())
 	{
-		StoreErrorStmt("prepare");
-		str_copy(pError, m_aErrorDetail, ErrorSize);
-		return true;
+		m_pStmt = It->second.get();
+		if(mysql_stmt_reset(m_pStmt))
+		{
+			StoreErrorStmt("reset");
+			str_copy(pError, m_aErrorDetail, ErrorSize);
+			m_Statements.erase(It);
+			m_pStmt = nullptr;
+			return true;
+		}
+	}
+	else
+	{
+		// queries are formatted from a small set of templates, only a bug fills the cache
+		if((int)m_Statements.size() >= MAX_CACHED_STATEMENTS)
+			m_Statements.clear();
+
+		std::unique_ptr<MYSQL_STMT, CStmtDeleter> pNewStmt(mysql_stmt_init(&m_Mysql));
+		m_pStmt = pNewStmt.get();
+		if(!m_pStmt)
+		{
+			StoreErrorMysql("stmt_init");
+			str_copy(pError, m_aErrorDetail, ErrorSize);
+			return true;
+		}
+		if(mysql_stmt_prepare(m_pStmt, pStmt, str_length(pStmt)))
+		{
+			StoreErrorStmt("prepare");
+			str_copy(pError, m_aErrorDetail, ErrorSize);
+			m_pStmt = nullptr;
+			return true;
+		}
+		m_Statements.emplace(pStmt, std::move(pNewStmt));
 	}
 	m_NewQuery = true;
-	unsigned NumParameters = mysql_stmt_param_count(m_pStmt.get());
+	unsigned NumParameters = mysql_stmt_param_count(m_pStmt);
 	m_aStmtParameters.resize(NumParameters);
 	m_aStmtParameterExtras.resize(NumParameters);
 	mem_zero(&m_aStmtParameters[0], sizeof(m_aStmtParameters[0]) * m_aStmtParameters.size());
@@ -421,20 +487,20 @@ bool CMysqlConnection::Step(bool *pEnd, char *pError, int ErrorSize)
 	if(m_NewQuery)
 	{
 		m_NewQuery = false;
-		if(mysql_stmt_bind_param(m_pStmt.get(), &m_aStmtParameters[0]))
+		if(mysql_stmt_bind_param(m_pStmt, &m_aStmtParameters[0]))
 		{
 			StoreErrorStmt("bind_param");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return true;
 		}
-		if(mysql_stmt_execute(m_pStmt.get()))
+		if(mysql_stmt_execute(m_pStmt))
 		{
 			StoreErrorStmt("execute");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return true;
 		}
 	}
-	int Result = mysql_stmt_fetch(m_pStmt.get());
+	int Result = mysql_stmt_fetch(m_pStmt);
 	if(Result == 1)
 	{
 		StoreErrorStmt("fetch");
@@ -452,19 +518,19 @@ bool CMysqlConnection::ExecuteUpdate(int *pNumUpdated, char *pError, int ErrorSi
 	if(m_NewQuery)
 	{
 		m_NewQuery = false;
-		if(mysql_stmt_bind_param(m_pStmt.get(), &m_aStmtParameters[0]))
+		if(mysql_stmt_bind_param(m_pStmt, &m_aStmtParameters[0]))
 		{
 			StoreErrorStmt("bind_param");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return true;
 		}
-		if(mysql_stmt_execute(m_pStmt.get()))
+		if(mysql_stmt_execute(m_pStmt))
 		{
 			StoreErrorStmt("execute");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return true;
 		}
-		*pNumUpdated = mysql_stmt_affected_rows(m_pStmt.get());
+		*pNumUpdated = mysql_stmt_affected_rows(m_pStmt);
 		return false;
 	}
 	str_copy(pError, "tried to execute update without query", ErrorSize);
@@ -485,7 +551,7 @@ bool CMysqlConnection::IsNull(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:null");
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
@@ -509,7 +575,7 @@ float CMysqlConnection::GetFloat(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:float");
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
@@ -537,7 +603,7 @@ int CMysqlConnection::GetInt(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:int");
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
@@ -571,7 +637,7 @@ void CMysqlConnection::GetString(int Col, char *pBuffer, int BufferSize)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = &Error;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:string");
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
@@ -603,7 +669,7 @@ int CMysqlConnection::GetBlob(int Col, unsigned char *pBuffer, int BufferSize)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = &Error;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:blob");
 		dbg_msg("mysql", "error fetching column %s", m_aErrorDetail);
@@ -620,6 +686,22 @@ int CMysqlConnection::GetBlob(int Col, unsigned char *pBuffer, int BufferSize)
 	return Length;
 }
 
+bool CMysqlConnection::Execute(const char *pQuery, char *pError, int ErrorSize)
+{
+	if(m_pStmt)
+		mysql_stmt_free_result(m_pStmt);
+	m_pStmt = nullptr;
+
+	// transaction control isn't allowed in every server version's prepared statements
+	if(mysql_real_query(&m_Mysql, pQuery, str_length(pQuery)))
+	{
+		StoreErrorMysql("query");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return true;
+	}
+	return false;
+}
+
 const char *CMysqlConnection::MedianMapTime(char *pBuffer, int BufferSize) const
 {
 	str_format(pBuffer, BufferSize,
@@ -6,6 +6,8 @@
 #include <engine/console.h>
 
 #include <atomic>
+#include <map>
+#include <string>
 
 class CSqliteConnection : public IDbConnection
 {
@@ -28,6 +30,7 @@ public:
 	virtual void Disconnect();
 
 	virtual bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize);
+	virtual bool Execute(const char *pQuery, char *pError, int ErrorSize);
 
 	virtual void BindString(int Idx, const char *pString);
 	virtual void BindBlob(int Idx, unsigned char *pBlob, int Size);
@@ -52,11 +55,20 @@ private:
 	char m_aFilename[512];
 	bool m_Setup;
 
+	enum
+	{
+		MAX_CACHED_STATEMENTS = 64,
+	};
+
 	sqlite3 *m_pDb;
+	// current statement, owned by m_Statements
 	sqlite3_stmt *m_pStmt;
+	std::map<std::string, sqlite3_stmt *> m_Statements;
 	bool m_Done; // no more rows available for Step
-	// returns false, if the query succeeded
-	bool Execute(const char *pQuery, char *pError, int ErrorSize);
+
+	// resets the current statement so it can be reused later
+	void ReleaseStatement();
+	void ClearStatements();
 
 	// returns true if an error was formatted
 	bool FormatError(int Result, char *pError, int ErrorSize);
@@ -78,8 +90,7 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	ClearStatements();
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
@@ -122,8 +133,13 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 		return true;
 	}
 
-	// wait for database to unlock so we don't have to handle SQLITE_BUSY errors
-	sqlite3_busy_timeout(m_pDb, -1);
+	// wait for the database to unlock instead of failing with SQLITE_BUSY,
+	// a batch of writes holds the write lock for its whole transaction
+	sqlite3_busy_timeout(m_pDb, 10000);
+
+	// readers don't block on the writer and the other way round
+	if(Execute("PRAGMA journal_mode=WAL", pError, ErrorSize))
+		return true;
 
 	if(m_Setup)
 	{
@@ -150,27 +166,60 @@ bool CSqliteConnection::Connect(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
-	m_pStmt = nullptr;
+	ReleaseStatement();
 	m_InUse.store(false);
 }
 
-bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+void CSqliteConnection::ReleaseStatement()
 {
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	{
+		// the bound buffers belong to the caller and may be gone on the next use
+		sqlite3_reset(m_pStmt);
+		sqlite3_clear_bindings(m_pStmt);
+	}
+	m_pStmt = nullptr;
+	m_Done = true;
+}
+
+void CSqliteConnection::ClearStatements()
+{
 	m_pStmt = nullptr;
+	for(auto &Statement : m_Statements)
+		sqlite3_finalize(Statement.second);
+	m_Statements.clear();
+}
+
+bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+{
+	ReleaseStatement();
+
+	auto It = m_Statements.find(pStmt);
+	if(It != m_Statements.end())
+	{
+		m_pStmt = It->second;
+		m_Done = false;
+		return false;
+	}
+
+	// queries are formatted from a small set of templates, only a bug fills the cache
+	if((int)m_Statements.size() >= MAX_CACHED_STATEMENTS)
+		ClearStatements();
+
+	sqlite3_stmt *pNewStmt = nullptr;
 	int Result = sqlite3_prepare_v2(
 		m_pDb,
 		pStmt,
 		-1, // pStmt can be any length
-		&m_pStmt,
+		&pNewStmt,
 		NULL);
 	if(FormatError(Result, pError, ErrorSize))
 	{
+		sqlite3_finalize(pNewStmt);
 		return true;
 	}
+	m_Statements.emplace(pStmt, pNewStmt);
+	m_pStmt = pNewStmt;
 	m_Done = false;
 	return false;
 }
@@ -306,6 +355,9 @@ const char *CSqliteConnection::MedianMapTime(char *pBuffer, int BufferSize) cons
 
 bool CSqliteConnection::Execute(const char *pQuery, char *pError, int ErrorSize)
 {
+	// an unfinished statement would keep the transaction busy
+	ReleaseStatement();
+
 	char *pErrorMsg;
 	int Result = sqlite3_exec(m_pDb, pQuery, NULL, NULL, &pErrorMsg);
 	if(Result != SQLITE_OK)
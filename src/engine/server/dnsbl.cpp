@@ -0,0 +1,109 @@
+#include "dnsbl.h"
+
+#include <engine/engine.h>
+#include <engine/shared/jobs.h>
+
+bool CDnsblHostResolver::IsListed(const char *pQuery)
+{
+	NETADDR Addr;
+	return net_host_lookup(pQuery, &Addr, NETTYPE_IPV4) == 0;
+}
+
+class CDnsblLookup : public IJob
+{
+	std::shared_ptr<IDnsblResolver> m_pResolver;
+	std::shared_ptr<CDnsbl::CCompletions> m_pCompletions;
+	NETADDR m_Addr;
+	int m_Generation;
+	char m_aQuery[256];
+
+	void Run() override
+	{
+		CDnsbl::CResult Result;
+		Result.m_Addr = m_Addr;
+		Result.m_Listed = m_pResolver->IsListed(m_aQuery);
+		Result.m_Generation = m_Generation;
+
+		std::unique_lock Lock(m_pCompletions->m_Lock);
+		m_pCompletions->m_vResults.push_back(Result);
+		m_pCompletions->m_NumResults.fetch_add(1, std::memory_order_release);
+	}
+
+public:
+	CDnsblLookup(std::shared_ptr<IDnsblResolver> pResolver, std::shared_ptr<CDnsbl::CCompletions> pCompletions, const NETADDR *pAddr, int Generation, const char *pQuery) :
+		m_pResolver(std::move(pResolver)), m_pCompletions(std::move(pCompletions)), m_Addr(*pAddr), m_Generation(Generation)
+	{
+		str_copy(m_aQuery, pQuery, sizeof(m_aQuery));
+	}
+};
+
+void CDnsbl::Init(IEngine *pEngine, std::shared_ptr<IDnsblResolver> pResolver)
+{
+	m_pEngine = pEngine;
+	m_pResolver = pResolver ? std::move(pResolver) : std::make_shared<CDnsblHostResolver>();
+	m_pCompletions = std::make_shared<CCompletions>();
+}
+
+bool CDnsbl::SetProvider(const char *pHost, const char *pKey, int CacheTime)
+{
+	m_CacheTime = CacheTime;
+	if(str_comp(m_aHost, pHost) == 0 && str_comp(m_aKey, pKey) == 0)
+		return false;
+
+	str_copy(m_aHost, pHost, sizeof(m_aHost));
+	str_copy(m_aKey, pKey, sizeof(m_aKey));
+	m_Cache.clear();
+	m_Pending.clear();
+	m_Generation++;
+	return true;
+}
+
+void CDnsbl::PruneCache(int64 Now)
+{
+	for(auto It = m_Cache.begin(); It != m_Cache.end();)
+	{
+		if(It->second.m_Expire <= Now)
+			It = m_Cache.erase(It);
+		else
+			++It;
+	}
+}
+
+int CDnsbl::Lookup(const NETADDR *pAddr, int64 Now)
+{
+	//TODO: support ipv6
+	if(pAddr->type != NETTYPE_IPV4)
+		return VERDICT_UNSUPPORTED;
+
+	NETADDR Addr = *pAddr;
+	Addr.port = 0;
+
+	auto Cached = m_Cache.find(Addr);
+	if(Cached != m_Cache.end())
+	{
+		if(Cached->second.m_Expire > Now)
+			return Cached->second.m_Listed ? VERDICT_LISTED : VERDICT_CLEAN;
+		m_Cache.erase(Cached);
+	}
+
+	// one lookup per address, every waiting client gets the result
+	if(m_Pending.count(Addr))
+		return VERDICT_PENDING;
+
+	// build dnsbl host lookup
+	char aQuery[256];
+	if(m_aKey[0] == '\0')
+	{
+		// without key
+		str_format(aQuery, sizeof(aQuery), "%d.%d.%d.%d.%s", Addr.ip[3], Addr.ip[2], Addr.ip[1], Addr.ip[0], m_aHost);
+	}
+	else
+	{
+		// with key
+		str_format(aQuery, sizeof(aQuery), "%s.%d.%d.%d.%d.%s", m_aKey, Addr.ip[3], Addr.ip[2], Addr.ip[1], Addr.ip[0], m_aHost);
+	}
+
+	m_Pending[Addr] = Now;
+	m_pEngine->AddJob(std::make_shared<CDnsblLookup>(m_pResolver, m_pCompletions, &Addr, m_Generation, aQuery));
+	return VERDICT_PENDING;
+}
@@ -0,0 +1,129 @@
+#ifndef ENGINE_SERVER_DNSBL_H
+#define ENGINE_SERVER_DNSBL_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class IEngine;
+
+// answers whether a dnsbl query name resolves, i.e. the address is listed
+class IDnsblResolver
+{
+public:
+	virtual ~IDnsblResolver() {}
+
+	// called on a job pool thread
+	virtual bool IsListed(const char *pQuery) = 0;
+};
+
+class CDnsblHostResolver : public IDnsblResolver
+{
+public:
+	bool IsListed(const char *pQuery) override;
+};
+
+// asynchronous dnsbl lookups with a verdict cache, results are collected
+// on the main thread with `Update`
+class CDnsbl
+{
+public:
+	enum
+	{
+		VERDICT_PENDING = 0,
+		VERDICT_LISTED,
+		VERDICT_CLEAN,
+		VERDICT_UNSUPPORTED,
+	};
+
+	struct CResult
+	{
+		NETADDR m_Addr;
+		bool m_Listed;
+		// the provider the lookup was started for
+		int m_Generation;
+	};
+
+	// shared with the lookup jobs, which may outlive this object
+	struct CCompletions
+	{
+		std::mutex m_Lock;
+		std::vector<CResult> m_vResults;
+		std::atomic<int> m_NumResults{0};
+	};
+
+private:
+	struct CAddrLess
+	{
+		bool operator()(const NETADDR &a, const NETADDR &b) const { return net_addr_comp_noport(&a, &b) < 0; }
+	};
+
+	struct CCacheEntry
+	{
+		bool m_Listed;
+		int64 m_Expire;
+	};
+
+	IEngine *m_pEngine = nullptr;
+	std::shared_ptr<IDnsblResolver> m_pResolver;
+	std::shared_ptr<CCompletions> m_pCompletions;
+
+	char m_aHost[128] = "";
+	char m_aKey[128] = "";
+	int m_CacheTime = 0;
+	// bumped on provider changes, older results are dropped
+	int m_Generation = 0;
+
+	std::map<NETADDR, CCacheEntry, CAddrLess> m_Cache;
+	std::map<NETADDR, int64, CAddrLess> m_Pending;
+
+	void PruneCache(int64 Now);
+
+public:
+	void Init(IEngine *pEngine, std::shared_ptr<IDnsblResolver> pResolver = nullptr);
+
+	// changing the provider drops the cached verdicts and the pending
+	// lookups, returns whether it changed
+	bool SetProvider(const char *pHost, const char *pKey, int CacheTime);
+
+	// returns the cached verdict or starts a lookup and returns `VERDICT_PENDING`
+	int Lookup(const NETADDR *pAddr, int64 Now);
+
+	// calls `Fn(const NETADDR *pAddr, bool Listed)` for every finished lookup
+	// of the current provider, returns the number of finished lookups. Cheap
+	// if none finished since the last call
+	template<class F>
+	int Update(int64 Now, F &&Fn)
+	{
+		if(m_pCompletions->m_NumResults.load(std::memory_order_acquire) == 0)
+			return 0;
+
+		std::vector<CResult> vResults;
+		{
+			std::unique_lock Lock(m_pCompletions->m_Lock);
+			vResults.swap(m_pCompletions->m_vResults);
+			m_pCompletions->m_NumResults.store(0, std::memory_order_relaxed);
+		}
+
+		if(m_Cache.size() >= 1024)
+			PruneCache(Now);
+		for(const CResult &Result : vResults)
+		{
+			if(Result.m_Generation != m_Generation)
+				continue;
+			m_Pending.erase(Result.m_Addr);
+			m_Cache[Result.m_Addr] = {Result.m_Listed, Now + (int64)m_CacheTime * time_freq()};
+			Fn(&Result.m_Addr, Result.m_Listed);
+		}
+		return vResults.size();
+	}
+
+	int NumCached() const { return m_Cache.size(); }
+	int NumPending() const { return m_Pending.size(); }
+};
+
+#endif
@@ -84,6 +84,8 @@ class CRegister : public IRegister
 				m_pRegister(std::move(pRegister)),
 				m_pHttp(pHttp)
 			{
+				// waits for the http request, don't hold up latency sensitive jobs
+				Priority(PRIORITY_BULK);
 			}
 			~CJob() override = default;
 		};
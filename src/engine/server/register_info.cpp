@@ -0,0 +1,213 @@
+#include "register_info.h"
+
+#include <engine/engine.h>
+#include <engine/shared/jsonwriter.h>
+
+bool CRegisterInfo::CInfo::operator==(const CInfo &Other) const
+{
+	return m_MaxClients == Other.m_MaxClients &&
+		m_MaxPlayers == Other.m_MaxPlayers &&
+		m_Passworded == Other.m_Passworded &&
+		str_comp(m_aGameType, Other.m_aGameType) == 0 &&
+		str_comp(m_aName, Other.m_aName) == 0 &&
+		str_comp(m_aMapName, Other.m_aMapName) == 0 &&
+		str_comp(m_aMapSha256, Other.m_aMapSha256) == 0 &&
+		m_MapSize == Other.m_MapSize &&
+		str_comp(m_aVersion, Other.m_aVersion) == 0;
+}
+
+bool CRegisterInfo::CClient::operator==(const CClient &Other) const
+{
+	if(str_comp(m_aName, Other.m_aName) != 0 ||
+		str_comp(m_aClan, Other.m_aClan) != 0 ||
+		m_Country != Other.m_Country ||
+		m_Score != Other.m_Score ||
+		m_IsPlayer != Other.m_IsPlayer ||
+		m_HasPlayerInfo != Other.m_HasPlayerInfo)
+		return false;
+	if(!m_HasPlayerInfo)
+		return true;
+
+	const CServerInfoPlayer &A = m_PlayerInfo;
+	const CServerInfoPlayer &B = Other.m_PlayerInfo;
+	return str_comp(A.m_aSkinName, B.m_aSkinName) == 0 &&
+		A.m_UseCustomColor == B.m_UseCustomColor &&
+		(!A.m_UseCustomColor || (A.m_ColorBody == B.m_ColorBody && A.m_ColorFeet == B.m_ColorFeet)) &&
+		A.m_Afk == B.m_Afk &&
+		A.m_Team == B.m_Team;
+}
+
+CRegisterInfo::CRegisterInfo() :
+	m_pCache(std::make_shared<CCache>())
+{
+}
+
+void CRegisterInfo::SetInfo(const CInfo &Info)
+{
+	if(m_Info == Info)
+		return;
+	m_Info = Info;
+	m_Changed = true;
+}
+
+void CRegisterInfo::SetClient(int ClientID, const CClient &Client)
+{
+	if(m_aVersions[ClientID] && m_aClients[ClientID] == Client)
+		return;
+	m_aClients[ClientID] = Client;
+	// never reuse a version, the cache may still hold an older entry
+	m_aVersions[ClientID] = m_NextVersion++;
+	m_Changed = true;
+}
+
+void CRegisterInfo::RemoveClient(int ClientID)
+{
+	if(!m_aVersions[ClientID])
+		return;
+	m_aVersions[ClientID] = 0;
+	m_Changed = true;
+}
+
+bool CRegisterInfo::Encode(IEngine *pEngine)
+{
+	if(!m_Changed || m_pJob)
+		return false;
+
+	std::shared_ptr<CJob> pJob = std::make_shared<CJob>();
+	pJob->m_Info = m_Info;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		pJob->m_aVersions[i] = m_aVersions[i];
+		// no job is running, the cache can be read here
+		if(m_aVersions[i] && m_pCache->m_aVersions[i] != m_aVersions[i])
+			pJob->m_vChanged.emplace_back(i, m_aClients[i]);
+	}
+	pJob->m_pCache = m_pCache;
+
+	m_Changed = false;
+	m_pJob = pJob;
+	pEngine->AddJob(std::move(pJob));
+	return true;
+}
+
+bool CRegisterInfo::PollResult(std::string *pResult)
+{
+	if(!m_pJob || m_pJob->State() != IJob::STATE_DONE)
+		return false;
+	*pResult = std::move(m_pJob->m_Result);
+	m_NumEncoded = m_pJob->m_vChanged.size();
+	m_pJob = nullptr;
+	return true;
+}
+
+void CRegisterInfo::WriteClient(CJsonWriter *pWriter, const CClient &Client)
+{
+	pWriter->BeginObject();
+
+	pWriter->WriteAttribute("name");
+	pWriter->WriteStrValue(Client.m_aName);
+
+	pWriter->WriteAttribute("clan");
+	pWriter->WriteStrValue(Client.m_aClan);
+
+	pWriter->WriteAttribute("country");
+	pWriter->WriteIntValue(Client.m_Country); // ISO 3166-1 numeric
+
+	pWriter->WriteAttribute("score");
+	pWriter->WriteIntValue(Client.m_Score);
+
+	pWriter->WriteAttribute("is_player");
+	pWriter->WriteBoolValue(Client.m_IsPlayer);
+
+	if(Client.m_HasPlayerInfo)
+	{
+		const CServerInfoPlayer &Player = Client.m_PlayerInfo;
+
+		pWriter->WriteAttribute("skin");
+		pWriter->BeginObject();
+
+		// 0.6
+		pWriter->WriteAttribute("name");
+		pWriter->WriteStrValue(Player.m_aSkinName);
+
+		if(Player.m_UseCustomColor)
+		{
+			pWriter->WriteAttribute("color_body");
+			pWriter->WriteIntValue(Player.m_ColorBody);
+
+			pWriter->WriteAttribute("color_feet");
+			pWriter->WriteIntValue(Player.m_ColorFeet);
+		}
+
+		pWriter->EndObject();
+
+		pWriter->WriteAttribute("afk");
+		pWriter->WriteBoolValue(Player.m_Afk);
+
+		pWriter->WriteAttribute("team");
+		pWriter->WriteIntValue(Player.m_Team);
+	}
+
+	pWriter->EndObject();
+}
+
+void CRegisterInfo::CJob::Run()
+{
+	CCache *pCache = m_pCache.get();
+	for(const auto &[ClientID, Client] : m_vChanged)
+	{
+		CJsonStringWriter Writer;
+		WriteClient(&Writer, Client);
+		pCache->m_aJson[ClientID] = Writer.GetOutputString();
+		pCache->m_aVersions[ClientID] = m_aVersions[ClientID];
+	}
+
+	CJsonStringWriter JsonWriter;
+
+	JsonWriter.BeginObject();
+	JsonWriter.WriteAttribute("max_clients");
+	JsonWriter.WriteIntValue(m_Info.m_MaxClients);
+
+	JsonWriter.WriteAttribute("max_players");
+	JsonWriter.WriteIntValue(m_Info.m_MaxPlayers);
+
+	JsonWriter.WriteAttribute("passworded");
+	JsonWriter.WriteBoolValue(m_Info.m_Passworded);
+
+	JsonWriter.WriteAttribute("game_type");
+	JsonWriter.WriteStrValue(m_Info.m_aGameType);
+
+	JsonWriter.WriteAttribute("name");
+	JsonWriter.WriteStrValue(m_Info.m_aName);
+
+	JsonWriter.WriteAttribute("map");
+	JsonWriter.BeginObject();
+	JsonWriter.WriteAttribute("name");
+	JsonWriter.WriteStrValue(m_Info.m_aMapName);
+	JsonWriter.WriteAttribute("sha256");
+	JsonWriter.WriteStrValue(m_Info.m_aMapSha256);
+	JsonWriter.WriteAttribute("size");
+	JsonWriter.WriteIntValue(m_Info.m_MapSize);
+	JsonWriter.EndObject();
+
+	JsonWriter.WriteAttribute("version");
+	JsonWriter.WriteStrValue(m_Info.m_aVersion);
+
+	JsonWriter.WriteAttribute("client_score_kind");
+	JsonWriter.WriteStrValue("points"); // "points" or "time"
+
+	JsonWriter.WriteAttribute("requires_login");
+	JsonWriter.WriteBoolValue(false);
+
+	JsonWriter.WriteAttribute("clients");
+	JsonWriter.BeginArray();
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_aVersions[i])
+			JsonWriter.WriteRawValue(pCache->m_aJson[i].c_str());
+	}
+	JsonWriter.EndArray();
+	JsonWriter.EndObject();
+
+	m_Result = JsonWriter.GetOutputString();
+}
@@ -0,0 +1,108 @@
+#ifndef ENGINE_SERVER_REGISTER_INFO_H
+#define ENGINE_SERVER_REGISTER_INFO_H
+
+#include <base/hash.h>
+#include <engine/server.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/protocol.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class IEngine;
+
+// structured server info for the master servers. The main thread keeps the
+// model up to date, the JSON is written on the job pool and only client
+// entries that changed since the last job are encoded again.
+class CRegisterInfo
+{
+public:
+	struct CInfo
+	{
+		int m_MaxClients = 0;
+		int m_MaxPlayers = 0;
+		bool m_Passworded = false;
+		char m_aGameType[32] = "";
+		char m_aName[128] = "";
+		char m_aMapName[IO_MAX_PATH_LENGTH] = "";
+		char m_aMapSha256[SHA256_MAXSTRSIZE] = "";
+		int m_MapSize = 0;
+		char m_aVersion[64] = "";
+
+		bool operator==(const CInfo &Other) const;
+		bool operator!=(const CInfo &Other) const { return !(*this == Other); }
+	};
+
+	struct CClient
+	{
+		char m_aName[MAX_NAME_LENGTH] = "";
+		char m_aClan[MAX_CLAN_LENGTH] = "";
+		int m_Country = -1;
+		int m_Score = 0;
+		bool m_IsPlayer = false;
+		bool m_HasPlayerInfo = false;
+		CServerInfoPlayer m_PlayerInfo = {};
+
+		bool operator==(const CClient &Other) const;
+		bool operator!=(const CClient &Other) const { return !(*this == Other); }
+	};
+
+private:
+	// encoded client entries, only touched by the running job. Shared with
+	// the jobs, which may outlive this object
+	struct CCache
+	{
+		unsigned m_aVersions[MAX_CLIENTS] = {0};
+		std::string m_aJson[MAX_CLIENTS];
+	};
+
+	class CJob : public IJob
+	{
+		void Run() override;
+
+	public:
+		CJob() { Priority(PRIORITY_BULK); }
+
+		CInfo m_Info;
+		// 0 if the client is not included
+		unsigned m_aVersions[MAX_CLIENTS];
+		std::vector<std::pair<int, CClient>> m_vChanged;
+		std::shared_ptr<CCache> m_pCache;
+
+		std::string m_Result;
+	};
+
+	CInfo m_Info;
+	CClient m_aClients[MAX_CLIENTS];
+	unsigned m_aVersions[MAX_CLIENTS] = {0};
+	unsigned m_NextVersion = 1;
+	bool m_Changed = true;
+
+	std::shared_ptr<CCache> m_pCache;
+	std::shared_ptr<CJob> m_pJob;
+	int m_NumEncoded = 0;
+
+public:
+	CRegisterInfo();
+
+	void SetInfo(const CInfo &Info);
+	void SetClient(int ClientID, const CClient &Client);
+	void RemoveClient(int ClientID);
+
+	// returns true until the result of the last job was polled
+	bool Busy() const { return m_pJob != nullptr; }
+	// starts encoding the current model on the job pool. Returns false if
+	// a job is still running or nothing changed since the last one
+	bool Encode(IEngine *pEngine);
+	// returns true once for every finished job
+	bool PollResult(std::string *pResult);
+
+	// number of client entries the last finished job had to encode
+	int NumEncodedClients() const { return m_NumEncoded; }
+
+	static void WriteClient(class CJsonWriter *pWriter, const CClient &Client);
+};
+
+#endif // ENGINE_SERVER_REGISTER_INFO_H
@@ -20,7 +20,6 @@
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
 #include <engine/shared/filecollection.h>
-#include <engine/shared/jsonwriter.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 #include <engine/shared/packer.h>
@@ -41,6 +40,7 @@
 #include <engine/shared/uuid_manager.h>
 
 #include "register.h"
+#include "shard.h"
 
 #if defined(CONF_FAMILY_WINDOWS)
 #include <windows.h>
@@ -143,6 +143,18 @@ void CServerBan::InitServerBan(IConsole *pConsole, IStorage *pStorage, CServer *
 	Console()->Register("ban", "s[ip|id] ?i[minutes] r[reason]", CFGFLAG_SERVER | CFGFLAG_STORE, ConBanExt, this, "Ban player with ip/client id for x minutes for any reason");
 	Console()->Register("ban_region", "s[region] s[ip|id] ?i[minutes] r[reason]", CFGFLAG_SERVER | CFGFLAG_STORE, ConBanRegion, this, "Ban player in a region");
 	Console()->Register("ban_region_range", "s[region] s[first ip] s[last ip] ?i[minutes] r[reason]", CFGFLAG_SERVER | CFGFLAG_STORE, ConBanRegionRange, this, "Ban range in a region");
+	Console()->Register("bans_import", "s[file] ?i[minutes] ?r[reason]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansImportExt, this, "Ban every ip, CIDR block or range (first - last) listed in a file, one per line (0 minutes = permanent)");
+}
+
+// the shard front keeps routing the banned addresses to this child
+static void SendTunnelBan(NETSOCKET Socket, const NETADDR *pAddr, int Seconds)
+{
+	CNetBase::SendTunnelBan(Socket, pAddr, pAddr, Seconds);
+}
+
+static void SendTunnelBan(NETSOCKET Socket, const CNetRange *pRange, int Seconds)
+{
+	CNetBase::SendTunnelBan(Socket, &pRange->m_LB, &pRange->m_UB, Seconds);
 }
 
 template<class T>
@@ -186,6 +198,8 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 	}
 
 	int Result = Ban(pBanPool, pData, Seconds, pReason);
+	if(Result >= 0 && CNetBase::Tunnelled())
+		SendTunnelBan(Server()->m_NetServer.Socket(), pData, Seconds);
 	if(Result != 0)
 		return Result;
 
@@ -198,9 +212,8 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 
 		if(NetMatch(&Data, Server()->m_NetServer.ClientAddr(i)))
 		{
-			CNetHash NetHash(&Data);
 			char aBuf[256];
-			MakeBanInfo(pBanPool->Find(&Data, &NetHash), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
+			MakeBanInfo(pBanPool->Find(&Data), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
 			Server()->m_NetServer.Drop(i, aBuf);
 		}
 	}
@@ -264,6 +277,23 @@ void CServerBan::ConBanRegionRange(IConsole::IResult *pResult, void *pUser)
 	ConBanRange(pResult, static_cast<CNetBan *>(pServerBan));
 }
 
+void CServerBan::ConBansImportExt(IConsole::IResult *pResult, void *pUser)
+{
+	CServerBan *pThis = static_cast<CServerBan *>(pUser);
+	ConBansImport(pResult, static_cast<CNetBan *>(pThis));
+
+	// the import doesn't go through BanExt, drop matching clients afterwards
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(pThis->Server()->m_aClients[i].m_State == CServer::CClient::STATE_EMPTY)
+			continue;
+
+		char aBuf[256];
+		if(pThis->IsBanned(pThis->Server()->m_NetServer.ClientAddr(i), aBuf, sizeof(aBuf)))
+			pThis->Server()->m_NetServer.Drop(i, aBuf);
+	}
+}
+
 void CServer::CClient::Reset()
 {
 	// reset input
@@ -314,6 +344,7 @@ CServer::CServer()
 	m_ServerInfoFirstRequest = 0;
 	m_ServerInfoNumRequests = 0;
 	m_ServerInfoNeedsUpdate = false;
+	m_RegisterInfoExpired = 0;
 
 #ifdef CONF_FAMILY_UNIX
 	m_ConnLoggingSocketCreated = false;
@@ -780,6 +811,8 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 					Packet.m_DataSize = pPack->Size();
 					Packet.m_ClientID = i;
 					m_NetServer.Send(&Packet);
+					if(g_Config.m_SvBandwidthStats)
+						m_BandwidthStats.OnSendMsg(i, GameServer()->GetDDRaceTeam(i), pMsg->m_System, pMsg->m_MsgID, Packet.m_DataSize);
 				}
 			}
 		}
@@ -801,7 +834,11 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 		}
 
 		if(!(Flags & MSGFLAG_NOSEND))
+		{
 			m_NetServer.Send(&Packet);
+			if(g_Config.m_SvBandwidthStats)
+				m_BandwidthStats.OnSendMsg(ClientID, GameServer()->GetDDRaceTeam(ClientID), pMsg->m_System, pMsg->m_MsgID, Packet.m_DataSize);
+		}
 	}
 
 	return 0;
@@ -878,11 +915,13 @@ void CServer::DoSnapshot()
 			int DeltaSize;
 
 			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
+			m_SnapshotBuilder.SetStats(g_Config.m_SvBandwidthStats ? m_BandwidthStats.SnapItemStats() : 0);
 
 			GameServer()->OnSnap(i);
 
 			// finish snapshot
 			SnapshotSize = m_SnapshotBuilder.Finish(pData);
+			m_SnapshotBuilder.SetStats(0);
 
 			if(m_aDemoRecorder[i].IsRecording())
 			{
@@ -921,7 +960,11 @@ void CServer::DoSnapshot()
 			// create delta
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+			m_SnapshotDelta.SetStats(g_Config.m_SvBandwidthStats ? m_BandwidthStats.DeltaItemStats() : 0);
+			DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData, m_SnapshotBuilder.UnchangedSince(), DeltaTick);
+			m_SnapshotDelta.SetStats(0);
+			if(g_Config.m_SvBandwidthStats)
+				m_BandwidthStats.CommitSnap(i, GameServer()->GetDDRaceTeam(i));
 
 			if(DeltaSize)
 			{
@@ -931,6 +974,7 @@ void CServer::DoSnapshot()
 				int NumPackets;
 
 				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
+				m_ServerMetrics.m_pSnapshotBytes->Observe(SnapshotSize);
 				NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
 
 				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
@@ -964,6 +1008,7 @@ void CServer::DoSnapshot()
 			}
 			else
 			{
+				m_ServerMetrics.m_pSnapshotBytes->Observe(0);
 				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
 				Msg.AddInt(m_CurrentGameTick);
 				Msg.AddInt(m_CurrentGameTick - DeltaTick);
@@ -1012,6 +1057,7 @@ int CServer::NewClientNoAuthCallback(int ClientID, void *pUser)
 
 	pThis->SendCapabilities(ClientID);
 	pThis->SendMap(ClientID);
+	pThis->InitDnsbl(ClientID);
 #if defined(CONF_FAMILY_UNIX)
 	pThis->SendConnLoggingCommand(OPEN_SESSION, pThis->m_NetServer.ClientAddr(ClientID));
 #endif
@@ -1038,11 +1084,13 @@ int CServer::NewClientCallback(int ClientID, void *pUser, bool Sixup)
 	pThis->m_aClients[ClientID].m_LoginAxiom = false;
 	memset(&pThis->m_aClients[ClientID].m_Addr, 0, sizeof(NETADDR));
 	pThis->m_aClients[ClientID].Reset();
+	pThis->m_BandwidthStats.ResetClient(ClientID);
 
 	pThis->GameServer()->OnClientEngineJoin(ClientID, Sixup);
 	pThis->Antibot()->OnEngineClientJoin(ClientID, Sixup);
 
 	pThis->m_aClients[ClientID].m_Sixup = Sixup;
+	pThis->InitDnsbl(ClientID);
 
 #if defined(CONF_FAMILY_UNIX)
 	pThis->SendConnLoggingCommand(OPEN_SESSION, pThis->m_NetServer.ClientAddr(ClientID));
@@ -1060,28 +1108,209 @@ int CServer::ClientCheckDisruptive(int ClientID, void *pUser)
 
 void CServer::InitDnsbl(int ClientID)
 {
-	NETADDR Addr = *m_NetServer.ClientAddr(ClientID);
+	if(!g_Config.m_SvDnsbl)
+		return;
 
-	//TODO: support ipv6
-	if(Addr.type != NETTYPE_IPV4)
+	m_Dnsbl.SetProvider(g_Config.m_SvDnsblHost, g_Config.m_SvDnsblKey, g_Config.m_SvDnsblCacheTime);
+	switch(m_Dnsbl.Lookup(m_NetServer.ClientAddr(ClientID), time_get()))
+	{
+	case CDnsbl::VERDICT_PENDING:
+		m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_PENDING;
+		break;
+	case CDnsbl::VERDICT_LISTED:
+		OnDnsblVerdict(ClientID, true);
+		break;
+	case CDnsbl::VERDICT_CLEAN:
+		OnDnsblVerdict(ClientID, false);
+		break;
+	}
+}
+
+void CServer::OnDnsblVerdict(int ClientID, bool Listed)
+{
+	if(!Listed)
+	{
+		// entry not found -> whitelisted
+		m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_WHITELISTED;
 		return;
+	}
+
+	// entry found -> blacklisted
+	m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_BLACKLISTED;
+
+	// console output
+	char aAddrStr[NETADDR_MAXSTRSIZE];
+	net_addr_str(m_NetServer.ClientAddr(ClientID), aAddrStr, sizeof(aAddrStr), true);
 
-	// build dnsbl host lookup
 	char aBuf[256];
-	if(g_Config.m_SvDnsblKey[0] == '\0')
+	str_format(aBuf, sizeof(aBuf), "ClientID=%d addr=<{%s}> secure=%s blacklisted", ClientID, aAddrStr, m_NetServer.HasSecurityToken(ClientID) ? "yes" : "no");
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "dnsbl", aBuf);
+
+	if(g_Config.m_SvDnsblBan)
+		m_NetServer.NetBan()->BanAddr(m_NetServer.ClientAddr(ClientID), 60 * 10, "VPN detected, try connecting without. Contact admin if mistaken");
+}
+
+void CServer::UpdateDnsbl()
+{
+	if(!g_Config.m_SvDnsbl)
 	{
-		// without key
-		str_format(aBuf, sizeof(aBuf), "%d.%d.%d.%d.%s", Addr.ip[3], Addr.ip[2], Addr.ip[1], Addr.ip[0], g_Config.m_SvDnsblHost);
+		m_DnsblEnabled = false;
+		return;
 	}
-	else
+
+	// clients connected before sv_dnsbl was enabled
+	if(!m_DnsblEnabled)
+	{
+		m_DnsblEnabled = true;
+		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		{
+			if(m_aClients[ClientID].m_State != CClient::STATE_EMPTY && m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_NONE)
+				InitDnsbl(ClientID);
+		}
+	}
+
+	// the lookups of a previous provider are dropped, start them again
+	if(m_Dnsbl.SetProvider(g_Config.m_SvDnsblHost, g_Config.m_SvDnsblKey, g_Config.m_SvDnsblCacheTime))
+	{
+		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		{
+			if(m_aClients[ClientID].m_State != CClient::STATE_EMPTY && m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_PENDING)
+				InitDnsbl(ClientID);
+		}
+	}
+
+	m_Dnsbl.Update(time_get(), [&](const NETADDR *pAddr, bool Listed) {
+		for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
+		{
+			if(m_aClients[ClientID].m_State != CClient::STATE_EMPTY &&
+				m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_PENDING &&
+				net_addr_comp_noport(m_NetServer.ClientAddr(ClientID), pAddr) == 0)
+				OnDnsblVerdict(ClientID, Listed);
+		}
+	});
+}
+
+void CServer::InitMetrics()
+{
+	CServerMetrics &M = m_ServerMetrics;
+	M.m_pTicks = m_Metrics.Counter("ddnet_ticks_total", "Game ticks simulated");
+	M.m_pTickDuration = m_Metrics.Histogram("ddnet_tick_duration_seconds", "Time spent in the game tick", {100, 250, 500, 1000, 2500, 5000, 10000, 20000, 50000}, 1e-6);
+	M.m_pSnapshotBytes = m_Metrics.Histogram("ddnet_snapshot_bytes", "Compressed snapshot delta size per client", {0, 64, 128, 256, 512, 1024, 2048, 4096, 8192});
+	M.m_pClients = m_Metrics.Gauge("ddnet_clients", "Connected clients, including those still loading");
+	M.m_pPlayers = m_Metrics.Gauge("ddnet_players", "Clients in game");
+	M.m_pSentPackets = m_Metrics.Counter("ddnet_net_sent_packets_total", "UDP packets sent");
+	M.m_pSentBytes = m_Metrics.Counter("ddnet_net_sent_bytes_total", "UDP bytes sent");
+	M.m_pRecvPackets = m_Metrics.Counter("ddnet_net_recv_packets_total", "UDP packets received");
+	M.m_pRecvBytes = m_Metrics.Counter("ddnet_net_recv_bytes_total", "UDP bytes received");
+	M.m_pResends = m_Metrics.Counter("ddnet_net_resent_chunks_total", "Vital chunks resent to clients");
+	M.m_pConnlessJunk = m_Metrics.Counter("ddnet_connless_junk_total", "Connectionless packets dropped as junk");
+	M.m_pConnlessLimited = m_Metrics.Counter("ddnet_connless_limited_total", "Connectionless packets dropped by the rate limit");
+	M.m_pJobQueue = m_Metrics.Gauge("ddnet_job_queue", "Jobs waiting for a worker thread");
+	static const char *s_apPriorityNames[] = {"latency", "bulk"};
+	static_assert(std::size(s_apPriorityNames) == IJob::NUM_PRIORITIES, "missing job priority names");
+	for(int i = 0; i < IJob::NUM_PRIORITIES; i++)
 	{
-		// with key
-		str_format(aBuf, sizeof(aBuf), "%s.%d.%d.%d.%d.%s", g_Config.m_SvDnsblKey, Addr.ip[3], Addr.ip[2], Addr.ip[1], Addr.ip[0], g_Config.m_SvDnsblHost);
+		char aName[64];
+		char aHelp[128];
+		str_format(aName, sizeof(aName), "ddnet_jobs_%s_done_total", s_apPriorityNames[i]);
+		str_format(aHelp, sizeof(aHelp), "Completed %s jobs", s_apPriorityNames[i]);
+		M.m_apJobsDone[i] = m_Metrics.Counter(aName, aHelp);
+		str_format(aName, sizeof(aName), "ddnet_jobs_%s_wait_microseconds_total", s_apPriorityNames[i]);
+		str_format(aHelp, sizeof(aHelp), "Time %s jobs spent queued", s_apPriorityNames[i]);
+		M.m_apJobWaitTime[i] = m_Metrics.Counter(aName, aHelp);
+		str_format(aName, sizeof(aName), "ddnet_jobs_%s_run_microseconds_total", s_apPriorityNames[i]);
+		str_format(aHelp, sizeof(aHelp), "Time spent running %s jobs", s_apPriorityNames[i]);
+		M.m_apJobRunTime[i] = m_Metrics.Counter(aName, aHelp);
+		str_format(aName, sizeof(aName), "ddnet_jobs_%s_max_run_microseconds", s_apPriorityNames[i]);
+		str_format(aHelp, sizeof(aHelp), "Longest %s job so far", s_apPriorityNames[i]);
+		M.m_apJobMaxRunTime[i] = m_Metrics.Gauge(aName, aHelp);
+	}
+	M.m_pSqlQueue = m_Metrics.Gauge("ddnet_sql_queue", "Database tasks waiting for a worker thread");
+	M.m_pJobsStolen = m_Metrics.Counter("ddnet_jobs_stolen_total", "Jobs a worker took from the queue of another worker");
+
+	net_stats(&M.m_LastNetStats);
+	M.m_LastResends = 0;
+	M.m_LastConnlessJunk = 0;
+	M.m_LastConnlessLimited = 0;
+	Kernel()->RequestInterface<IEngine>()->GetJobStats(&M.m_LastJobStats);
+	M.m_LastUpdate = time_get();
+
+	if(!g_Config.m_SvMetricsPort)
+		return;
+
+	NETADDR BindAddr;
+	if(!g_Config.m_SvMetricsBindaddr[0] || net_host_lookup(g_Config.m_SvMetricsBindaddr, &BindAddr, NETTYPE_ALL) != 0)
+	{
+		mem_zero(&BindAddr, sizeof(BindAddr));
+		BindAddr.type = NETTYPE_ALL;
 	}
+	BindAddr.port = g_Config.m_SvMetricsPort;
+
+	char aBuf[128];
+	if(m_MetricsExporter.Open(&m_Metrics, BindAddr))
+		str_format(aBuf, sizeof(aBuf), "serving metrics on %s:%d", g_Config.m_SvMetricsBindaddr, g_Config.m_SvMetricsPort);
+	else
+		str_format(aBuf, sizeof(aBuf), "couldn't open metrics port %d", g_Config.m_SvMetricsPort);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "metrics", aBuf);
+}
+
+void CServer::UpdateMetrics()
+{
+	CServerMetrics &M = m_ServerMetrics;
+	const int64 Now = time_get();
+	if(Now < M.m_LastUpdate + time_freq())
+		return;
+	M.m_LastUpdate = Now;
+
+	int NumClients = 0;
+	int NumPlayers = 0;
+	for(const auto &Client : m_aClients)
+	{
+		if(Client.m_State == CClient::STATE_EMPTY)
+			continue;
+		NumClients++;
+		if(Client.m_State == CClient::STATE_INGAME)
+			NumPlayers++;
+	}
+	M.m_pClients->Set(NumClients);
+	M.m_pPlayers->Set(NumPlayers);
+
+	// the system counters are ints and may wrap, the unsigned difference doesn't care
+	NETSTATS Stats;
+	net_stats(&Stats);
+	M.m_pSentPackets->Add((unsigned)Stats.sent_packets - (unsigned)M.m_LastNetStats.sent_packets);
+	M.m_pSentBytes->Add((unsigned)Stats.sent_bytes - (unsigned)M.m_LastNetStats.sent_bytes);
+	M.m_pRecvPackets->Add((unsigned)Stats.recv_packets - (unsigned)M.m_LastNetStats.recv_packets);
+	M.m_pRecvBytes->Add((unsigned)Stats.recv_bytes - (unsigned)M.m_LastNetStats.recv_bytes);
+	M.m_LastNetStats = Stats;
+
+	// resends of dropped connections are lost, count only the growth
+	const int64 NumResends = m_NetServer.NumResends();
+	if(NumResends > M.m_LastResends)
+		M.m_pResends->Add(NumResends - M.m_LastResends);
+	M.m_LastResends = NumResends;
+
+	const CNetConnlessFilter *pFilter = m_NetServer.ConnlessFilter();
+	M.m_pConnlessJunk->Add(pFilter->NumJunk() - M.m_LastConnlessJunk);
+	M.m_pConnlessLimited->Add(pFilter->NumLimited() - M.m_LastConnlessLimited);
+	M.m_LastConnlessJunk = pFilter->NumJunk();
+	M.m_LastConnlessLimited = pFilter->NumLimited();
 
 	IEngine *pEngine = Kernel()->RequestInterface<IEngine>();
-	pEngine->AddJob(m_aClients[ClientID].m_pDnsblLookup = std::make_shared<CHostLookup>(aBuf, NETTYPE_IPV4));
-	m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_PENDING;
+	M.m_pJobQueue->Set(pEngine->NumQueuedJobs());
+	CJobPool::CStats JobStats;
+	pEngine->GetJobStats(&JobStats);
+	for(int i = 0; i < IJob::NUM_PRIORITIES; i++)
+	{
+		M.m_apJobsDone[i]->Add(JobStats.m_aNumDone[i] - M.m_LastJobStats.m_aNumDone[i]);
+		M.m_apJobWaitTime[i]->Add((JobStats.m_aWaitTime[i] - M.m_LastJobStats.m_aWaitTime[i]) * 1000000 / time_freq());
+		M.m_apJobRunTime[i]->Add((JobStats.m_aRunTime[i] - M.m_LastJobStats.m_aRunTime[i]) * 1000000 / time_freq());
+		M.m_apJobMaxRunTime[i]->Set(JobStats.m_aMaxRunTime[i] * 1000000 / time_freq());
+	}
+	M.m_pJobsStolen->Add(JobStats.m_NumStolen - M.m_LastJobStats.m_NumStolen);
+	M.m_LastJobStats = JobStats;
+
+	M.m_pSqlQueue->Set(DbPool()->NumQueued());
 }
 
 #ifdef CONF_FAMILY_UNIX
@@ -1793,6 +2022,11 @@ void CServer::SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type)
 	SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless());
 }
 
+void CServer::ConnlessInfoCallback(const NETADDR *pAddr, int Token, int Type, void *pUser)
+{
+	static_cast<CServer *>(pUser)->SendServerInfoConnless(pAddr, Token, Type);
+}
+
 static inline int GetCacheIndex(int Type, bool SendClient)
 {
 	if(Type == SERVERINFO_INGAME)
@@ -1806,6 +2040,7 @@ static inline int GetCacheIndex(int Type, bool SendClient)
 CServer::CCache::CCache()
 {
 	m_Cache.clear();
+	m_Tick = -1;
 }
 
 CServer::CCache::~CCache()
@@ -1829,8 +2064,11 @@ void CServer::CCache::Clear()
 	m_Cache.clear();
 }
 
-void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
+void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 {
+	pCache->Clear();
+	pCache->m_Tick = m_CurrentGameTick;
+
 	// One chance to improve the protocol!
 	CPacker p;
 	char aBuf[256];
@@ -1850,7 +2088,6 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool Sen
 
 	p.Reset();
 
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
 #define ADD_INT(p, x) \
 	do \
 	{ \
@@ -1858,17 +2095,7 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool Sen
 		(p).AddString(aBuf, 0); \
 	} while(0)
 
-	switch(Type)
-	{
-	case SERVERINFO_EXTENDED: ADD_RAW(p, SERVERBROWSE_INFO_EXTENDED); break;
-	case SERVERINFO_64_LEGACY: ADD_RAW(p, SERVERBROWSE_INFO_64_LEGACY); break;
-	case SERVERINFO_VANILLA: ADD_RAW(p, SERVERBROWSE_INFO); break;
-	case SERVERINFO_INGAME: ADD_RAW(p, SERVERBROWSE_INFO); break;
-	default: dbg_assert(false, "unknown serverinfo type");
-	}
-
-	ADD_INT(p, Token);
-
+	// the header and the request token are added by SendServerInfo
 	p.AddString(GameServer()->Version(), 32);
 
 	const char *pMapName = GetMapName();
@@ -1934,21 +2161,9 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool Sen
 	int PrefixSize = p.Size();
 
 	CPacker q;
-	CNetChunk Packet;
-	int PacketsSent = 0;
 	int PlayersSent = 0;
-	Packet.m_ClientID = -1;
-	Packet.m_Address = *pAddr;
-	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 
-	#define SEND(size) \
-		do \
-		{ \
-			Packet.m_pData = q.Data(); \
-			Packet.m_DataSize = size; \
-			m_NetServer.Send(&Packet); \
-			PacketsSent++; \
-		} while(0)
+	#define SEND(size) pCache->AddChunk(q.Data(), size)
 
 	#define RESET() \
 		do \
@@ -2040,10 +2255,59 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool Sen
 	SEND(q.Size());
 	#undef SEND
 	#undef RESET
-	#undef ADD_RAW
 	#undef ADD_INT
 }
 
+void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
+{
+	// ingame info differs from vanilla in the name, it is only sent on changes
+	CCache IngameCache;
+	CCache *pCache = &IngameCache;
+	if(Type == SERVERINFO_INGAME)
+		CacheServerInfo(pCache, Type, SendClients);
+	else
+	{
+		// rebuilt at most once per tick, requests in between are answered from the cache
+		pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
+		if(pCache->m_Cache.empty() || pCache->m_Tick != m_CurrentGameTick)
+			CacheServerInfo(pCache, Type, SendClients);
+	}
+
+	char aToken[16];
+	str_format(aToken, sizeof(aToken), "%d", Token);
+	const int TokenSize = str_length(aToken) + 1;
+
+	CNetChunk Packet;
+	Packet.m_ClientID = -1;
+	Packet.m_Address = *pAddr;
+	Packet.m_Flags = NETSENDFLAG_CONNLESS;
+
+	bool First = true;
+	unsigned char aData[NET_MAX_PAYLOAD];
+	for(const CCache::CCacheChunk &Chunk : pCache->m_Cache)
+	{
+		// extended info only has the header in the first packet
+		int Size = 0;
+		if(First || Type != SERVERINFO_EXTENDED)
+		{
+			const unsigned char *pHeader = Type == SERVERINFO_EXTENDED ? SERVERBROWSE_INFO_EXTENDED :
+						       Type == SERVERINFO_64_LEGACY ? SERVERBROWSE_INFO_64_LEGACY :
+										      SERVERBROWSE_INFO;
+			mem_copy(aData, pHeader, sizeof(SERVERBROWSE_INFO));
+			mem_copy(aData + sizeof(SERVERBROWSE_INFO), aToken, TokenSize);
+			Size = sizeof(SERVERBROWSE_INFO) + TokenSize;
+		}
+		First = false;
+
+		if(Size + Chunk.m_DataSize > (int)sizeof(aData))
+			continue;
+		mem_copy(aData + Size, Chunk.m_aData, Chunk.m_DataSize);
+		Packet.m_pData = aData;
+		Packet.m_DataSize = Size + Chunk.m_DataSize;
+		m_NetServer.Send(&Packet);
+	}
+}
+
 void CServer::GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients)
 {
 	if(Token != -1)
@@ -2059,9 +2323,17 @@ void CServer::GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients)
 	pPacker->AddRaw(FirstChunk.m_aData, FirstChunk.m_DataSize);
 }
 
+void CServer::ResetRoomBandwidth(int Room)
+{
+	if(Room >= 0 && Room < MAX_CLIENTS)
+		m_BandwidthStats.ResetRoom(Room);
+}
+
 void CServer::ExpireServerInfo()
 {
 	m_ServerInfoNeedsUpdate = true;
+	for(auto &Cache : m_aServerInfoCache)
+		Cache.Clear();
 }
 
 void CServer::UpdateRegisterServerInfo()
@@ -2070,92 +2342,61 @@ void CServer::UpdateRegisterServerInfo()
 	int PlayerCount = 0, ClientCount = 0;
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(m_aClients[i].IncludedInServerInfo())
+		if(!m_aClients[i].IncludedInServerInfo())
 		{
-			if(GameServer()->IsClientPlayer(i))
-				PlayerCount++;
-
-			ClientCount++;
+			m_RegisterInfo.RemoveClient(i);
+			continue;
 		}
-	}
-
-	int MaxPlayers = std::max(m_NetServer.MaxClients(), PlayerCount);
-	int MaxClients = std::max(m_NetServer.MaxClients(), ClientCount);
-	char aMapSha256[SHA256_MAXSTRSIZE];
-
-	sha256_str(m_aCurrentMapSha256[SIX], aMapSha256, sizeof(aMapSha256));
-
-	CJsonStringWriter JsonWriter;
-
-	JsonWriter.BeginObject();
-	JsonWriter.WriteAttribute("max_clients");
-	JsonWriter.WriteIntValue(MaxClients);
-
-	JsonWriter.WriteAttribute("max_players");
-	JsonWriter.WriteIntValue(MaxPlayers);
-
-	JsonWriter.WriteAttribute("passworded");
-	JsonWriter.WriteBoolValue(g_Config.m_Password[0]);
 
-	JsonWriter.WriteAttribute("game_type");
-	JsonWriter.WriteStrValue(GameServer()->GameType());
+		CRegisterInfo::CClient Client;
+		str_copy(Client.m_aName, ClientName(i), sizeof(Client.m_aName));
+		str_copy(Client.m_aClan, ClientClan(i), sizeof(Client.m_aClan));
+		Client.m_Country = m_aClients[i].m_Country;
+		Client.m_Score = m_aClients[i].m_Score;
+		Client.m_IsPlayer = GameServer()->IsClientPlayer(i);
+		Client.m_HasPlayerInfo = GameServer()->OnUpdatePlayerServerInfo(&Client.m_PlayerInfo, i);
+		m_RegisterInfo.SetClient(i, Client);
 
-	JsonWriter.WriteAttribute("name");
-	JsonWriter.WriteStrValue(g_Config.m_SvName);
+		if(Client.m_IsPlayer)
+			PlayerCount++;
 
-	JsonWriter.WriteAttribute("map");
-	JsonWriter.BeginObject();
-	JsonWriter.WriteAttribute("name");
-	JsonWriter.WriteStrValue(GetMapName());
-	JsonWriter.WriteAttribute("sha256");
-	JsonWriter.WriteStrValue(aMapSha256);
-	JsonWriter.WriteAttribute("size");
-	JsonWriter.WriteIntValue(m_aCurrentMapSize[SIX]);
-	JsonWriter.EndObject();
-
-	JsonWriter.WriteAttribute("version");
-	JsonWriter.WriteStrValue(GameServer()->Version());
-
-	JsonWriter.WriteAttribute("client_score_kind");
-	JsonWriter.WriteStrValue("points"); // "points" or "time"
+		ClientCount++;
+	}
 
-	JsonWriter.WriteAttribute("requires_login");
-	JsonWriter.WriteBoolValue(false);
+	CRegisterInfo::CInfo Info;
+	Info.m_MaxClients = std::max(m_NetServer.MaxClients(), ClientCount);
+	Info.m_MaxPlayers = std::max(m_NetServer.MaxClients(), PlayerCount);
+	Info.m_Passworded = g_Config.m_Password[0];
+	str_copy(Info.m_aGameType, GameServer()->GameType(), sizeof(Info.m_aGameType));
+	str_copy(Info.m_aName, g_Config.m_SvName, sizeof(Info.m_aName));
+	str_copy(Info.m_aMapName, GetMapName(), sizeof(Info.m_aMapName));
+	sha256_str(m_aCurrentMapSha256[SIX], Info.m_aMapSha256, sizeof(Info.m_aMapSha256));
+	Info.m_MapSize = m_aCurrentMapSize[SIX];
+	str_copy(Info.m_aVersion, GameServer()->Version(), sizeof(Info.m_aVersion));
+	m_RegisterInfo.SetInfo(Info);
 
-	JsonWriter.WriteAttribute("clients");
-	JsonWriter.BeginArray();
+	// the JSON is written on the job pool, see `PumpRegisterInfo`
+	m_RegisterInfo.Encode(Kernel()->RequestInterface<IEngine>());
+}
 
-	for(int i = 0; i < MAX_CLIENTS; i++)
+void CServer::PumpRegisterInfo()
+{
+	std::string Info;
+	if(m_RegisterInfo.PollResult(&Info))
 	{
-		if(m_aClients[i].IncludedInServerInfo())
-		{
-			JsonWriter.BeginObject();
-
-			JsonWriter.WriteAttribute("name");
-			JsonWriter.WriteStrValue(ClientName(i));
-
-			JsonWriter.WriteAttribute("clan");
-			JsonWriter.WriteStrValue(ClientClan(i));
-
-			JsonWriter.WriteAttribute("country");
-			JsonWriter.WriteIntValue(m_aClients[i].m_Country); // ISO 3166-1 numeric
-
-			JsonWriter.WriteAttribute("score");
-			JsonWriter.WriteIntValue(m_aClients[i].m_Score);
-
-			JsonWriter.WriteAttribute("is_player");
-			JsonWriter.WriteBoolValue(GameServer()->IsClientPlayer(i));
-
-			GameServer()->OnUpdatePlayerServerInfo(&JsonWriter, i);
-
-			JsonWriter.EndObject();
-		}
+		m_pRegister->OnNewInfo(Info.c_str());
+		// the front registers for all of its children
+		if(CNetBase::Tunnelled())
+			CNetBase::SendTunnelInfo(m_NetServer.Socket(), Info.c_str());
 	}
 
-	JsonWriter.EndArray();
-	JsonWriter.EndObject();
-
-	m_pRegister->OnNewInfo(JsonWriter.GetOutputString().c_str());
+	// collect changes for a while, e.g. a room mode change followed by the
+	// players joining it
+	if(m_RegisterInfoExpired && !m_RegisterInfo.Busy() && time_get() >= m_RegisterInfoExpired + g_Config.m_SvRegisterInfoDelay * time_freq() / 1000)
+	{
+		UpdateRegisterServerInfo();
+		m_RegisterInfoExpired = 0;
+	}
 }
 
 void CServer::UpdateServerInfo(bool Resend)
@@ -2163,7 +2404,8 @@ void CServer::UpdateServerInfo(bool Resend)
 	if(!m_pRegister || m_RunServer == false)
 		return;
 
-	UpdateRegisterServerInfo();
+	if(!m_RegisterInfoExpired)
+		m_RegisterInfoExpired = time_get();
 
 	if(Resend)
 	{
@@ -2193,39 +2435,9 @@ void CServer::PumpNetwork(bool PacketWaiting)
 		{
 			if(ResponseToken == NET_SECURITY_TOKEN_UNKNOWN && m_pRegister->OnPacket(&Packet))
 				continue;
-			if(Packet.m_DataSize >= int(sizeof(SERVERBROWSE_GETINFO)) &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
-			{
-				// stateless
-				int ExtraToken = 0;
-				int Type = -1;
-				if(Packet.m_DataSize >= (int)sizeof(SERVERBROWSE_GETINFO) + 1 &&
-					mem_comp(Packet.m_pData, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
-				{
-					if(Packet.m_Flags & NETSENDFLAG_EXTENDED)
-					{
-						Type = SERVERINFO_EXTENDED;
-						ExtraToken = (Packet.m_aExtraData[0] << 8) | Packet.m_aExtraData[1];
-					}
-					else
-						Type = SERVERINFO_VANILLA;
-				}
-				else if(Packet.m_DataSize >= (int)sizeof(SERVERBROWSE_GETINFO_64_LEGACY) + 1 &&
-						mem_comp(Packet.m_pData, SERVERBROWSE_GETINFO_64_LEGACY, sizeof(SERVERBROWSE_GETINFO_64_LEGACY)) == 0)
-				{
-					Type = SERVERINFO_64_LEGACY;
-				}
-				if(Type != -1)
-				{
-					int Token = ((unsigned char *)Packet.m_pData)[sizeof(SERVERBROWSE_GETINFO)];
-					Token |= ExtraToken << 8;
-					SendServerInfoConnless(&Packet.m_Address, Token, Type);
-				}
-			}
-			else
-			{
-				ProcessClientPacket(&Packet);
-			}
+
+			// server info requests are answered by the network layer already
+			ProcessClientPacket(&Packet);
 		}
 	}
 
@@ -2382,6 +2594,7 @@ int CServer::Run()
 			DbPool()->RegisterDatabase(std::move(pCopy), CDbConnectionPool::WRITE);
 		}
 	}
+	DbPool()->Start(g_Config.m_SvSqlReadWorkers, g_Config.m_SvSqlWriteWorkers, g_Config.m_SvSqlWriteBatch);
 
 	// start server
 	NETADDR BindAddr;
@@ -2409,6 +2622,14 @@ int CServer::Run()
 	m_UPnP.Open(BindAddr);
 #endif
 
+	if(g_Config.m_SvShardFront)
+	{
+		NETADDR FrontAddr;
+		net_addr_from_str(&FrontAddr, "127.0.0.1");
+		FrontAddr.port = g_Config.m_SvShardFront;
+		CNetBase::SetTunnel(&FrontAddr);
+	}
+
 	if(Port == 0)
 		dbg_msg("server", "using port %d", BindAddr.port);
 
@@ -2417,6 +2638,10 @@ int CServer::Run()
 #endif
 
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, ClientCheckDisruptive, this);
+	m_NetServer.SetConnlessInfoCallback(ConnlessInfoCallback, this);
+
+	if(g_Config.m_SvNetThread)
+		m_NetServer.StartRecvThread();
 
 	if(!m_Http.Init(std::chrono::seconds{2}, &g_Config))
 	{
@@ -2424,8 +2649,11 @@ int CServer::Run()
 		return -1;
 	}
 
+	m_Dnsbl.Init(Kernel()->RequestInterface<IEngine>());
+	m_DnsblEnabled = false;
 	m_pRegister = CreateRegister(&g_Config, m_pConsole, Kernel()->RequestInterface<IEngine>(), &m_Http, g_Config.m_SvPort, NET_SECURITY_TOKEN_UNSUPPORTED);
 	m_Econ.Init(Config(), Console(), &m_ServerBan);
+	InitMetrics();
 
 #if defined(CONF_FAMILY_UNIX)
 	m_Fifo.Init(Console(), g_Config.m_SvInputFifo, CFGFLAG_SERVER);
@@ -2529,48 +2757,9 @@ int CServer::Run()
 			}
 
 			// handle dnsbl
-			if(g_Config.m_SvDnsbl)
-			{
-				for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
-				{
-					if(m_aClients[ClientID].m_State == CClient::STATE_EMPTY)
-						continue;
+			UpdateDnsbl();
 
-					if(m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_NONE)
-					{
-						// initiate dnsbl lookup
-						InitDnsbl(ClientID);
-					}
-					else if(m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_PENDING &&
-						m_aClients[ClientID].m_pDnsblLookup->State() == IJob::STATE_DONE)
-					{
-						if(m_aClients[ClientID].m_pDnsblLookup->m_Result != 0)
-						{
-							// entry not found -> whitelisted
-							m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_WHITELISTED;
-						}
-						else
-						{
-							// entry found -> blacklisted
-							m_aClients[ClientID].m_DnsblState = CClient::DNSBL_STATE_BLACKLISTED;
-
-							// console output
-							char aAddrStr[NETADDR_MAXSTRSIZE];
-							net_addr_str(m_NetServer.ClientAddr(ClientID), aAddrStr, sizeof(aAddrStr), true);
-
-							char aBuf[256];
-
-							str_format(aBuf, sizeof(aBuf), "ClientID=%d addr=<{%s}> secure=%s blacklisted", ClientID, aAddrStr, m_NetServer.HasSecurityToken(ClientID) ? "yes" : "no");
-
-							Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "dnsbl", aBuf);
-						}
-					}
-
-					if(m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_BLACKLISTED &&
-						g_Config.m_SvDnsblBan)
-						m_NetServer.NetBan()->BanAddr(m_NetServer.ClientAddr(ClientID), 60 * 10, "VPN detected, try connecting without. Contact admin if mistaken");
-				}
-			}
+			UpdateMetrics();
 
 			while(t > TickStartTime(m_CurrentGameTick + 1))
 			{
@@ -2598,7 +2787,10 @@ int CServer::Run()
 					}
 				}
 
+				const int64 TickStart = time_get();
 				GameServer()->OnTick();
+				m_ServerMetrics.m_pTicks->Add();
+				m_ServerMetrics.m_pTickDuration->Observe((time_get() - TickStart) * 1000000 / time_freq());
 				if(ErrorShutdown())
 				{
 					break;
@@ -2616,6 +2808,9 @@ int CServer::Run()
 #if defined(CONF_FAMILY_UNIX)
 				m_Fifo.Update();
 #endif
+
+				if(g_Config.m_SvBandwidthStats)
+					m_BandwidthStats.DumpCsv(Storage(), g_Config.m_SvBandwidthStatsFile, g_Config.m_SvBandwidthStatsDump);
 			}
 
 			// master server stuff
@@ -2623,6 +2818,13 @@ int CServer::Run()
 
 			if(m_ServerInfoNeedsUpdate)
 				UpdateServerInfo();
+			PumpRegisterInfo();
+
+			if(CNetBase::Tunnelled() && time_get() > CNetBase::TunnelHeartbeat() + CNetTunnel::HEARTBEAT_TIMEOUT * time_freq())
+			{
+				dbg_msg("server", "lost the shard front, shutting down");
+				m_RunServer = STOPPING;
+			}
 
 			Antibot()->OnEngineTick();
 
@@ -2652,7 +2854,7 @@ int CServer::Run()
 				if(g_Config.m_SvShutdownWhenEmpty)
 					m_RunServer = STOPPING;
 				else
-					PacketWaiting = net_socket_read_wait(m_NetServer.Socket(), 1000000);
+					PacketWaiting = m_NetServer.Wait(1000000);
 			}
 			else
 			{
@@ -2662,7 +2864,7 @@ int CServer::Run()
 				int64 t = time_get();
 				int x = (TickStartTime(m_CurrentGameTick + 1) - t) * 1000000 / time_freq() + 1;
 
-				PacketWaiting = x > 0 ? net_socket_read_wait(m_NetServer.Socket(), x) : true;
+				PacketWaiting = x > 0 ? m_NetServer.Wait(x) : true;
 			}
 		}
 	}
@@ -2681,7 +2883,12 @@ int CServer::Run()
 
 	m_NetServer.Close();
 	m_pRegister->OnShutdown();
+
+	// flush the demos that are still queued
+	for(auto &Recorder : m_aDemoRecorder)
+		Recorder.Stop();
 	m_Econ.Shutdown();
+	m_MetricsExporter.Close();
 	m_Http.Shutdown();
 
 #if defined(CONF_FAMILY_UNIX)
@@ -2781,6 +2988,15 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 		}
 		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 	}
+
+	if(pThis->m_NetServer.HasRecvThread())
+	{
+		str_format(aBuf, sizeof(aBuf), "network thread: queued=%d dropped=%d", pThis->m_NetServer.RecvThread()->NumQueued(), pThis->m_NetServer.RecvThread()->NumDropped());
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+
+	str_format(aBuf, sizeof(aBuf), "connless: junk=%d rate limited=%d", pThis->m_NetServer.ConnlessFilter()->NumJunk(), pThis->m_NetServer.ConnlessFilter()->NumLimited());
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 }
 
 static int GetAuthLevel(const char *pLevel)
@@ -3052,6 +3268,39 @@ void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConBandwidthStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	if(!g_Config.m_SvBandwidthStats)
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", "bandwidth accounting is disabled, enable it with sv_bandwidth_stats 1");
+
+	if(pResult->NumArguments() < 2)
+	{
+		pThis->m_BandwidthStats.PrintGlobal(pThis->Console());
+		return;
+	}
+
+	const char *pScope = pResult->GetString(0);
+	int ID = pResult->GetInteger(1);
+	if(ID < 0 || ID >= MAX_CLIENTS)
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", "invalid id");
+		return;
+	}
+
+	if(!str_comp_nocase(pScope, "client"))
+		pThis->m_BandwidthStats.PrintClient(pThis->Console(), ID);
+	else if(!str_comp_nocase(pScope, "room"))
+		pThis->m_BandwidthStats.PrintRoom(pThis->Console(), ID);
+	else
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "bandwidth", "scope must be 'client' or 'room'");
+}
+
+void CServer::ConBandwidthReset(IConsole::IResult *pResult, void *pUser)
+{
+	static_cast<CServer *>(pUser)->m_BandwidthStats.Reset();
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_RunServer = STOPPING;
@@ -3066,6 +3315,7 @@ void CServer::DemoRecorder_HandleAutoStart()
 		char aDate[20];
 		str_timestamp(aDate, sizeof(aDate));
 		str_format(aFilename, sizeof(aFilename), "demos/%s_%s.demo", "auto/autorecord", aDate);
+		m_aDemoRecorder[MAX_CLIENTS].SetAsync(g_Config.m_SvDemoAsyncBuffer * 1024);
 		m_aDemoRecorder[MAX_CLIENTS].Start(Storage(), m_pConsole, aFilename, GameServer()->NetVersion(), m_aCurrentMap, &m_aCurrentMapSha256[SIX], m_aCurrentMapCrc[SIX], "server", m_aCurrentMapSize[SIX], m_apCurrentMapData[SIX]);
 		if(g_Config.m_SvAutoDemoMax)
 		{
@@ -3102,6 +3352,7 @@ void CServer::StartRecord(int ClientID)
 	{
 		char aFilename[128];
 		str_format(aFilename, sizeof(aFilename), "demos/%s_%d_%d_tmp.demo", m_aCurrentMap, m_NetServer.Address().port, ClientID);
+		m_aDemoRecorder[ClientID].SetAsync(g_Config.m_SvDemoAsyncBuffer * 1024);
 		m_aDemoRecorder[ClientID].Start(Storage(), Console(), aFilename, GameServer()->NetVersion(), m_aCurrentMap, &m_aCurrentMapSha256[SIX], m_aCurrentMapCrc[SIX], "server", m_aCurrentMapSize[SIX], m_apCurrentMapData[SIX]);
 	}
 }
@@ -3136,6 +3387,7 @@ void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 		str_timestamp(aDate, sizeof(aDate));
 		str_format(aFilename, sizeof(aFilename), "demos/demo_%s.demo", aDate);
 	}
+	pServer->m_aDemoRecorder[MAX_CLIENTS].SetAsync(g_Config.m_SvDemoAsyncBuffer * 1024);
 	pServer->m_aDemoRecorder[MAX_CLIENTS].Start(pServer->Storage(), pServer->Console(), aFilename, pServer->GameServer()->NetVersion(), pServer->m_aCurrentMap, &pServer->m_aCurrentMapSha256[SIX], pServer->m_aCurrentMapCrc[SIX], "server", pServer->m_aCurrentMapSize[SIX], pServer->m_apCurrentMapData[SIX]);
 }
 
@@ -3144,6 +3396,37 @@ void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->m_aDemoRecorder[MAX_CLIENTS].Stop();
 }
 
+void CServer::ConDemoWriterStatus(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pServer = (CServer *)pUser;
+	char aBuf[256];
+	for(int i = 0; i < MAX_CLIENTS + 1; i++)
+	{
+		const CDemoRecorder &Recorder = pServer->m_aDemoRecorder[i];
+		if(!Recorder.IsRecording())
+			continue;
+
+		char aName[32];
+		if(i == MAX_CLIENTS)
+			str_copy(aName, "server", sizeof(aName));
+		else
+			str_format(aName, sizeof(aName), "client %d", i);
+
+		if(!Recorder.IsAsync())
+		{
+			str_format(aBuf, sizeof(aBuf), "%s: synchronous", aName);
+		}
+		else
+		{
+			CDemoRecorder::CWriterStats Stats;
+			Recorder.GetWriterStats(&Stats);
+			str_format(aBuf, sizeof(aBuf), "%s: queued=%d peak=%d/%d bytes records=%lld sync=%lld",
+				aName, Stats.m_QueuedBytes, Stats.m_PeakBytes, Stats.m_BufferSize, Stats.m_NumRecords, Stats.m_NumSync);
+		}
+		pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
+	}
+}
+
 void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_MapReload = true;
@@ -3264,6 +3547,13 @@ void CServer::ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pU
 		((CServer *)pUserData)->m_NetServer.SetMaxClientsPerIP(pResult->GetInteger(0));
 }
 
+void CServer::ConchainJobThreadsUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments())
+		((CServer *)pUserData)->Kernel()->RequestInterface<IEngine>()->SetNumJobThreads(g_Config.m_SvJobThreads);
+}
+
 void CServer::ConchainCommandAccessUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	if(pResult->NumArguments() == 2)
@@ -3449,11 +3739,14 @@ void CServer::RegisterCommands()
 	Console()->Register("kick", "i[id] ?r[reason]", CFGFLAG_SERVER, ConKick, this, "Kick player with specified id for any reason");
 	Console()->Register("status", "?r[name]", CFGFLAG_SERVER, ConStatus, this, "List players containing name or all players");
 	Console()->Register("shutdown", "", CFGFLAG_SERVER, ConShutdown, this, "Shut down");
+	Console()->Register("bandwidth_stats", "?s['client'|'room'] ?i[id]", CFGFLAG_SERVER, ConBandwidthStats, this, "Show outgoing bytes by snapshot item type and message, globally or for a client or room");
+	Console()->Register("bandwidth_reset", "", CFGFLAG_SERVER, ConBandwidthReset, this, "Reset the bandwidth accounting counters");
 	Console()->Register("logout", "", CFGFLAG_SERVER, ConLogout, this, "Logout of rcon");
 	Console()->Register("show_ips", "?i[show]", CFGFLAG_SERVER, ConShowIps, this, "Show IP addresses in rcon commands (1 = on, 0 = off)");
 
 	Console()->Register("record", "?s[file]", CFGFLAG_SERVER | CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
+	Console()->Register("demo_writer_status", "", CFGFLAG_SERVER, ConDemoWriterStatus, this, "Show the backlog of the asynchronous demo writers");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
 
@@ -3475,6 +3768,7 @@ void CServer::RegisterCommands()
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
 
 	Console()->Chain("sv_max_clients_per_ip", ConchainMaxclientsperipUpdate, this);
+	Console()->Chain("sv_job_threads", ConchainJobThreadsUpdate, this);
 	Console()->Chain("access_level", ConchainCommandAccessUpdate, this);
 	Console()->Chain("console_output_level", ConchainConsoleOutputLevelUpdate, this);
 
@@ -3501,14 +3795,14 @@ void CServer::SnapFreeID(int ID)
 	m_IDPool.FreeID(ID);
 }
 
-void *CServer::SnapNewItem(int Type, int ID, int Size)
+void *CServer::SnapNewItem(int Type, int ID, int Size, int UnchangedSince)
 {
 	if(Type > 0xffff)
 	{
 		g_UuidManager.GetUuid(Type);
 	}
 	dbg_assert(ID >= 0 && ID <= 0xffff, "incorrect id");
-	return ID < 0 ? 0 : m_SnapshotBuilder.NewItem(Type, ID, Size);
+	return ID < 0 ? 0 : m_SnapshotBuilder.NewItem(Type, ID, Size, UnchangedSince);
 }
 
 void CServer::SnapSetStaticsize(int ItemType, int Size)
@@ -3606,8 +3900,19 @@ int main(int argc, const char **argv) // ignore_convention
 	pEngine->InitLogfile();
 
 	// run the server
-	dbg_msg("server", "starting...");
-	int Ret = pServer->Run();
+	int Ret;
+	if(g_Config.m_SvShards > 0)
+	{
+		dbg_msg("server", "starting shard front...");
+		CShardFront *pFront = new CShardFront(pConsole, pEngine);
+		Ret = pFront->Run(argc, argv); // ignore_convention
+		delete pFront;
+	}
+	else
+	{
+		dbg_msg("server", "starting...");
+		Ret = pServer->Run();
+	}
 
 	MysqlUninit();
 
@@ -3667,7 +3972,7 @@ const char *CServer::GetAnnouncementLine(char const *pFileName)
 
 int *CServer::GetIdMap(int ClientID)
 {
-	return m_aIdMap + VANILLA_MAX_CLIENTS * ClientID;
+	return m_aIdMap + MAX_ID_MAP * ClientID;
 }
 
 bool CServer::SetTimedOut(int ClientID, int OrigID)
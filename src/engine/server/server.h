@@ -17,6 +17,7 @@
 #include <engine/shared/fifo.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/http.h>
+#include <engine/shared/metrics.h>
 #include <engine/shared/network.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
@@ -28,7 +29,10 @@
 
 #include "antibot.h"
 #include "authmanager.h"
+#include "bandwidth.h"
+#include "dnsbl.h"
 #include "name_ban.h"
+#include "register_info.h"
 
 #if defined(CONF_UPNP)
 #include "upnp.h"
@@ -85,6 +89,7 @@ public:
 	static void ConBanExt(class IConsole::IResult *pResult, void *pUser);
 	static void ConBanRegion(class IConsole::IResult *pResult, void *pUser);
 	static void ConBanRegionRange(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansImportExt(class IConsole::IResult *pResult, void *pUser);
 };
 
 class CServer : public IServer
@@ -202,7 +207,6 @@ public:
 
 		// DNSBL
 		int m_DnsblState;
-		std::shared_ptr<CHostLookup> m_pDnsblLookup;
 
 		bool m_Sixup;
 		bool m_DisruptiveLeave;
@@ -213,7 +217,7 @@ public:
 	};
 
 	CClient m_aClients[MAX_CLIENTS];
-	int m_aIdMap[MAX_CLIENTS * VANILLA_MAX_CLIENTS];
+	int m_aIdMap[MAX_CLIENTS * MAX_ID_MAP];
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
@@ -225,6 +229,42 @@ public:
 #endif
 	CServerBan m_ServerBan;
 	CHttp m_Http;
+	CBandwidthStats m_BandwidthStats;
+	CDnsbl m_Dnsbl;
+	bool m_DnsblEnabled;
+	CMetrics m_Metrics;
+	CMetricsExporter m_MetricsExporter;
+
+	struct CServerMetrics
+	{
+		CMetricCounter *m_pTicks;
+		CMetricHistogram *m_pTickDuration;
+		CMetricHistogram *m_pSnapshotBytes;
+		CMetricGauge *m_pClients;
+		CMetricGauge *m_pPlayers;
+		CMetricCounter *m_pSentPackets;
+		CMetricCounter *m_pSentBytes;
+		CMetricCounter *m_pRecvPackets;
+		CMetricCounter *m_pRecvBytes;
+		CMetricCounter *m_pResends;
+		CMetricCounter *m_pConnlessJunk;
+		CMetricCounter *m_pConnlessLimited;
+		CMetricGauge *m_pJobQueue;
+		CMetricCounter *m_apJobsDone[IJob::NUM_PRIORITIES];
+		CMetricCounter *m_apJobWaitTime[IJob::NUM_PRIORITIES];
+		CMetricCounter *m_apJobRunTime[IJob::NUM_PRIORITIES];
+		CMetricGauge *m_apJobMaxRunTime[IJob::NUM_PRIORITIES];
+		CMetricCounter *m_pJobsStolen;
+		CMetricGauge *m_pSqlQueue;
+
+		// last totals of the sources that only offer running totals
+		NETSTATS m_LastNetStats;
+		int64 m_LastResends;
+		int m_LastConnlessJunk;
+		int m_LastConnlessLimited;
+		CJobPool::CStats m_LastJobStats;
+		int64 m_LastUpdate;
+	} m_ServerMetrics;
 
 	IEngineMap *m_pMap;
 
@@ -356,6 +396,7 @@ public:
 		};
 
 		std::list<CCacheChunk> m_Cache;
+		int m_Tick; // game tick the chunks were built in
 
 		CCache();
 		~CCache();
@@ -366,13 +407,20 @@ public:
 	CCache m_aServerInfoCache[3 * 2];
 	CCache m_aSixupServerInfoCache[2];
 	bool m_ServerInfoNeedsUpdate;
+	CRegisterInfo m_RegisterInfo;
+	// time of the oldest change not yet sent to the master servers, 0 if none
+	int64 m_RegisterInfoExpired;
 
 	void UpdateRegisterServerInfo();
+	void PumpRegisterInfo();
 	void ExpireServerInfo();
+	void ResetRoomBandwidth(int Room);
+	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
 	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
 	void GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients);
 	bool RateLimitServerInfoConnless();
 	void SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type);
+	static void ConnlessInfoCallback(const NETADDR *pAddr, int Token, int Type, void *pUser);
 	void UpdateServerInfo(bool Resend = false);
 
 	void PumpNetwork(bool PacketWaiting);
@@ -392,8 +440,11 @@ public:
 	static void ConKick(IConsole::IResult *pResult, void *pUser);
 	static void ConStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
+	static void ConBandwidthStats(IConsole::IResult *pResult, void *pUser);
+	static void ConBandwidthReset(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConDemoWriterStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
@@ -415,6 +466,7 @@ public:
 
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainJobThreadsUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainCommandAccessUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainConsoleOutputLevelUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMapUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -435,7 +487,7 @@ public:
 
 	virtual int SnapNewID();
 	virtual void SnapFreeID(int ID);
-	virtual void *SnapNewItem(int Type, int ID, int Size);
+	virtual void *SnapNewItem(int Type, int ID, int Size, int UnchangedSince = -1);
 	void SnapSetStaticsize(int ItemType, int Size);
 
 	// DDRace
@@ -448,7 +500,13 @@ public:
 
 	virtual int *GetIdMap(int ClientID);
 
+	void InitMetrics();
+	void UpdateMetrics();
+	CMetrics *Metrics() override { return &m_Metrics; }
+
 	void InitDnsbl(int ClientID);
+	void OnDnsblVerdict(int ClientID, bool Listed);
+	void UpdateDnsbl();
 	bool DnsblWhite(int ClientID)
 	{
 		return m_aClients[ClientID].m_DnsblState == CClient::DNSBL_STATE_NONE ||
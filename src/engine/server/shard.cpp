@@ -0,0 +1,602 @@
+#include "shard.h"
+
+#include "register.h"
+
+#include <engine/shared/config.h>
+#include <engine/shared/json.h>
+#include <engine/shared/jsonwriter.h>
+
+#include <algorithm>
+#include <csignal>
+
+static volatile sig_atomic_t s_Interrupted = 0;
+
+static void HandleInterrupt(int Signal)
+{
+	s_Interrupted = 1;
+}
+
+void CShardRoutes::Init(int NumShards)
+{
+	m_Routes.clear();
+	m_vShards.assign(NumShards, CShardState());
+	m_vpPins.clear();
+	m_Pins.Clear();
+}
+
+unsigned CShardRoutes::Weight(const NETADDR &Addr, int Shard)
+{
+	// fnv-1a over the ip and the shard, then mixed so that every bit counts
+	unsigned Hash = 2166136261u;
+	for(int i = 0; i < NetAddressBits(Addr.type) / 8; i++)
+		Hash = (Hash ^ Addr.ip[i]) * 16777619u;
+	Hash = (Hash ^ (unsigned)Shard) * 16777619u;
+	Hash ^= Hash >> 16;
+	Hash *= 0x85ebca6bu;
+	Hash ^= Hash >> 13;
+	Hash *= 0xc2b2ae35u;
+	Hash ^= Hash >> 16;
+	return Hash;
+}
+
+int CShardRoutes::Pick(const NETADDR &Addr) const
+{
+	// the child that banned the address answers with the ban
+	const CPin *pPin = m_Pins.Lookup(&Addr);
+	if(pPin && m_vShards[pPin->m_Shard].m_Alive)
+		return pPin->m_Shard;
+
+	// running shards with free slots first, then the running ones
+	int Best = 0;
+	uint64_t BestScore = 0;
+	for(int i = 0; i < (int)m_vShards.size(); i++)
+	{
+		uint64_t Score = ((uint64_t)m_vShards[i].m_Alive << 33) | ((uint64_t)!m_vShards[i].m_Full << 32) | Weight(Addr, i);
+		if(Score > BestScore)
+		{
+			Best = i;
+			BestScore = Score;
+		}
+	}
+	return Best;
+}
+
+void CShardRoutes::Pin(const NETADDR &First, const NETADDR &Last, int Shard, int64_t Expire)
+{
+	if(Shard < 0 || Shard >= (int)m_vShards.size() || First.type != Last.type ||
+		(First.type != NETTYPE_IPV4 && First.type != NETTYPE_IPV6) ||
+		mem_comp(First.ip, Last.ip, NetAddressBits(First.type) / 8) > 0)
+		return;
+
+	// a ban of the same addresses replaces the old one
+	for(auto &pPin : m_vpPins)
+	{
+		if(net_addr_comp_noport(&pPin->m_First, &First) == 0 && net_addr_comp_noport(&pPin->m_Last, &Last) == 0)
+		{
+			pPin->m_Shard = Shard;
+			pPin->m_Expire = Expire;
+			return;
+		}
+	}
+
+	m_vpPins.push_back(std::make_unique<CPin>(CPin{First, Last, Shard, Expire}));
+	CPin *pPin = m_vpPins.back().get();
+	NetRangeToPrefixes(&First, &Last, [&](const unsigned char *pKey, int PrefixLength) {
+		m_Pins.Insert(First.type, pKey, PrefixLength, pPin);
+		return true;
+	});
+
+	// clients of the range on other shards time out and meet the ban when
+	// they connect again
+	for(auto It = m_Routes.begin(); It != m_Routes.end();)
+	{
+		if(It->second.m_Shard != Shard && m_Pins.Lookup(&It->first) == pPin)
+		{
+			m_vShards[It->second.m_Shard].m_NumRoutes--;
+			It = m_Routes.erase(It);
+		}
+		else
+			++It;
+	}
+}
+
+void CShardRoutes::Unpin(CPin *pPin)
+{
+	NetRangeToPrefixes(&pPin->m_First, &pPin->m_Last, [&](const unsigned char *pKey, int PrefixLength) {
+		m_Pins.Remove(pPin->m_First.type, pKey, PrefixLength, pPin);
+		return true;
+	});
+}
+
+int CShardRoutes::Route(const NETADDR &Addr, int64_t Now)
+{
+	auto It = m_Routes.find(Addr);
+	if(It != m_Routes.end())
+	{
+		if(m_vShards[It->second.m_Shard].m_Alive)
+		{
+			It->second.m_LastPacket = Now;
+			return It->second.m_Shard;
+		}
+		m_vShards[It->second.m_Shard].m_NumRoutes--;
+		m_Routes.erase(It);
+	}
+
+	int Shard = Pick(Addr);
+	if((int)m_Routes.size() >= MAX_ROUTES)
+		return Shard;
+
+	m_Routes.emplace(Addr, CRoute{Shard, Now});
+	m_vShards[Shard].m_NumRoutes++;
+	return Shard;
+}
+
+void CShardRoutes::Expire(int64_t Before, int64_t Now)
+{
+	for(auto It = m_Routes.begin(); It != m_Routes.end();)
+	{
+		if(It->second.m_LastPacket < Before)
+		{
+			m_vShards[It->second.m_Shard].m_NumRoutes--;
+			It = m_Routes.erase(It);
+		}
+		else
+			++It;
+	}
+
+	for(auto It = m_vpPins.begin(); It != m_vpPins.end();)
+	{
+		if((*It)->m_Expire >= 0 && (*It)->m_Expire < Now)
+		{
+			Unpin(It->get());
+			It = m_vpPins.erase(It);
+		}
+		else
+			++It;
+	}
+}
+
+bool CShardInfoParts::Add(const unsigned char *pData, int DataSize, std::string *pInfo)
+{
+	if(DataSize < CNetTunnel::INFO_HEADERSIZE)
+		return false;
+	int Serial = pData[0];
+	int Part = pData[1];
+	int NumParts = pData[2];
+	if(Part >= NumParts)
+		return false;
+
+	// a newer info replaces the parts of an incomplete one
+	if(Serial != m_Serial || NumParts != (int)m_vParts.size())
+	{
+		m_Serial = Serial;
+		m_NumReceived = 0;
+		m_vParts.assign(NumParts, std::string());
+		m_vReceived.assign(NumParts, false);
+	}
+	if(m_vReceived[Part])
+		return false;
+
+	m_vParts[Part].assign((const char *)pData + CNetTunnel::INFO_HEADERSIZE, DataSize - CNetTunnel::INFO_HEADERSIZE);
+	m_vReceived[Part] = true;
+	if(++m_NumReceived < NumParts)
+		return false;
+
+	pInfo->clear();
+	for(const auto &PartData : m_vParts)
+		pInfo->append(PartData);
+	m_Serial = -1;
+	m_vParts.clear();
+	m_vReceived.clear();
+	return true;
+}
+
+CShardFront::CShardFront(IConsole *pConsole, IEngine *pEngine) :
+	m_pConsole(pConsole),
+	m_pEngine(pEngine)
+{
+	m_Socket.type = NETTYPE_INVALID;
+	m_LocalSocket.type = NETTYPE_INVALID;
+}
+
+CShardFront::~CShardFront()
+{
+	delete m_pRegister;
+	if(m_Socket.type)
+		net_udp_close(m_Socket);
+	if(m_LocalSocket.type)
+		net_udp_close(m_LocalSocket);
+}
+
+bool CShardFront::Open(int Port, int ShardPort)
+{
+	NETADDR BindAddr;
+	int NetType = g_Config.m_SvIpv4Only ? NETTYPE_IPV4 : NETTYPE_ALL;
+	if(!g_Config.m_Bindaddr[0] || net_host_lookup(g_Config.m_Bindaddr, &BindAddr, NetType) != 0)
+		mem_zero(&BindAddr, sizeof(BindAddr));
+	BindAddr.type = NetType;
+	BindAddr.port = Port;
+	m_Socket = net_udp_create(BindAddr);
+	if(!m_Socket.type)
+	{
+		dbg_msg("shard", "couldn't open socket. port %d might already be in use", Port);
+		return false;
+	}
+
+	NETADDR LocalAddr;
+	net_addr_from_str(&LocalAddr, "127.0.0.1");
+	LocalAddr.port = ShardPort;
+	m_LocalSocket = net_udp_create(LocalAddr);
+	if(!m_LocalSocket.type)
+	{
+		dbg_msg("shard", "couldn't open local socket. port %d might already be in use", ShardPort);
+		return false;
+	}
+
+	net_init_mmsgs(&m_MMSGS);
+	net_init_mmsgs(&m_LocalMMSGS);
+	return true;
+}
+
+void CShardFront::Spawn(int Shard, int ShardPort)
+{
+	// the children get the same arguments, the last one wins
+	CShard &Child = m_vShards[Shard];
+	str_format(m_aOverride, sizeof(m_aOverride), "sv_shards 0; sv_shard_front %d; sv_port %d; bindaddr 127.0.0.1; sv_ipv4only 1; sv_register 0; ec_port 0; sv_metrics_port 0; sv_input_fifo \"\"", ShardPort, Child.m_Addr.port);
+	Child.m_Process = shell_execute_args(m_aExecutable, m_vpArguments.data(), m_vpArguments.size());
+	Child.m_NextSpawn = time_get() + RESPAWN_DELAY * time_freq();
+	m_Routes.SetAlive(Shard, Child.m_Process != 0);
+	if(!Child.m_Process)
+		dbg_msg("shard", "couldn't start shard %d from '%s'", Shard, m_aExecutable);
+}
+
+void CShardFront::UpdateShards(int ShardPort)
+{
+	int64_t Now = time_get();
+	for(int i = 0; i < (int)m_vShards.size(); i++)
+	{
+		CShard &Shard = m_vShards[i];
+		if(Shard.m_Process && !is_process_alive(Shard.m_Process))
+		{
+			dbg_msg("shard", "shard %d exited, starting it again", i);
+			Shard.m_Process = 0;
+			m_Routes.SetAlive(i, false);
+
+			// its players are gone
+			std::unique_lock<std::mutex> Lock(m_InfoMutex);
+			m_vInfos[i].clear();
+			m_InfoChanged = true;
+		}
+		// don't spin on a child that exits right away
+		if(!Shard.m_Process && Now >= Shard.m_NextSpawn)
+			Spawn(i, ShardPort);
+	}
+}
+
+bool CShardFront::OnRegisterPacket(const NETADDR &Addr, unsigned char *pData, int DataSize)
+{
+	if(!(pData[0] & (NET_PACKETFLAG_CONNLESS << 2)))
+		return false;
+
+	bool Sixup = false;
+	SECURITY_TOKEN Token;
+	SECURITY_TOKEN ResponseToken = NET_SECURITY_TOKEN_UNKNOWN;
+	if(CNetBase::UnpackPacket(pData, DataSize, &m_Packet, Sixup, &Token, &ResponseToken) != 0 ||
+		!(m_Packet.m_Flags & NET_PACKETFLAG_CONNLESS) ||
+		ResponseToken != NET_SECURITY_TOKEN_UNKNOWN)
+		return false;
+
+	CNetChunk Chunk;
+	Chunk.m_ClientID = -1;
+	Chunk.m_Flags = NETSENDFLAG_CONNLESS;
+	Chunk.m_Address = Addr;
+	Chunk.m_DataSize = m_Packet.m_DataSize;
+	Chunk.m_pData = m_Packet.m_aChunkData;
+	return m_pRegister->OnPacket(&Chunk);
+}
+
+void CShardFront::PumpClients()
+{
+	int64_t Now = time_get();
+	unsigned char aBuffer[NET_MAX_PACKETSIZE];
+	unsigned char aDatagram[NET_MAX_DATAGRAMSIZE];
+	while(true)
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes = net_udp_recv(m_Socket, &Addr, aBuffer, sizeof(aBuffer), &m_MMSGS, &pData);
+		if(Bytes <= 0)
+			break;
+		if(Bytes > NET_MAX_PACKETSIZE)
+			continue;
+
+		// the master's challenges are for the front
+		if(OnRegisterPacket(Addr, pData, Bytes))
+			continue;
+
+		int Shard = m_Routes.Route(Addr, Now);
+		int Size = CNetTunnel::Pack(aDatagram, sizeof(aDatagram), CNetTunnel::TYPE_PACKET, &Addr, pData, Bytes);
+		net_udp_send(m_LocalSocket, &m_vShards[Shard].m_Addr, aDatagram, Size);
+	}
+}
+
+void CShardFront::RelayThread(void *pUser)
+{
+	static_cast<CShardFront *>(pUser)->RelayLoop();
+}
+
+void CShardFront::RelayLoop()
+{
+	unsigned char aBuffer[NET_MAX_DATAGRAMSIZE];
+	while(!m_Shutdown)
+	{
+		// wake up regularly to check for shutdown
+		if(!net_socket_read_wait(m_LocalSocket, 100000))
+			continue;
+
+		while(true)
+		{
+			NETADDR Addr;
+			unsigned char *pData;
+			int Bytes = net_udp_recv(m_LocalSocket, &Addr, aBuffer, sizeof(aBuffer), &m_LocalMMSGS, &pData);
+			if(Bytes <= 0)
+				break;
+
+			int Shard = -1;
+			for(int i = 0; i < (int)m_vShards.size() && Shard < 0; i++)
+				if(net_addr_comp(&Addr, &m_vShards[i].m_Addr) == 0)
+					Shard = i;
+			if(Shard < 0)
+				continue;
+
+			int Type;
+			NETADDR ClientAddr;
+			const unsigned char *pPayload;
+			int Size = CNetTunnel::Unpack(pData, Bytes, &Type, &ClientAddr, &pPayload);
+			if(Size < 0)
+				continue;
+
+			if(Type == CNetTunnel::TYPE_PACKET)
+				net_udp_send(m_Socket, &ClientAddr, pPayload, Size);
+			else if(Type == CNetTunnel::TYPE_BAN && Size == CNetTunnel::BAN_SIZE)
+			{
+				CBan Ban;
+				Ban.m_Shard = Shard;
+				Ban.m_First = ClientAddr;
+				Ban.m_Last = ClientAddr;
+				mem_copy(Ban.m_Last.ip, pPayload, sizeof(Ban.m_Last.ip));
+				Ban.m_Seconds = (pPayload[16] << 24) | (pPayload[17] << 16) | (pPayload[18] << 8) | pPayload[19];
+				std::unique_lock<std::mutex> Lock(m_InfoMutex);
+				m_vBans.push_back(Ban);
+			}
+			else if(Type == CNetTunnel::TYPE_INFO)
+			{
+				std::string Info;
+				if(m_vShards[Shard].m_InfoParts.Add(pPayload, Size, &Info))
+				{
+					std::unique_lock<std::mutex> Lock(m_InfoMutex);
+					m_vInfos[Shard] = std::move(Info);
+					m_InfoChanged = true;
+				}
+			}
+		}
+	}
+}
+
+void CShardFront::UpdateInfo()
+{
+	std::vector<std::string> vInfos;
+	{
+		std::unique_lock<std::mutex> Lock(m_InfoMutex);
+		if(!m_InfoChanged)
+			return;
+		vInfos = m_vInfos;
+		m_InfoChanged = false;
+	}
+
+	for(int i = 0; i < (int)vInfos.size(); i++)
+		m_Routes.SetFull(i, InfoFull(vInfos[i]));
+
+	std::string Info;
+	if(MergeInfos(vInfos, &Info))
+		m_pRegister->OnNewInfo(Info.c_str());
+}
+
+void CShardFront::UpdateBans()
+{
+	std::vector<CBan> vBans;
+	{
+		std::unique_lock<std::mutex> Lock(m_InfoMutex);
+		if(m_vBans.empty())
+			return;
+		vBans.swap(m_vBans);
+	}
+
+	int64_t Now = time_get();
+	for(const CBan &Ban : vBans)
+		m_Routes.Pin(Ban.m_First, Ban.m_Last, Ban.m_Shard, Ban.m_Seconds > 0 ? Now + Ban.m_Seconds * time_freq() : -1);
+}
+
+int CShardFront::Run(int argc, const char **argv)
+{
+	int Port = g_Config.m_SvPort ? g_Config.m_SvPort : 8303;
+	int ShardPort = g_Config.m_SvShardPort ? g_Config.m_SvShardPort : Port + 1;
+	if(!Open(Port, ShardPort))
+		return -1;
+
+	if(!m_Http.Init(std::chrono::seconds{2}, &g_Config))
+	{
+		dbg_msg("shard", "Failed to initialize the HTTP client.");
+		return -1;
+	}
+	m_pRegister = CreateRegister(&g_Config, m_pConsole, m_pEngine, &m_Http, Port, NET_SECURITY_TOKEN_UNSUPPORTED);
+	m_pRegister->OnConfigChange();
+
+	// execv doesn't search the PATH the front may have been started through
+	if(fs_executable_path(m_aExecutable, sizeof(m_aExecutable)) != 0)
+		str_copy(m_aExecutable, argv[0], sizeof(m_aExecutable));
+	m_vpArguments.assign(argv + 1, argv + argc);
+	m_vpArguments.push_back(m_aOverride);
+
+	m_vShards.resize(g_Config.m_SvShards);
+	m_vInfos.resize(m_vShards.size());
+	m_Routes.Init(m_vShards.size());
+	for(int i = 0; i < (int)m_vShards.size(); i++)
+	{
+		net_addr_from_str(&m_vShards[i].m_Addr, "127.0.0.1");
+		m_vShards[i].m_Addr.port = ShardPort + 1 + i;
+		Spawn(i, ShardPort);
+	}
+	m_pRelayThread = thread_init(RelayThread, this, "shard relay");
+
+	std::signal(SIGINT, HandleInterrupt);
+	std::signal(SIGTERM, HandleInterrupt);
+	dbg_msg("shard", "front on port %d, %d shards from port %d", Port, (int)m_vShards.size(), ShardPort + 1);
+
+	int64_t NextHeartbeat = 0;
+	while(!s_Interrupted)
+	{
+		if(net_socket_read_wait(m_Socket, 100000))
+			PumpClients();
+
+		int64_t Now = time_get();
+		if(Now >= NextHeartbeat)
+		{
+			unsigned char aDatagram[NET_TUNNEL_HEADERSIZE];
+			int Size = CNetTunnel::Pack(aDatagram, sizeof(aDatagram), CNetTunnel::TYPE_HEARTBEAT, nullptr, nullptr, 0);
+			for(const auto &Shard : m_vShards)
+				net_udp_send(m_LocalSocket, &Shard.m_Addr, aDatagram, Size);
+
+			UpdateShards(ShardPort);
+			// connected clients send packets all the time
+			m_Routes.Expire(Now - ROUTE_TIMEOUT * time_freq(), Now);
+			NextHeartbeat = Now + CNetTunnel::HEARTBEAT_INTERVAL * time_freq();
+		}
+
+		UpdateInfo();
+		UpdateBans();
+		m_pRegister->Update();
+	}
+
+	dbg_msg("shard", "shutting down");
+	m_pRegister->OnShutdown();
+	m_Shutdown = true;
+	thread_wait(m_pRelayThread);
+	for(auto &Shard : m_vShards)
+		if(Shard.m_Process)
+			kill_process(Shard.m_Process);
+	m_Http.Shutdown();
+	return 0;
+}
+
+static int JsonInt(const json_value *pValue)
+{
+	return pValue->type == json_integer ? json_int_get(pValue) : 0;
+}
+
+static void WriteJson(CJsonWriter *pWriter, const json_value *pValue)
+{
+	switch(pValue->type)
+	{
+	case json_object:
+		pWriter->BeginObject();
+		for(const auto &Entry : pValue->u.object)
+		{
+			pWriter->WriteAttribute(Entry.name);
+			WriteJson(pWriter, Entry.value);
+		}
+		pWriter->EndObject();
+		break;
+	case json_array:
+		pWriter->BeginArray();
+		for(const json_value *pElement : pValue->u.array)
+			WriteJson(pWriter, pElement);
+		pWriter->EndArray();
+		break;
+	case json_integer:
+		pWriter->WriteIntValue(pValue->u.integer);
+		break;
+	case json_double:
+	{
+		char aBuf[64];
+		str_format(aBuf, sizeof(aBuf), "%g", pValue->u.dbl);
+		pWriter->WriteRawValue(aBuf);
+		break;
+	}
+	case json_string:
+		pWriter->WriteStrValue(pValue->u.string.ptr);
+		break;
+	case json_boolean:
+		pWriter->WriteBoolValue(pValue->u.boolean);
+		break;
+	default:
+		pWriter->WriteNullValue();
+	}
+}
+
+bool CShardFront::InfoFull(const std::string &Info)
+{
+	json_value *pInfo = json_parse(Info.c_str(), Info.size());
+	if(!pInfo)
+		return false;
+	const json_value *pMaxClients = json_object_get(pInfo, "max_clients");
+	const json_value *pClients = json_object_get(pInfo, "clients");
+	bool Full = pMaxClients->type == json_integer && pClients->type == json_array &&
+		    json_array_length(pClients) >= json_int_get(pMaxClients);
+	json_value_free(pInfo);
+	return Full;
+}
+
+bool CShardFront::MergeInfos(const std::vector<std::string> &vInfos, std::string *pResult)
+{
+	std::vector<json_value *> vpInfos;
+	for(const auto &Info : vInfos)
+	{
+		json_value *pInfo = json_parse(Info.c_str(), Info.size());
+		if(pInfo && pInfo->type == json_object)
+			vpInfos.push_back(pInfo);
+		else if(pInfo)
+			json_value_free(pInfo);
+	}
+	if(vpInfos.empty())
+		return false;
+
+	int MaxClients = 0;
+	int MaxPlayers = 0;
+	for(const json_value *pInfo : vpInfos)
+	{
+		MaxClients += JsonInt(json_object_get(pInfo, "max_clients"));
+		MaxPlayers += JsonInt(json_object_get(pInfo, "max_players"));
+	}
+
+	// the rest is the same for all children
+	CJsonStringWriter Writer;
+	Writer.BeginObject();
+	for(const auto &Entry : vpInfos[0]->u.object)
+	{
+		Writer.WriteAttribute(Entry.name);
+		if(str_comp(Entry.name, "max_clients") == 0)
+			Writer.WriteIntValue(MaxClients);
+		else if(str_comp(Entry.name, "max_players") == 0)
+			Writer.WriteIntValue(MaxPlayers);
+		else if(str_comp(Entry.name, "clients") == 0)
+		{
+			Writer.BeginArray();
+			for(const json_value *pInfo : vpInfos)
+			{
+				const json_value *pClients = json_object_get(pInfo, "clients");
+				for(int i = 0; i < json_array_length(pClients); i++)
+					WriteJson(&Writer, json_array_get(pClients, i));
+			}
+			Writer.EndArray();
+		}
+		else
+			WriteJson(&Writer, Entry.value);
+	}
+	Writer.EndObject();
+	*pResult = Writer.GetOutputString();
+
+	for(json_value *pInfo : vpInfos)
+		json_value_free(pInfo);
+	return true;
+}
@@ -0,0 +1,193 @@
+#ifndef ENGINE_SERVER_SHARD_H
+#define ENGINE_SERVER_SHARD_H
+
+#include <base/system.h>
+#include <engine/shared/http.h>
+#include <engine/shared/network.h>
+#include <engine/shared/nettrie.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class IConsole;
+class IEngine;
+class IRegister;
+
+// Routes client addresses to shards. A new address goes to the shard that
+// ranks highest for its ip (rendezvous hashing) among the running ones with
+// free slots, so the clients of an ip meet the same child's bans and
+// per-ip limit. Addresses banned by a child stay with it until the ban
+// expires.
+class CShardRoutes
+{
+public:
+	enum
+	{
+		// beyond this, new addresses are routed but not remembered
+		MAX_ROUTES = 1 << 16,
+	};
+
+private:
+	struct CRoute
+	{
+		int m_Shard;
+		int64_t m_LastPacket;
+	};
+
+	struct CPin
+	{
+		NETADDR m_First;
+		NETADDR m_Last;
+		int m_Shard;
+		// -1 for never
+		int64_t m_Expire;
+	};
+
+	struct CShardState
+	{
+		int m_NumRoutes = 0;
+		bool m_Alive = true;
+		bool m_Full = false;
+	};
+
+	struct CAddrLess
+	{
+		bool operator()(const NETADDR &a, const NETADDR &b) const { return net_addr_comp(&a, &b) < 0; }
+	};
+
+	std::map<NETADDR, CRoute, CAddrLess> m_Routes;
+	std::vector<CShardState> m_vShards;
+	std::vector<std::unique_ptr<CPin>> m_vpPins;
+	CNetPrefixTrie<CPin *> m_Pins;
+
+	int Pick(const NETADDR &Addr) const;
+	void Unpin(CPin *pPin);
+
+public:
+	void Init(int NumShards);
+	// dead shards lose their routes, full ones get no new addresses
+	void SetAlive(int Shard, bool Alive) { m_vShards[Shard].m_Alive = Alive; }
+	void SetFull(int Shard, bool Full) { m_vShards[Shard].m_Full = Full; }
+	bool IsAlive(int Shard) const { return m_vShards[Shard].m_Alive; }
+	// routes the addresses from `First` to `Last` to the shard until `Expire`
+	void Pin(const NETADDR &First, const NETADDR &Last, int Shard, int64_t Expire);
+
+	// returns the shard of the address, routes it if it's new
+	int Route(const NETADDR &Addr, int64_t Now);
+	// removes the routes without packets since `Before` and the pins that
+	// expired before `Now`
+	void Expire(int64_t Before, int64_t Now);
+
+	int NumRoutes() const { return m_Routes.size(); }
+	int NumRoutes(int Shard) const { return m_vShards[Shard].m_NumRoutes; }
+	int NumPins() const { return m_vpPins.size(); }
+
+	// the rank of the shard for the address, the port doesn't count
+	static unsigned Weight(const NETADDR &Addr, int Shard);
+};
+
+// The register info of a shard arrives in parts, see `CNetTunnel`.
+class CShardInfoParts
+{
+	int m_Serial = -1;
+	int m_NumReceived = 0;
+	std::vector<std::string> m_vParts;
+	std::vector<bool> m_vReceived;
+
+public:
+	// returns true and the whole info once the last part of it arrived
+	bool Add(const unsigned char *pData, int DataSize, std::string *pInfo);
+};
+
+// Owns the public port and spreads the clients over child server processes
+// on the same machine. Each client address is routed to one child, its
+// packets are tunnelled over localhost with the client's address in front.
+// The front registers with the merged infos of the children.
+class CShardFront
+{
+	enum
+	{
+		// in seconds, forget the shard of an address without packets
+		ROUTE_TIMEOUT = 30,
+	};
+
+	enum
+	{
+		// in seconds, between the starts of a child that keeps exiting
+		RESPAWN_DELAY = 5,
+	};
+
+	struct CShard
+	{
+		PROCESS m_Process = 0;
+		int64_t m_NextSpawn = 0;
+		NETADDR m_Addr;
+		CShardInfoParts m_InfoParts;
+	};
+
+	struct CBan
+	{
+		int m_Shard;
+		NETADDR m_First;
+		NETADDR m_Last;
+		int m_Seconds;
+	};
+
+	IConsole *m_pConsole;
+	IEngine *m_pEngine;
+	CHttp m_Http;
+	IRegister *m_pRegister = nullptr;
+
+	NETSOCKET m_Socket;
+	NETSOCKET m_LocalSocket;
+	MMSGS m_MMSGS;
+	MMSGS m_LocalMMSGS;
+	CNetPacketConstruct m_Packet;
+
+	char m_aExecutable[IO_MAX_PATH_LENGTH];
+	std::vector<const char *> m_vpArguments;
+	char m_aOverride[256];
+
+	std::vector<CShard> m_vShards;
+	CShardRoutes m_Routes;
+
+	// written by the relay thread
+	std::mutex m_InfoMutex;
+	std::vector<std::string> m_vInfos;
+	bool m_InfoChanged = false;
+	std::vector<CBan> m_vBans;
+
+	std::atomic_bool m_Shutdown{false};
+	void *m_pRelayThread = nullptr;
+
+	bool Open(int Port, int ShardPort);
+	void Spawn(int Shard, int ShardPort);
+	void UpdateShards(int ShardPort);
+	bool OnRegisterPacket(const NETADDR &Addr, unsigned char *pData, int DataSize);
+	void PumpClients();
+	void UpdateInfo();
+	void UpdateBans();
+
+	static void RelayThread(void *pUser);
+	void RelayLoop();
+
+public:
+	CShardFront(IConsole *pConsole, IEngine *pEngine);
+	~CShardFront();
+
+	// runs until it is interrupted, spawns `sv_shards` children with the
+	// command line arguments of the front
+	int Run(int argc, const char **argv);
+
+	// merges the register infos of the children into one, returns false if
+	// none of them is valid
+	static bool MergeInfos(const std::vector<std::string> &vInfos, std::string *pResult);
+	// whether the register info has as many clients as slots
+	static bool InfoFull(const std::string &Info);
+};
+
+#endif // ENGINE_SERVER_SHARD_H
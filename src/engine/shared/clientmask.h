@@ -0,0 +1,95 @@
+#ifndef ENGINE_SHARED_CLIENTMASK_H
+#define ENGINE_SHARED_CLIENTMASK_H
+
+#include <base/system.h>
+
+#include "protocol.h"
+
+#include <cstdint>
+
+// A set of client ids. All operations work on whole words in loops of a
+// fixed length, which the compiler unrolls or vectorizes, so they cost
+// O(NUM_CLIENTS / 64) and don't depend on the number of clients set.
+template<int NUM_CLIENTS>
+class CGenericClientMask
+{
+public:
+	enum
+	{
+		NUM_WORDS = (NUM_CLIENTS + 63) / 64,
+	};
+
+private:
+	uint64_t m_aWords[NUM_WORDS];
+
+public:
+	CGenericClientMask() :
+		m_aWords{}
+	{
+	}
+
+	static CGenericClientMask All()
+	{
+		CGenericClientMask Mask;
+		for(auto &Word : Mask.m_aWords)
+			Word = ~(uint64_t)0;
+		return Mask;
+	}
+
+	static CGenericClientMask One(int ClientID)
+	{
+		CGenericClientMask Mask;
+		Mask.Set(ClientID);
+		return Mask;
+	}
+
+	bool IsSet(int ClientID) const { return (m_aWords[ClientID / 64] >> (ClientID % 64)) & 1; }
+	void Set(int ClientID) { m_aWords[ClientID / 64] |= (uint64_t)1 << (ClientID % 64); }
+	void Unset(int ClientID) { m_aWords[ClientID / 64] &= ~((uint64_t)1 << (ClientID % 64)); }
+
+	bool IsEmpty() const
+	{
+		uint64_t Any = 0;
+		for(auto Word : m_aWords)
+			Any |= Word;
+		return Any == 0;
+	}
+
+	CGenericClientMask &operator|=(const CGenericClientMask &Other)
+	{
+		for(int i = 0; i < NUM_WORDS; i++)
+			m_aWords[i] |= Other.m_aWords[i];
+		return *this;
+	}
+
+	CGenericClientMask &operator&=(const CGenericClientMask &Other)
+	{
+		for(int i = 0; i < NUM_WORDS; i++)
+			m_aWords[i] &= Other.m_aWords[i];
+		return *this;
+	}
+
+	CGenericClientMask operator|(const CGenericClientMask &Other) const { return CGenericClientMask(*this) |= Other; }
+	CGenericClientMask operator&(const CGenericClientMask &Other) const { return CGenericClientMask(*this) &= Other; }
+
+	CGenericClientMask operator~() const
+	{
+		CGenericClientMask Mask;
+		for(int i = 0; i < NUM_WORDS; i++)
+			Mask.m_aWords[i] = ~m_aWords[i];
+		return Mask;
+	}
+
+	bool operator==(const CGenericClientMask &Other) const
+	{
+		uint64_t Diff = 0;
+		for(int i = 0; i < NUM_WORDS; i++)
+			Diff |= m_aWords[i] ^ Other.m_aWords[i];
+		return Diff == 0;
+	}
+	bool operator!=(const CGenericClientMask &Other) const { return !(*this == Other); }
+};
+
+typedef CGenericClientMask<MAX_CLIENTS> CClientMask;
+
+#endif // ENGINE_SHARED_CLIENTMASK_H
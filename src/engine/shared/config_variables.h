@@ -20,10 +20,18 @@ MACRO_CONFIG_STR(SvHostname, sv_hostname, 128, "", CFGFLAG_SAVE | CFGFLAG_SERVER
 MACRO_CONFIG_STR(SvMap, sv_map, 128, "mega_std_collection", CFGFLAG_SERVER, "Map to use on the server")
 MACRO_CONFIG_INT(SvMaxClients, sv_max_clients, MAX_CLIENTS, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients that are allowed on a server")
 MACRO_CONFIG_INT(SvMaxClientsPerIP, sv_max_clients_per_ip, 4, 1, MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients with the same IP that can connect to the server")
+MACRO_CONFIG_INT(SvNetThread, sv_net_thread, 0, 0, 1, CFGFLAG_SERVER, "Receive network packets on a dedicated thread (setting only works in initial config)")
+MACRO_CONFIG_INT(SvShards, sv_shards, 0, 0, 16, CFGFLAG_SERVER, "Number of child server processes to spread the players over behind this port, 0 to run a single server (setting only works in initial config)")
+MACRO_CONFIG_INT(SvShardPort, sv_shard_port, 0, 0, 65535, CFGFLAG_SERVER, "Local port of the shard front, the children use the following ones, 0 for sv_port + 1 (setting only works in initial config)")
+MACRO_CONFIG_INT(SvShardFront, sv_shard_front, 0, 0, 65535, CFGFLAG_SERVER, "Local port of the shard front this server runs behind, set by the front (setting only works in initial config)")
+MACRO_CONFIG_INT(SvBandwidthStats, sv_bandwidth_stats, 0, 0, 1, CFGFLAG_SERVER, "Account outgoing bytes per client, room, snapshot item type and message")
+MACRO_CONFIG_INT(SvBandwidthStatsDump, sv_bandwidth_stats_dump, 0, 0, 86400, CFGFLAG_SERVER, "Interval in seconds in which bandwidth stats are appended to sv_bandwidth_stats_file (0 = off)")
+MACRO_CONFIG_STR(SvBandwidthStatsFile, sv_bandwidth_stats_file, 128, "bandwidth_stats.csv", CFGFLAG_SERVER, "CSV file the bandwidth stats are appended to")
 MACRO_CONFIG_INT(SvHighBandwidth, sv_high_bandwidth, 0, 0, 1, CFGFLAG_SERVER, "Use high bandwidth mode. Doubles the bandwidth required for the server. LAN use only")
 MACRO_CONFIG_STR(SvRegister, sv_register, 16, "1", CFGFLAG_SERVER, "Register server with master server for public listing, can also accept a comma-separated list of protocols to register on, like 'ipv4,ipv6'")
 MACRO_CONFIG_STR(SvRegisterExtra, sv_register_extra, 256, "", CFGFLAG_SERVER, "Extra headers to send to the register endpoint, comma-separated 'Header: Value' pairs")
 MACRO_CONFIG_STR(SvRegisterUrl, sv_register_url, 128, "https://master1.ddnet.org/ddnet/15/register", CFGFLAG_SERVER, "Masterserver URL to register to")
+MACRO_CONFIG_INT(SvRegisterInfoDelay, sv_register_info_delay, 500, 0, 10000, CFGFLAG_SERVER, "Milliseconds to collect server info changes before sending them to the master server")
 MACRO_CONFIG_INT(HttpAllowInsecure, http_allow_insecure, 0, 0, 1, CFGFLAG_CLIENT | CFGFLAG_SERVER, "Allow insecure HTTP protocol in addition to the secure HTTPS one. Mostly useful for testing.")
 MACRO_CONFIG_STR(SvRconPassword, sv_rcon_password, 32, "", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, "Remote console password (full access)")
 MACRO_CONFIG_STR(SvRconModPassword, sv_rcon_mod_password, 32, "", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, "Remote console password for moderators (limited access)")
@@ -39,12 +47,19 @@ MACRO_CONFIG_STR(SvDnsblKey, sv_dnsbl_key, 128, "", CFGFLAG_SERVER | CFGFLAG_NON
 MACRO_CONFIG_INT(SvDnsblVote, sv_dnsbl_vote, 0, 0, 1, CFGFLAG_SERVER, "Block votes by blacklisted addresses")
 MACRO_CONFIG_INT(SvDnsblBan, sv_dnsbl_ban, 0, 0, 1, CFGFLAG_SERVER, "Automatically ban blacklisted addresses")
 MACRO_CONFIG_INT(SvDnsblChat, sv_dnsbl_chat, 0, 0, 1, CFGFLAG_SERVER, "Don't allow chat from blacklisted addresses")
+MACRO_CONFIG_INT(SvDnsblCacheTime, sv_dnsbl_cache_time, 600, 0, 86400, CFGFLAG_SERVER, "How long DNSBL verdicts are cached per address (in seconds)")
 MACRO_CONFIG_INT(SvRconVote, sv_rcon_vote, 0, 0, 1, CFGFLAG_SERVER, "Only allow authed clients to call votes")
 
 MACRO_CONFIG_INT(SvRagequitBanTime, sv_ragequit_bantime, 0, 0, 1440, CFGFLAG_SERVER, "The time a client gets banned if quickly rejoined after ragequit. 0 disables this.")
 
 MACRO_CONFIG_INT(SvPlayerDemoRecord, sv_player_demo_record, 0, 0, 1, CFGFLAG_SERVER, "Automatically record demos for each player")
 MACRO_CONFIG_INT(SvDemoChat, sv_demo_chat, 0, 0, 1, CFGFLAG_SERVER, "Record chat for demos")
+MACRO_CONFIG_INT(SvDemoAsyncBuffer, sv_demo_async_buffer, 0, 0, 65536, CFGFLAG_SERVER, "Size in KiB of the buffer that demo records are written from by a separate thread (0 = write synchronously). A record that doesn't fit waits for the thread and is written synchronously")
+MACRO_CONFIG_INT(SvJobThreads, sv_job_threads, 2, 1, 32, CFGFLAG_SERVER, "Number of worker threads for background jobs (only more threads can be added at runtime)")
+MACRO_CONFIG_INT(SvMetricsPort, sv_metrics_port, 0, 0, 65535, CFGFLAG_SERVER, "Port to serve Prometheus metrics on over http (0 to disable, setting only works in initial config)")
+MACRO_CONFIG_STR(SvMetricsBindaddr, sv_metrics_bindaddr, 128, "127.0.0.1", CFGFLAG_SERVER, "Address to bind the metrics http server to (setting only works in initial config)")
+MACRO_CONFIG_INT(SvConnlessRate, sv_connless_rate, 0, 0, 1000, CFGFLAG_SERVER, "Maximum number of connectionless packets (e.g. server info requests) accepted per second from one address (0 for no limit). Players behind a shared address (NAT, CGNAT) count together, so keep it well above their combined server browser traffic")
+MACRO_CONFIG_INT(SvConnlessBurst, sv_connless_burst, 20, 1, 1000, CFGFLAG_SERVER, "Number of connectionless packets one address may send in a burst before sv_connless_rate applies")
 MACRO_CONFIG_INT(SvServerInfoPerSecond, sv_server_info_per_second, 50, 0, 10000, CFGFLAG_SERVER, "Maximum number of complete server info responses that are sent out per second (0 for no limit)")
 MACRO_CONFIG_INT(SvVanConnPerSecond, sv_van_conn_per_second, 10, 0, 10000, CFGFLAG_SERVER, "Antispoof specific ratelimit (0 for no limit)")
 MACRO_CONFIG_INT(SvSixup, sv_sixup, 1, 0, 1, CFGFLAG_SERVER, "Enable sixup connections")
@@ -114,6 +129,9 @@ MACRO_CONFIG_STR(SvRegionName, sv_region_name, 5, "UNK", CFGFLAG_SERVER, "Server
 MACRO_CONFIG_STR(SvSqlServerName, sv_sql_servername, 5, "UNK", CFGFLAG_SERVER, "SQL Server name that is inserted into record table")
 MACRO_CONFIG_INT(SvUseSQL, sv_use_sql, 0, 0, 1, CFGFLAG_SERVER, "Enables MySQL backend instead of SQLite backend (sv_sqlite_file is still used as fallback write server when no MySQL server is reachable)")
 MACRO_CONFIG_INT(SvSqlQueriesDelay, sv_sql_queries_delay, 1, 0, 20, CFGFLAG_SERVER, "Delay in seconds between SQL queries of a single player")
+MACRO_CONFIG_INT(SvSqlReadWorkers, sv_sql_read_workers, 2, 1, 16, CFGFLAG_SERVER, "Number of threads running read queries (setting only works in initial config)")
+MACRO_CONFIG_INT(SvSqlWriteWorkers, sv_sql_write_workers, 1, 1, 16, CFGFLAG_SERVER, "Number of threads running write queries, more than one may reorder writes (setting only works in initial config)")
+MACRO_CONFIG_INT(SvSqlWriteBatch, sv_sql_write_batch, 16, 1, 256, CFGFLAG_SERVER, "Maximum number of queued writes committed in one transaction (setting only works in initial config)")
 MACRO_CONFIG_STR(SvSqliteFile, sv_sqlite_file, 64, "ddnet-server.sqlite", CFGFLAG_SERVER, "File to store ranks in case sv_use_sql is turned off or used as backup sql server")
 
 #if defined(CONF_UPNP)
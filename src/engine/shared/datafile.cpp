@@ -714,6 +714,20 @@ int CDataFileWriter::AddData(int Size, void *pData, int CompressionLevel)
 	return m_NumDatas - 1;
 }
 
+int CDataFileWriter::AddDataCompressed(int UncompressedSize, const void *pCompressedData, int CompressedSize)
+{
+	dbg_assert(m_NumDatas < 1024, "too much data");
+
+	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
+	pInfo->m_UncompressedSize = UncompressedSize;
+	pInfo->m_CompressedSize = CompressedSize;
+	pInfo->m_pCompressedData = malloc(CompressedSize);
+	mem_copy(pInfo->m_pCompressedData, pCompressedData, CompressedSize);
+
+	m_NumDatas++;
+	return m_NumDatas - 1;
+}
+
 int CDataFileWriter::AddDataSwapped(int Size, void *pData)
 {
 	dbg_assert(Size % sizeof(int) == 0, "incorrect boundary");
@@ -109,6 +109,8 @@ public:
 	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType = IStorage::TYPE_SAVE);
 	int AddData(int Size, void *pData, int CompressionLevel = Z_DEFAULT_COMPRESSION);
 	int AddDataSwapped(int Size, void *pData);
+	// adds data that was compressed with zlib already
+	int AddDataCompressed(int UncompressedSize, const void *pCompressedData, int CompressedSize);
 	int AddItem(int Type, int ID, int Size, void *pData);
 	int Finish();
 };
@@ -16,6 +16,9 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <condition_variable>
+#include <mutex>
+
 static const unsigned char s_aHeaderMarker[7] = {'T', 'W', 'D', 'E', 'M', 'O', 0};
 static const unsigned char s_CurVersion = 6;
 static const unsigned char s_OldVersion = 3;
@@ -33,6 +36,227 @@ CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapDat
 	m_LastTickMarker = -1;
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_NoMapData = NoMapData;
+	m_AsyncBufferSize = 0;
+	m_pWriter = 0;
+}
+
+/*
+	Tickmarker
+		7	= Always set
+		6	= Keyframe flag
+		0-5	= Delta tick
+
+	Normal
+		7 = Not set
+		5-6	= Type
+		0-4	= Size
+*/
+
+enum
+{
+	CHUNKTYPEFLAG_TICKMARKER = 0x80,
+	CHUNKTICKFLAG_KEYFRAME = 0x40, // only when tickmarker is set
+	CHUNKTICKFLAG_TICK_COMPRESSED = 0x20, // when we store the tick value in the first chunk
+
+	CHUNKMASK_TICK = 0x1f,
+	CHUNKMASK_TICK_LEGACY = 0x3f,
+	CHUNKMASK_TYPE = 0x60,
+	CHUNKMASK_SIZE = 0x1f,
+
+	CHUNKTYPE_SNAPSHOT = 1,
+	CHUNKTYPE_MESSAGE = 2,
+	CHUNKTYPE_DELTA = 3,
+
+	CHUNKFLAG_BIGSIZE = 0x10
+};
+
+// Asynchronous writer
+//
+// The recording thread copies raw snapshots and messages into a ring buffer,
+// the writer thread turns them into chunks. Records are stored contiguously,
+// a record that doesn't fit at the end of the buffer starts at the front.
+// If the buffer is full, the recording thread waits until the writer caught
+// up and writes the record itself, so nothing is lost.
+class CDemoRecorder::CWriter
+{
+public:
+	enum
+	{
+		RECORD_WRAP = -1,
+		RECORD_SNAPSHOT = 0,
+		RECORD_MESSAGE,
+	};
+
+	struct CRecordHeader
+	{
+		int m_Type;
+		int m_Tick;
+		int m_Size;
+	};
+
+	CDemoRecorder *m_pRecorder;
+	// private copy, the original is used by the recording thread meanwhile
+	CSnapshotDelta m_SnapshotDelta;
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Cond;
+	std::condition_variable m_DrainedCond;
+	unsigned char *m_pBuffer;
+	int m_BufferSize;
+	int m_Head;
+	int m_Tail;
+	int m_Used;
+	bool m_Shutdown;
+
+	int m_PeakBytes;
+	int64 m_NumRecords;
+	int64 m_NumSync;
+
+	void *m_pThread;
+
+	CWriter(CDemoRecorder *pRecorder, const CSnapshotDelta &SnapshotDelta, int BufferSize) :
+		m_pRecorder(pRecorder), m_SnapshotDelta(SnapshotDelta)
+	{
+		m_SnapshotDelta.SetStats(0);
+		m_BufferSize = BufferSize & ~3;
+		m_pBuffer = (unsigned char *)malloc(m_BufferSize);
+		m_Head = 0;
+		m_Tail = 0;
+		m_Used = 0;
+		m_Shutdown = false;
+		m_PeakBytes = 0;
+		m_NumRecords = 0;
+		m_NumSync = 0;
+		m_pThread = thread_init(ThreadMain, this, "demo writer");
+	}
+
+	~CWriter()
+	{
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Shutdown = true;
+		}
+		m_Cond.notify_one();
+		thread_wait(m_pThread);
+		free(m_pBuffer);
+	}
+
+	static int RecordSize(int DataSize) { return sizeof(CRecordHeader) + ((DataSize + 3) & ~3); }
+
+	void WriteRecord(int Type, int Tick, const void *pData, int Size)
+	{
+		if(Type == RECORD_SNAPSHOT)
+			m_pRecorder->WriteSnapshot(Tick, pData, Size, &m_SnapshotDelta);
+		else
+			m_pRecorder->Write(CHUNKTYPE_MESSAGE, pData, Size);
+	}
+
+	// called from the recording thread, only waits for the writer if the
+	// buffer is full
+	void Push(int Type, int Tick, const void *pData, int Size)
+	{
+		const int Needed = RecordSize(Size);
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_NumRecords++;
+			if(m_Used == 0)
+			{
+				m_Head = 0;
+				m_Tail = 0;
+			}
+
+			int Pos = -1;
+			if(m_Tail > m_Head || (m_Tail == m_Head && m_Used == 0))
+			{
+				if(m_BufferSize - m_Tail >= Needed)
+					Pos = m_Tail;
+				else if(m_Head >= Needed)
+				{
+					// skip the rest of the buffer
+					if(m_BufferSize - m_Tail >= (int)sizeof(CRecordHeader))
+						((CRecordHeader *)(m_pBuffer + m_Tail))->m_Type = RECORD_WRAP;
+					m_Used += m_BufferSize - m_Tail;
+					Pos = 0;
+				}
+			}
+			else if(m_Head - m_Tail >= Needed)
+				Pos = m_Tail;
+
+			if(Pos < 0)
+			{
+				// the writer is idle once the buffer is empty, the record is
+				// written here to keep the order
+				m_NumSync++;
+				m_DrainedCond.wait(Lock, [this] { return m_Used == 0; });
+				WriteRecord(Type, Tick, pData, Size);
+				return;
+			}
+
+			CRecordHeader *pHeader = (CRecordHeader *)(m_pBuffer + Pos);
+			pHeader->m_Type = Type;
+			pHeader->m_Tick = Tick;
+			pHeader->m_Size = Size;
+			mem_copy(pHeader + 1, pData, Size);
+			m_Tail = Pos + Needed;
+			m_Used += Needed;
+			m_PeakBytes = maximum(m_PeakBytes, m_Used);
+		}
+		m_Cond.notify_one();
+	}
+
+	void Run()
+	{
+		while(true)
+		{
+			CRecordHeader *pHeader;
+			{
+				std::unique_lock<std::mutex> Lock(m_Mutex);
+				m_Cond.wait(Lock, [this] { return m_Used > 0 || m_Shutdown; });
+				if(m_Used == 0)
+					break;
+
+				if(m_BufferSize - m_Head < (int)sizeof(CRecordHeader) || ((CRecordHeader *)(m_pBuffer + m_Head))->m_Type == RECORD_WRAP)
+				{
+					m_Used -= m_BufferSize - m_Head;
+					m_Head = 0;
+					if(m_Used == 0)
+						m_DrainedCond.notify_one();
+					continue;
+				}
+				pHeader = (CRecordHeader *)(m_pBuffer + m_Head);
+			}
+
+			// the record stays reserved until it is written
+			WriteRecord(pHeader->m_Type, pHeader->m_Tick, pHeader + 1, pHeader->m_Size);
+
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			const int Size = RecordSize(pHeader->m_Size);
+			m_Head += Size;
+			m_Used -= Size;
+			if(m_Used == 0)
+				m_DrainedCond.notify_one();
+		}
+	}
+
+	static void ThreadMain(void *pUser)
+	{
+		((CWriter *)pUser)->Run();
+	}
+};
+
+void CDemoRecorder::GetWriterStats(CWriterStats *pStats) const
+{
+	if(!m_pWriter)
+	{
+		mem_zero(pStats, sizeof(*pStats));
+		return;
+	}
+	std::unique_lock<std::mutex> Lock(m_pWriter->m_Mutex);
+	pStats->m_BufferSize = m_pWriter->m_BufferSize;
+	pStats->m_QueuedBytes = m_pWriter->m_Used;
+	pStats->m_PeakBytes = m_pWriter->m_PeakBytes;
+	pStats->m_NumRecords = m_pWriter->m_NumRecords;
+	pStats->m_NumSync = m_pWriter->m_NumSync;
 }
 
 // Record
@@ -136,6 +360,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	// Header.m_Length - add this on stop
 	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
 	io_write(DemoFile, &Header, sizeof(Header));
+	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
 	io_write(DemoFile, &TimelineMarkers, sizeof(TimelineMarkers)); // fill this on stop
 
 	//Write Sha256
@@ -168,6 +393,7 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 
 	m_LastKeyFrame = -1;
 	m_LastTickMarker = -1;
+	m_LastChunkTick = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
 
@@ -180,42 +406,15 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_File = DemoFile;
 	str_copy(m_aCurrentFilename, pFilename, sizeof(m_aCurrentFilename));
 
+	if(m_AsyncBufferSize > 0)
+		m_pWriter = new CWriter(this, *m_pSnapshotDelta, m_AsyncBufferSize);
+
 	return 0;
 }
 
-/*
-	Tickmarker
-		7	= Always set
-		6	= Keyframe flag
-		0-5	= Delta tick
-
-	Normal
-		7 = Not set
-		5-6	= Type
-		0-4	= Size
-*/
-
-enum
-{
-	CHUNKTYPEFLAG_TICKMARKER = 0x80,
-	CHUNKTICKFLAG_KEYFRAME = 0x40, // only when tickmarker is set
-	CHUNKTICKFLAG_TICK_COMPRESSED = 0x20, // when we store the tick value in the first chunk
-
-	CHUNKMASK_TICK = 0x1f,
-	CHUNKMASK_TICK_LEGACY = 0x3f,
-	CHUNKMASK_TYPE = 0x60,
-	CHUNKMASK_SIZE = 0x1f,
-
-	CHUNKTYPE_SNAPSHOT = 1,
-	CHUNKTYPE_MESSAGE = 2,
-	CHUNKTYPE_DELTA = 3,
-
-	CHUNKFLAG_BIGSIZE = 0x10
-};
-
 void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 {
-	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
+	if(m_LastChunkTick == -1 || Tick - m_LastChunkTick > CHUNKMASK_TICK || Keyframe)
 	{
 		unsigned char aChunk[5];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER;
@@ -232,13 +431,11 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 	else
 	{
 		unsigned char aChunk[1];
-		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
+		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastChunkTick);
 		io_write(m_File, aChunk, sizeof(aChunk));
 	}
 
-	m_LastTickMarker = Tick;
-	if(m_FirstTick < 0)
-		m_FirstTick = Tick;
+	m_LastChunkTick = Tick;
 }
 
 void CDemoRecorder::Write(int Type, const void *pData, int Size)
@@ -293,6 +490,18 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 }
 
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+{
+	m_LastTickMarker = Tick;
+	if(m_FirstTick < 0)
+		m_FirstTick = Tick;
+
+	if(m_pWriter)
+		m_pWriter->Push(CWriter::RECORD_SNAPSHOT, Tick, pData, Size);
+	else
+		WriteSnapshot(Tick, pData, Size, m_pSnapshotDelta);
+}
+
+void CDemoRecorder::WriteSnapshot(int Tick, const void *pData, int Size, CSnapshotDelta *pSnapshotDelta)
 {
 	if(m_LastKeyFrame == -1 || (Tick - m_LastKeyFrame) > SERVER_TICK_SPEED * 5)
 	{
@@ -314,7 +523,7 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 		// write tickmarker
 		WriteTickMarker(Tick, 0);
 
-		DeltaSize = m_pSnapshotDelta->CreateDelta((CSnapshot *)m_aLastSnapshotData, (CSnapshot *)pData, &aDeltaData);
+		DeltaSize = pSnapshotDelta->CreateDelta((CSnapshot *)m_aLastSnapshotData, (CSnapshot *)pData, &aDeltaData);
 		if(DeltaSize)
 		{
 			// record delta
@@ -333,7 +542,10 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 			return;
 		}
 	}
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	if(m_pWriter)
+		m_pWriter->Push(CWriter::RECORD_MESSAGE, -1, pData, Size);
+	else
+		Write(CHUNKTYPE_MESSAGE, pData, Size);
 }
 
 int CDemoRecorder::Stop()
@@ -341,6 +553,17 @@ int CDemoRecorder::Stop()
 	if(!m_File)
 		return -1;
 
+	char aWriterStats[128] = "";
+	if(m_pWriter)
+	{
+		// flush the queued records
+		CWriterStats Stats;
+		GetWriterStats(&Stats);
+		delete m_pWriter;
+		m_pWriter = 0;
+		str_format(aWriterStats, sizeof(aWriterStats), " (records=%lld sync=%lld peak=%d/%d bytes)", Stats.m_NumRecords, Stats.m_NumSync, Stats.m_PeakBytes, Stats.m_BufferSize);
+	}
+
 	// add the demo length to the header
 	io_seek(m_File, s_LengthOffset, IOSEEK_START);
 	int DemoLength = Length();
@@ -373,7 +596,11 @@ int CDemoRecorder::Stop()
 	io_close(m_File);
 	m_File = 0;
 	if(m_pConsole)
-		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording");
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "Stopped recording%s", aWriterStats);
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
+	}
 
 	return 0;
 }
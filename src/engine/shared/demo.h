@@ -12,10 +12,26 @@
 
 class CDemoRecorder : public IDemoRecorder
 {
+public:
+	// backpressure counters of the asynchronous writer
+	struct CWriterStats
+	{
+		int m_BufferSize;
+		int m_QueuedBytes;
+		int m_PeakBytes;
+		int64 m_NumRecords;
+		// records written by the recording thread because the buffer was full
+		int64 m_NumSync;
+	};
+
+private:
+	class CWriter;
+
 	class IConsole *m_pConsole;
 	IOHANDLE m_File;
 	char m_aCurrentFilename[256];
 	int m_LastTickMarker;
+	int m_LastChunkTick;
 	int m_LastKeyFrame;
 	int m_FirstTick;
 	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
@@ -28,12 +44,26 @@ class CDemoRecorder : public IDemoRecorder
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
+	// compression and disk writes happen on this thread if set
+	int m_AsyncBufferSize;
+	CWriter *m_pWriter;
+
 	void WriteTickMarker(int Tick, int Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void WriteSnapshot(int Tick, const void *pData, int Size, class CSnapshotDelta *pSnapshotDelta);
 
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
-	CDemoRecorder() {}
+	CDemoRecorder() :
+		m_File(0), m_AsyncBufferSize(0), m_pWriter(0) {}
+
+	// records are queued into a buffer of `BufferSize` bytes and written by a
+	// separate thread, records that don't fit are written synchronously once the
+	// thread caught up. 0 writes synchronously.
+	// takes effect on the next `Start`
+	void SetAsync(int BufferSize) { m_AsyncBufferSize = BufferSize; }
+	bool IsAsync() const { return m_pWriter != 0; }
+	void GetWriterStats(CWriterStats *pStats) const;
 
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST *pSha256, unsigned MapCrc, const char *pType, unsigned int MapSize, unsigned char *pMapData, IOHANDLE MapFile = 0, DEMOFUNC_FILTER pfnFilter = 0, void *pUser = 0);
 	int Stop();
@@ -472,9 +472,18 @@ void CHttpRequest::OnCompletionInternal(void *pHandle, unsigned int Result)
 	// or other threads may try to access the result of a completed HTTP request,
 	// before the result has been initialized/updated in OnCompletion.
 	OnCompletion(State);
+	SetDone(State);
+}
+
+void CHttpRequest::SetDone(EHttpState State)
+{
 	{
 		std::unique_lock WaitLock(m_WaitMutex);
 		m_State = State;
+		// still under the lock, the queue may be destroyed as soon as
+		// `Wait()` returns
+		if(m_pCompletionQueue)
+			m_pCompletionQueue->Push(this);
 	}
 	m_WaitCondition.notify_all();
 }
@@ -711,11 +720,7 @@ void CHttp::RunLoop()
 			if(pRequest->ShouldSkipRequest())
 			{
 				pRequest->OnCompletion(EHttpState::DONE);
-				{
-					std::unique_lock WaitLock(pRequest->m_WaitMutex);
-					pRequest->m_State = EHttpState::DONE;
-				}
-				pRequest->m_WaitCondition.notify_all();
+				pRequest->SetDone(EHttpState::DONE);
 				NewRequests.pop_front();
 				continue;
 			}
@@ -830,3 +835,47 @@ CHttp::~CHttp()
 	Shutdown();
 	thread_wait(m_pThread);
 }
+
+void CHttpCompletionQueue::Push(CHttpRequest *pRequest)
+{
+	std::unique_lock Lock(m_Lock);
+	m_vCompleted.push_back(pRequest);
+}
+
+CHttpCompletionQueue::~CHttpCompletionQueue()
+{
+	for(auto &[pRequest, Entry] : m_Pending)
+	{
+		pRequest->Abort();
+		pRequest->Wait();
+	}
+}
+
+void CHttpCompletionQueue::Run(IHttp *pHttp, std::shared_ptr<CHttpRequest> pRequest, FCallback &&Callback)
+{
+	CHttpRequest *pKey = pRequest.get();
+	pRequest->m_pCompletionQueue = this;
+	m_Pending.emplace(pKey, std::make_pair(pRequest, std::move(Callback)));
+	pHttp->Run(pRequest);
+}
+
+int CHttpCompletionQueue::Drain()
+{
+	std::vector<CHttpRequest *> vCompleted;
+	{
+		std::unique_lock Lock(m_Lock);
+		std::swap(vCompleted, m_vCompleted);
+	}
+
+	for(CHttpRequest *pRequest : vCompleted)
+	{
+		auto It = m_Pending.find(pRequest);
+		if(It == m_Pending.end())
+			continue;
+		// keep the request alive while the callback runs
+		auto Entry = std::move(It->second);
+		m_Pending.erase(It);
+		Entry.second(Entry.first.get());
+	}
+	return vCompleted.size();
+}
@@ -9,9 +9,11 @@
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 #include <engine/http.h>
 
@@ -48,9 +50,12 @@ struct CTimeout
 	long LowSpeedTime;
 };
 
+class CHttpCompletionQueue;
+
 class CHttpRequest : public IHttpRequest
 {
 	friend class CHttp;
+	friend class CHttpCompletionQueue;
 
 	enum class REQUEST
 	{
@@ -125,6 +130,7 @@ class CHttpRequest : public IHttpRequest
 	std::atomic<bool> m_Abort{false};
 	std::mutex m_WaitMutex;
 	std::condition_variable m_WaitCondition;
+	CHttpCompletionQueue *m_pCompletionQueue = nullptr;
 
 	int m_StatusCode = 0;
 	bool m_HeadersEnded = false;
@@ -137,6 +143,8 @@ class CHttpRequest : public IHttpRequest
 	bool ConfigureHandle(void *pHandle); // void * == CURL *
 	// `pHandle` can be nullptr if no handle was ever created for this request.
 	void OnCompletionInternal(void *pHandle, unsigned int Result); // void * == CURL *, unsigned int == CURLcode
+	// Publishes the final state to `Wait()` and the completion queue.
+	void SetDone(EHttpState State);
 
 	// Abort the request if `OnHeader()` returns something other than
 	// `DataSize`. `pHeader` is NOT null-terminated.
@@ -294,6 +302,35 @@ inline std::unique_ptr<CHttpRequest> HttpPostJson(const char *pUrl, CConfig *pCo
 	return pResult;
 }
 
+// Delivers finished requests to the thread that calls `Drain()`, e.g. once
+// per game tick, so that the callbacks can safely touch the game state.
+class CHttpCompletionQueue
+{
+public:
+	typedef std::function<void(CHttpRequest *pRequest)> FCallback;
+
+private:
+	friend class CHttpRequest;
+
+	// only touched by the draining thread
+	std::unordered_map<CHttpRequest *, std::pair<std::shared_ptr<CHttpRequest>, FCallback>> m_Pending;
+
+	std::mutex m_Lock;
+	std::vector<CHttpRequest *> m_vCompleted;
+
+	// called from the http thread
+	void Push(CHttpRequest *pRequest);
+
+public:
+	~CHttpCompletionQueue();
+
+	// Starts the request, `Callback` is invoked from `Drain()` once it has finished.
+	void Run(IHttp *pHttp, std::shared_ptr<CHttpRequest> pRequest, FCallback &&Callback);
+	// Runs the callbacks of all finished requests, returns their number.
+	int Drain();
+	int NumPending() const { return m_Pending.size(); }
+};
+
 void EscapeUrl(char *pBuf, int Size, const char *pStr);
 
 template<int N>
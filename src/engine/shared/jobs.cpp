@@ -1,12 +1,16 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "jobs.h"
+
+#include <base/math.h>
+
 #include <algorithm>
 
 IJob::IJob() :
-	m_pNext(nullptr),
 	m_State(STATE_QUEUED),
-	m_Abortable(false)
+	m_Abortable(false),
+	m_Priority(PRIORITY_LATENCY),
+	m_QueueTime(0)
 {
 }
 
@@ -45,6 +49,17 @@ bool IJob::IsAbortable() const
 CJobPool::CJobPool()
 {
 	m_Shutdown = true;
+	m_NumWorkers = 0;
+	m_NextWorker = 0;
+	m_NumQueued = 0;
+	m_NumStolen = 0;
+	for(int i = 0; i < IJob::NUM_PRIORITIES; i++)
+	{
+		m_aNumDone[i] = 0;
+		m_aWaitTime[i] = 0;
+		m_aRunTime[i] = 0;
+		m_aMaxRunTime[i] = 0;
+	}
 }
 
 CJobPool::~CJobPool()
@@ -57,74 +72,120 @@ CJobPool::~CJobPool()
 
 void CJobPool::WorkerThread(void *pUser)
 {
-	static_cast<CJobPool *>(pUser)->RunLoop();
+	CWorker *pWorker = static_cast<CWorker *>(pUser);
+	pWorker->m_pPool->RunLoop(pWorker->m_Index);
 }
 
-void CJobPool::RunLoop()
+std::shared_ptr<IJob> CJobPool::PopJob(int Worker)
+{
+	const int NumWorkers = m_NumWorkers.load(std::memory_order_acquire);
+	for(int Priority = 0; Priority < IJob::NUM_PRIORITIES; Priority++)
+	{
+		// own queue first, then the others starting with the next worker
+		for(int i = 0; i < NumWorkers; i++)
+		{
+			CWorker &Victim = m_aWorkers[(Worker + i) % NumWorkers];
+			const CLockScope LockScope(Victim.m_Lock);
+			std::deque<std::shared_ptr<IJob>> &Queue = Victim.m_aQueues[Priority];
+			if(Queue.empty())
+				continue;
+			std::shared_ptr<IJob> pJob = std::move(Queue.front());
+			Queue.pop_front();
+			m_NumQueued.fetch_sub(1, std::memory_order_relaxed);
+			if(i != 0)
+				m_NumStolen.fetch_add(1, std::memory_order_relaxed);
+			return pJob;
+		}
+	}
+	return nullptr;
+}
+
+void CJobPool::RunJob(std::shared_ptr<IJob> &pJob)
+{
+	IJob::EJobState OldStateQueued = IJob::STATE_QUEUED;
+	if(!pJob->m_State.compare_exchange_strong(OldStateQueued, IJob::STATE_RUNNING))
+	{
+		if(OldStateQueued == IJob::STATE_ABORTED)
+		{
+			// job was aborted before it was started
+			pJob->m_State = IJob::STATE_ABORTED;
+			return;
+		}
+		dbg_assert(false, "Job state invalid. Job was reused or uninitialized.");
+		dbg_break();
+	}
+
+	const int Priority = pJob->m_Priority;
+	const int64 StartTime = time_get();
+	m_aWaitTime[Priority].fetch_add(StartTime - pJob->m_QueueTime, std::memory_order_relaxed);
+
+	// remember running jobs so we can abort them
+	{
+		const CLockScope LockScope(m_LockRunning);
+		m_RunningJobs.push_back(pJob);
+	}
+	pJob->Run();
+	{
+		const CLockScope LockScope(m_LockRunning);
+		m_RunningJobs.erase(std::find(m_RunningJobs.begin(), m_RunningJobs.end(), pJob));
+	}
+
+	const int64 RunTime = time_get() - StartTime;
+	m_aNumDone[Priority].fetch_add(1, std::memory_order_relaxed);
+	m_aRunTime[Priority].fetch_add(RunTime, std::memory_order_relaxed);
+	int64 MaxRunTime = m_aMaxRunTime[Priority].load(std::memory_order_relaxed);
+	while(RunTime > MaxRunTime && !m_aMaxRunTime[Priority].compare_exchange_weak(MaxRunTime, RunTime, std::memory_order_relaxed))
+	{
+	}
+
+	// do not change state to done if job was not completed successfully
+	IJob::EJobState OldStateRunning = IJob::STATE_RUNNING;
+	if(!pJob->m_State.compare_exchange_strong(OldStateRunning, IJob::STATE_DONE))
+	{
+		if(OldStateRunning != IJob::STATE_ABORTED)
+		{
+			dbg_assert(false, "Job state invalid, must be either running or aborted");
+		}
+	}
+}
+
+void CJobPool::RunLoop(int Worker)
 {
 	while(true)
 	{
 		// wait for job to become available
 		sphore_wait(&m_Semaphore);
 
-		// fetch job from queue
-		std::shared_ptr<IJob> pJob = nullptr;
-		{
-			const CLockScope LockScope(m_Lock);
-			if(m_pFirstJob)
-			{
-				pJob = m_pFirstJob;
-				m_pFirstJob = m_pFirstJob->m_pNext;
-				// allow remaining objects in list to destruct, even when current object stays alive
-				pJob->m_pNext = nullptr;
-				if(!m_pFirstJob)
-					m_pLastJob = nullptr;
-			}
-		}
+		// every wakeup belongs to a queued job, but another worker may take
+		// it first and leave ours in a queue that was already scanned
+		std::shared_ptr<IJob> pJob;
+		while(!(pJob = PopJob(Worker)) && !m_Shutdown)
+			thread_yield();
 
 		if(pJob)
 		{
-			IJob::EJobState OldStateQueued = IJob::STATE_QUEUED;
-			if(!pJob->m_State.compare_exchange_strong(OldStateQueued, IJob::STATE_RUNNING))
-			{
-				if(OldStateQueued == IJob::STATE_ABORTED)
-				{
-					// job was aborted before it was started
-					pJob->m_State = IJob::STATE_ABORTED;
-					continue;
-				}
-				dbg_assert(false, "Job state invalid. Job was reused or uninitialized.");
-				dbg_break();
-			}
-
-			// remember running jobs so we can abort them
-			{
-				const CLockScope LockScope(m_LockRunning);
-				m_RunningJobs.push_back(pJob);
-			}
-			pJob->Run();
-			{
-				const CLockScope LockScope(m_LockRunning);
-				m_RunningJobs.erase(std::find(m_RunningJobs.begin(), m_RunningJobs.end(), pJob));
-			}
-
-			// do not change state to done if job was not completed successfully
-			IJob::EJobState OldStateRunning = IJob::STATE_RUNNING;
-			if(!pJob->m_State.compare_exchange_strong(OldStateRunning, IJob::STATE_DONE))
-			{
-				if(OldStateRunning != IJob::STATE_ABORTED)
-				{
-					dbg_assert(false, "Job state invalid, must be either running or aborted");
-				}
-			}
+			RunJob(pJob);
 		}
-		else if(m_Shutdown)
+		else
 		{
 			// shut down worker thread when pool is shutting down and no more jobs are left
 			break;
 		}
 	}
+}
 
+void CJobPool::StartWorkers(int NumThreads)
+{
+	dbg_assert(NumThreads <= MAX_THREADS, "too many job threads");
+	for(int i = m_NumWorkers; i < NumThreads; i++)
+	{
+		CWorker &Worker = m_aWorkers[i];
+		Worker.m_pPool = this;
+		Worker.m_Index = i;
+		// publish the worker before it starts, so its queues can be stolen from
+		m_NumWorkers.store(i + 1, std::memory_order_release);
+		Worker.m_pThread = thread_init(WorkerThread, &Worker, "CJobPool worker");
+	}
 }
 
 void CJobPool::Init(int NumThreads)
@@ -132,17 +193,15 @@ void CJobPool::Init(int NumThreads)
 	dbg_assert(m_Shutdown, "Job pool already running");
 	m_Shutdown = false;
 
-	const CLockScope LockScope(m_Lock);
 	sphore_init(&m_Semaphore);
-	m_pFirstJob = nullptr;
-	m_pLastJob = nullptr;
+	m_NumWorkers = 0;
+	StartWorkers(NumThreads);
+}
 
-	// start worker threads
-	m_vpThreads.reserve(NumThreads);
-	for(int i = 0; i < NumThreads; i++)
-	{
-		m_vpThreads.push_back(thread_init(WorkerThread, this, "CJobPool worker"));
-	}
+void CJobPool::SetNumThreads(int NumThreads)
+{
+	dbg_assert(!m_Shutdown, "Job pool not running");
+	StartWorkers(minimum(NumThreads, (int)MAX_THREADS));
 }
 
 void CJobPool::Shutdown()
@@ -150,34 +209,20 @@ void CJobPool::Shutdown()
 	dbg_assert(!m_Shutdown, "Job pool already shut down");
 	m_Shutdown = true;
 
+	const int NumWorkers = m_NumWorkers;
+
 	// abort queued jobs
+	for(int i = 0; i < NumWorkers; i++)
 	{
-		const CLockScope LockScope(m_Lock);
-		std::shared_ptr<IJob> pJob = m_pFirstJob;
-		std::shared_ptr<IJob> pPrev = nullptr;
-		while(pJob != nullptr)
+		CWorker &Worker = m_aWorkers[i];
+		const CLockScope LockScope(Worker.m_Lock);
+		for(auto &Queue : Worker.m_aQueues)
 		{
-			std::shared_ptr<IJob> pNext = pJob->m_pNext;
-			if(pJob->Abort())
-			{
-				// only remove abortable jobs from queue
-				pJob->m_pNext = nullptr;
-				if(pPrev)
-				{
-					pPrev->m_pNext = pNext;
-				}
-				else
-				{
-					m_pFirstJob = pNext;
-				}
-			}
-			else
-			{
-				pPrev = pJob;
-			}
-			pJob = pNext;
+			// only remove abortable jobs from queue
+			const size_t OldSize = Queue.size();
+			Queue.erase(std::remove_if(Queue.begin(), Queue.end(), [](const std::shared_ptr<IJob> &pJob) { return pJob->Abort(); }), Queue.end());
+			m_NumQueued.fetch_sub(OldSize - Queue.size(), std::memory_order_relaxed);
 		}
-		m_pLastJob = pPrev;
 	}
 
 	// abort running jobs
@@ -190,18 +235,19 @@ void CJobPool::Shutdown()
 	}
 
 	// wake up all worker threads
-	for(size_t i = 0; i < m_vpThreads.size(); i++)
+	for(int i = 0; i < NumWorkers; i++)
 	{
 		sphore_signal(&m_Semaphore);
 	}
 
 	// wait for all worker threads to finish
-	for(void *pThread : m_vpThreads)
+	for(int i = 0; i < NumWorkers; i++)
 	{
-		thread_wait(pThread);
+		thread_wait(m_aWorkers[i].m_pThread);
+		m_aWorkers[i].m_pThread = nullptr;
 	}
 
-	m_vpThreads.clear();
+	m_NumWorkers = 0;
 	sphore_destroy(&m_Semaphore);
 }
 
@@ -215,19 +261,31 @@ void CJobPool::Add(std::shared_ptr<IJob> pJob)
 	}
 
 	// add job to queue
+	pJob->m_QueueTime = time_get();
+	const int Priority = pJob->m_Priority;
+	CWorker &Worker = m_aWorkers[m_NextWorker.fetch_add(1, std::memory_order_relaxed) % m_NumWorkers.load(std::memory_order_acquire)];
 	{
-		const CLockScope LockScope(m_Lock);
-		if(m_pLastJob)
-			m_pLastJob->m_pNext = pJob;
-		m_pLastJob = std::move(pJob);
-		if(!m_pFirstJob)
-			m_pFirstJob = m_pLastJob;
+		const CLockScope LockScope(Worker.m_Lock);
+		Worker.m_aQueues[Priority].push_back(std::move(pJob));
+		m_NumQueued.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	// signal a worker thread that a job is available
 	sphore_signal(&m_Semaphore);
 }
 
+void CJobPool::GetStats(CStats *pStats) const
+{
+	for(int i = 0; i < IJob::NUM_PRIORITIES; i++)
+	{
+		pStats->m_aNumDone[i] = m_aNumDone[i].load(std::memory_order_relaxed);
+		pStats->m_aWaitTime[i] = m_aWaitTime[i].load(std::memory_order_relaxed);
+		pStats->m_aRunTime[i] = m_aRunTime[i].load(std::memory_order_relaxed);
+		pStats->m_aMaxRunTime[i] = m_aMaxRunTime[i].load(std::memory_order_relaxed);
+	}
+	pStats->m_NumStolen = m_NumStolen.load(std::memory_order_relaxed);
+}
+
 void CJobPool::RunBlocking(IJob *pJob)
 {
 	pJob->m_State = IJob::STATE_RUNNING;
@@ -50,10 +50,30 @@ public:
 		STATE_ABORTED,
 	};
 
+	/**
+	 * The scheduling class of a job. Queued jobs of a higher priority are
+	 * always started before jobs of a lower priority.
+	 */
+	enum EJobPriority
+	{
+		/**
+		 * Jobs whose result is waited for, e.g. by a connecting client.
+		 */
+		PRIORITY_LATENCY = 0,
+
+		/**
+		 * Background work which may be delayed, e.g. master server registration.
+		 */
+		PRIORITY_BULK,
+
+		NUM_PRIORITIES,
+	};
+
 private:
-	std::shared_ptr<IJob> m_pNext;
 	std::atomic<EJobState> m_State;
 	std::atomic<bool> m_Abortable;
+	EJobPriority m_Priority;
+	int64 m_QueueTime;
 
 protected:
 	/**
@@ -70,6 +90,14 @@ protected:
 	 */
 	void Abortable(bool Abortable);
 
+	/**
+	 * Sets the scheduling class of this job, the default is
+	 * @link PRIORITY_LATENCY @endlink.
+	 *
+	 * @remark Must be called before the job is enqueued.
+	 */
+	void Priority(EJobPriority Priority) { m_Priority = Priority; }
+
 public:
 	IJob();
 	virtual ~IJob();
@@ -117,28 +145,74 @@ public:
 	 * @return `true` if the job can be aborted, `false` otherwise.
 	 */
 	bool IsAbortable() const;
+
+	EJobPriority Priority() const { return m_Priority; }
 };
 
 /**
  * A job pool which runs jobs in one or more worker threads.
  *
+ * Every worker owns a queue per priority. Jobs are distributed over the
+ * workers round-robin and a worker without queued jobs of a priority
+ * steals from the other workers before it looks at lower priorities.
+ *
  * @see IJob
  */
 class CJobPool
 {
-	std::vector<void *> m_vpThreads;
+public:
+	enum
+	{
+		MAX_THREADS = 32,
+	};
+
+	/**
+	 * Running totals of the pool, durations are in `time_get` units.
+	 */
+	struct CStats
+	{
+		int64 m_aNumDone[IJob::NUM_PRIORITIES];
+		int64 m_aWaitTime[IJob::NUM_PRIORITIES];
+		int64 m_aRunTime[IJob::NUM_PRIORITIES];
+		int64 m_aMaxRunTime[IJob::NUM_PRIORITIES];
+		int64 m_NumStolen;
+	};
+
+private:
+	struct CWorker
+	{
+		CJobPool *m_pPool;
+		int m_Index;
+		void *m_pThread;
+
+		CmutexLock m_Lock;
+		std::deque<std::shared_ptr<IJob>> m_aQueues[IJob::NUM_PRIORITIES] GUARDED_BY(m_Lock);
+	};
+
+	CWorker m_aWorkers[MAX_THREADS];
+	std::atomic<int> m_NumWorkers;
+	std::atomic<unsigned> m_NextWorker;
 	std::atomic<bool> m_Shutdown;
 
-	CmutexLock m_Lock;
+	// counts queued jobs, plus one wakeup per worker on shutdown
 	SEMAPHORE m_Semaphore;
-	std::shared_ptr<IJob> m_pFirstJob GUARDED_BY(m_Lock);
-	std::shared_ptr<IJob> m_pLastJob GUARDED_BY(m_Lock);
+
+	std::atomic<int> m_NumQueued;
+
+	std::atomic<int64> m_aNumDone[IJob::NUM_PRIORITIES];
+	std::atomic<int64> m_aWaitTime[IJob::NUM_PRIORITIES];
+	std::atomic<int64> m_aRunTime[IJob::NUM_PRIORITIES];
+	std::atomic<int64> m_aMaxRunTime[IJob::NUM_PRIORITIES];
+	std::atomic<int64> m_NumStolen;
 
 	CmutexLock m_LockRunning;
 	std::deque<std::shared_ptr<IJob>> m_RunningJobs GUARDED_BY(m_LockRunning);
 
 	static void WorkerThread(void *pUser) NO_THREAD_SAFETY_ANALYSIS;
-	void RunLoop() NO_THREAD_SAFETY_ANALYSIS;
+	void RunLoop(int Worker) NO_THREAD_SAFETY_ANALYSIS;
+	void StartWorkers(int NumThreads);
+	std::shared_ptr<IJob> PopJob(int Worker) NO_THREAD_SAFETY_ANALYSIS;
+	void RunJob(std::shared_ptr<IJob> &pJob) REQUIRES(!m_LockRunning);
 
 public:
 	CJobPool();
@@ -147,11 +221,19 @@ public:
 	/**
 	 * Initializes the job pool with the given number of worker threads.
 	 *
-	 * @param NumTheads The number of worker threads.
+	 * @param NumTheads The number of worker threads, at most @link MAX_THREADS @endlink.
+	 *
+	 * @remark Must be called on the main thread.
+	 */
+	void Init(int NumThreads);
+
+	/**
+	 * Starts additional worker threads until there are `NumThreads` of them.
+	 * Running workers are never stopped.
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Init(int NumThreads) REQUIRES(!m_Lock);
+	void SetNumThreads(int NumThreads);
 
 	/**
 	 * Shuts down the job pool. Aborts all abortable jobs. Then waits for all
@@ -159,7 +241,7 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Shutdown() REQUIRES(!m_Lock) REQUIRES(!m_LockRunning);
+	void Shutdown() REQUIRES(!m_LockRunning);
 
 	/**
 	 * Adds a job to the queue of the job pool.
@@ -169,7 +251,14 @@ public:
 	 * @remark If the job pool is already shutting down, no additional jobs
 	 * will be enqueue anymore. Abortable jobs will immediately be aborted.
 	 */
-	void Add(std::shared_ptr<IJob> pJob) REQUIRES(!m_Lock);
+	void Add(std::shared_ptr<IJob> pJob);
+
+	/**
+	 * Returns the number of jobs waiting for a worker thread.
+	 */
+	int NumQueued() const { return m_NumQueued.load(std::memory_order_relaxed); }
+	int NumThreads() const { return m_NumWorkers.load(std::memory_order_relaxed); }
+	void GetStats(CStats *pStats) const;
 	static void RunBlocking(IJob *pJob);
 };
 #endif
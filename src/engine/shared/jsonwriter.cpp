@@ -102,6 +102,14 @@ void CJsonWriter::WriteNullValue()
 	CompleteDataType();
 }
 
+void CJsonWriter::WriteRawValue(const char *pValue)
+{
+	dbg_assert(CanWriteDatatype(), "Cannot write value here");
+	WriteIndent(false);
+	WriteInternal(pValue);
+	CompleteDataType();
+}
+
 bool CJsonWriter::CanWriteDatatype()
 {
 	return m_States.empty() || TopState()->m_Kind == STATE_ARRAY || TopState()->m_Kind == STATE_ATTRIBUTE;
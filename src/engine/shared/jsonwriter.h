@@ -77,6 +77,9 @@ public:
 	void WriteIntValue(int Value);
 	void WriteBoolValue(bool Value);
 	void WriteNullValue();
+	// Write an already encoded value, e.g. the output of another writer.
+	// The value is not checked and keeps its own indentation.
+	void WriteRawValue(const char *pValue);
 };
 
 /**
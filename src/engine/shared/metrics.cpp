@@ -0,0 +1,216 @@
+#include "metrics.h"
+
+int CMetricCounter::ShardIndex()
+{
+	static std::atomic<int> s_NextShard{0};
+	thread_local int s_Shard = s_NextShard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+	return s_Shard;
+}
+
+int64 CMetricCounter::Value() const
+{
+	int64 Value = 0;
+	for(const CShard &Shard : m_aShards)
+		Value += Shard.m_Value.load(std::memory_order_relaxed);
+	return Value;
+}
+
+CMetricHistogram::CMetricHistogram(std::vector<int64> vBounds, double Scale) :
+	m_vBounds(std::move(vBounds)), m_pCounts(new std::atomic<int64>[m_vBounds.size() + 1]), m_Scale(Scale)
+{
+	for(size_t i = 0; i <= m_vBounds.size(); i++)
+		m_pCounts[i].store(0, std::memory_order_relaxed);
+}
+
+void CMetricHistogram::Observe(int64 Value)
+{
+	// the last bucket is +Inf
+	size_t Bucket = 0;
+	while(Bucket < m_vBounds.size() && Value > m_vBounds[Bucket])
+		Bucket++;
+	m_pCounts[Bucket].fetch_add(1, std::memory_order_relaxed);
+	m_Sum.fetch_add(Value, std::memory_order_relaxed);
+}
+
+CMetrics::CEntry *CMetrics::Find(const char *pName, EType Type)
+{
+	for(auto &pEntry : m_vpEntries)
+	{
+		if(pEntry->m_Name == pName)
+		{
+			dbg_assert(pEntry->m_Type == Type, "metric registered with a different type");
+			return pEntry.get();
+		}
+	}
+	return nullptr;
+}
+
+CMetricCounter *CMetrics::Counter(const char *pName, const char *pHelp)
+{
+	std::unique_lock Lock(m_Lock);
+	if(CEntry *pEntry = Find(pName, TYPE_COUNTER))
+		return pEntry->m_pCounter.get();
+
+	auto pEntry = std::make_unique<CEntry>();
+	pEntry->m_Name = pName;
+	pEntry->m_Help = pHelp;
+	pEntry->m_Type = TYPE_COUNTER;
+	pEntry->m_pCounter = std::make_unique<CMetricCounter>();
+	m_vpEntries.push_back(std::move(pEntry));
+	return m_vpEntries.back()->m_pCounter.get();
+}
+
+CMetricGauge *CMetrics::Gauge(const char *pName, const char *pHelp)
+{
+	std::unique_lock Lock(m_Lock);
+	if(CEntry *pEntry = Find(pName, TYPE_GAUGE))
+		return pEntry->m_pGauge.get();
+
+	auto pEntry = std::make_unique<CEntry>();
+	pEntry->m_Name = pName;
+	pEntry->m_Help = pHelp;
+	pEntry->m_Type = TYPE_GAUGE;
+	pEntry->m_pGauge = std::make_unique<CMetricGauge>();
+	m_vpEntries.push_back(std::move(pEntry));
+	return m_vpEntries.back()->m_pGauge.get();
+}
+
+CMetricHistogram *CMetrics::Histogram(const char *pName, const char *pHelp, std::vector<int64> vBounds, double Scale)
+{
+	std::unique_lock Lock(m_Lock);
+	if(CEntry *pEntry = Find(pName, TYPE_HISTOGRAM))
+		return pEntry->m_pHistogram.get();
+
+	auto pEntry = std::make_unique<CEntry>();
+	pEntry->m_Name = pName;
+	pEntry->m_Help = pHelp;
+	pEntry->m_Type = TYPE_HISTOGRAM;
+	pEntry->m_pHistogram = std::make_unique<CMetricHistogram>(std::move(vBounds), Scale);
+	m_vpEntries.push_back(std::move(pEntry));
+	return m_vpEntries.back()->m_pHistogram.get();
+}
+
+void CMetrics::Render(std::string &Out) const
+{
+	static const char *s_apTypeNames[] = {"counter", "gauge", "histogram"};
+
+	std::unique_lock Lock(m_Lock);
+	char aBuf[256];
+	for(const auto &pEntry : m_vpEntries)
+	{
+		const char *pName = pEntry->m_Name.c_str();
+		str_format(aBuf, sizeof(aBuf), "# HELP %s %s\n# TYPE %s %s\n", pName, pEntry->m_Help.c_str(), pName, s_apTypeNames[pEntry->m_Type]);
+		Out += aBuf;
+
+		switch(pEntry->m_Type)
+		{
+		case TYPE_COUNTER:
+			str_format(aBuf, sizeof(aBuf), "%s %lld\n", pName, pEntry->m_pCounter->Value());
+			Out += aBuf;
+			break;
+		case TYPE_GAUGE:
+			str_format(aBuf, sizeof(aBuf), "%s %lld\n", pName, pEntry->m_pGauge->Value());
+			Out += aBuf;
+			break;
+		case TYPE_HISTOGRAM:
+		{
+			const CMetricHistogram *pHistogram = pEntry->m_pHistogram.get();
+			int64 Cumulative = 0;
+			for(size_t i = 0; i <= pHistogram->m_vBounds.size(); i++)
+			{
+				Cumulative += pHistogram->m_pCounts[i].load(std::memory_order_relaxed);
+				if(i < pHistogram->m_vBounds.size())
+					str_format(aBuf, sizeof(aBuf), "%s_bucket{le=\"%g\"} %lld\n", pName, pHistogram->m_vBounds[i] * pHistogram->m_Scale, Cumulative);
+				else
+					str_format(aBuf, sizeof(aBuf), "%s_bucket{le=\"+Inf\"} %lld\n", pName, Cumulative);
+				Out += aBuf;
+			}
+			str_format(aBuf, sizeof(aBuf), "%s_sum %g\n%s_count %lld\n", pName, pHistogram->m_Sum.load(std::memory_order_relaxed) * pHistogram->m_Scale, pName, Cumulative);
+			Out += aBuf;
+			break;
+		}
+		}
+	}
+}
+
+bool CMetricsExporter::Open(CMetrics *pMetrics, NETADDR BindAddr)
+{
+	m_pMetrics = pMetrics;
+	m_Socket = net_tcp_create(BindAddr);
+	if(!m_Socket.type)
+		return false;
+	if(net_tcp_listen(m_Socket, 16) != 0)
+	{
+		net_tcp_close(m_Socket);
+		return false;
+	}
+	m_Shutdown = false;
+	m_pThread = thread_init(ThreadMain, this, "metrics");
+	return true;
+}
+
+void CMetricsExporter::Close()
+{
+	if(!m_pThread)
+		return;
+	m_Shutdown = true;
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+	net_tcp_close(m_Socket);
+}
+
+void CMetricsExporter::ThreadMain(void *pUser)
+{
+	static_cast<CMetricsExporter *>(pUser)->Run();
+}
+
+void CMetricsExporter::Run()
+{
+	while(!m_Shutdown)
+	{
+		// wake up regularly to check for shutdown
+		if(net_socket_read_wait(m_Socket, 100000) <= 0)
+			continue;
+
+		NETSOCKET Client;
+		NETADDR ClientAddr;
+		if(net_tcp_accept(m_Socket, &Client, &ClientAddr) < 0)
+			continue;
+		Serve(Client);
+		net_tcp_close(Client);
+	}
+}
+
+void CMetricsExporter::Serve(NETSOCKET Client)
+{
+	// every request gets the metrics, only wait for the end of the header
+	char aRequest[1024];
+	int Size = 0;
+	int64 Timeout = time_get() + time_freq();
+	while(Size < (int)sizeof(aRequest) - 1 && time_get() < Timeout && !m_Shutdown)
+	{
+		if(net_socket_read_wait(Client, 100000) <= 0)
+			continue;
+		int Bytes = net_tcp_recv(Client, aRequest + Size, sizeof(aRequest) - 1 - Size);
+		if(Bytes <= 0)
+			return;
+		Size += Bytes;
+		aRequest[Size] = 0;
+		if(str_find(aRequest, "\r\n\r\n") || str_find(aRequest, "\n\n"))
+			break;
+	}
+
+	std::string Body;
+	m_pMetrics->Render(Body);
+
+	char aHeader[256];
+	str_format(aHeader, sizeof(aHeader), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", (int)Body.size());
+	std::string Response = aHeader + Body;
+	for(size_t Sent = 0; Sent < Response.size();)
+	{
+		int Bytes = net_tcp_send(Client, Response.c_str() + Sent, Response.size() - Sent);
+		if(Bytes <= 0)
+			return;
+		Sent += Bytes;
+	}
+}
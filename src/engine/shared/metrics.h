@@ -0,0 +1,125 @@
+#ifndef ENGINE_SHARED_METRICS_H
+#define ENGINE_SHARED_METRICS_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Monotonic counter. Every thread adds to its own cache line, the shards
+ * are only summed up when the value is read.
+ */
+class CMetricCounter
+{
+	enum
+	{
+		NUM_SHARDS = 16,
+	};
+
+	struct alignas(64) CShard
+	{
+		std::atomic<int64> m_Value{0};
+	};
+
+	CShard m_aShards[NUM_SHARDS];
+
+	static int ShardIndex();
+
+public:
+	void Add(int64 Value = 1) { m_aShards[ShardIndex()].m_Value.fetch_add(Value, std::memory_order_relaxed); }
+	int64 Value() const;
+};
+
+class CMetricGauge
+{
+	std::atomic<int64> m_Value{0};
+
+public:
+	void Set(int64 Value) { m_Value.store(Value, std::memory_order_relaxed); }
+	void Add(int64 Value) { m_Value.fetch_add(Value, std::memory_order_relaxed); }
+	int64 Value() const { return m_Value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Histogram with fixed upper bounds. Observed values are integers, e.g.
+ * microseconds, and multiplied by the scale on export.
+ */
+class CMetricHistogram
+{
+	std::vector<int64> m_vBounds;
+	std::unique_ptr<std::atomic<int64>[]> m_pCounts;
+	std::atomic<int64> m_Sum{0};
+	double m_Scale;
+
+	friend class CMetrics;
+
+public:
+	CMetricHistogram(std::vector<int64> vBounds, double Scale);
+
+	void Observe(int64 Value);
+};
+
+/**
+ * Registry of all metrics of the process, rendered in the Prometheus text
+ * exposition format. Registering the same name twice returns the existing
+ * metric, so subsystems can register again after a reload.
+ */
+class CMetrics
+{
+	enum EType
+	{
+		TYPE_COUNTER,
+		TYPE_GAUGE,
+		TYPE_HISTOGRAM,
+	};
+
+	struct CEntry
+	{
+		std::string m_Name;
+		std::string m_Help;
+		EType m_Type;
+		std::unique_ptr<CMetricCounter> m_pCounter;
+		std::unique_ptr<CMetricGauge> m_pGauge;
+		std::unique_ptr<CMetricHistogram> m_pHistogram;
+	};
+
+	mutable std::mutex m_Lock;
+	std::vector<std::unique_ptr<CEntry>> m_vpEntries;
+
+	CEntry *Find(const char *pName, EType Type);
+
+public:
+	CMetricCounter *Counter(const char *pName, const char *pHelp);
+	CMetricGauge *Gauge(const char *pName, const char *pHelp);
+	CMetricHistogram *Histogram(const char *pName, const char *pHelp, std::vector<int64> vBounds, double Scale = 1.0);
+
+	void Render(std::string &Out) const;
+};
+
+/**
+ * Serves the metrics over http on a local tcp port, from its own thread.
+ */
+class CMetricsExporter
+{
+	CMetrics *m_pMetrics = nullptr;
+	NETSOCKET m_Socket;
+	void *m_pThread = nullptr;
+	std::atomic<bool> m_Shutdown{false};
+
+	static void ThreadMain(void *pUser);
+	void Run();
+	void Serve(NETSOCKET Client);
+
+public:
+	~CMetricsExporter() { Close(); }
+
+	bool Open(CMetrics *pMetrics, NETADDR BindAddr);
+	void Close();
+	bool IsOpen() const { return m_pThread != nullptr; }
+};
+
+#endif
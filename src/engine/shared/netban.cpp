@@ -4,103 +4,94 @@
 #include <engine/shared/config.h>
 #include <engine/storage.h>
 
+#include "linereader.h"
 #include "netban.h"
 
-CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
+template<class F>
+static void ForEachPrefix(const NETADDR *pAddr, F &&Fn)
 {
-	if(pAddr->type == NETTYPE_IPV4)
-		m_Hash = (pAddr->ip[0] + pAddr->ip[1] + pAddr->ip[2] + pAddr->ip[3]) & 0xFF;
-	else
-		m_Hash = (pAddr->ip[0] + pAddr->ip[1] + pAddr->ip[2] + pAddr->ip[3] + pAddr->ip[4] + pAddr->ip[5] + pAddr->ip[6] + pAddr->ip[7] +
-				 pAddr->ip[8] + pAddr->ip[9] + pAddr->ip[10] + pAddr->ip[11] + pAddr->ip[12] + pAddr->ip[13] + pAddr->ip[14] + pAddr->ip[15]) &
-			 0xFF;
-	m_HashIndex = 0;
+	Fn(pAddr->ip, NetAddressBits(pAddr->type));
 }
 
-CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
+template<class F>
+static void ForEachPrefix(const CNetRange *pRange, F &&Fn)
 {
-	m_Hash = 0;
-	m_HashIndex = 0;
-	for(int i = 0; pRange->m_LB.ip[i] == pRange->m_UB.ip[i]; ++i)
-	{
-		m_Hash += pRange->m_LB.ip[i];
-		++m_HashIndex;
-	}
-	m_Hash &= 0xFF;
+	NetRangeToPrefixes(&pRange->m_LB, &pRange->m_UB, Fn);
 }
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
+static int DataType(const NETADDR *pAddr) { return pAddr->type; }
+static int DataType(const CNetRange *pRange) { return pRange->m_LB.type; }
+
+template<class T>
+CNetBan::CBanPool<T>::CBanPool()
 {
-	int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
-	{
-		Sum += pAddr->ip[i - 1];
-		aHash[i].m_Hash = Sum & 0xFF;
-		aHash[i].m_HashIndex = i % Length;
-	}
-	return Length;
+	mem_zero(m_apWheel, sizeof(m_apWheel));
+	m_LastExpired = -1;
+	m_pFirstUsed = 0;
+	m_pLastUsed = 0;
+	m_CountUsed = 0;
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo, const CNetHash *pNetHash)
+template<class T>
+CNetBan::CBanPool<T>::~CBanPool()
 {
-	if(!m_pFirstFree)
-		return 0;
+	Reset();
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::WheelInsert(CBan<T> *pBan)
+{
+	pBan->m_pWheelPrev = 0;
+	pBan->m_pWheelNext = 0;
+	if(pBan->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER)
+		return;
+
+	CBan<T> **ppSlot = &m_apWheel[pBan->m_Info.m_Expires % WHEEL_SIZE];
+	if(*ppSlot)
+		(*ppSlot)->m_pWheelPrev = pBan;
+	pBan->m_pWheelNext = *ppSlot;
+	*ppSlot = pBan;
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::WheelRemove(CBan<T> *pBan)
+{
+	if(pBan->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER)
+		return;
+
+	if(pBan->m_pWheelNext)
+		pBan->m_pWheelNext->m_pWheelPrev = pBan->m_pWheelPrev;
+	if(pBan->m_pWheelPrev)
+		pBan->m_pWheelPrev->m_pWheelNext = pBan->m_pWheelNext;
+	else
+		m_apWheel[pBan->m_Info.m_Expires % WHEEL_SIZE] = pBan->m_pWheelNext;
+	pBan->m_pWheelNext = pBan->m_pWheelPrev = 0;
+}
 
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Add(const T *pData, const CBanInfo *pInfo)
+{
 	// create new ban
-	CBan<T> *pBan = m_pFirstFree;
+	CBan<T> *pBan = new CBan<T>;
 	pBan->m_Data = *pData;
 	pBan->m_Info = *pInfo;
-	pBan->m_NetHash = *pNetHash;
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstFree = pBan->m_pNext;
-
-	// add it to the hash list
-	if(m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash])
-		m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]->m_pHashPrev = pBan;
-	pBan->m_pHashPrev = 0;
-	pBan->m_pHashNext = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
-	m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
-
-	// insert it into the used list
-	if(m_pFirstUsed)
-	{
-		for(CBan<T> *p = m_pFirstUsed;; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
 
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
-		}
-	}
+	// index it
+	const int Type = DataType(pData);
+	ForEachPrefix(pData, [&](const unsigned char *pKey, int PrefixLength) {
+		m_Trie.Insert(Type, pKey, PrefixLength, pBan);
+		return true;
+	});
+	WheelInsert(pBan);
+
+	// append it to the used list
+	pBan->m_pNext = 0;
+	pBan->m_pPrev = m_pLastUsed;
+	if(m_pLastUsed)
+		m_pLastUsed->m_pNext = pBan;
 	else
-	{
 		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
-	}
+	m_pLastUsed = pBan;
 
 	// update ban count
 	++m_CountUsed;
@@ -108,35 +99,31 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	return pBan;
 }
 
-template<class T, int HashCount>
-int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
+template<class T>
+int CNetBan::CBanPool<T>::Remove(CBan<T> *pBan)
 {
 	if(pBan == 0)
 		return -1;
 
-	// remove from hash list
-	if(pBan->m_pHashNext)
-		pBan->m_pHashNext->m_pHashPrev = pBan->m_pHashPrev;
-	if(pBan->m_pHashPrev)
-		pBan->m_pHashPrev->m_pHashNext = pBan->m_pHashNext;
-	else
-		m_aapHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
-	pBan->m_pHashNext = pBan->m_pHashPrev = 0;
+	// remove from the index
+	const int Type = DataType(&pBan->m_Data);
+	ForEachPrefix(&pBan->m_Data, [&](const unsigned char *pKey, int PrefixLength) {
+		m_Trie.Remove(Type, pKey, PrefixLength, pBan);
+		return true;
+	});
+	WheelRemove(pBan);
 
 	// remove from used list
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
+	else
+		m_pLastUsed = pBan->m_pPrev;
 	if(pBan->m_pPrev)
 		pBan->m_pPrev->m_pNext = pBan->m_pNext;
 	else
 		m_pFirstUsed = pBan->m_pNext;
 
-	// add to recycle list
-	if(m_pFirstFree)
-		m_pFirstFree->m_pPrev = pBan;
-	pBan->m_pPrev = 0;
-	pBan->m_pNext = m_pFirstFree;
-	m_pFirstFree = pBan;
+	delete pBan;
 
 	// update ban count
 	--m_CountUsed;
@@ -144,52 +131,38 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 	return 0;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
+template<class T>
+void CNetBan::CBanPool<T>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
+	WheelRemove(pBan);
 	pBan->m_Info = *pInfo;
+	WheelInsert(pBan);
+}
 
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
+template<class T>
+template<class F>
+void CNetBan::CBanPool<T>::Expire(int Now, F &&pfnExpired)
+{
+	// visit every slot once after a long pause, else only the slots due since the last call
+	int First = m_LastExpired + 1;
+	if(m_LastExpired < 0 || Now - First > WHEEL_SIZE)
+		First = Now - WHEEL_SIZE;
 
-	// insert it into the used list
-	if(m_pFirstUsed)
+	for(int Time = First; Time < Now; Time++)
 	{
-		for(CBan<T> *p = m_pFirstUsed;; p = p->m_pNext)
+		CBan<T> *pBan = m_apWheel[Time % WHEEL_SIZE];
+		while(pBan)
 		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
+			CBan<T> *pNext = pBan->m_pWheelNext;
+			if(pBan->m_Info.m_Expires < Now)
 			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
-
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
+				pfnExpired(pBan);
+				Remove(pBan);
 			}
+			pBan = pNext;
 		}
 	}
-	else
-	{
-		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
-	}
+	m_LastExpired = Now - 1;
 }
 
 void CNetBan::UnbanAll()
@@ -198,27 +171,47 @@ void CNetBan::UnbanAll()
 	m_BanRangePool.Reset();
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Reset()
+template<class T>
+void CNetBan::CBanPool<T>::Reset()
 {
-	mem_zero(m_aapHashList, sizeof(m_aapHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
-	m_pFirstUsed = 0;
-	m_CountUsed = 0;
-
-	for(int i = 1; i < MAX_BANS - 1; ++i)
+	for(CBan<T> *pBan = m_pFirstUsed; pBan;)
 	{
-		m_aBans[i].m_pNext = &m_aBans[i + 1];
-		m_aBans[i].m_pPrev = &m_aBans[i - 1];
+		CBan<T> *pNext = pBan->m_pNext;
+		delete pBan;
+		pBan = pNext;
 	}
+	m_Trie.Clear();
+	mem_zero(m_apWheel, sizeof(m_apWheel));
+	m_pFirstUsed = 0;
+	m_pLastUsed = 0;
+	m_CountUsed = 0;
+}
 
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS - 1].m_pPrev = &m_aBans[MAX_BANS - 2];
-	m_pFirstFree = &m_aBans[0];
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Find(const T *pData) const
+{
+	// an identical ban is stored at the first prefix of the data
+	CBan<T> *pResult = 0;
+	const int Type = DataType(pData);
+	ForEachPrefix(pData, [&](const unsigned char *pKey, int PrefixLength) {
+		if(const std::vector<CBan<T> *> *pvBans = m_Trie.Find(Type, pKey, PrefixLength))
+		{
+			for(CBan<T> *pBan : *pvBans)
+			{
+				if(NetComp(&pBan->m_Data, pData) == 0)
+				{
+					pResult = pBan;
+					break;
+				}
+			}
+		}
+		return false;
+	});
+	return pResult;
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Get(int Index) const
 {
 	if(Index < 0 || Index >= Num())
 		return 0;
@@ -232,13 +225,18 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
 	return 0;
 }
 
+// the server bans through these pools as well
+template class CNetBan::CBanPool<NETADDR>;
+template class CNetBan::CBanPool<CNetRange>;
+
 template<class T>
-int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason)
+int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason, bool Verbose)
 {
 	// do not ban localhost
 	if(NetMatch(pData, &m_LocalhostIPV4) || NetMatch(pData, &m_LocalhostIPV6))
 	{
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (localhost)");
+		if(Verbose)
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (localhost)");
 		return -1;
 	}
 
@@ -250,37 +248,35 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	str_copy(Info.m_aReason, pReason, sizeof(Info.m_aReason));
 
 	// check if it already exists
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		// adjust the ban
 		pBanPool->Update(pBan, &Info);
-		char aBuf[128];
-		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_LIST);
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		if(Verbose)
+		{
+			char aBuf[128];
+			MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_LIST);
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		}
 		return 1;
 	}
 
 	// add ban and print result
-	pBan = pBanPool->Add(pData, &Info, &NetHash);
-	if(pBan)
+	pBan = pBanPool->Add(pData, &Info);
+	if(Verbose)
 	{
 		char aBuf[128];
 		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_BANADD);
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		return 0;
 	}
-	else
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (full banlist)");
-	return -1;
+	return 0;
 }
 
 template<class T>
 int CNetBan::Unban(T *pBanPool, const typename T::CDataType *pData)
 {
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		char aBuf[256];
@@ -311,26 +307,23 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("unban_all", "", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConUnbanAll, this, "Unban all entries");
 	Console()->Register("bans", "", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBans, this, "Show banlist");
 	Console()->Register("bans_save", "s[file]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_import", "s[file] ?i[minutes] ?r[reason]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansImport, this, "Ban every ip, CIDR block or range (first - last) listed in a file, one per line (0 minutes = permanent)");
 }
 
 void CNetBan::Update()
 {
-	int Now = time_timestamp();
+	Expire(time_timestamp());
+}
 
-	// remove expired bans
-	char aBuf[256], aNetStr[256];
-	while(m_BanAddrPool.First() && m_BanAddrPool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanAddrPool.First()->m_Info.m_Expires < Now)
-	{
-		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanAddrPool.First()->m_Data, aNetStr, sizeof(aNetStr)));
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		m_BanAddrPool.Remove(m_BanAddrPool.First());
-	}
-	while(m_BanRangePool.First() && m_BanRangePool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanRangePool.First()->m_Info.m_Expires < Now)
-	{
-		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanRangePool.First()->m_Data, aNetStr, sizeof(aNetStr)));
+void CNetBan::Expire(int Now)
+{
+	auto PrintExpired = [this](const auto *pBan) {
+		char aBuf[256], aNetStr[256];
+		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&pBan->m_Data, aNetStr, sizeof(aNetStr)));
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		m_BanRangePool.Remove(m_BanRangePool.First());
-	}
+	};
+	m_BanAddrPool.Expire(Now, PrintExpired);
+	m_BanRangePool.Expire(Now, PrintExpired);
 }
 
 int CNetBan::BanAddr(const NETADDR *pAddr, int Seconds, const char *pReason)
@@ -392,6 +385,112 @@ int CNetBan::UnbanByIndex(int Index)
 	return Result;
 }
 
+static bool ParseAddr(NETADDR *pAddr, const char *pStr)
+{
+	// ipv6 addresses are listed without brackets
+	char aBuf[128];
+	if(pStr[0] != '[' && str_find(pStr, ":"))
+	{
+		str_format(aBuf, sizeof(aBuf), "[%s]", pStr);
+		pStr = aBuf;
+	}
+	return net_addr_from_str(pAddr, pStr) == 0 && pAddr->port == 0;
+}
+
+// returns 0 for an address, 1 for a range and -1 for an invalid entry
+static int ParseBanEntry(const char *pEntry, NETADDR *pAddr, CNetRange *pRange)
+{
+	char aFirst[128];
+	const char *pSeparator = str_find(pEntry, "-");
+	if(pSeparator)
+	{
+		str_copy(aFirst, pEntry, minimum((int)sizeof(aFirst), (int)(pSeparator - pEntry) + 1));
+		str_utf8_trim_right(aFirst);
+		if(!ParseAddr(&pRange->m_LB, aFirst) || !ParseAddr(&pRange->m_UB, str_utf8_skip_whitespaces(pSeparator + 1)))
+			return -1;
+		return pRange->m_LB.type == pRange->m_UB.type && NetComp(&pRange->m_LB, &pRange->m_UB) <= 0 ? 1 : -1;
+	}
+
+	pSeparator = str_find(pEntry, "/");
+	if(!pSeparator)
+		return ParseAddr(pAddr, pEntry) ? 0 : -1;
+
+	str_copy(aFirst, pEntry, minimum((int)sizeof(aFirst), (int)(pSeparator - pEntry) + 1));
+	if(!ParseAddr(&pRange->m_LB, aFirst) || !str_isallnum(pSeparator + 1))
+		return -1;
+	const int Bits = NetAddressBits(pRange->m_LB.type);
+	const int PrefixLength = str_toint(pSeparator + 1);
+	if(PrefixLength < 0 || PrefixLength > Bits)
+		return -1;
+
+	pRange->m_UB = pRange->m_LB;
+	for(int i = PrefixLength; i < Bits; i++)
+	{
+		pRange->m_LB.ip[i >> 3] &= ~(1 << (7 - (i & 7)));
+		pRange->m_UB.ip[i >> 3] |= 1 << (7 - (i & 7));
+	}
+	if(PrefixLength == Bits)
+	{
+		*pAddr = pRange->m_LB;
+		return 0;
+	}
+	return 1;
+}
+
+int CNetBan::ImportBans(const char *pFilename, int Seconds, const char *pReason)
+{
+	char aBuf[256];
+	IOHANDLE File = Storage()->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to open ban list '%s'", pFilename);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return -1;
+	}
+
+	int NumAdded = 0, NumUpdated = 0, NumInvalid = 0;
+	CLineReader LineReader;
+	LineReader.Init(File);
+	while(char *pLine = LineReader.Get())
+	{
+		char *pComment = (char *)str_find(pLine, "#");
+		if(pComment)
+			*pComment = 0;
+		str_utf8_trim_right(pLine);
+		const char *pEntry = str_utf8_skip_whitespaces(pLine);
+		if(!pEntry[0])
+			continue;
+
+		NETADDR Addr;
+		CNetRange Range;
+		int Result;
+		switch(ParseBanEntry(pEntry, &Addr, &Range))
+		{
+		case 0:
+			Result = Ban(&m_BanAddrPool, &Addr, Seconds, pReason, false);
+			break;
+		case 1:
+			// a range of a single address is stored as address ban
+			Result = NetComp(&Range.m_LB, &Range.m_UB) == 0 ? Ban(&m_BanAddrPool, &Range.m_LB, Seconds, pReason, false) : Ban(&m_BanRangePool, &Range, Seconds, pReason, false);
+			break;
+		default:
+			Result = -1;
+		}
+
+		if(Result == 0)
+			NumAdded++;
+		else if(Result == 1)
+			NumUpdated++;
+		else
+			NumInvalid++;
+	}
+	io_close(File);
+
+	str_format(aBuf, sizeof(aBuf), "imported '%s': %d added, %d updated, %d skipped", pFilename, NumAdded, NumUpdated, NumInvalid);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+	return NumAdded + NumUpdated;
+}
+
 bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize) const
 {
 	NETADDR Addr;
@@ -402,11 +501,9 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 		pAddr = &Addr;
 		Addr.type = NETTYPE_IPV4;
 	}
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
 
 	// check ban addresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CBanAddr *pBan = m_BanAddrPool.Lookup(pAddr);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
@@ -414,16 +511,11 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 	}
 
 	// check ban ranges
-	for(int i = Length - 1; i >= 0; --i)
+	CBanRange *pBanRange = m_BanRangePool.Lookup(pAddr);
+	if(pBanRange)
 	{
-		for(CBanRange *pBan = m_BanRangePool.First(&aHash[i]); pBan; pBan = pBan->m_pHashNext)
-		{
-			if(NetMatch(&pBan->m_Data, pAddr, i, Length))
-			{
-				MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
-				return true;
-			}
-		}
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
+		return true;
 	}
 
 	return false;
@@ -558,3 +650,12 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pResult->GetString(0));
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
+
+void CNetBan::ConBansImport(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+
+	int Minutes = pResult->NumArguments() > 1 ? clamp(pResult->GetInteger(1), 0, 525600) : 0;
+	const char *pReason = pResult->NumArguments() > 2 ? pResult->GetString(2) : "Listed";
+	pThis->ImportBans(pResult->GetString(0), Minutes * 60, pReason);
+}
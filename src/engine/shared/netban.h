@@ -5,6 +5,8 @@
 
 #include <base/system.h>
 
+#include "nettrie.h"
+
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
 {
 	return mem_comp(pAddr1, pAddr2, pAddr1->type == NETTYPE_IPV4 ? 8 : 20);
@@ -60,19 +62,6 @@ protected:
 		return pBuffer;
 	}
 
-	class CNetHash
-	{
-	public:
-		int m_Hash;
-		int m_HashIndex; // matching parts for ranges, 0 for addr
-
-		CNetHash() {}
-		CNetHash(const NETADDR *pAddr);
-		CNetHash(const CNetRange *pRange);
-
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
-	};
-
 	struct CBanInfo
 	{
 		enum
@@ -89,67 +78,71 @@ protected:
 	{
 		T m_Data;
 		CBanInfo m_Info;
-		CNetHash m_NetHash;
 
-		// hash list
-		CBan *m_pHashNext;
-		CBan *m_pHashPrev;
+		// expiry wheel slot list
+		CBan *m_pWheelNext;
+		CBan *m_pWheelPrev;
 
-		// used or free list
+		// used list
 		CBan *m_pNext;
 		CBan *m_pPrev;
 	};
 
-	template<class T, int HashCount>
+	// bans are indexed by their address prefixes, ranges are split into
+	// the prefixes covering them. Expiring bans are kept in a timing wheel
+	// with one slot per second, so `Expire` only visits the due slots.
+	template<class T>
 	class CBanPool
 	{
 	public:
 		typedef T CDataType;
 
-		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo, const CNetHash *pNetHash);
+		CBanPool();
+		~CBanPool();
+
+		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo);
 		int Remove(CBan<CDataType> *pBan);
 		void Update(CBan<CDataType> *pBan, const CBanInfo *pInfo);
 		void Reset();
+		// removes the bans that expired before `Now`, calling `pfnExpired` before each removal
+		template<class F>
+		void Expire(int Now, F &&pfnExpired);
 
 		int Num() const { return m_CountUsed; }
-		bool IsFull() const { return m_CountUsed == MAX_BANS; }
+		int NumNodes() const { return m_Trie.NumNodes(); }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
-		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
-		{
-			for(CBan<CDataType> *pBan = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
-			{
-				if(NetComp(&pBan->m_Data, pData) == 0)
-					return pBan;
-			}
-
-			return 0;
-		}
+		CBan<CDataType> *Find(const CDataType *pData) const;
+		// a ban that covers the address
+		CBan<CDataType> *Lookup(const NETADDR *pAddr) const { return m_Trie.Lookup(pAddr); }
 		CBan<CDataType> *Get(int Index) const;
 
 	private:
 		enum
 		{
-			MAX_BANS = 1024,
+			WHEEL_SIZE = 4096,
 		};
 
-		CBan<CDataType> *m_aapHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
-		CBan<CDataType> *m_pFirstFree;
+		void WheelInsert(CBan<CDataType> *pBan);
+		void WheelRemove(CBan<CDataType> *pBan);
+
+		CNetPrefixTrie<CBan<CDataType> *> m_Trie;
+		CBan<CDataType> *m_apWheel[WHEEL_SIZE];
+		int m_LastExpired;
 		CBan<CDataType> *m_pFirstUsed;
+		CBan<CDataType> *m_pLastUsed;
 		int m_CountUsed;
 	};
 
-	typedef CBanPool<NETADDR, 1> CBanAddrPool;
-	typedef CBanPool<CNetRange, 16> CBanRangePool;
+	typedef CBanPool<NETADDR> CBanAddrPool;
+	typedef CBanPool<CNetRange> CBanRangePool;
 	typedef CBan<NETADDR> CBanAddr;
 	typedef CBan<CNetRange> CBanRange;
 
 	template<class T>
 	void MakeBanInfo(const CBan<T> *pBan, char *pBuf, unsigned BuffSize, int Type) const;
 	template<class T>
-	int Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason);
+	int Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason, bool Verbose = true);
 	template<class T>
 	int Unban(T *pBanPool, const typename T::CDataType *pData);
 
@@ -174,6 +167,8 @@ public:
 	virtual ~CNetBan() {}
 	void Init(class IConsole *pConsole, class IStorage *pStorage);
 	void Update();
+	// removes the bans that expired before `Now`
+	void Expire(int Now);
 
 	virtual int BanAddr(const NETADDR *pAddr, int Seconds, const char *pReason);
 	virtual int BanRange(const CNetRange *pRange, int Seconds, const char *pReason);
@@ -182,6 +177,8 @@ public:
 	int UnbanByIndex(int Index);
 	void UnbanAll();
 	bool IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize) const;
+	// adds a ban for every address, CIDR block or range in the file, one per line
+	int ImportBans(const char *pFilename, int Seconds, const char *pReason);
 
 	static void ConBan(class IConsole::IResult *pResult, void *pUser);
 	static void ConBanRange(class IConsole::IResult *pResult, void *pUser);
@@ -190,6 +187,7 @@ public:
 	static void ConUnbanAll(class IConsole::IResult *pResult, void *pUser);
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansImport(class IConsole::IResult *pResult, void *pUser);
 };
 
 template<class T>
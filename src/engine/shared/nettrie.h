@@ -0,0 +1,309 @@
+#ifndef ENGINE_SHARED_NETTRIE_H
+#define ENGINE_SHARED_NETTRIE_H
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <algorithm>
+#include <vector>
+
+inline int NetAddressBits(int Type)
+{
+	return Type == NETTYPE_IPV4 ? 32 : 128;
+}
+
+/**
+ * Path-compressed binary trie over IP address prefixes, with one tree per
+ * address family. Every node stores the values of exactly one prefix, so
+ * a lookup visits at most one node per prefix bit.
+ *
+ * @tparam T Value type, must be comparable and default constructible.
+ */
+template<class T>
+class CNetPrefixTrie
+{
+	enum
+	{
+		FAMILY_IPV4 = 0,
+		FAMILY_IPV6,
+		NUM_FAMILIES,
+	};
+
+	struct CNode
+	{
+		unsigned char m_aPrefix[16];
+		int m_PrefixLength;
+		CNode *m_apChildren[2];
+		std::vector<T> m_vValues;
+	};
+
+	CNode *m_apRoots[NUM_FAMILIES];
+	int m_NumNodes;
+
+	static int Bit(const unsigned char *pKey, int Index) { return (pKey[Index >> 3] >> (7 - (Index & 7))) & 1; }
+
+	static int CommonBits(const unsigned char *pKey1, const unsigned char *pKey2, int MaxBits)
+	{
+		int Bits = 0;
+		while(Bits + 8 <= MaxBits && pKey1[Bits >> 3] == pKey2[Bits >> 3])
+			Bits += 8;
+		while(Bits < MaxBits && Bit(pKey1, Bits) == Bit(pKey2, Bits))
+			Bits++;
+		return Bits;
+	}
+
+	CNode *NewNode(const unsigned char *pKey, int PrefixLength)
+	{
+		CNode *pNode = new CNode;
+		mem_zero(pNode->m_aPrefix, sizeof(pNode->m_aPrefix));
+		mem_copy(pNode->m_aPrefix, pKey, (PrefixLength + 7) / 8);
+		if(PrefixLength & 7)
+			pNode->m_aPrefix[PrefixLength >> 3] &= 0xff << (8 - (PrefixLength & 7));
+		pNode->m_PrefixLength = PrefixLength;
+		pNode->m_apChildren[0] = 0;
+		pNode->m_apChildren[1] = 0;
+		m_NumNodes++;
+		return pNode;
+	}
+
+	void DeleteNode(CNode *pNode)
+	{
+		delete pNode;
+		m_NumNodes--;
+	}
+
+	void DeleteTree(CNode *pNode)
+	{
+		if(!pNode)
+			return;
+		DeleteTree(pNode->m_apChildren[0]);
+		DeleteTree(pNode->m_apChildren[1]);
+		DeleteNode(pNode);
+	}
+
+	static int Family(int Type) { return Type == NETTYPE_IPV4 ? FAMILY_IPV4 : FAMILY_IPV6; }
+
+public:
+	CNetPrefixTrie()
+	{
+		m_apRoots[FAMILY_IPV4] = 0;
+		m_apRoots[FAMILY_IPV6] = 0;
+		m_NumNodes = 0;
+	}
+	~CNetPrefixTrie() { Clear(); }
+
+	CNetPrefixTrie(const CNetPrefixTrie &) = delete;
+	CNetPrefixTrie &operator=(const CNetPrefixTrie &) = delete;
+
+	void Clear()
+	{
+		for(auto &pRoot : m_apRoots)
+		{
+			DeleteTree(pRoot);
+			pRoot = 0;
+		}
+	}
+
+	int NumNodes() const { return m_NumNodes; }
+
+	/**
+	 * Adds a value to a prefix.
+	 *
+	 * @param Type `NETTYPE_IPV4` or `NETTYPE_IPV6`.
+	 * @param pKey Address bytes, only the first `PrefixLength` bits are used.
+	 * @param PrefixLength Prefix length in bits.
+	 * @param Value Value to add.
+	 */
+	void Insert(int Type, const unsigned char *pKey, int PrefixLength, const T &Value)
+	{
+		CNode **ppRoot = &m_apRoots[Family(Type)];
+		if(!*ppRoot)
+			*ppRoot = NewNode(pKey, 0);
+
+		CNode *pNode = *ppRoot;
+		while(true)
+		{
+			if(pNode->m_PrefixLength == PrefixLength)
+			{
+				pNode->m_vValues.push_back(Value);
+				return;
+			}
+
+			CNode **ppChild = &pNode->m_apChildren[Bit(pKey, pNode->m_PrefixLength)];
+			CNode *pChild = *ppChild;
+			if(!pChild)
+			{
+				*ppChild = NewNode(pKey, PrefixLength);
+				(*ppChild)->m_vValues.push_back(Value);
+				return;
+			}
+
+			const int Common = CommonBits(pKey, pChild->m_aPrefix, minimum(PrefixLength, pChild->m_PrefixLength));
+			if(Common == pChild->m_PrefixLength)
+			{
+				pNode = pChild;
+				continue;
+			}
+
+			// the key diverges inside the compressed path of the child
+			CNode *pSplit = NewNode(pKey, Common);
+			pSplit->m_apChildren[Bit(pChild->m_aPrefix, Common)] = pChild;
+			*ppChild = pSplit;
+			if(Common == PrefixLength)
+			{
+				pSplit->m_vValues.push_back(Value);
+			}
+			else
+			{
+				CNode *pLeaf = NewNode(pKey, PrefixLength);
+				pLeaf->m_vValues.push_back(Value);
+				pSplit->m_apChildren[Bit(pKey, Common)] = pLeaf;
+			}
+			return;
+		}
+	}
+
+	/**
+	 * Removes a value from a prefix and prunes nodes that became redundant.
+	 *
+	 * @return `true` if the value was found.
+	 */
+	bool Remove(int Type, const unsigned char *pKey, int PrefixLength, const T &Value)
+	{
+		CNode **ppParentLink = 0;
+		CNode **ppLink = &m_apRoots[Family(Type)];
+		while(*ppLink)
+		{
+			CNode *pNode = *ppLink;
+			if(pNode->m_PrefixLength > PrefixLength || CommonBits(pKey, pNode->m_aPrefix, pNode->m_PrefixLength) < pNode->m_PrefixLength)
+				return false;
+
+			if(pNode->m_PrefixLength < PrefixLength)
+			{
+				ppParentLink = ppLink;
+				ppLink = &pNode->m_apChildren[Bit(pKey, pNode->m_PrefixLength)];
+				continue;
+			}
+
+			auto It = std::find(pNode->m_vValues.begin(), pNode->m_vValues.end(), Value);
+			if(It == pNode->m_vValues.end())
+				return false;
+			pNode->m_vValues.erase(It);
+
+			// keep the roots, they anchor the family
+			if(!pNode->m_vValues.empty() || !ppParentLink)
+				return true;
+
+			if(pNode->m_apChildren[0] && pNode->m_apChildren[1])
+				return true;
+
+			*ppLink = pNode->m_apChildren[0] ? pNode->m_apChildren[0] : pNode->m_apChildren[1];
+			DeleteNode(pNode);
+
+			// the parent may only be left as a pass-through node
+			CNode *pParent = *ppParentLink;
+			if(pParent != m_apRoots[Family(Type)] && pParent->m_vValues.empty() && (!pParent->m_apChildren[0] || !pParent->m_apChildren[1]))
+			{
+				*ppParentLink = pParent->m_apChildren[0] ? pParent->m_apChildren[0] : pParent->m_apChildren[1];
+				DeleteNode(pParent);
+			}
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Returns the values stored for exactly this prefix.
+	 *
+	 * @return Pointer to the values or `nullptr` if the prefix has none.
+	 */
+	const std::vector<T> *Find(int Type, const unsigned char *pKey, int PrefixLength) const
+	{
+		const CNode *pNode = m_apRoots[Family(Type)];
+		while(pNode)
+		{
+			if(pNode->m_PrefixLength > PrefixLength || CommonBits(pKey, pNode->m_aPrefix, pNode->m_PrefixLength) < pNode->m_PrefixLength)
+				return 0;
+			if(pNode->m_PrefixLength == PrefixLength)
+				return pNode->m_vValues.empty() ? 0 : &pNode->m_vValues;
+			pNode = pNode->m_apChildren[Bit(pKey, pNode->m_PrefixLength)];
+		}
+		return 0;
+	}
+
+	/**
+	 * Finds the longest stored prefix that contains the address.
+	 *
+	 * @return The first value of that prefix or `T()` if none matches.
+	 */
+	T Lookup(const NETADDR *pAddr) const
+	{
+		const int Bits = NetAddressBits(pAddr->type);
+		T Result = T();
+		const CNode *pNode = m_apRoots[Family(pAddr->type)];
+		while(pNode)
+		{
+			if(CommonBits(pAddr->ip, pNode->m_aPrefix, pNode->m_PrefixLength) < pNode->m_PrefixLength)
+				break;
+			if(!pNode->m_vValues.empty())
+				Result = pNode->m_vValues.front();
+			if(pNode->m_PrefixLength == Bits)
+				break;
+			pNode = pNode->m_apChildren[Bit(pAddr->ip, pNode->m_PrefixLength)];
+		}
+		return Result;
+	}
+};
+
+/**
+ * Splits an inclusive address range into the minimal list of prefixes
+ * covering it, from the lowest address upwards.
+ *
+ * @param pLB Lower bound.
+ * @param pUB Upper bound, same type as `pLB` and not smaller.
+ * @param Fn Called with `(const unsigned char *pKey, int PrefixLength)` for
+ *           every prefix, returns `false` to stop.
+ */
+template<class F>
+void NetRangeToPrefixes(const NETADDR *pLB, const NETADDR *pUB, F &&Fn)
+{
+	const int Bits = NetAddressBits(pLB->type);
+	const int Bytes = Bits / 8;
+	auto GetBit = [](const unsigned char *pKey, int Index) { return (pKey[Index >> 3] >> (7 - (Index & 7))) & 1; };
+
+	unsigned char aCur[16];
+	mem_copy(aCur, pLB->ip, Bytes);
+	while(true)
+	{
+		// biggest aligned block starting at the current address
+		int HostBits = 0;
+		while(HostBits < Bits && !GetBit(aCur, Bits - 1 - HostBits))
+			HostBits++;
+
+		unsigned char aLast[16];
+		while(true)
+		{
+			mem_copy(aLast, aCur, Bytes);
+			for(int i = Bits - HostBits; i < Bits; i++)
+				aLast[i >> 3] |= 1 << (7 - (i & 7));
+			if(HostBits == 0 || mem_comp(aLast, pUB->ip, Bytes) <= 0)
+				break;
+			HostBits--;
+		}
+
+		if(!Fn((const unsigned char *)aCur, Bits - HostBits))
+			return;
+		if(mem_comp(aLast, pUB->ip, Bytes) >= 0)
+			return;
+
+		// continue after the block
+		mem_copy(aCur, aLast, Bytes);
+		for(int i = Bytes - 1; i >= 0; i--)
+		{
+			if(++aCur[i] != 0)
+				break;
+		}
+	}
+}
+
+#endif
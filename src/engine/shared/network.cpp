@@ -6,6 +6,8 @@
 #include "huffman.h"
 #include "network.h"
 
+#include <engine/masterserver.h>
+
 void CNetRecvUnpacker::Clear()
 {
 	m_Valid = false;
@@ -90,6 +92,102 @@ int CNetRecvUnpacker::FetchChunk(CNetChunk *pChunk)
 }
 
 static const unsigned char NET_HEADER_EXTENDED[] = {'x', 'e'};
+int CNetConnlessFilter::Classify(const unsigned char *pData, int Size, int *pToken, int *pType)
+{
+	if(Size < NET_PACKETHEADERSIZE || Size > NET_MAX_PACKETSIZE)
+		return KIND_JUNK;
+	if(!((pData[0] >> 2) & NET_PACKETFLAG_CONNLESS))
+		return KIND_CONNECTED;
+
+	// 0.7 connless packets carry two tokens, they are checked by the server
+	if((pData[0] & 0x3) == 1)
+		return Size >= 9 ? KIND_OTHER : KIND_JUNK;
+
+	const int Offset = 6;
+	if(Size < Offset)
+		return KIND_JUNK;
+	const bool Extended = mem_comp(pData, NET_HEADER_EXTENDED, sizeof(NET_HEADER_EXTENDED)) == 0;
+	if(!Extended)
+	{
+		for(int i = 0; i < Offset; i++)
+		{
+			if(pData[i] != 0xff)
+				return KIND_JUNK;
+		}
+	}
+
+	const unsigned char *pPayload = pData + Offset;
+	const int PayloadSize = Size - Offset;
+	if(PayloadSize >= (int)sizeof(SERVERBROWSE_GETINFO) + 1 && mem_comp(pPayload, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
+	{
+		*pToken = pPayload[sizeof(SERVERBROWSE_GETINFO)];
+		if(Extended)
+		{
+			*pToken |= ((pData[sizeof(NET_HEADER_EXTENDED)] << 8) | pData[sizeof(NET_HEADER_EXTENDED) + 1]) << 8;
+			*pType = SERVERINFO_EXTENDED;
+		}
+		else
+			*pType = SERVERINFO_VANILLA;
+		return KIND_INFO;
+	}
+	return KIND_OTHER;
+}
+
+bool CNetConnlessFilter::Allow(const NETADDR *pAddr, int64 Now, int Rate, int Burst)
+{
+	if(Rate <= 0)
+		return true;
+
+	NETADDR Addr = *pAddr;
+	Addr.port = 0;
+	unsigned Hash = 2166136261u;
+	for(unsigned char Byte : Addr.ip)
+		Hash = (Hash ^ Byte) * 16777619u;
+
+	// linear probing, the least recently refilled bucket gets evicted
+	CBucket *pBucket = 0;
+	CBucket *pOldest = 0;
+	for(int i = 0; i < MAX_PROBES; i++)
+	{
+		CBucket *pProbe = &m_aBuckets[(Hash + i) % TABLE_SIZE];
+		if(pProbe->m_LastRefill && net_addr_comp(&pProbe->m_Addr, &Addr) == 0)
+		{
+			pBucket = pProbe;
+			break;
+		}
+		if(!pOldest || pProbe->m_LastRefill < pOldest->m_LastRefill)
+			pOldest = pProbe;
+	}
+
+	const int64 Capacity = maximum(Burst, 1) * (int64)1000;
+	if(!pBucket)
+	{
+		pBucket = pOldest;
+		pBucket->m_Addr = Addr;
+		pBucket->m_LastRefill = Now;
+		pBucket->m_Tokens = Capacity;
+	}
+	else
+	{
+		// long idle buckets are full anyway, don't let the product overflow
+		const int64 Elapsed = minimum(Now - pBucket->m_LastRefill, time_freq() * 1000);
+		const int64 Refill = Elapsed * Rate * 1000 / time_freq();
+		if(Refill > 0)
+		{
+			pBucket->m_Tokens = minimum(Capacity, pBucket->m_Tokens + Refill);
+			pBucket->m_LastRefill = Now;
+		}
+	}
+
+	if(pBucket->m_Tokens < 1000)
+	{
+		m_NumLimited++;
+		return false;
+	}
+	pBucket->m_Tokens -= 1000;
+	return true;
+}
+
 // packs the data tight and sends it
 void CNetBase::SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *pData, int DataSize, bool Extended, unsigned char aExtra[4])
 {
@@ -106,7 +204,7 @@ void CNetBase::SendPacketConnless(NETSOCKET Socket, NETADDR *pAddr, const void *
 		mem_copy(aBuffer + sizeof(NET_HEADER_EXTENDED), aExtra, 4);
 	}
 	mem_copy(aBuffer + DATA_OFFSET, pData, DataSize);
-	net_udp_send(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
+	SendDatagram(Socket, pAddr, aBuffer, DataSize + DATA_OFFSET);
 }
 
 void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct *pPacket, SECURITY_TOKEN SecurityToken, bool Sixup, bool NoCompress)
@@ -176,7 +274,7 @@ void CNetBase::SendPacket(NETSOCKET Socket, NETADDR *pAddr, CNetPacketConstruct
 		aBuffer[0] = ((pPacket->m_Flags << 2) & 0xfc) | ((pPacket->m_Ack >> 8) & 0x3);
 		aBuffer[1] = pPacket->m_Ack & 0xff;
 		aBuffer[2] = pPacket->m_NumChunks;
-		net_udp_send(Socket, pAddr, aBuffer, FinalSize);
+		SendDatagram(Socket, pAddr, aBuffer, FinalSize);
 
 		// log raw socket data
 		if(ms_DataLogSent)
@@ -365,6 +463,9 @@ int CNetBase::IsSeqInBackroom(int Seq, int Ack)
 IOHANDLE CNetBase::ms_DataLogSent = 0;
 IOHANDLE CNetBase::ms_DataLogRecv = 0;
 CHuffman CNetBase::ms_Huffman;
+bool CNetBase::ms_Tunnelled = false;
+NETADDR CNetBase::ms_TunnelAddr;
+int64_t CNetBase::ms_TunnelHeartbeat = 0;
 
 void CNetBase::OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv)
 {
@@ -431,3 +532,130 @@ void CNetBase::Init()
 {
 	ms_Huffman.Init(s_aFreqTable);
 }
+
+int CNetTunnel::Pack(unsigned char *pBuffer, int BufferSize, int Type, const NETADDR *pAddr, const void *pData, int DataSize)
+{
+	if(NET_TUNNEL_HEADERSIZE + DataSize > BufferSize)
+		return -1;
+
+	pBuffer[0] = Type;
+	mem_zero(&pBuffer[1], NET_TUNNEL_HEADERSIZE - 1);
+	if(pAddr)
+	{
+		pBuffer[1] = pAddr->type;
+		mem_copy(&pBuffer[2], pAddr->ip, sizeof(pAddr->ip));
+		pBuffer[18] = (pAddr->port >> 8) & 0xff;
+		pBuffer[19] = pAddr->port & 0xff;
+	}
+	if(DataSize)
+		mem_copy(&pBuffer[NET_TUNNEL_HEADERSIZE], pData, DataSize);
+	return NET_TUNNEL_HEADERSIZE + DataSize;
+}
+
+int CNetTunnel::Unpack(const unsigned char *pData, int DataSize, int *pType, NETADDR *pAddr, const unsigned char **ppPayload)
+{
+	if(DataSize < NET_TUNNEL_HEADERSIZE || pData[0] > TYPE_BAN)
+		return -1;
+	if(pData[1] != NETTYPE_INVALID && pData[1] != NETTYPE_IPV4 && pData[1] != NETTYPE_IPV6)
+		return -1;
+	if(pData[0] == TYPE_PACKET && pData[1] == NETTYPE_INVALID)
+		return -1;
+
+	*pType = pData[0];
+	mem_zero(pAddr, sizeof(*pAddr));
+	pAddr->type = pData[1];
+	mem_copy(pAddr->ip, &pData[2], sizeof(pAddr->ip));
+	pAddr->port = (pData[18] << 8) | pData[19];
+	*ppPayload = &pData[NET_TUNNEL_HEADERSIZE];
+	return DataSize - NET_TUNNEL_HEADERSIZE;
+}
+
+void CNetBase::SetTunnel(const NETADDR *pFrontAddr)
+{
+	ms_Tunnelled = true;
+	ms_TunnelAddr = *pFrontAddr;
+	ms_TunnelHeartbeat = time_get();
+}
+
+void CNetBase::SendDatagram(NETSOCKET Socket, const NETADDR *pAddr, const void *pData, int DataSize)
+{
+	if(!ms_Tunnelled)
+	{
+		net_udp_send(Socket, pAddr, pData, DataSize);
+		return;
+	}
+
+	unsigned char aBuffer[NET_MAX_DATAGRAMSIZE];
+	int Size = CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_PACKET, pAddr, pData, DataSize);
+	if(Size >= 0)
+		net_udp_send(Socket, &ms_TunnelAddr, aBuffer, Size);
+}
+
+bool CNetBase::UnwrapDatagram(NETADDR *pAddr, unsigned char **ppData, int *pDataSize)
+{
+	// only the front can talk to a child
+	if(net_addr_comp(pAddr, &ms_TunnelAddr) != 0)
+		return false;
+
+	int Type;
+	NETADDR Addr;
+	const unsigned char *pPayload;
+	int Size = CNetTunnel::Unpack(*ppData, *pDataSize, &Type, &Addr, &pPayload);
+	if(Size < 0)
+		return false;
+	if(Type == CNetTunnel::TYPE_HEARTBEAT)
+	{
+		ms_TunnelHeartbeat = time_get();
+		return false;
+	}
+	if(Type != CNetTunnel::TYPE_PACKET || Size == 0)
+		return false;
+
+	*pAddr = Addr;
+	*ppData += NET_TUNNEL_HEADERSIZE;
+	*pDataSize = Size;
+	return true;
+}
+
+void CNetBase::SendTunnelInfo(NETSOCKET Socket, const char *pInfo)
+{
+	static unsigned char s_Serial = 0;
+	s_Serial++;
+
+	int InfoSize = str_length(pInfo);
+	int NumParts = (InfoSize + CNetTunnel::MAX_INFO_PART - 1) / CNetTunnel::MAX_INFO_PART;
+	if(NumParts > 255)
+	{
+		dbg_msg("network", "register info too large for the shard front, size=%d", InfoSize);
+		return;
+	}
+
+	for(int Part = 0; Part < NumParts; Part++)
+	{
+		unsigned char aPart[NET_MAX_PACKETSIZE];
+		int Offset = Part * CNetTunnel::MAX_INFO_PART;
+		int PartSize = minimum(InfoSize - Offset, (int)CNetTunnel::MAX_INFO_PART);
+		aPart[0] = s_Serial;
+		aPart[1] = Part;
+		aPart[2] = NumParts;
+		mem_copy(&aPart[CNetTunnel::INFO_HEADERSIZE], pInfo + Offset, PartSize);
+
+		unsigned char aBuffer[NET_MAX_PACKETSIZE];
+		int Size = CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_INFO, nullptr, aPart, CNetTunnel::INFO_HEADERSIZE + PartSize);
+		net_udp_send(Socket, &ms_TunnelAddr, aBuffer, Size);
+	}
+}
+
+void CNetBase::SendTunnelBan(NETSOCKET Socket, const NETADDR *pFirst, const NETADDR *pLast, int Seconds)
+{
+	unsigned char aBan[CNetTunnel::BAN_SIZE];
+	mem_copy(aBan, pLast->ip, sizeof(pLast->ip));
+	aBan[16] = (Seconds >> 24) & 0xff;
+	aBan[17] = (Seconds >> 16) & 0xff;
+	aBan[18] = (Seconds >> 8) & 0xff;
+	aBan[19] = Seconds & 0xff;
+
+	unsigned char aBuffer[NET_TUNNEL_HEADERSIZE + CNetTunnel::BAN_SIZE];
+	int Size = CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_BAN, pFirst, aBan, sizeof(aBan));
+	net_udp_send(Socket, &ms_TunnelAddr, aBuffer, Size);
+}
@@ -4,12 +4,18 @@
 #define ENGINE_SHARED_NETWORK_H
 
 #include "huffman.h"
+#include "protocol.h"
 #include "ringbuffer.h"
+#include "spscqueue.h"
 
 #include <base/math.h>
 
 #include <engine/message.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 /*
 
 CURRENT:
@@ -54,9 +60,12 @@ enum
 
 	NET_MAX_PACKETSIZE = 1400,
 	NET_MAX_PAYLOAD = NET_MAX_PACKETSIZE - 6,
+	// a packet between a shard front and its children, see `CNetTunnel`
+	NET_TUNNEL_HEADERSIZE = 20,
+	NET_MAX_DATAGRAMSIZE = NET_MAX_PACKETSIZE + NET_TUNNEL_HEADERSIZE,
 	NET_MAX_CHUNKHEADERSIZE = 5,
 	NET_PACKETHEADERSIZE = 3,
-	NET_MAX_CLIENTS = 64,
+	NET_MAX_CLIENTS = MAX_CLIENTS,
 	NET_MAX_CONSOLE_CLIENTS = 4,
 	NET_MAX_SEQUENCE = 1 << 10,
 	NET_SEQUENCE_MASK = NET_MAX_SEQUENCE - 1,
@@ -89,6 +98,8 @@ enum
 
 	NET_CONNLIMIT_IPS = 16,
 
+	NET_RECV_QUEUE_SIZE = 1024,
+
 	NET_ENUM_TERMINATOR
 };
 
@@ -110,6 +121,7 @@ typedef int (*NETFUNC_NEWCLIENT)(int ClientID, void *pUser, bool Sixup);
 typedef int (*NETFUNC_NEWCLIENT_NOAUTH)(int ClientID, void *pUser);
 typedef int (*NETFUNC_CLIENTREJOIN)(int ClientID, void *pUser);
 typedef int (*NETFUNC_CLIENTCHECKDISRUPTIVE)(int ClientID, void *pUser);
+typedef void (*NETFUNC_CONNLESS_INFO)(const NETADDR *pAddr, int Token, int Type, void *pUser);
 
 struct CNetChunk
 {
@@ -189,6 +201,7 @@ private:
 	NETADDR m_PeerAddr;
 	NETSOCKET m_Socket;
 	NETSTATS m_Stats;
+	int64 m_NumResends; // chunks resent since Init, kept across reconnects
 
 	//
 	void ResetStats();
@@ -233,6 +246,7 @@ public:
 	int SeqSequence() const { return m_Sequence; }
 	int SecurityToken() const { return m_SecurityToken; }
 	CStaticRingBuffer<CNetChunkResend, NET_CONN_BUFFERSIZE> *ResendBuffer() { return &m_Buffer; };
+	int64 NumResends() const { return m_NumResends; }
 
 	void SetTimedOut(const NETADDR *pAddr, int Sequence, int Ack, SECURITY_TOKEN SecurityToken, CStaticRingBuffer<CNetChunkResend, NET_CONN_BUFFERSIZE> *pResendBuffer, bool Sixup);
 
@@ -285,7 +299,7 @@ public:
 	int m_CurrentChunk;
 	int m_ClientID;
 	CNetPacketConstruct m_Data;
-	unsigned char m_aBuffer[NET_MAX_PACKETSIZE];
+	unsigned char m_aBuffer[NET_MAX_DATAGRAMSIZE];
 
 	CNetRecvUnpacker() { Clear(); }
 	void Clear();
@@ -293,6 +307,93 @@ public:
 	int FetchChunk(CNetChunk *pChunk);
 };
 
+struct CNetRecvDatagram
+{
+	NETADDR m_Addr;
+	int m_Kind;
+	int m_InfoToken;
+	int m_InfoType;
+	int m_DataSize;
+	unsigned char m_aData[NET_MAX_DATAGRAMSIZE];
+};
+
+// receives datagrams of a socket on a dedicated thread, so that the
+// socket buffer is drained even while the consuming thread is busy.
+// connless floods are filtered out here, before they take up the queue
+class CNetRecvThread
+{
+	NETSOCKET m_Socket;
+	class CNetServer *m_pServer;
+	MMSGS m_MMSGS;
+	void *m_pThread;
+	std::atomic<bool> m_Shutdown;
+	std::atomic<int> m_NumDropped;
+
+	std::mutex m_WaitMutex;
+	std::condition_variable m_WaitCondition;
+
+	CSpscQueue<CNetRecvDatagram, NET_RECV_QUEUE_SIZE> m_Queue;
+
+	static void ThreadMain(void *pUser);
+	void RunLoop();
+
+public:
+	CNetRecvThread(NETSOCKET Socket, class CNetServer *pServer);
+	~CNetRecvThread();
+
+	// copies the oldest received datagram into pBuffer, returns its size or 0 if none is queued.
+	// the kind and info request fields are the ones of `CNetServer::FilterDatagram`
+	int Fetch(NETADDR *pAddr, unsigned char *pBuffer, int BufferSize, int *pKind, int *pInfoToken, int *pInfoType);
+	// waits until a datagram is queued or the timeout in microseconds expired
+	bool Wait(int Time);
+
+	int NumQueued() const { return (int)m_Queue.Size(); }
+	int NumDropped() const { return m_NumDropped; }
+};
+
+// sorts connectionless datagrams by their fixed header bytes and rate
+// limits them per source address, before anything is unpacked.
+// zero initialized by `CNetServer::Open`, only used by one thread at a
+// time, the counters may be read from any thread
+class CNetConnlessFilter
+{
+public:
+	enum
+	{
+		KIND_CONNECTED = 0, // not connectionless, left to the normal path
+		KIND_JUNK,
+		KIND_INFO,
+		KIND_OTHER,
+
+		TABLE_SIZE = 4096,
+		MAX_PROBES = 8,
+	};
+
+private:
+	// token bucket, tokens are in thousandths of a packet
+	struct CBucket
+	{
+		NETADDR m_Addr;
+		int64 m_LastRefill;
+		int64 m_Tokens;
+	};
+
+	CBucket m_aBuckets[TABLE_SIZE];
+	std::atomic<int> m_NumJunk;
+	std::atomic<int> m_NumLimited;
+
+public:
+	// returns the kind, for `KIND_INFO` also the request token and serverinfo type
+	static int Classify(const unsigned char *pData, int Size, int *pToken, int *pType);
+	// takes a token from the bucket of the address, `Rate` packets per second
+	// with bursts of up to `Burst` packets, 0 disables the limit
+	bool Allow(const NETADDR *pAddr, int64 Now, int Rate, int Burst);
+
+	void CountJunk() { m_NumJunk++; }
+	int NumJunk() const { return m_NumJunk; }
+	int NumLimited() const { return m_NumLimited; }
+};
+
 // server side
 class CNetServer
 {
@@ -336,6 +437,15 @@ class CNetServer
 
 	CNetRecvUnpacker m_RecvUnpacker;
 
+	CNetRecvThread *m_pRecvThread;
+
+	CNetConnlessFilter m_ConnlessFilter;
+	// copies of the config, the receive thread must not read it
+	std::atomic<int> m_ConnlessRate;
+	std::atomic<int> m_ConnlessBurst;
+	NETFUNC_CONNLESS_INFO m_pfnConnlessInfo;
+	void *m_pConnlessInfoUser;
+
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
 	void OnPreConnMsg(NETADDR &Addr, CNetPacketConstruct &Packet);
@@ -352,15 +462,32 @@ class CNetServer
 public:
 	int SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT pfnDelClient, void *pUser);
 	int SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_NEWCLIENT_NOAUTH pfnNewClientNoAuth, NETFUNC_CLIENTREJOIN pfnClientRejoin, NETFUNC_DELCLIENT pfnDelClient, NETFUNC_CLIENTCHECKDISRUPTIVE pfnClientIsDisruptive, void *pUser);
+	// answers server info requests straight from `Recv`, without unpacking them
+	void SetConnlessInfoCallback(NETFUNC_CONNLESS_INFO pfnConnlessInfo, void *pUser);
 
 	//
 	bool Open(NETADDR BindAddr, class CNetBan *pNetBan, int MaxClients, int MaxClientsPerIP, int Flags);
 	int Close();
 
+	// network thread
+	void StartRecvThread();
+	void StopRecvThread();
+	bool HasRecvThread() const { return m_pRecvThread != nullptr; }
+	const CNetRecvThread *RecvThread() const { return m_pRecvThread; }
+	const CNetConnlessFilter *ConnlessFilter() const { return &m_ConnlessFilter; }
+	int64 NumResends() const;
+	// unwraps tunnelled datagrams, drops connless junk, 0.7 connless packets
+	// with a wrong token and rate limited ones. returns false for dropped
+	// datagrams, otherwise the kind and for info requests the token and type.
+	// called by the receive thread if it runs
+	bool FilterDatagram(NETADDR *pAddr, unsigned char **ppData, int *pBytes, int *pKind, int *pInfoToken, int *pInfoType);
+
 	//
 	int Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken);
 	int Send(CNetChunk *pChunk);
 	int Update();
+	// waits for incoming data for at most Time microseconds
+	bool Wait(int Time);
 
 	//
 	int Drop(int ClientID, const char *pReason);
@@ -466,6 +593,41 @@ public:
 	bool SecurityTokenUnknown() { return m_Connection.SecurityToken() == NET_SECURITY_TOKEN_UNKNOWN; }
 };
 
+// The datagrams between a shard front and its child servers, they carry the
+// address of the client so that the children see the real addresses. See
+// `engine/server/shard.h`.
+class CNetTunnel
+{
+public:
+	enum
+	{
+		// a packet from or for the client at the address
+		TYPE_PACKET = 0,
+		// a part of the register info of a child
+		TYPE_INFO,
+		// the front is still running
+		TYPE_HEARTBEAT,
+		// a child banned the addresses from the header's one up to the
+		// payload's one, the front keeps routing them to that child
+		TYPE_BAN,
+
+		// serial, part and number of parts in front of an info part
+		INFO_HEADERSIZE = 3,
+		// the last address and the ban's seconds, 0 for a permanent one
+		BAN_SIZE = 20,
+		MAX_INFO_PART = NET_MAX_PACKETSIZE - NET_TUNNEL_HEADERSIZE - INFO_HEADERSIZE,
+
+		// in seconds, a child stops without heartbeats
+		HEARTBEAT_INTERVAL = 1,
+		HEARTBEAT_TIMEOUT = 10,
+	};
+
+	// returns the size of the datagram or -1 if it doesn't fit
+	static int Pack(unsigned char *pBuffer, int BufferSize, int Type, const NETADDR *pAddr, const void *pData, int DataSize);
+	// returns the size of the payload or -1 if the datagram is invalid
+	static int Unpack(const unsigned char *pData, int DataSize, int *pType, NETADDR *pAddr, const unsigned char **ppPayload);
+};
+
 // TODO: both, fix these. This feels like a junk class for stuff that doesn't fit anywere
 class CNetBase
 {
@@ -473,6 +635,10 @@ class CNetBase
 	static IOHANDLE ms_DataLogRecv;
 	static CHuffman ms_Huffman;
 
+	static bool ms_Tunnelled;
+	static NETADDR ms_TunnelAddr;
+	static int64_t ms_TunnelHeartbeat;
+
 public:
 	static void OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv);
 	static void CloseLog();
@@ -486,6 +652,17 @@ public:
 
 	static int UnpackPacket(unsigned char *pBuffer, int Size, CNetPacketConstruct *pPacket, bool &Sixup, SECURITY_TOKEN *pSecurityToken = 0, SECURITY_TOKEN *pResponseToken = 0);
 
+	// sends all datagrams through the shard front at `pFrontAddr`
+	static void SetTunnel(const NETADDR *pFrontAddr);
+	static bool Tunnelled() { return ms_Tunnelled; }
+	static int64_t TunnelHeartbeat() { return ms_TunnelHeartbeat; }
+	static void SendDatagram(NETSOCKET Socket, const NETADDR *pAddr, const void *pData, int DataSize);
+	// replaces the front's address by the client's one, returns false if
+	// the datagram isn't a client packet
+	static bool UnwrapDatagram(NETADDR *pAddr, unsigned char **ppData, int *pDataSize);
+	static void SendTunnelInfo(NETSOCKET Socket, const char *pInfo);
+	static void SendTunnelBan(NETSOCKET Socket, const NETADDR *pFirst, const NETADDR *pLast, int Seconds);
+
 	// The backroom is ack-NET_MAX_SEQUENCE/2. Used for knowing if we acked a packet or not
 	static int IsSeqInBackroom(int Seq, int Ack);
 };
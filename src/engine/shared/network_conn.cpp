@@ -61,6 +61,7 @@ void CNetConnection::Init(NETSOCKET Socket, bool BlockCloseMsg)
 {
 	Reset();
 	ResetStats();
+	m_NumResends = 0;
 
 	m_Socket = Socket;
 	m_BlockCloseMsg = BlockCloseMsg;
@@ -174,6 +175,7 @@ void CNetConnection::ResendChunk(CNetChunkResend *pResend)
 {
 	QueueChunkEx(pResend->m_Flags | NET_CHUNKFLAG_RESEND, pResend->m_DataSize, pResend->m_pData, pResend->m_Sequence);
 	pResend->m_LastSendTime = time_get();
+	m_NumResends++;
 }
 
 void CNetConnection::Resend()
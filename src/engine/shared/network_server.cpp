@@ -76,6 +76,9 @@ bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Ma
 
 	secure_random_fill(m_aSecurityTokenSeed, sizeof(m_aSecurityTokenSeed));
 
+	m_ConnlessRate = g_Config.m_SvConnlessRate;
+	m_ConnlessBurst = g_Config.m_SvConnlessBurst;
+
 	for(auto &Slot : m_aSlots)
 		Slot.m_Connection.Init(m_Socket, true);
 
@@ -103,12 +106,140 @@ int CNetServer::SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_NEWCLIENT_N
 	return 0;
 }
 
+int64 CNetServer::NumResends() const
+{
+	int64 NumResends = 0;
+	for(const auto &Slot : m_aSlots)
+		NumResends += Slot.m_Connection.NumResends();
+	return NumResends;
+}
+
+void CNetServer::SetConnlessInfoCallback(NETFUNC_CONNLESS_INFO pfnConnlessInfo, void *pUser)
+{
+	m_pfnConnlessInfo = pfnConnlessInfo;
+	m_pConnlessInfoUser = pUser;
+}
+
 int CNetServer::Close()
 {
 	// TODO: implement me
+	StopRecvThread();
 	return 0;
 }
 
+CNetRecvThread::CNetRecvThread(NETSOCKET Socket, CNetServer *pServer) :
+	m_Socket(Socket),
+	m_pServer(pServer),
+	m_Shutdown(false),
+	m_NumDropped(0)
+{
+	net_init_mmsgs(&m_MMSGS);
+	m_pThread = thread_init(ThreadMain, this, "network receive");
+}
+
+CNetRecvThread::~CNetRecvThread()
+{
+	m_Shutdown = true;
+	thread_wait(m_pThread);
+}
+
+void CNetRecvThread::ThreadMain(void *pUser)
+{
+	static_cast<CNetRecvThread *>(pUser)->RunLoop();
+}
+
+void CNetRecvThread::RunLoop()
+{
+	unsigned char aBuffer[NET_MAX_DATAGRAMSIZE];
+	while(!m_Shutdown)
+	{
+		// wake up regularly to check for shutdown
+		if(!net_socket_read_wait(m_Socket, 100000))
+			continue;
+
+		bool Received = false;
+		while(true)
+		{
+			NETADDR Addr;
+			unsigned char *pData;
+			int Bytes = net_udp_recv(m_Socket, &Addr, aBuffer, sizeof(aBuffer), &m_MMSGS, &pData);
+			if(Bytes <= 0)
+				break;
+
+			int Kind, InfoToken = -1, InfoType = -1;
+			if(!m_pServer->FilterDatagram(&Addr, &pData, &Bytes, &Kind, &InfoToken, &InfoType))
+				continue;
+
+			CNetRecvDatagram *pDatagram = m_Queue.Back();
+			if(!pDatagram)
+			{
+				// consumer is lagging behind, drop instead of blocking the socket
+				m_NumDropped++;
+				continue;
+			}
+			pDatagram->m_Addr = Addr;
+			pDatagram->m_Kind = Kind;
+			pDatagram->m_InfoToken = InfoToken;
+			pDatagram->m_InfoType = InfoType;
+			pDatagram->m_DataSize = minimum(Bytes, (int)sizeof(pDatagram->m_aData));
+			mem_copy(pDatagram->m_aData, pData, pDatagram->m_DataSize);
+			m_Queue.Push();
+			Received = true;
+		}
+
+		if(Received)
+		{
+			// lock to not lose the wakeup between the consumer's check and wait
+			{
+				std::unique_lock<std::mutex> Lock(m_WaitMutex);
+			}
+			m_WaitCondition.notify_one();
+		}
+	}
+}
+
+int CNetRecvThread::Fetch(NETADDR *pAddr, unsigned char *pBuffer, int BufferSize, int *pKind, int *pInfoToken, int *pInfoType)
+{
+	CNetRecvDatagram *pDatagram = m_Queue.Front();
+	if(!pDatagram)
+		return 0;
+
+	int Size = minimum(pDatagram->m_DataSize, BufferSize);
+	*pAddr = pDatagram->m_Addr;
+	*pKind = pDatagram->m_Kind;
+	*pInfoToken = pDatagram->m_InfoToken;
+	*pInfoType = pDatagram->m_InfoType;
+	mem_copy(pBuffer, pDatagram->m_aData, Size);
+	m_Queue.Pop();
+	return Size;
+}
+
+bool CNetRecvThread::Wait(int Time)
+{
+	std::unique_lock<std::mutex> Lock(m_WaitMutex);
+	return m_WaitCondition.wait_for(Lock, std::chrono::microseconds(Time), [this] { return !m_Queue.Empty(); });
+}
+
+void CNetServer::StartRecvThread()
+{
+	if(m_pRecvThread)
+		return;
+	m_pRecvThread = new CNetRecvThread(m_Socket, this);
+}
+
+void CNetServer::StopRecvThread()
+{
+	delete m_pRecvThread;
+	m_pRecvThread = nullptr;
+}
+
+bool CNetServer::Wait(int Time)
+{
+	if(m_pRecvThread)
+		return m_pRecvThread->Wait(Time);
+	return net_socket_read_wait(m_Socket, Time);
+}
+
 int CNetServer::Drop(int ClientID, const char *pReason)
 {
 	// TODO: insert lots of checks here
@@ -129,6 +260,9 @@ int CNetServer::Drop(int ClientID, const char *pReason)
 
 int CNetServer::Update()
 {
+	m_ConnlessRate = g_Config.m_SvConnlessRate;
+	m_ConnlessBurst = g_Config.m_SvConnlessBurst;
+
 	for(int i = 0; i < MaxClients(); i++)
 	{
 		m_aSlots[i].m_Connection.Update();
@@ -169,6 +303,37 @@ SECURITY_TOKEN CNetServer::GetToken(const NETADDR &Addr)
 	return SecurityToken;
 }
 
+bool CNetServer::FilterDatagram(NETADDR *pAddr, unsigned char **ppData, int *pBytes, int *pKind, int *pInfoToken, int *pInfoType)
+{
+	// behind a shard front, all packets come from it
+	if(CNetBase::Tunnelled() && !CNetBase::UnwrapDatagram(pAddr, ppData, pBytes))
+		return false;
+
+	// sort out connless floods before the packet is looked at any further
+	*pKind = CNetConnlessFilter::Classify(*ppData, *pBytes, pInfoToken, pInfoType);
+	if(*pKind == CNetConnlessFilter::KIND_CONNECTED)
+		return true;
+	if(*pKind == CNetConnlessFilter::KIND_JUNK)
+	{
+		m_ConnlessFilter.CountJunk();
+		return false;
+	}
+
+	// 0.7 connless packets have to carry our token
+	if(((*ppData)[0] & 0x3) == 1)
+	{
+		SECURITY_TOKEN Token;
+		mem_copy(&Token, &(*ppData)[1], sizeof(Token));
+		if(Token != GetToken(*pAddr))
+		{
+			m_ConnlessFilter.CountJunk();
+			return false;
+		}
+	}
+
+	return m_ConnlessFilter.Allow(pAddr, time_get(), m_ConnlessRate, m_ConnlessBurst);
+}
+
 void CNetServer::SendControl(NETADDR &Addr, int ControlMsg, const void *pExtra, int ExtraSize, SECURITY_TOKEN SecurityToken)
 {
 	CNetBase::SendControlMsg(m_Socket, &Addr, 0, ControlMsg, pExtra, ExtraSize, SecurityToken);
@@ -648,11 +813,29 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 
 		// TODO: empty the recvinfo
 		unsigned char *pData;
-		int Bytes = net_udp_recv(m_Socket, &Addr, m_RecvUnpacker.m_aBuffer, NET_MAX_PACKETSIZE, &m_MMSGS, &pData);
+		int Bytes;
+		int Kind, InfoToken, InfoType;
+		if(m_pRecvThread)
+		{
+			// already filtered by the receive thread
+			Bytes = m_pRecvThread->Fetch(&Addr, m_RecvUnpacker.m_aBuffer, sizeof(m_RecvUnpacker.m_aBuffer), &Kind, &InfoToken, &InfoType);
+			pData = m_RecvUnpacker.m_aBuffer;
 
-		// no more packets for now
-		if(Bytes <= 0)
-			break;
+			// no more packets for now
+			if(Bytes <= 0)
+				break;
+		}
+		else
+		{
+			Bytes = net_udp_recv(m_Socket, &Addr, m_RecvUnpacker.m_aBuffer, sizeof(m_RecvUnpacker.m_aBuffer), &m_MMSGS, &pData);
+
+			// no more packets for now
+			if(Bytes <= 0)
+				break;
+
+			if(!FilterDatagram(&Addr, &pData, &Bytes, &Kind, &InfoToken, &InfoType))
+				continue;
+		}
 
 		// check if we just should drop the packet
 		char aBuf[128];
@@ -663,6 +846,12 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 			continue;
 		}
 
+		if(Kind == CNetConnlessFilter::KIND_INFO && m_pfnConnlessInfo)
+		{
+			m_pfnConnlessInfo(&Addr, InfoToken, InfoType, m_pConnlessInfoUser);
+			continue;
+		}
+
 		SECURITY_TOKEN Token;
 		bool Sixup = false;
 		*pResponseToken = NET_SECURITY_TOKEN_UNKNOWN;
@@ -670,9 +859,6 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 		{
 			if(m_RecvUnpacker.m_Data.m_Flags & NET_PACKETFLAG_CONNLESS)
 			{
-				if(Sixup && Token != GetToken(Addr))
-					continue;
-
 				pChunk->m_Flags = NETSENDFLAG_CONNLESS;
 				pChunk->m_ClientID = -1;
 				pChunk->m_Address = Addr;
@@ -795,7 +981,7 @@ int CNetServer::SendConnlessSixup(CNetChunk *pChunk, SECURITY_TOKEN ResponseToke
 	mem_copy(aBuffer + 1, &ResponseToken, 4);
 	mem_copy(aBuffer + 5, &Token, 4);
 	mem_copy(aBuffer + 9, pChunk->m_pData, pChunk->m_DataSize);
-	net_udp_send(m_Socket, &pChunk->m_Address, aBuffer, pChunk->m_DataSize + 9);
+	CNetBase::SendDatagram(m_Socket, &pChunk->m_Address, aBuffer, pChunk->m_DataSize + 9);
 
 	return 0;
 }
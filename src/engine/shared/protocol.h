@@ -5,6 +5,11 @@
 
 #include <base/system.h>
 
+// set by the MAX_CLIENTS build option
+#ifndef CONF_MAX_CLIENTS
+#define CONF_MAX_CLIENTS 64
+#endif
+
 /*
 	Connection diagram - How the initialization works.
 
@@ -82,8 +87,11 @@ enum
 	SERVERINFO_LEVEL_MIN = 0,
 	SERVERINFO_LEVEL_MAX = 2,
 
-	MAX_CLIENTS = 64,
+	MAX_CLIENTS = CONF_MAX_CLIENTS,
 	VANILLA_MAX_CLIENTS = 16,
+	// the most ids DDNet and 0.7 clients know, the others are mapped into them
+	// like for vanilla clients
+	DDNET_MAX_CLIENTS = 64,
 
 	MAX_INPUT_SIZE = 128,
 	MAX_SNAPSHOT_PACKSIZE = 900,
@@ -87,6 +87,16 @@ void CSnapshot::DebugDump()
 	}
 }
 
+int CSnapshot::StatsTypeIndex(int InternalType)
+{
+	if(InternalType >= 0 && InternalType < STATS_NUM_NETOBJ_TYPES)
+		return InternalType;
+	// extended item types are allocated downwards from MAX_TYPE
+	if(InternalType <= MAX_TYPE && InternalType > MAX_TYPE - STATS_NUM_EXTENDED_TYPES)
+		return STATS_NUM_NETOBJ_TYPES + MAX_TYPE - InternalType;
+	return STATS_OTHER;
+}
+
 // CSnapshotDelta
 
 struct CItemList
@@ -176,6 +186,7 @@ CSnapshotDelta::CSnapshotDelta()
 	mem_zero(m_aSnapshotDataUpdates, sizeof(m_aSnapshotDataUpdates));
 	m_SnapshotCurrent = 0;
 	mem_zero(&m_Empty, sizeof(m_Empty));
+	m_pStats = 0;
 }
 
 CSnapshotDelta::CSnapshotDelta(const CSnapshotDelta &Old)
@@ -185,6 +196,7 @@ CSnapshotDelta::CSnapshotDelta(const CSnapshotDelta &Old)
 	mem_copy(m_aSnapshotDataUpdates, Old.m_aSnapshotDataUpdates, sizeof(m_aSnapshotDataUpdates));
 	mem_copy(&m_SnapshotCurrent, &Old.m_SnapshotCurrent, sizeof(m_SnapshotCurrent));
 	mem_copy(&m_Empty, &Old.m_Empty, sizeof(m_Empty));
+	m_pStats = Old.m_pStats;
 }
 
 void CSnapshotDelta::SetStaticsize(int ItemType, int Size)
@@ -200,7 +212,7 @@ CSnapshotDelta::CData *CSnapshotDelta::EmptyDelta()
 }
 
 // TODO: OPT: this should be made much faster
-int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData)
+int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData, const int *pUnchangedSince, int FromTick)
 {
 	CData *pDelta = (CData *)pDstData;
 	int *pData = (int *)pDelta->m_aData;
@@ -227,6 +239,8 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 			pDelta->m_NumDeletedItems++;
 			*pData = pFromItem->Key();
 			pData++;
+			if(m_pStats)
+				m_pStats[CSnapshot::StatsTypeIndex(pFromItem->Type())] += sizeof(int);
 		}
 	}
 
@@ -244,6 +258,8 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 
 	for(i = 0; i < NumItems; i++)
 	{
+		int *pItemStart = pData;
+
 		// do delta
 		ItemSize = pTo->GetItemSize(i); // O(1) .. O(n)
 		pCurItem = pTo->GetItem(i); // O(1) .. O(n)
@@ -253,6 +269,10 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 
 		if(PastIndex != -1)
 		{
+			// the same item as in pFrom, nothing to send
+			if(pUnchangedSince && pUnchangedSince[i] >= 0 && pUnchangedSince[i] <= FromTick)
+				continue;
+
 			int *pItemDataDst = pData + 3;
 
 			pPastItem = pFrom->GetItem(PastIndex);
@@ -282,6 +302,9 @@ int CSnapshotDelta::CreateDelta(CSnapshot *pFrom, CSnapshot *pTo, void *pDstData
 			pDelta->m_NumUpdateItems++;
 			Count++;
 		}
+
+		if(m_pStats && pData != pItemStart)
+			m_pStats[CSnapshot::StatsTypeIndex(pCurItem->Type())] += (char *)pData - (char *)pItemStart;
 	}
 
 	if(0)
@@ -535,6 +558,7 @@ int CSnapshotStorage::Get(int Tick, int64 *pTagtime, CSnapshot **ppData, CSnapsh
 CSnapshotBuilder::CSnapshotBuilder()
 {
 	m_NumExtendedItemTypes = 0;
+	m_pStats = 0;
 }
 
 void CSnapshotBuilder::Init(bool Sixup)
@@ -618,7 +642,7 @@ int CSnapshotBuilder::GetExtendedItemTypeIndex(int TypeID)
 	return Index;
 }
 
-void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
+void *CSnapshotBuilder::NewItem(int Type, int ID, int Size, int UnchangedSince)
 {
 	if(m_DataSize + sizeof(CSnapshotItem) + Size >= CSnapshot::MAX_SIZE ||
 		m_NumItems + 1 >= MAX_ITEMS)
@@ -651,8 +675,12 @@ void *CSnapshotBuilder::NewItem(int Type, int ID, int Size)
 	mem_zero(pObj, sizeof(CSnapshotItem) + Size);
 	pObj->m_TypeAndID = (Type << 16) | ID;
 	m_aOffsets[m_NumItems] = m_DataSize;
+	m_aUnchangedSince[m_NumItems] = UnchangedSince;
 	m_DataSize += sizeof(CSnapshotItem) + Size;
 	m_NumItems++;
 
+	if(m_pStats)
+		m_pStats[CSnapshot::StatsTypeIndex(Type)] += sizeof(CSnapshotItem) + Size;
+
 	return pObj->Data();
 }
@@ -33,7 +33,13 @@ public:
 		OFFSET_UUID_TYPE = 0x4000,
 		MAX_TYPE = 0x7fff,
 		MAX_PARTS = 64,
-		MAX_SIZE = MAX_PARTS * 1024
+		MAX_SIZE = MAX_PARTS * 1024,
+
+		// bandwidth accounting buckets: netobj types, extended types, everything else
+		STATS_NUM_NETOBJ_TYPES = 64,
+		STATS_NUM_EXTENDED_TYPES = 64,
+		STATS_OTHER = STATS_NUM_NETOBJ_TYPES + STATS_NUM_EXTENDED_TYPES,
+		STATS_NUM_TYPES,
 	};
 
 	void Clear()
@@ -50,6 +56,9 @@ public:
 	unsigned Crc();
 	void DebugDump();
 	static void RemoveExtraInfo(unsigned char *pData);
+
+	// maps an internal item type to its bandwidth accounting bucket
+	static int StatsTypeIndex(int InternalType);
 };
 
 // CSnapshotDelta
@@ -76,6 +85,7 @@ private:
 	int m_aSnapshotDataUpdates[0xffff];
 	int m_SnapshotCurrent;
 	CData m_Empty;
+	int64 *m_pStats;
 
 	void UndiffItem(int *pPast, int *pDiff, int *pOut, int Size);
 
@@ -86,8 +96,12 @@ public:
 	int GetDataRate(int Index) { return m_aSnapshotDataRate[Index]; }
 	int GetDataUpdates(int Index) { return m_aSnapshotDataUpdates[Index]; }
 	void SetStaticsize(int ItemType, int Size);
+	// counts the delta bytes per item type bucket into pStats if set, see `CSnapshot::StatsTypeIndex`
+	void SetStats(int64 *pStats) { m_pStats = pStats; }
 	CData *EmptyDelta();
-	int CreateDelta(class CSnapshot *pFrom, class CSnapshot *pTo, void *pData);
+	// pUnchangedSince optionally gives per item of pTo the tick since which
+	// it has been the same, these items are not compared if pFrom is as new
+	int CreateDelta(class CSnapshot *pFrom, class CSnapshot *pTo, void *pData, const int *pUnchangedSince = 0, int FromTick = -1);
 	int UnpackDelta(class CSnapshot *pFrom, class CSnapshot *pTo, void *pData, int DataSize);
 };
 
@@ -134,6 +148,7 @@ class CSnapshotBuilder
 	int m_DataSize;
 
 	int m_aOffsets[MAX_ITEMS];
+	int m_aUnchangedSince[MAX_ITEMS];
 	int m_NumItems;
 
 	int m_aExtendedItemTypes[MAX_EXTENDED_ITEM_TYPES];
@@ -144,17 +159,25 @@ class CSnapshotBuilder
 
 	bool m_Sixup;
 
+	int64 *m_pStats;
+
 public:
 	CSnapshotBuilder();
 
 	void Init(bool Sixup = false);
+	// counts the item bytes per item type bucket into pStats if set, see `CSnapshot::StatsTypeIndex`
+	void SetStats(int64 *pStats) { m_pStats = pStats; }
 
-	void *NewItem(int Type, int ID, int Size);
+	// UnchangedSince is the tick since which the item has been the same in
+	// every snapshot of this receiver, -1 if unknown
+	void *NewItem(int Type, int ID, int Size, int UnchangedSince = -1);
 
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
 
 	int Finish(void *pSnapdata);
+	// the hints for `CSnapshotDelta::CreateDelta` of the finished snapshot
+	const int *UnchangedSince() const { return m_aUnchangedSince; }
 };
 
 #endif // ENGINE_SNAPSHOT_H
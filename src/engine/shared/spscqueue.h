@@ -0,0 +1,99 @@
+#ifndef ENGINE_SHARED_SPSCQUEUE_H
+#define ENGINE_SHARED_SPSCQUEUE_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * Elements are constructed in place: the producer obtains a free slot with
+ * `Back()`, fills it and publishes it with `Push()`. The consumer reads the
+ * oldest element with `Front()` and releases it with `Pop()`.
+ *
+ * @tparam T Element type, must be default constructible.
+ * @tparam N Capacity, must be a power of two.
+ */
+template<class T, size_t N>
+class CSpscQueue
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+	enum
+	{
+		CACHE_LINE_SIZE = 64,
+	};
+
+	// written by the consumer only
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_Head{0};
+	// written by the producer only
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_Tail{0};
+	alignas(CACHE_LINE_SIZE) T m_aData[N];
+
+public:
+	/**
+	 * Returns the slot the next element is written to.
+	 *
+	 * @remark Must only be called from the producer thread.
+	 *
+	 * @return Pointer to a free slot or `nullptr` if the queue is full.
+	 */
+	T *Back()
+	{
+		const size_t Tail = m_Tail.load(std::memory_order_relaxed);
+		if(Tail - m_Head.load(std::memory_order_acquire) >= N)
+			return nullptr;
+		return &m_aData[Tail & (N - 1)];
+	}
+
+	/**
+	 * Publishes the slot previously returned by `Back()` to the consumer.
+	 *
+	 * @remark Must only be called from the producer thread.
+	 */
+	void Push()
+	{
+		m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Returns the oldest element in the queue.
+	 *
+	 * @remark Must only be called from the consumer thread.
+	 *
+	 * @return Pointer to the oldest element or `nullptr` if the queue is empty.
+	 */
+	T *Front()
+	{
+		const size_t Head = m_Head.load(std::memory_order_relaxed);
+		if(Head == m_Tail.load(std::memory_order_acquire))
+			return nullptr;
+		return &m_aData[Head & (N - 1)];
+	}
+
+	/**
+	 * Releases the element previously returned by `Front()`.
+	 *
+	 * @remark Must only be called from the consumer thread.
+	 */
+	void Pop()
+	{
+		m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Returns the approximate number of queued elements. Exact when called
+	 * from either the producer or the consumer while the other is idle.
+	 */
+	size_t Size() const
+	{
+		return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+	}
+
+	bool Empty() const { return Size() == 0; }
+	static constexpr size_t Capacity() { return N; }
+};
+
+#endif
@@ -4,6 +4,8 @@
 
 #include <engine/shared/config.h>
 
+#include <algorithm>
+
 const char *CTuningParams::ms_apNames[] =
 	{
 #define MACRO_TUNING_PARAM(Name, ScriptName, Value, Description) #ScriptName,
@@ -11,6 +13,8 @@ const char *CTuningParams::ms_apNames[] =
 #undef MACRO_TUNING_PARAM
 };
 
+const CTuningValues CWorldCore::ms_DefaultTuning;
+
 bool CTuningParams::Set(int Index, float Value)
 {
 	if(Index < 0 || Index >= Num())
@@ -56,6 +60,66 @@ float VelocityRamp(float Value, float Start, float Range, float Curvature)
 	return 1.0f / powf(Curvature, (Value - Start) / Range);
 }
 
+void CWorldCore::BuildBroadphase()
+{
+	m_NumBroadphase = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!m_apCharacters[i])
+			continue;
+		// NaN positions aren't near anything
+		vec2 Pos = m_apCharacters[i]->m_Pos;
+		if(Pos.x != Pos.x || Pos.y != Pos.y)
+			continue;
+		CBroadphaseEntry *pEntry = &m_aBroadphase[m_NumBroadphase++];
+		pEntry->m_X = Pos.x;
+		pEntry->m_Y = Pos.y;
+		pEntry->m_ID = i;
+	}
+	std::sort(m_aBroadphase, m_aBroadphase + m_NumBroadphase, [](const CBroadphaseEntry &a, const CBroadphaseEntry &b) { return a.m_X < b.m_X; });
+	m_BroadphaseValid = true;
+}
+
+int CWorldCore::FindCharacters(vec2 From, vec2 To, float Radius, int *pIDs)
+{
+	if(m_NoBroadphase)
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			pIDs[i] = i;
+		return MAX_CLIENTS;
+	}
+
+	if(!m_BroadphaseValid)
+		BuildBroadphase();
+
+	// a bit more so that rounding in the exact tests can't miss anyone, it
+	// grows with the coordinates (hooks can fly off very far)
+	float Scale = maximum(maximum(absolute(From.x), absolute(From.y)), maximum(absolute(To.x), absolute(To.y)));
+	Radius += 1.0f + Scale / 8192.0f;
+	float MinX = minimum(From.x, To.x) - Radius;
+	float MaxX = maximum(From.x, To.x) + Radius;
+	float MinY = minimum(From.y, To.y) - Radius;
+	float MaxY = maximum(From.y, To.y) + Radius;
+
+	// NaN from a broken segment, test everyone like before
+	if(!(MinX <= MaxX && MinY <= MaxY))
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			pIDs[i] = i;
+		return MAX_CLIENTS;
+	}
+
+	const CBroadphaseEntry *pEntry = std::lower_bound(m_aBroadphase, m_aBroadphase + m_NumBroadphase, MinX, [](const CBroadphaseEntry &Entry, float X) { return Entry.m_X < X; });
+	int Num = 0;
+	for(; pEntry < m_aBroadphase + m_NumBroadphase && pEntry->m_X <= MaxX; pEntry++)
+	{
+		if(pEntry->m_Y >= MinY && pEntry->m_Y <= MaxY)
+			pIDs[Num++] = pEntry->m_ID;
+	}
+	std::sort(pIDs, pIDs + Num);
+	return Num;
+}
+
 void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams)
 {
 	m_pWorld = pWorld;
@@ -107,6 +171,13 @@ void CCharacterCore::Reset()
 	m_Input.m_TargetY = -1;
 }
 
+void CCharacterCore::SetPos(vec2 Pos)
+{
+	m_Pos = Pos;
+	if(m_pWorld)
+		m_pWorld->InvalidateBroadphase();
+}
+
 void CCharacterCore::Tick(bool UseInput)
 {
 	float PhysSize = 28.0f;
@@ -122,11 +193,11 @@ void CCharacterCore::Tick(bool UseInput)
 
 	vec2 TargetDirection = normalize(vec2(m_Input.m_TargetX, m_Input.m_TargetY));
 
-	m_Vel.y += m_pWorld->m_Tuning.m_Gravity;
+	m_Vel.y += m_pWorld->m_pTuning->m_Gravity;
 
-	float MaxSpeed = Grounded ? m_pWorld->m_Tuning.m_GroundControlSpeed : m_pWorld->m_Tuning.m_AirControlSpeed;
-	float Accel = Grounded ? m_pWorld->m_Tuning.m_GroundControlAccel : m_pWorld->m_Tuning.m_AirControlAccel;
-	float Friction = Grounded ? m_pWorld->m_Tuning.m_GroundFriction : m_pWorld->m_Tuning.m_AirFriction;
+	float MaxSpeed = Grounded ? m_pWorld->m_pTuning->m_GroundControlSpeed : m_pWorld->m_pTuning->m_AirControlSpeed;
+	float Accel = Grounded ? m_pWorld->m_pTuning->m_GroundControlAccel : m_pWorld->m_pTuning->m_AirControlAccel;
+	float Friction = Grounded ? m_pWorld->m_pTuning->m_GroundFriction : m_pWorld->m_pTuning->m_AirFriction;
 
 	// handle input
 	if(UseInput)
@@ -153,14 +224,14 @@ void CCharacterCore::Tick(bool UseInput)
 				if(Grounded)
 				{
 					m_TriggeredEvents |= COREEVENT_GROUND_JUMP;
-					m_Vel.y = -m_pWorld->m_Tuning.m_GroundJumpImpulse;
+					m_Vel.y = -m_pWorld->m_pTuning->m_GroundJumpImpulse;
 					m_Jumped |= 1;
 					m_JumpedTotal = 1;
 				}
 				else if(!(m_Jumped & 2))
 				{
 					m_TriggeredEvents |= COREEVENT_AIR_JUMP;
-					m_Vel.y = -m_pWorld->m_Tuning.m_AirJumpImpulse;
+					m_Vel.y = -m_pWorld->m_pTuning->m_AirJumpImpulse;
 					m_Jumped |= 3;
 					m_JumpedTotal++;
 				}
@@ -178,7 +249,7 @@ void CCharacterCore::Tick(bool UseInput)
 				m_HookPos = m_Pos + TargetDirection * PhysSize * 1.5f;
 				m_HookDir = TargetDirection;
 				m_HookedPlayer = -1;
-				m_HookTick = SERVER_TICK_SPEED * (1.25f - m_pWorld->m_Tuning.m_HookDuration);
+				m_HookTick = SERVER_TICK_SPEED * (1.25f - m_pWorld->m_pTuning->m_HookDuration);
 				m_TriggeredEvents |= COREEVENT_HOOK_LAUNCH;
 			}
 		}
@@ -226,11 +297,11 @@ void CCharacterCore::Tick(bool UseInput)
 	}
 	else if(m_HookState == HOOK_FLYING)
 	{
-		vec2 NewPos = m_HookPos + m_HookDir * m_pWorld->m_Tuning.m_HookFireSpeed;
-		if((!m_NewHook && distance(m_Pos, NewPos) > m_pWorld->m_Tuning.m_HookLength) || (m_NewHook && distance(m_HookTeleBase, NewPos) > m_pWorld->m_Tuning.m_HookLength))
+		vec2 NewPos = m_HookPos + m_HookDir * m_pWorld->m_pTuning->m_HookFireSpeed;
+		if((!m_NewHook && distance(m_Pos, NewPos) > m_pWorld->m_pTuning->m_HookLength) || (m_NewHook && distance(m_HookTeleBase, NewPos) > m_pWorld->m_pTuning->m_HookLength))
 		{
 			m_HookState = HOOK_RETRACT_START;
-			NewPos = m_Pos + normalize(NewPos - m_Pos) * m_pWorld->m_Tuning.m_HookLength;
+			NewPos = m_Pos + normalize(NewPos - m_Pos) * m_pWorld->m_pTuning->m_HookLength;
 			m_pReset = true;
 		}
 
@@ -255,11 +326,14 @@ void CCharacterCore::Tick(bool UseInput)
 		}
 
 		// Check against other players first
-		if(this->m_Hook && m_pWorld && m_pWorld->m_Tuning.m_PlayerHooking)
+		if(this->m_Hook && m_pWorld && m_pWorld->m_pTuning->m_PlayerHooking)
 		{
 			float Distance = 0.0f;
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			int aIDs[MAX_CLIENTS];
+			int NumIDs = m_pWorld->FindCharacters(m_HookPos, NewPos, PhysSize + 2.0f, aIDs);
+			for(int j = 0; j < NumIDs; j++)
 			{
+				int i = aIDs[j];
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
 					continue;
@@ -335,7 +409,7 @@ void CCharacterCore::Tick(bool UseInput)
 		// don't do this hook rutine when we are hook to a player
 		if(m_HookedPlayer == -1 && distance(m_HookPos, m_Pos) > 46.0f)
 		{
-			vec2 HookVel = normalize(m_HookPos - m_Pos) * m_pWorld->m_Tuning.m_HookDragAccel;
+			vec2 HookVel = normalize(m_HookPos - m_Pos) * m_pWorld->m_pTuning->m_HookDragAccel;
 			// the hook as more power to drag you up then down.
 			// this makes it easier to get on top of an platform
 			if(HookVel.y > 0)
@@ -351,7 +425,7 @@ void CCharacterCore::Tick(bool UseInput)
 			vec2 NewVel = m_Vel + HookVel;
 
 			// check if we are under the legal limit for the hook
-			if(length(NewVel) < m_pWorld->m_Tuning.m_HookDragSpeed || length(NewVel) < length(m_Vel))
+			if(length(NewVel) < m_pWorld->m_pTuning->m_HookDragSpeed || length(NewVel) < length(m_Vel))
 				m_Vel = NewVel; // no problem. apply
 		}
 
@@ -367,8 +441,19 @@ void CCharacterCore::Tick(bool UseInput)
 
 	if(m_pWorld)
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		int aIDs[MAX_CLIENTS];
+		int NumIDs = m_pWorld->FindCharacters(m_Pos, m_Pos, PhysSize * 1.25f, aIDs);
+		// the hooked player is pulled from any distance
+		if(m_HookedPlayer != -1 && !std::binary_search(aIDs, aIDs + NumIDs, m_HookedPlayer))
 		{
+			int *pInsert = std::lower_bound(aIDs, aIDs + NumIDs, m_HookedPlayer);
+			std::copy_backward(pInsert, aIDs + NumIDs, aIDs + NumIDs + 1);
+			*pInsert = m_HookedPlayer;
+			NumIDs++;
+		}
+		for(int j = 0; j < NumIDs; j++)
+		{
+			int i = aIDs[j];
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 			if(!pCharCore)
 				continue;
@@ -388,7 +473,7 @@ void CCharacterCore::Tick(bool UseInput)
 			{
 				vec2 Dir = normalize(m_Pos - pCharCore->m_Pos);
 
-				bool CanCollide = (m_Super || pCharCore->m_Super) || (pCharCore->m_Collision && m_Collision && !m_NoCollision && !pCharCore->m_NoCollision && m_pWorld->m_Tuning.m_PlayerCollision);
+				bool CanCollide = (m_Super || pCharCore->m_Super) || (pCharCore->m_Collision && m_Collision && !m_NoCollision && !pCharCore->m_NoCollision && m_pWorld->m_pTuning->m_PlayerCollision);
 
 				if(CanCollide && Distance < PhysSize * 1.25f && Distance > 0.0f)
 				{
@@ -405,11 +490,11 @@ void CCharacterCore::Tick(bool UseInput)
 				}
 
 				// handle hook influence
-				if(m_Hook && m_HookedPlayer == i && m_pWorld->m_Tuning.m_PlayerHooking)
+				if(m_Hook && m_HookedPlayer == i && m_pWorld->m_pTuning->m_PlayerHooking)
 				{
 					if(Distance > PhysSize * 1.50f) // TODO: fix tweakable variable
 					{
-						float Accel = m_pWorld->m_Tuning.m_HookDragAccel * (Distance / m_pWorld->m_Tuning.m_HookLength);
+						float Accel = m_pWorld->m_pTuning->m_HookDragAccel * (Distance / m_pWorld->m_pTuning->m_HookLength);
 
 						// add force to the hooked player
 						pCharCore->m_HookDragVel += Dir * Accel * 1.5f;
@@ -435,7 +520,7 @@ void CCharacterCore::Tick(bool UseInput)
 void CCharacterCore::AddDragVelocity()
 {
 	// Apply hook interaction velocity
-	float DragSpeed = m_pWorld->m_Tuning.m_HookDragSpeed;
+	float DragSpeed = m_pWorld->m_pTuning->m_HookDragSpeed;
 
 	vec2 Temp;
 	Temp.x = SaturatedAdd(-DragSpeed, DragSpeed, m_Vel.x, m_HookDragVel.x);
@@ -450,7 +535,10 @@ void CCharacterCore::ResetDragVelocity()
 
 void CCharacterCore::Move()
 {
-	float RampValue = VelocityRamp(length(m_Vel) * 50, m_pWorld->m_Tuning.m_VelrampStart, m_pWorld->m_Tuning.m_VelrampRange, m_pWorld->m_Tuning.m_VelrampCurvature);
+	if(m_pWorld)
+		m_pWorld->InvalidateBroadphase();
+
+	float RampValue = VelocityRamp(length(m_Vel) * 50, m_pWorld->m_pTuning->m_VelrampStart, m_pWorld->m_pTuning->m_VelrampRange, m_pWorld->m_pTuning->m_VelrampCurvature);
 
 	m_Vel.x = m_Vel.x * RampValue;
 
@@ -472,7 +560,7 @@ void CCharacterCore::Move()
 
 	m_Vel.x = m_Vel.x * (1.0f / RampValue);
 
-	if(m_pWorld && (m_Super || (m_pWorld->m_Tuning.m_PlayerCollision && m_Collision && !m_NoCollision && !m_Solo)))
+	if(m_pWorld && (m_Super || (m_pWorld->m_pTuning->m_PlayerCollision && m_Collision && !m_NoCollision && !m_Solo)))
 	{
 		// check player collision
 		float Distance = distance(m_Pos, NewPos);
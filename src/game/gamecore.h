@@ -64,6 +64,25 @@ public:
 	bool Get(const char *pName, float *pValue) const;
 };
 
+// The values of a tuning set converted to floats once, the physics read
+// these instead of converting the fixed point values on every access.
+class CTuningValues
+{
+public:
+	CTuningValues() :
+		CTuningValues(CTuningParams()) {}
+	explicit CTuningValues(const CTuningParams &Params)
+	{
+#define MACRO_TUNING_PARAM(Name, ScriptName, Value, Description) m_##Name = Params.m_##Name;
+#include "tuning.h"
+#undef MACRO_TUNING_PARAM
+	}
+
+#define MACRO_TUNING_PARAM(Name, ScriptName, Value, Description) float m_##Name;
+#include "tuning.h"
+#undef MACRO_TUNING_PARAM
+};
+
 inline void StrToInts(int *pInts, int Num, const char *pStr)
 {
 	int Index = 0;
@@ -168,14 +187,47 @@ enum
 
 class CWorldCore
 {
+	// the characters sorted by x, rebuilt by the first query after one of
+	// them moved, usually once per tick
+	struct CBroadphaseEntry
+	{
+		float m_X;
+		float m_Y;
+		int m_ID;
+	};
+	CBroadphaseEntry m_aBroadphase[MAX_CLIENTS];
+	int m_NumBroadphase = 0;
+	bool m_BroadphaseValid = false;
+
+	void BuildBroadphase();
+
 public:
 	CWorldCore()
 	{
 		mem_zero(m_apCharacters, sizeof(m_apCharacters));
+		m_pTuning = &ms_DefaultTuning;
 	}
 
-	CTuningParams m_Tuning;
+	static const CTuningValues ms_DefaultTuning;
+	// set before the characters of a tune zone tick, not owned
+	const CTuningValues *m_pTuning;
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
+
+	// return every slot from `FindCharacters`, to compare against
+	bool m_NoBroadphase = false;
+
+	void SetCharacter(int ClientID, class CCharacterCore *pCore)
+	{
+		m_apCharacters[ClientID] = pCore;
+		m_BroadphaseValid = false;
+	}
+	// call after a character moved other than by `CCharacterCore::Move`
+	void InvalidateBroadphase() { m_BroadphaseValid = false; }
+
+	// writes the ids of the characters that may be within `Radius` of the
+	// segment from `From` to `To` to `pIDs` in ascending order, returns
+	// their number
+	int FindCharacters(vec2 From, vec2 To, float Radius, int *pIDs);
 };
 
 class CCharacterCore
@@ -215,6 +267,8 @@ public:
 	void Reset();
 	void Tick(bool UseInput);
 	void Move();
+	// teleports the character
+	void SetPos(vec2 Pos);
 
 	void AddDragVelocity();
 	void ResetDragVelocity();
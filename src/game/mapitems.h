@@ -208,6 +208,8 @@ enum
 	TILE_USE_DDRSHOTGUN = 153,
 	TILE_USE_OLDLASER = 168,
 	TILE_USE_PVPSHOTGUN = 169,
+	// speedup tile type, the part of a mega map is m_MaxSpeed | m_Angle << 8.
+	// m_Force stays 0, clients that don't check the type see no speedup then
 	TILE_MEGAMAP_INDEX = 255,
 
 	ENTITY_OFFSET = 255 - 16 * 4,
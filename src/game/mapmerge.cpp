@@ -0,0 +1,1073 @@
+#include "mapmerge.h"
+
+#include <base/system.h>
+#include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/linereader.h>
+#include <engine/storage.h>
+#include <game/gamecore.h>
+#include <game/mapitems.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <engine/external/stb/stb_rect_pack.h>
+
+#define MAP_PADDING_X 24
+#define MAP_PADDING_Y 16
+#define MAP_TILESIZE 32
+
+struct SMapImage
+{
+	int m_Width;
+	int m_Height;
+	int m_External;
+	char *m_pName;
+	void *m_pData;
+	int m_DataSize;
+	int m_Index;
+};
+
+struct SLayer
+{
+	CMapItemLayer m_Layer;
+	int m_Width;
+	int m_Height;
+	int m_Flags;
+
+	int m_NumQuads;
+
+	CColor m_Color;
+	int m_ColorEnv;
+	int m_ColorEnvOffset;
+
+	int m_Image;
+	void *m_pData;
+	int m_DataSize;
+
+	int m_aName[3];
+};
+
+struct SLayerGroup
+{
+	int m_OffsetX;
+	int m_OffsetY;
+	int m_ParallaxX;
+	int m_ParallaxY;
+
+	int m_UseClipping;
+	int m_ClipX;
+	int m_ClipY;
+	int m_ClipW;
+	int m_ClipH;
+
+	int m_aName[3];
+
+	std::vector<SLayer *> m_vLayers;
+};
+
+// Writes the merged map, its datas are compressed in parallel once all of
+// them are known. Compressed datas are kept in a cache directory by the hash
+// of their content, the layers and images of unchanged source maps aren't
+// compressed again.
+class CCachedDataFileWriter
+{
+	struct CBlob
+	{
+		int m_Size;
+		// the compressed content came from the cache
+		bool m_Cached = false;
+		// the content while it's not compressed
+		std::vector<char> m_vData;
+		std::vector<char> m_vCompressed;
+	};
+
+	class CCompressJob : public IJob
+	{
+		CBlob *m_pBlob;
+
+		void Run() override
+		{
+			unsigned long CompressedSize = compressBound(m_pBlob->m_Size);
+			m_pBlob->m_vCompressed.resize(CompressedSize);
+			int Result = compress2((Bytef *)m_pBlob->m_vCompressed.data(), &CompressedSize, (Bytef *)m_pBlob->m_vData.data(), m_pBlob->m_Size, Z_DEFAULT_COMPRESSION); // ignore_convention
+			if(Result != Z_OK)
+			{
+				dbg_msg("map_merge", "compression error %d", Result);
+				dbg_assert(0, "zlib error");
+			}
+			m_pBlob->m_vCompressed.resize(CompressedSize);
+			m_pBlob->m_vData = std::vector<char>();
+		}
+
+	public:
+		CCompressJob(CBlob *pBlob) :
+			m_pBlob(pBlob) {}
+	};
+
+	IStorage *m_pStorage;
+	CDataFileWriter m_Writer;
+	char m_aCacheDir[IO_MAX_PATH_LENGTH];
+	// equal datas share their blob
+	std::map<std::string, std::unique_ptr<CBlob>> m_Blobs;
+	std::vector<CBlob *> m_vpDatas;
+	int m_NumCached = 0;
+
+	void CachePath(const std::string &Hash, char *pBuf, int BufSize) const
+	{
+		str_format(pBuf, BufSize, "%s/%s", m_aCacheDir, Hash.c_str());
+	}
+
+	// a cache file may be cut short or changed, it's only used if it
+	// uncompresses to the data it's named after
+	static bool CheckCached(const CBlob *pBlob, const char *pHash)
+	{
+		std::vector<char> vData(pBlob->m_Size);
+		unsigned long Size = pBlob->m_Size;
+		if(uncompress((Bytef *)vData.data(), &Size, (const Bytef *)pBlob->m_vCompressed.data(), pBlob->m_vCompressed.size()) != Z_OK || Size != (unsigned long)pBlob->m_Size) // ignore_convention
+			return false;
+		char aHash[SHA256_MAXSTRSIZE];
+		sha256_str(sha256(vData.data(), Size), aHash, sizeof(aHash));
+		return str_comp(aHash, pHash) == 0;
+	}
+
+	static int RemoveUnusedCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+	{
+		CCachedDataFileWriter *pSelf = (CCachedDataFileWriter *)pUser;
+		if(IsDir || pSelf->m_Blobs.count(pName))
+			return 0;
+		char aPath[IO_MAX_PATH_LENGTH];
+		pSelf->CachePath(pName, aPath, sizeof(aPath));
+		pSelf->m_pStorage->RemoveFile(aPath, IStorage::TYPE_SAVE);
+		return 0;
+	}
+
+public:
+	bool Open(IStorage *pStorage, const char *pFilename)
+	{
+		m_pStorage = pStorage;
+		str_format(m_aCacheDir, sizeof(m_aCacheDir), "%s.cache", pFilename);
+		pStorage->CreateFolder(m_aCacheDir, IStorage::TYPE_SAVE);
+		return m_Writer.Open(pStorage, pFilename);
+	}
+
+	int AddData(int Size, void *pData)
+	{
+		char aHash[SHA256_MAXSTRSIZE];
+		sha256_str(sha256(pData, Size), aHash, sizeof(aHash));
+		std::unique_ptr<CBlob> &pBlob = m_Blobs[aHash];
+		if(!pBlob)
+		{
+			pBlob = std::make_unique<CBlob>();
+			pBlob->m_Size = Size;
+
+			char aPath[IO_MAX_PATH_LENGTH];
+			CachePath(aHash, aPath, sizeof(aPath));
+			void *pCompressed;
+			unsigned CompressedSize;
+			if(m_pStorage->ReadFile(aPath, IStorage::TYPE_SAVE, &pCompressed, &CompressedSize))
+			{
+				pBlob->m_vCompressed.assign((char *)pCompressed, (char *)pCompressed + CompressedSize);
+				free(pCompressed);
+				pBlob->m_Cached = CheckCached(pBlob.get(), aHash);
+				if(pBlob->m_Cached)
+					m_NumCached++;
+				else
+				{
+					dbg_msg("map_merge", "cached data '%s' is broken, compressing it again", aPath);
+					pBlob->m_vCompressed.clear();
+				}
+			}
+			if(!pBlob->m_Cached)
+				pBlob->m_vData.assign((char *)pData, (char *)pData + Size);
+		}
+		m_vpDatas.push_back(pBlob.get());
+		return m_vpDatas.size() - 1;
+	}
+
+	int AddItem(int Type, int ID, int Size, void *pData) { return m_Writer.AddItem(Type, ID, Size, pData); }
+
+	int NumDatas() const { return m_Blobs.size(); }
+	int NumCached() const { return m_NumCached; }
+
+	void Finish(int NumThreads)
+	{
+		int NumCompressed = 0;
+		{
+			CJobPool Pool;
+			Pool.Init(NumThreads);
+			for(auto &Blob : m_Blobs)
+			{
+				if(!Blob.second->m_Cached)
+				{
+					Pool.Add(std::make_shared<CCompressJob>(Blob.second.get()));
+					NumCompressed++;
+				}
+			}
+			// waits for the jobs
+			Pool.Shutdown();
+		}
+		dbg_msg("map_merge", "compressed %d of %d datas with %d threads, the rest was cached", NumCompressed, (int)m_Blobs.size(), NumThreads);
+
+		// the cache holds the datas of the last merge, the files are renamed
+		// into place once they are complete, so an interrupted merge doesn't
+		// leave a partial one behind
+		for(auto &Blob : m_Blobs)
+		{
+			if(Blob.second->m_Cached)
+				continue;
+			char aPath[IO_MAX_PATH_LENGTH];
+			char aTmpPath[IO_MAX_PATH_LENGTH];
+			CachePath(Blob.first, aPath, sizeof(aPath));
+			str_format(aTmpPath, sizeof(aTmpPath), "%s.tmp", aPath);
+			IOHANDLE File = m_pStorage->OpenFile(aTmpPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+			if(!File)
+				continue;
+			bool Written = io_write(File, Blob.second->m_vCompressed.data(), Blob.second->m_vCompressed.size()) == Blob.second->m_vCompressed.size();
+			io_close(File);
+			if(!Written || !m_pStorage->RenameFile(aTmpPath, aPath, IStorage::TYPE_SAVE))
+				m_pStorage->RemoveFile(aTmpPath, IStorage::TYPE_SAVE);
+		}
+		m_pStorage->ListDirectory(IStorage::TYPE_SAVE, m_aCacheDir, RemoveUnusedCallback, this);
+
+		for(CBlob *pBlob : m_vpDatas)
+			m_Writer.AddDataCompressed(pBlob->m_Size, pBlob->m_vCompressed.data(), pBlob->m_vCompressed.size());
+		m_Writer.Finish();
+	}
+};
+
+static int SaveGameLayer(CCachedDataFileWriter &DataFileOut, int Width, int Height, void *pTiles, int &LayerCount, int Type)
+{
+	if(!pTiles)
+		return 0;
+
+	CMapItemLayerTilemap Item;
+	Item.m_Version = 3;
+
+	Item.m_Layer.m_Version = 0;
+	Item.m_Layer.m_Flags = 0;
+	Item.m_Layer.m_Type = LAYERTYPE_TILES;
+
+	Item.m_Color = {255, 255, 255, 255};
+	Item.m_ColorEnv = -1;
+	Item.m_ColorEnvOffset = 0;
+
+	Item.m_Width = Width;
+	Item.m_Height = Height;
+
+	Item.m_Image = -1;
+	Item.m_Tele = -1;
+	Item.m_Speedup = -1;
+	Item.m_Front = -1;
+	Item.m_Switch = -1;
+	Item.m_Tune = -1;
+
+	void *pEmptyData = malloc(Width * Height * sizeof(CTile));
+	mem_zero(pEmptyData, Width * Height * sizeof(CTile));
+
+	if(Type == TILESLAYERFLAG_GAME)
+	{
+		Item.m_Flags = TILESLAYERFLAG_GAME;
+		Item.m_Data = DataFileOut.AddData(Width * Height * sizeof(CTile), pTiles);
+		StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "Game");
+	}
+	else if(Type == TILESLAYERFLAG_FRONT)
+	{
+		Item.m_Flags = TILESLAYERFLAG_FRONT;
+		Item.m_Data = DataFileOut.AddData(Width * Height * sizeof(CTile), pEmptyData);
+		StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "Front");
+		Item.m_Front = DataFileOut.AddData(Width * Height * sizeof(CTile), pTiles);
+	}
+	else if(Type == TILESLAYERFLAG_TUNE)
+	{
+		Item.m_Flags = TILESLAYERFLAG_TUNE;
+		Item.m_Data = DataFileOut.AddData(Width * Height * sizeof(CTile), pEmptyData);
+		StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "Tune");
+		Item.m_Tune = DataFileOut.AddData(Width * Height * sizeof(CTuneTile), pTiles);
+	}
+	else if(Type == TILESLAYERFLAG_TELE)
+	{
+		Item.m_Flags = TILESLAYERFLAG_TELE;
+		Item.m_Data = DataFileOut.AddData(Width * Height * sizeof(CTile), pEmptyData);
+		StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "Tele");
+		Item.m_Tele = DataFileOut.AddData(Width * Height * sizeof(CTeleTile), pTiles);
+	}
+	else if(Type == TILESLAYERFLAG_SPEEDUP)
+	{
+		Item.m_Flags = TILESLAYERFLAG_SPEEDUP;
+		Item.m_Data = DataFileOut.AddData(Width * Height * sizeof(CTile), pEmptyData);
+		StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "Speedup");
+		Item.m_Speedup = DataFileOut.AddData(Width * Height * sizeof(CSpeedupTile), pTiles);
+	}
+	else if(Type == TILESLAYERFLAG_SWITCH)
+	{
+		Item.m_Flags = TILESLAYERFLAG_SWITCH;
+		Item.m_Data = DataFileOut.AddData(Width * Height * sizeof(CTile), pEmptyData);
+		StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "Switch");
+		Item.m_Switch = DataFileOut.AddData(Width * Height * sizeof(CSwitchTile), pTiles);
+	}
+	else
+	{
+		free(pEmptyData);
+		return 0;
+	}
+
+	dbg_msg("map_merge", "saving layer %d (%dx%d) type=%d, flags=%d, img=%d", LayerCount, Item.m_Width, Item.m_Height, Item.m_Layer.m_Type, Item.m_Flags, Item.m_Image);
+	DataFileOut.AddItem(MAPITEMTYPE_LAYER, LayerCount++, sizeof(Item), &Item);
+	free(pEmptyData);
+	return 1;
+}
+
+static int SaveLayers(CCachedDataFileWriter &DataFileOut, std::vector<SLayer *> &vLayers, int &LayerCount)
+{
+	int NumGroupLayer = 0;
+	for(auto &pLayer : vLayers)
+	{
+		if(pLayer->m_Layer.m_Type == LAYERTYPE_TILES)
+		{
+			CMapItemLayerTilemap Item;
+			Item.m_Version = 3;
+
+			Item.m_Layer.m_Version = 0;
+			Item.m_Layer.m_Flags = pLayer->m_Layer.m_Flags;
+			Item.m_Layer.m_Type = pLayer->m_Layer.m_Type;
+
+			Item.m_Color = pLayer->m_Color;
+			Item.m_ColorEnv = pLayer->m_ColorEnv;
+			Item.m_ColorEnvOffset = pLayer->m_ColorEnvOffset;
+
+			Item.m_Width = pLayer->m_Width;
+			Item.m_Height = pLayer->m_Height;
+			Item.m_Flags = pLayer->m_Flags;
+
+			Item.m_Image = pLayer->m_Image;
+
+			// TODO: ddnet layers
+			Item.m_Tele = -1;
+			Item.m_Speedup = -1;
+			Item.m_Front = -1;
+			Item.m_Switch = -1;
+			Item.m_Tune = -1;
+
+			Item.m_Data = DataFileOut.AddData(pLayer->m_DataSize, pLayer->m_pData);
+
+			Item.m_aName[0] = pLayer->m_aName[0];
+			Item.m_aName[1] = pLayer->m_aName[1];
+			Item.m_aName[2] = pLayer->m_aName[2];
+
+			dbg_msg("map_merge", "saving tile layer %d (%dx%d) flags=%d, img=%d", LayerCount, Item.m_Width, Item.m_Height, Item.m_Flags, Item.m_Image);
+			DataFileOut.AddItem(MAPITEMTYPE_LAYER, LayerCount++, sizeof(Item), &Item);
+			// automapper is skipped, since it won't work afterwards anyway
+			NumGroupLayer++;
+		}
+		else if(pLayer->m_Layer.m_Type == LAYERTYPE_QUADS)
+		{
+			CMapItemLayerQuads Item;
+			Item.m_Version = 2;
+			Item.m_Layer.m_Version = 0;
+			Item.m_Layer.m_Flags = pLayer->m_Layer.m_Flags;
+			Item.m_Layer.m_Type = pLayer->m_Layer.m_Type;
+			Item.m_Image = pLayer->m_Image;
+
+			Item.m_aName[0] = pLayer->m_aName[0];
+			Item.m_aName[1] = pLayer->m_aName[1];
+			Item.m_aName[2] = pLayer->m_aName[2];
+
+			Item.m_NumQuads = pLayer->m_NumQuads;
+			Item.m_Data = DataFileOut.AddData(pLayer->m_DataSize, pLayer->m_pData);
+
+			dbg_msg("map_merge", "saving quad layer %d, img=%d, num_quads=%d", LayerCount, Item.m_Image, Item.m_NumQuads);
+			DataFileOut.AddItem(MAPITEMTYPE_LAYER, LayerCount++, sizeof(Item), &Item);
+			NumGroupLayer++;
+		}
+	}
+	return NumGroupLayer;
+}
+
+static void SaveGroups(CCachedDataFileWriter &DataFileOut, std::vector<SLayerGroup *> &Groups, int &LayerCount, int &GroupCount)
+{
+	for(auto &pGroup : Groups)
+	{
+		CMapItemGroup GItem;
+		GItem.m_Version = CMapItemGroup::CURRENT_VERSION;
+		GItem.m_ParallaxX = pGroup->m_ParallaxX;
+		GItem.m_ParallaxY = pGroup->m_ParallaxY;
+		GItem.m_OffsetX = pGroup->m_OffsetX;
+		GItem.m_OffsetY = pGroup->m_OffsetY;
+		GItem.m_UseClipping = pGroup->m_UseClipping;
+		GItem.m_ClipX = pGroup->m_ClipX;
+		GItem.m_ClipY = pGroup->m_ClipY;
+		GItem.m_ClipW = pGroup->m_ClipW;
+		GItem.m_ClipH = pGroup->m_ClipH;
+		GItem.m_aName[0] = pGroup->m_aName[0];
+		GItem.m_aName[1] = pGroup->m_aName[1];
+		GItem.m_aName[2] = pGroup->m_aName[2];
+		GItem.m_StartLayer = LayerCount;
+		GItem.m_NumLayers = SaveLayers(DataFileOut, pGroup->m_vLayers, LayerCount);
+		dbg_msg("map_merge", "saving group %d containing layers %d-%d, isclip=%d, off=%d:%d, para=%d:%d, clip=%d:%d:%d:%d", GroupCount, GItem.m_StartLayer, GItem.m_StartLayer + GItem.m_NumLayers - 1, GItem.m_UseClipping, GItem.m_OffsetX, GItem.m_OffsetY, GItem.m_ParallaxX, GItem.m_ParallaxY, GItem.m_ClipX, GItem.m_ClipY, GItem.m_ClipW, GItem.m_ClipH);
+		DataFileOut.AddItem(MAPITEMTYPE_GROUP, GroupCount++, sizeof(GItem), &GItem);
+	}
+}
+
+// place of a map in the mega map, with its padding
+struct SLayoutRect
+{
+	int m_X;
+	int m_Y;
+	int m_W;
+	int m_H;
+};
+
+// the layout of the last merge, one "x y w h name" line per map
+static void LoadLayout(IStorage *pStorage, const char *pFilename, std::map<std::string, SLayoutRect> *pLayout)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	CLineReader LineReader;
+	LineReader.Init(File);
+	char *pLine;
+	while((pLine = LineReader.Get()))
+	{
+		int aValues[4];
+		for(int &Value : aValues)
+		{
+			pLine = str_skip_whitespaces(pLine);
+			Value = str_toint(pLine);
+			pLine = str_skip_to_whitespace(pLine);
+		}
+		pLine = str_skip_whitespaces(pLine);
+		if(pLine[0])
+			(*pLayout)[pLine] = {aValues[0], aValues[1], aValues[2], aValues[3]};
+	}
+	io_close(File);
+}
+
+static void SaveLayout(IStorage *pStorage, const char *pFilename, const char *const *ppMapNames, const std::vector<SLayoutRect> &vLayout)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		dbg_msg("map_merge", "failed to save the layout to '%s'", pFilename);
+		return;
+	}
+	for(int MapIndex = 0; MapIndex < (int)vLayout.size(); MapIndex++)
+	{
+		const SLayoutRect &Rect = vLayout[MapIndex];
+		char aBuf[IO_MAX_PATH_LENGTH + 64];
+		str_format(aBuf, sizeof(aBuf), "%d %d %d %d %s", Rect.m_X, Rect.m_Y, Rect.m_W, Rect.m_H, ppMapNames[MapIndex]);
+		io_write(File, aBuf, str_length(aBuf));
+		io_write_newline(File);
+	}
+	io_close(File);
+}
+
+bool MergeMaps(IStorage *pStorage, const char *pOutName, const char *const *ppMapNames, int NumMaps, SMapMergeStats *pStats)
+{
+	// the index of a map is stored in two bytes of the speedup tiles
+	if(NumMaps > 0xffff)
+	{
+		dbg_msg("map_merge", "too many maps, at most %d", 0xffff);
+		return false;
+	}
+
+	// maps that fit into their place of the last merge stay there
+	char aLayoutFile[IO_MAX_PATH_LENGTH];
+	str_format(aLayoutFile, sizeof(aLayoutFile), "%s.layout", pOutName);
+	std::map<std::string, SLayoutRect> LastLayout;
+	LoadLayout(pStorage, aLayoutFile, &LastLayout);
+	std::vector<SLayoutRect> vLayout(NumMaps);
+	std::vector<stbrp_rect> vNewRects;
+	int LayoutWidth = 0;
+	int LayoutBottom = 0;
+	int NumKept = 0;
+
+	// Preload data & packing, freed on every return
+	std::vector<std::unique_ptr<CDataFileReader>> vpDataFiles(NumMaps);
+	std::vector<stbrp_rect> vRects(NumMaps);
+	stbrp_rect *pRects = vRects.data();
+
+	int MaxMapWidth = 0;
+	for(int MapIndex = 0; MapIndex < NumMaps; MapIndex++)
+	{
+		vpDataFiles[MapIndex] = std::make_unique<CDataFileReader>();
+		CDataFileReader &DataFile = *vpDataFiles[MapIndex];
+
+		if(!DataFile.Open(pStorage, ppMapNames[MapIndex], IStorage::TYPE_ABSOLUTE))
+		{
+			dbg_msg("map_merge", "error opening map '%s'", ppMapNames[MapIndex]);
+			return false;
+		}
+
+		int LayersStart, LayersNum;
+		DataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+		int MapWidth = 0;
+		int MapHeight = 0;
+		for(int i = 0; i < LayersNum; i++)
+		{
+			CMapItemLayer *pLayerItem = (CMapItemLayer *)DataFile.GetItem(LayersStart + i, 0, 0);
+			if(pLayerItem->m_Type != LAYERTYPE_TILES)
+				continue;
+
+			CMapItemLayerTilemap *pTilemapItem = (CMapItemLayerTilemap *)pLayerItem;
+			if(pTilemapItem->m_Flags)
+			{
+				MapWidth = maximum(MapWidth, pTilemapItem->m_Width);
+				MapHeight = maximum(MapHeight, pTilemapItem->m_Height);
+			}
+		}
+
+		pRects[MapIndex].id = MapIndex;
+		pRects[MapIndex].w = MapWidth + MAP_PADDING_X * 2;
+		pRects[MapIndex].h = MapHeight + MAP_PADDING_Y * 2;
+		pRects[MapIndex].was_packed = false;
+		dbg_msg("map_merge", "size of map %s: %dx%d", ppMapNames[MapIndex], MapWidth, MapHeight);
+
+		auto Last = LastLayout.find(ppMapNames[MapIndex]);
+		if(Last != LastLayout.end() && pRects[MapIndex].w <= Last->second.m_W && pRects[MapIndex].h <= Last->second.m_H)
+		{
+			// keeps the whole place in case the map grows back
+			vLayout[MapIndex] = Last->second;
+			pRects[MapIndex].x = Last->second.m_X;
+			pRects[MapIndex].y = Last->second.m_Y;
+			pRects[MapIndex].was_packed = true;
+			LayoutWidth = maximum(Last->second.m_X + Last->second.m_W, LayoutWidth);
+			LayoutBottom = maximum(Last->second.m_Y + Last->second.m_H, LayoutBottom);
+			LastLayout.erase(Last);
+			NumKept++;
+			continue;
+		}
+
+		vNewRects.push_back(pRects[MapIndex]);
+		MaxMapWidth = maximum(MapWidth + MAP_PADDING_X * 2, MaxMapWidth);
+	}
+
+	if(!vNewRects.empty())
+	{
+		int MaxWidth = 2;
+		while(MaxWidth < maximum(MaxMapWidth, LayoutWidth))
+			MaxWidth *= 2;
+
+		// new and grown maps go below the kept ones
+		dbg_msg("map_merge", "packing %d of %d maps into a mega map of width %d below %d", (int)vNewRects.size(), NumMaps, MaxWidth, LayoutBottom);
+
+		stbrp_node *apPackerStorage = (stbrp_node *)malloc(sizeof(stbrp_node) * MaxWidth);
+		stbrp_context Packer;
+		stbrp_init_target(&Packer, MaxWidth, 10000, apPackerStorage, MaxWidth);
+
+		bool PackingSuccess = stbrp_pack_rects(&Packer, vNewRects.data(), vNewRects.size());
+		free(apPackerStorage);
+		if(!PackingSuccess)
+		{
+			dbg_msg("map_merge", "error packing maps");
+			return false;
+		}
+
+		for(const auto &Rect : vNewRects)
+		{
+			pRects[Rect.id].x = Rect.x;
+			pRects[Rect.id].y = Rect.y + LayoutBottom;
+			vLayout[Rect.id] = {pRects[Rect.id].x, pRects[Rect.id].y, Rect.w, Rect.h};
+		}
+	}
+
+	MaxMapWidth = 0;
+	int MaxMapHeight = 0;
+	for(int MapIndex = 0; MapIndex < NumMaps; MapIndex++)
+	{
+		dbg_msg("map_merge", "%s at %d, %d", ppMapNames[MapIndex], pRects[MapIndex].x, pRects[MapIndex].y);
+
+		MaxMapWidth = maximum(pRects[MapIndex].x + pRects[MapIndex].w - MAP_PADDING_X * 2, MaxMapWidth);
+		MaxMapHeight = maximum(pRects[MapIndex].y + pRects[MapIndex].h - MAP_PADDING_Y * 2, MaxMapHeight);
+	}
+
+	dbg_msg("map_merge", "mega map final size: %d x %d", MaxMapWidth, MaxMapHeight);
+
+	std::vector<SLayerGroup *> PreGameGroupGroups; // store groups before game groups
+	std::vector<SLayerGroup *> PostGameGroupGroups; // store groups after game groups
+
+	// Game Group layers
+	std::vector<CTile> vGameTiles(MaxMapWidth * MaxMapHeight);
+	std::vector<CSpeedupTile> vSpeedupTiles(MaxMapWidth * MaxMapHeight);
+	CTile *pGameTiles = vGameTiles.data();
+	CTeleTile *pTeleTiles = nullptr;
+	CSpeedupTile *pSpeedupTiles = vSpeedupTiles.data();
+	CTile *pFrontTiles = nullptr;
+	CSwitchTile *pSwitchTiles = nullptr;
+	CTuneTile *pTuneTiles = nullptr;
+	// clear the padding too, the datas are cached by their hash
+	mem_zero(pGameTiles, vGameTiles.size() * sizeof(CTile));
+	mem_zero(pSpeedupTiles, vSpeedupTiles.size() * sizeof(CSpeedupTile));
+
+	int NumImages = 0;
+	int NumSounds = 0;
+
+	std::vector<SMapImage> MapImages;
+	std::vector<CEnvPoint> EnvPoints;
+	std::vector<CMapItemEnvelope> Envelopes;
+
+	CCachedDataFileWriter DataFileOut;
+	if(!DataFileOut.Open(pStorage, pOutName))
+	{
+		dbg_msg("map_merge", "failed to open file '%s'...", pOutName);
+		return false;
+	}
+
+	// merge maps
+	for(int MapIndex = 0; MapIndex < NumMaps; MapIndex++)
+	{
+		CDataFileReader &DataFile = *vpDataFiles[MapIndex];
+
+		// load images
+		std::vector<int> ImageIDMap;
+		{
+			int Start, Num;
+			DataFile.GetType(MAPITEMTYPE_IMAGE, &Start, &Num);
+			ImageIDMap.resize(Num);
+
+			for(int i = 0; i < Num; i++)
+			{
+				CMapItemImage *pItem = (CMapItemImage *)DataFile.GetItem(Start + i, 0, 0);
+				char *pName = (char *)DataFile.GetData(pItem->m_ImageName);
+
+				bool ImageAlreadyExists = false;
+				for(auto &Image : MapImages)
+				{
+					if(Image.m_External == pItem->m_External && str_comp(Image.m_pName, pName) == 0)
+					{
+						ImageIDMap[i] = Image.m_Index;
+						ImageAlreadyExists = true;
+						break;
+					}
+				}
+
+				if(ImageAlreadyExists)
+				{
+					// save memory (probably)
+					DataFile.UnloadData(pItem->m_ImageName);
+					DataFile.UnloadData(pItem->m_ImageData);
+					continue;
+				}
+
+				SMapImage Image;
+				Image.m_External = pItem->m_External;
+				Image.m_Width = pItem->m_Width;
+				Image.m_Height = pItem->m_Height;
+				Image.m_pName = pName;
+				if(Image.m_External)
+					Image.m_pData = nullptr;
+				else
+				{
+					Image.m_pData = DataFile.GetData(pItem->m_ImageData);
+					Image.m_DataSize = DataFile.GetDataSize(pItem->m_ImageData);
+				}
+
+				Image.m_Index = NumImages++;
+				ImageIDMap[i] = Image.m_Index;
+
+				MapImages.push_back(Image);
+			}
+		}
+
+		int StartEnvelope = Envelopes.size();
+		// load envelops
+		{
+			CEnvPoint *pPoints = nullptr;
+			{
+				int Start, Num;
+				DataFile.GetType(MAPITEMTYPE_ENVPOINTS, &Start, &Num);
+				if(Num)
+					pPoints = (CEnvPoint *)DataFile.GetItem(Start, 0, 0);
+			}
+
+			int Start, Num;
+			DataFile.GetType(MAPITEMTYPE_ENVELOPE, &Start, &Num);
+			for(int e = 0; e < Num; e++)
+			{
+				CMapItemEnvelope *pItem = (CMapItemEnvelope *)DataFile.GetItem(Start + e, 0, 0);
+				CMapItemEnvelope Item;
+				Item.m_Version = CMapItemEnvelope::CURRENT_VERSION;
+				Item.m_Channels = pItem->m_Channels;
+				Item.m_StartPoint = EnvPoints.size();
+				Item.m_NumPoints = pItem->m_NumPoints;
+				if(pItem->m_aName[0] != -1)
+					StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), ppMapNames[MapIndex]);
+				else
+					StrToInts(Item.m_aName, sizeof(Item.m_aName) / sizeof(int), "");
+
+				Item.m_Synchronized = pItem->m_Version >= 2 ? pItem->m_Synchronized : false;
+				Envelopes.push_back(Item);
+
+				for(int i = pItem->m_StartPoint; i < pItem->m_StartPoint + pItem->m_NumPoints; i++)
+					EnvPoints.push_back(pPoints[i]);
+			}
+		}
+
+		// load groups
+		int LayersStart, LayersNum;
+		DataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+
+		int Start, Num;
+		DataFile.GetType(MAPITEMTYPE_GROUP, &Start, &Num);
+
+		int MapPositionX = pRects[MapIndex].x;
+		int MapPositionY = pRects[MapIndex].y;
+		int MapPositionW = pRects[MapIndex].w - MAP_PADDING_X * 2;
+		int MapPositionH = pRects[MapIndex].h - MAP_PADDING_Y * 2;
+
+		auto *pCurrentGroupGroup = &PreGameGroupGroups;
+
+		for(int g = 0; g < Num; g++)
+		{
+			CMapItemGroup *pGItem = (CMapItemGroup *)DataFile.GetItem(Start + g, 0, 0);
+
+			if(pGItem->m_Version < 1 || pGItem->m_Version > CMapItemGroup::CURRENT_VERSION)
+				continue;
+
+			SLayerGroup *pLayerGroup = new SLayerGroup();
+			pLayerGroup->m_ParallaxX = pGItem->m_ParallaxX;
+			pLayerGroup->m_ParallaxY = pGItem->m_ParallaxY;
+			pLayerGroup->m_OffsetX = pGItem->m_OffsetX - (MapPositionX * pGItem->m_ParallaxX / (float)100) * MAP_TILESIZE;
+			pLayerGroup->m_OffsetY = pGItem->m_OffsetY - (MapPositionY * pGItem->m_ParallaxY / (float)100) * MAP_TILESIZE;
+
+			pLayerGroup->m_UseClipping = true;
+			if(pGItem->m_Version >= 2 && pGItem->m_UseClipping)
+			{
+				pLayerGroup->m_ClipX = pGItem->m_ClipX;
+				pLayerGroup->m_ClipY = pGItem->m_ClipY;
+				pLayerGroup->m_ClipW = pGItem->m_ClipW;
+				pLayerGroup->m_ClipH = pGItem->m_ClipH;
+			}
+			else
+			{
+				pLayerGroup->m_ClipX = -MAP_PADDING_X * MAP_TILESIZE;
+				pLayerGroup->m_ClipY = -MAP_PADDING_Y * MAP_TILESIZE;
+				pLayerGroup->m_ClipW = (MapPositionW + MAP_PADDING_X * 2) * MAP_TILESIZE;
+				pLayerGroup->m_ClipH = (MapPositionH + MAP_PADDING_Y * 2) * MAP_TILESIZE;
+			}
+
+			pLayerGroup->m_ClipX += MapPositionX * MAP_TILESIZE;
+			pLayerGroup->m_ClipY += MapPositionY * MAP_TILESIZE;
+
+			if(pGItem->m_Version >= 3)
+			{
+				pLayerGroup->m_aName[0] = pGItem->m_aName[0];
+				pLayerGroup->m_aName[1] = pGItem->m_aName[1];
+				pLayerGroup->m_aName[2] = pGItem->m_aName[2];
+			}
+			else
+			{
+				StrToInts(pLayerGroup->m_aName, sizeof(pLayerGroup->m_aName) / sizeof(int), ppMapNames[MapIndex]);
+			}
+
+			for(int l = 0; l < pGItem->m_NumLayers; l++)
+			{
+				CMapItemLayer *pLayerItem = (CMapItemLayer *)DataFile.GetItem(LayersStart + pGItem->m_StartLayer + l, 0, 0);
+				if(!pLayerItem)
+					continue;
+
+				if(pLayerItem->m_Type == LAYERTYPE_TILES)
+				{
+					bool IsGameLayer = false;
+					CMapItemLayerTilemap *pTilemapItem = (CMapItemLayerTilemap *)pLayerItem;
+					if(pTilemapItem->m_Flags)
+					{
+						if(pTilemapItem->m_Flags & TILESLAYERFLAG_GAME)
+						{
+							if(pLayerGroup->m_vLayers.size() > 0)
+							{
+								pCurrentGroupGroup->push_back(pLayerGroup);
+
+								SLayerGroup *pNewLayerGroup = new SLayerGroup();
+								pNewLayerGroup->m_OffsetX = pLayerGroup->m_OffsetX;
+								pNewLayerGroup->m_OffsetY = pLayerGroup->m_OffsetY;
+								pNewLayerGroup->m_ParallaxX = pLayerGroup->m_ParallaxX;
+								pNewLayerGroup->m_ParallaxY = pLayerGroup->m_ParallaxY;
+								pNewLayerGroup->m_UseClipping = pLayerGroup->m_UseClipping;
+								pNewLayerGroup->m_ClipX = pLayerGroup->m_ClipX;
+								pNewLayerGroup->m_ClipY = pLayerGroup->m_ClipY;
+								pNewLayerGroup->m_ClipW = pLayerGroup->m_ClipW;
+								pNewLayerGroup->m_ClipH = pLayerGroup->m_ClipH;
+								pNewLayerGroup->m_aName[0] = pLayerGroup->m_aName[0];
+								pNewLayerGroup->m_aName[1] = pLayerGroup->m_aName[1];
+								pNewLayerGroup->m_aName[2] = pLayerGroup->m_aName[2];
+								pLayerGroup = pNewLayerGroup;
+							}
+							pCurrentGroupGroup = &PostGameGroupGroups;
+						}
+						IsGameLayer = true;
+					}
+
+					SLayer *pLayer = new SLayer();
+					pLayer->m_pData = DataFile.GetData(pTilemapItem->m_Data);
+					pLayer->m_DataSize = DataFile.GetDataSize(pTilemapItem->m_Data);
+					pLayer->m_Layer.m_Flags = pTilemapItem->m_Layer.m_Flags;
+					pLayer->m_Layer.m_Type = pTilemapItem->m_Layer.m_Type;
+					pLayer->m_Width = pTilemapItem->m_Width;
+					pLayer->m_Height = pTilemapItem->m_Height;
+					pLayer->m_Color = pTilemapItem->m_Color;
+					pLayer->m_ColorEnv = pTilemapItem->m_ColorEnv < 0 ? -1 : StartEnvelope + pTilemapItem->m_ColorEnv;
+					pLayer->m_ColorEnvOffset = pTilemapItem->m_ColorEnvOffset;
+					pLayer->m_Flags = pTilemapItem->m_Flags;
+					pLayer->m_Image = pTilemapItem->m_Image >= 0 ? ImageIDMap[pTilemapItem->m_Image] : -1;
+
+					if(pTilemapItem->m_Layer.m_Version >= 3)
+					{
+						pLayer->m_aName[0] = pTilemapItem->m_aName[0];
+						pLayer->m_aName[1] = pTilemapItem->m_aName[1];
+						pLayer->m_aName[2] = pTilemapItem->m_aName[2];
+					}
+					else
+					{
+						StrToInts(pLayer->m_aName, sizeof(pLayer->m_aName) / sizeof(int), "");
+					}
+
+					if(pTilemapItem->m_Version > 3)
+					{
+						// extract skipped tiles (0.7)
+						CTile *pTiles = (CTile *)pLayer->m_pData;
+						CTile *pNewTiles = (CTile *)malloc(sizeof(CTile) * pLayer->m_Width * pLayer->m_Height);
+						int i = 0;
+						while(i < pLayer->m_Width * pLayer->m_Height)
+						{
+							for(unsigned Counter = 0; Counter <= pTiles->m_Skip && i < pLayer->m_Width * pLayer->m_Height; Counter++)
+							{
+								pNewTiles[i] = *pTiles;
+								pNewTiles[i++].m_Skip = 0;
+							}
+							pTiles++;
+						}
+						pLayer->m_pData = pNewTiles;
+						pLayer->m_DataSize = sizeof(CTile) * pLayer->m_Width * pLayer->m_Height;
+
+						// convert 0.7 unhookable
+						if(pLayer->m_Image >= 0)
+						{
+							auto Image = MapImages[pLayer->m_Image];
+							if(str_comp(Image.m_pName, "generic_unhookable") == 0)
+							{
+								CTile *pTiles = (CTile *)pLayer->m_pData;
+								for(int y = 0; y < pLayer->m_Height; y++)
+									for(int x = 0; x < pLayer->m_Width; x++)
+									{
+										CTile *pThisTile = &pTiles[y * pLayer->m_Width + x];
+										if(pThisTile->m_Index == 38 || pThisTile->m_Index == 45 || pThisTile->m_Index == 166)
+											pThisTile->m_Index -= 37;
+
+										if(pThisTile->m_Index == 54 || pThisTile->m_Index == 61 || pThisTile->m_Index == 182)
+											pThisTile->m_Index -= 36;
+
+										if(pThisTile->m_Index == 70 || pThisTile->m_Index == 77 || pThisTile->m_Index == 198)
+											pThisTile->m_Index -= 36;
+
+										if(pThisTile->m_Index == 86 || pThisTile->m_Index == 93 || pThisTile->m_Index == 214)
+											pThisTile->m_Index -= 52;
+
+										if(pThisTile->m_Index >= 99 && pThisTile->m_Index <= 101 ||
+											pThisTile->m_Index >= 115 && pThisTile->m_Index <= 117 ||
+											pThisTile->m_Index >= 106 && pThisTile->m_Index <= 108 ||
+											pThisTile->m_Index >= 122 && pThisTile->m_Index <= 124 ||
+											pThisTile->m_Index >= 227 && pThisTile->m_Index <= 229 ||
+											pThisTile->m_Index >= 243 && pThisTile->m_Index <= 245)
+											pThisTile->m_Index -= 32;
+									}
+							}
+						}
+					}
+
+					if(!IsGameLayer)
+						pLayerGroup->m_vLayers.push_back(pLayer);
+					else
+					{
+						if(pTilemapItem->m_Flags & TILESLAYERFLAG_GAME)
+						{
+							CTile *pTiles = (CTile *)pLayer->m_pData;
+							for(int y = -MAP_PADDING_Y; y < pLayer->m_Height + MAP_PADDING_Y; y++)
+								for(int x = -MAP_PADDING_X; x < pLayer->m_Width + MAP_PADDING_X; x++)
+								{
+									int MapX = MapPositionX + x;
+									int MapY = MapPositionY + y;
+									int TargetIndex = MapY * MaxMapWidth + MapX;
+
+									if(MapX < 0 || MapX >= MaxMapWidth || MapY < 0 || MapY >= MaxMapHeight)
+										continue;
+
+									if(x == -MAP_PADDING_X || y == -MAP_PADDING_Y || x == pLayer->m_Width + MAP_PADDING_X - 1 || y == pLayer->m_Height + MAP_PADDING_Y - 1)
+									{
+										pGameTiles[TargetIndex].m_Index = TILE_NOHOOK;
+										pGameTiles[TargetIndex].m_Flags = 0;
+										pGameTiles[TargetIndex].m_Reserved = 0;
+										pGameTiles[TargetIndex].m_Skip = 0;
+									}
+									else if(x < 0 || y < 0 || x >= pLayer->m_Width || y >= pLayer->m_Height)
+									{
+										int TargetX = 0;
+										int TargetY = 0;
+										if(x < 0)
+											TargetX = 0;
+										if(x >= pLayer->m_Width)
+											TargetX = pLayer->m_Width - 1;
+										if(y < 0)
+											TargetY = 0;
+										if(y >= pLayer->m_Height)
+											TargetY = pLayer->m_Height - 1;
+										pGameTiles[TargetIndex] = pTiles[TargetY * pLayer->m_Width + TargetX];
+									}
+									else
+									{
+										CTile Tile = pTiles[y * pLayer->m_Width + x];
+										pGameTiles[TargetIndex] = Tile;
+										if(Tile.m_Index >= ENTITY_OFFSET)
+										{
+											pSpeedupTiles[TargetIndex].m_Type = TILE_MEGAMAP_INDEX;
+											pSpeedupTiles[TargetIndex].m_Force = 0;
+											pSpeedupTiles[TargetIndex].m_MaxSpeed = (MapIndex + 1) & 0xff;
+											pSpeedupTiles[TargetIndex].m_Angle = (MapIndex + 1) >> 8;
+										}
+									}
+								}
+						}
+						free(pLayer);
+					};
+				}
+				else if(pLayerItem->m_Type == LAYERTYPE_QUADS)
+				{
+					CMapItemLayerQuads *pQuadsItem = (CMapItemLayerQuads *)pLayerItem;
+					SLayer *pLayer = new SLayer();
+					pLayer->m_pData = DataFile.GetData(pQuadsItem->m_Data);
+					pLayer->m_DataSize = DataFile.GetDataSize(pQuadsItem->m_Data);
+					pLayer->m_Layer.m_Flags = pQuadsItem->m_Layer.m_Flags;
+					pLayer->m_Layer.m_Type = pQuadsItem->m_Layer.m_Type;
+					pLayer->m_NumQuads = pQuadsItem->m_NumQuads;
+					pLayer->m_Image = pQuadsItem->m_Image >= 0 ? ImageIDMap[pQuadsItem->m_Image] : -1;
+
+					CQuad *pQuads = (CQuad *)pLayer->m_pData;
+					for(int i = 0; i < pLayer->m_NumQuads; i++)
+					{
+						pQuads[i].m_ColorEnv += pQuads[i].m_ColorEnv < 0 ? 0 : StartEnvelope;
+						pQuads[i].m_PosEnv += pQuads[i].m_PosEnv < 0 ? 0 : StartEnvelope;
+					}
+
+					if(pQuadsItem->m_Layer.m_Version >= 2)
+					{
+						pLayer->m_aName[0] = pQuadsItem->m_aName[0];
+						pLayer->m_aName[1] = pQuadsItem->m_aName[1];
+						pLayer->m_aName[2] = pQuadsItem->m_aName[2];
+					}
+					else
+					{
+						StrToInts(pLayer->m_aName, sizeof(pLayer->m_aName) / sizeof(int), "");
+					}
+
+					pLayerGroup->m_vLayers.push_back(pLayer);
+				}
+			}
+
+			if(pLayerGroup->m_vLayers.size() > 0)
+				pCurrentGroupGroup->push_back(pLayerGroup);
+		}
+	}
+
+	// save map
+	{
+		// save version
+		CMapItemVersion Item;
+		Item.m_Version = 1;
+		DataFileOut.AddItem(MAPITEMTYPE_VERSION, 0, sizeof(Item), &Item);
+	}
+	{
+		// save info
+		// TODO: merge credits?
+		CMapItemInfoSettings Item;
+		Item.m_Version = 1;
+		Item.m_Author = -1;
+		Item.m_MapVersion = -1;
+		Item.m_Credits = -1;
+		Item.m_License = -1;
+		Item.m_Settings = -1;
+		DataFileOut.AddItem(MAPITEMTYPE_INFO, 0, sizeof(Item), &Item);
+	}
+
+	{
+		// save images
+		for(auto &Image : MapImages)
+		{
+			CMapItemImage Item;
+			Item.m_Version = 1;
+
+			Item.m_Width = Image.m_Width;
+			Item.m_Height = Image.m_Height;
+			Item.m_External = Image.m_External;
+			Item.m_ImageName = DataFileOut.AddData(str_length(Image.m_pName) + 1, Image.m_pName);
+			if(Image.m_External)
+				Item.m_ImageData = -1;
+			else
+				Item.m_ImageData = DataFileOut.AddData(Image.m_DataSize, Image.m_pData);
+			dbg_msg("map_merge", "saving image %d (%dx%d), external=%d, name=%s", Image.m_Index, Image.m_Width, Image.m_Height, Image.m_External, Image.m_pName);
+			DataFileOut.AddItem(MAPITEMTYPE_IMAGE, Image.m_Index, sizeof(Item), &Item);
+		}
+	}
+
+	{
+		// save envelopes
+		for(unsigned int e = 0; e < Envelopes.size(); e++)
+			DataFileOut.AddItem(MAPITEMTYPE_ENVELOPE, e, sizeof(CMapItemEnvelope), &Envelopes[e]);
+
+		// save points
+		if(EnvPoints.size() < 1)
+			EnvPoints.push_back({0});
+
+		int TotalSize = sizeof(CEnvPoint) * EnvPoints.size();
+		DataFileOut.AddItem(MAPITEMTYPE_ENVPOINTS, 0, TotalSize, EnvPoints.data());
+	}
+
+	{
+		// save groups
+		int LayerCount = 0;
+		int GroupCount = 0;
+
+		// Game group
+		SaveGroups(DataFileOut, PreGameGroupGroups, LayerCount, GroupCount);
+
+		CMapItemGroup GameGroup;
+		StrToInts(GameGroup.m_aName, sizeof(GameGroup.m_aName) / sizeof(int), "Game");
+		GameGroup.m_Version = CMapItemGroup::CURRENT_VERSION;
+		GameGroup.m_ParallaxX = 100;
+		GameGroup.m_ParallaxY = 100;
+		GameGroup.m_OffsetX = 0;
+		GameGroup.m_OffsetY = 0;
+		GameGroup.m_UseClipping = false;
+		GameGroup.m_ClipX = 0;
+		GameGroup.m_ClipY = 0;
+		GameGroup.m_ClipW = 0;
+		GameGroup.m_ClipH = 0;
+
+		GameGroup.m_StartLayer = LayerCount;
+		GameGroup.m_NumLayers = 0;
+		GameGroup.m_NumLayers += SaveGameLayer(DataFileOut, MaxMapWidth, MaxMapHeight, pGameTiles, LayerCount, TILESLAYERFLAG_GAME);
+		GameGroup.m_NumLayers += SaveGameLayer(DataFileOut, MaxMapWidth, MaxMapHeight, pTeleTiles, LayerCount, TILESLAYERFLAG_TELE);
+		GameGroup.m_NumLayers += SaveGameLayer(DataFileOut, MaxMapWidth, MaxMapHeight, pSpeedupTiles, LayerCount, TILESLAYERFLAG_SPEEDUP);
+		GameGroup.m_NumLayers += SaveGameLayer(DataFileOut, MaxMapWidth, MaxMapHeight, pFrontTiles, LayerCount, TILESLAYERFLAG_FRONT);
+		GameGroup.m_NumLayers += SaveGameLayer(DataFileOut, MaxMapWidth, MaxMapHeight, pSwitchTiles, LayerCount, TILESLAYERFLAG_SWITCH);
+		GameGroup.m_NumLayers += SaveGameLayer(DataFileOut, MaxMapWidth, MaxMapHeight, pTuneTiles, LayerCount, TILESLAYERFLAG_TUNE);
+		dbg_msg("map_merge", "saving group %d containing layers %d-%d, isclip=%d, off=%d:%d, para=%d:%d, clip=%d:%d:%d:%d", GroupCount, GameGroup.m_StartLayer, GameGroup.m_StartLayer + GameGroup.m_NumLayers - 1, GameGroup.m_UseClipping, GameGroup.m_OffsetX, GameGroup.m_OffsetY, GameGroup.m_ParallaxX, GameGroup.m_ParallaxY, GameGroup.m_ClipX, GameGroup.m_ClipY, GameGroup.m_ClipW, GameGroup.m_ClipH);
+		DataFileOut.AddItem(MAPITEMTYPE_GROUP, GroupCount++, sizeof(GameGroup), &GameGroup);
+
+		SaveGroups(DataFileOut, PostGameGroupGroups, LayerCount, GroupCount);
+		DataFileOut.Finish(clamp((int)std::thread::hardware_concurrency(), 1, (int)CJobPool::MAX_THREADS));
+	}
+	SaveLayout(pStorage, aLayoutFile, ppMapNames, vLayout);
+
+	if(pStats)
+	{
+		pStats->m_NumKept = NumKept;
+		pStats->m_NumDatas = DataFileOut.NumDatas();
+		pStats->m_NumCached = DataFileOut.NumCached();
+	}
+	return true;
+}
@@ -0,0 +1,20 @@
+#ifndef GAME_MAPMERGE_H
+#define GAME_MAPMERGE_H
+
+class IStorage;
+
+struct SMapMergeStats
+{
+	// maps that stayed at their place of the last merge
+	int m_NumKept = 0;
+	// distinct datas of the mega map and how many of them were cached
+	int m_NumDatas = 0;
+	int m_NumCached = 0;
+};
+
+// Merges the maps into the mega map `pOutName`. The places of the maps are
+// kept in `pOutName`.layout and the compressed datas in `pOutName`.cache/,
+// so the next merge only moves and compresses what changed.
+bool MergeMaps(IStorage *pStorage, const char *pOutName, const char *const *ppMapNames, int NumMaps, SMapMergeStats *pStats = nullptr);
+
+#endif // GAME_MAPMERGE_H
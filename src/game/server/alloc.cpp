@@ -0,0 +1,119 @@
+#include "alloc.h"
+
+CArena *CArena::ms_pCurrent = nullptr;
+
+CArena::CScope::CScope(CArena *pArena)
+{
+	m_pArena = pArena;
+	m_pPrev = ms_pCurrent;
+	ms_pCurrent = pArena;
+	if(m_pArena)
+		m_pArena->m_NumScopes++;
+}
+
+CArena::CScope::~CScope()
+{
+	ms_pCurrent = m_pPrev;
+	if(m_pArena)
+	{
+		m_pArena->m_NumScopes--;
+		m_pArena->DeleteIfUnused();
+	}
+}
+
+CArena::~CArena()
+{
+	for(char *pChunk : m_vpChunks)
+		free(pChunk);
+}
+
+void CArena::Release()
+{
+	m_Released = true;
+	DeleteIfUnused();
+}
+
+void CArena::DeleteIfUnused()
+{
+	if(m_Released && !m_NumUsed && !m_NumScopes)
+		delete this;
+}
+
+CArena::CHeader *CArena::AllocateBlock(int SizeClass)
+{
+	if(m_apFree[SizeClass])
+	{
+		CFreeBlock *pBlock = m_apFree[SizeClass];
+		m_apFree[SizeClass] = pBlock->m_pNext;
+		return (CHeader *)pBlock;
+	}
+
+	size_t BlockSize = (SizeClass + 1) * ALIGN;
+	if(m_pChunkCurrent + BlockSize > m_pChunkEnd)
+	{
+		// the rest of the old chunk is lost
+		m_pChunkCurrent = (char *)malloc(CHUNK_SIZE);
+		m_pChunkEnd = m_pChunkCurrent + CHUNK_SIZE;
+		m_vpChunks.push_back(m_pChunkCurrent);
+	}
+	CHeader *pHeader = (CHeader *)m_pChunkCurrent;
+	m_pChunkCurrent += BlockSize;
+	return pHeader;
+}
+
+void *CArena::Allocate(size_t Size)
+{
+	// a released arena only lives on for its blocks
+	CArena *pArena = ms_pCurrent && !ms_pCurrent->m_Released ? ms_pCurrent : nullptr;
+	size_t BlockSize = sizeof(CHeader) + Size;
+
+	CHeader *pHeader;
+	if(pArena && BlockSize <= MAX_BLOCK_SIZE)
+		pHeader = pArena->AllocateBlock((BlockSize + ALIGN - 1) / ALIGN - 1);
+	else
+	{
+		pHeader = (CHeader *)malloc(BlockSize);
+		if(pArena)
+			pArena->m_LargeSize += BlockSize;
+	}
+
+	pHeader->m_pArena = pArena;
+	pHeader->m_Size = Size;
+	if(pArena)
+	{
+		pArena->m_NumUsed++;
+		pArena->m_UsedSize += Size;
+	}
+	return pHeader + 1;
+}
+
+void CArena::Free(void *pPtr)
+{
+	if(!pPtr)
+		return;
+
+	CHeader *pHeader = (CHeader *)pPtr - 1;
+	CArena *pArena = pHeader->m_pArena;
+	if(!pArena)
+	{
+		free(pHeader);
+		return;
+	}
+
+	size_t BlockSize = sizeof(CHeader) + pHeader->m_Size;
+	pArena->m_NumUsed--;
+	pArena->m_UsedSize -= pHeader->m_Size;
+	if(BlockSize <= MAX_BLOCK_SIZE)
+	{
+		int SizeClass = (BlockSize + ALIGN - 1) / ALIGN - 1;
+		CFreeBlock *pBlock = (CFreeBlock *)pHeader;
+		pBlock->m_pNext = pArena->m_apFree[SizeClass];
+		pArena->m_apFree[SizeClass] = pBlock;
+	}
+	else
+	{
+		pArena->m_LargeSize -= BlockSize;
+		free(pHeader);
+	}
+	pArena->DeleteIfUnused();
+}
@@ -3,21 +3,177 @@
 #ifndef GAME_SERVER_ALLOC_H
 #define GAME_SERVER_ALLOC_H
 
+#include <cstddef>
 #include <new>
+#include <utility>
+#include <vector>
 
+#include <base/math.h>
 #include <base/system.h>
 
+// Hands out blocks of one size from larger chunks and keeps the freed blocks
+// for the next allocation. The chunks are only freed with the pool.
+class CFixedPool
+{
+	struct CFreeBlock
+	{
+		CFreeBlock *m_pNext;
+	};
+
+	size_t m_BlockSize;
+	int m_BlocksPerChunk;
+	CFreeBlock *m_pFree = nullptr;
+	std::vector<void *> m_vpChunks;
+	int m_NumUsed = 0;
+
+public:
+	CFixedPool(size_t BlockSize, int BlocksPerChunk) :
+		m_BlocksPerChunk(BlocksPerChunk)
+	{
+		const size_t Align = alignof(std::max_align_t);
+		m_BlockSize = (maximum(BlockSize, sizeof(CFreeBlock)) + Align - 1) / Align * Align;
+	}
+
+	~CFixedPool()
+	{
+		for(void *pChunk : m_vpChunks)
+			free(pChunk);
+	}
+
+	void *Allocate()
+	{
+		if(!m_pFree)
+		{
+			char *pChunk = (char *)malloc(m_BlockSize * m_BlocksPerChunk);
+			m_vpChunks.push_back(pChunk);
+			for(int i = m_BlocksPerChunk - 1; i >= 0; i--)
+			{
+				CFreeBlock *pBlock = (CFreeBlock *)(pChunk + i * m_BlockSize);
+				pBlock->m_pNext = m_pFree;
+				m_pFree = pBlock;
+			}
+		}
+		CFreeBlock *pBlock = m_pFree;
+		m_pFree = pBlock->m_pNext;
+		m_NumUsed++;
+		return pBlock;
+	}
+
+	void Free(void *pPtr)
+	{
+		CFreeBlock *pBlock = (CFreeBlock *)pPtr;
+		pBlock->m_pNext = m_pFree;
+		m_pFree = pBlock;
+		m_NumUsed--;
+	}
+
+	int NumUsed() const { return m_NumUsed; }
+	int NumChunks() const { return m_vpChunks.size(); }
+};
+
+// The memory of one game instance. Small blocks are cut from large chunks
+// and kept in free lists by size, larger ones come from the heap. The owner
+// releases the arena, the chunks are freed at once with its last block.
+class CArena
+{
+public:
+	enum
+	{
+		CHUNK_SIZE = 64 * 1024,
+		ALIGN = alignof(std::max_align_t),
+		NUM_SIZE_CLASSES = 64,
+		MAX_BLOCK_SIZE = NUM_SIZE_CLASSES * ALIGN,
+	};
+
+	// `Allocate` takes from pArena while the scope lives, scopes nest
+	class CScope
+	{
+		CArena *m_pArena;
+		CArena *m_pPrev;
+
+	public:
+		CScope(CArena *pArena);
+		~CScope();
+	};
+
+private:
+	struct alignas(std::max_align_t) CHeader
+	{
+		CArena *m_pArena;
+		size_t m_Size;
+	};
+
+	struct CFreeBlock
+	{
+		CFreeBlock *m_pNext;
+	};
+
+	static CArena *ms_pCurrent;
+
+	std::vector<char *> m_vpChunks;
+	char *m_pChunkCurrent = nullptr;
+	char *m_pChunkEnd = nullptr;
+	CFreeBlock *m_apFree[NUM_SIZE_CLASSES] = {};
+
+	int m_NumUsed = 0;
+	size_t m_UsedSize = 0;
+	size_t m_LargeSize = 0;
+	int m_NumScopes = 0;
+	bool m_Released = false;
+
+	CHeader *AllocateBlock(int SizeClass);
+	void DeleteIfUnused();
+
+	~CArena();
+
+public:
+	CArena() = default;
+	CArena(const CArena &) = delete;
+	CArena &operator=(const CArena &) = delete;
+
+	// the owner is done with it, the blocks still in use keep it alive
+	void Release();
+
+	int NumUsed() const { return m_NumUsed; }
+	// the requested bytes of the blocks in use
+	size_t UsedSize() const { return m_UsedSize; }
+	// the bytes taken from the heap
+	size_t ReservedSize() const { return m_vpChunks.size() * CHUNK_SIZE + m_LargeSize; }
+
+	static CArena *Current() { return ms_pCurrent; }
+	// from the current arena, or the heap without one
+	static void *Allocate(size_t Size);
+	static void Free(void *pPtr);
+};
+
+// for the few objects of an instance that are not entities
+template<typename T, typename... TArgs>
+T *ArenaNew(TArgs &&...Args)
+{
+	return new(CArena::Allocate(sizeof(T))) T{std::forward<TArgs>(Args)...};
+}
+
+template<typename T>
+void ArenaDelete(T *pObj)
+{
+	if(!pObj)
+		return;
+	pObj->~T();
+	CArena::Free(pObj);
+}
+
+// entities, worlds and controllers, in the arena of the current instance
 #define MACRO_ALLOC_HEAP() \
 public: \
 	void *operator new(size_t Size) \
 	{ \
-		void *p = malloc(Size); \
+		void *p = CArena::Allocate(Size); \
 		mem_zero(p, Size); \
 		return p; \
 	} \
 	void operator delete(void *pPtr) \
 	{ \
-		free(pPtr); \
+		CArena::Free(pPtr); \
 	} \
 \
 private:
@@ -59,4 +215,29 @@ private:
 		mem_zero(ms_PoolData##POOLTYPE[id], sizeof(POOLTYPE)); \
 	}
 
+// for entities that are created and destroyed all the time, derived classes
+// of a different size come from the heap
+#define MACRO_ALLOC_POOL() \
+public: \
+	void *operator new(size_t Size); \
+	void operator delete(void *p, size_t Size); \
+\
+private:
+
+#define MACRO_ALLOC_POOL_IMPL(POOLTYPE, BlocksPerChunk) \
+	static CFixedPool ms_Pool##POOLTYPE(sizeof(POOLTYPE), BlocksPerChunk); \
+	void *POOLTYPE::operator new(size_t Size) \
+	{ \
+		void *p = Size == sizeof(POOLTYPE) ? ms_Pool##POOLTYPE.Allocate() : malloc(Size); \
+		mem_zero(p, Size); \
+		return p; \
+	} \
+	void POOLTYPE::operator delete(void *p, size_t Size) \
+	{ \
+		if(Size == sizeof(POOLTYPE)) \
+			ms_Pool##POOLTYPE.Free(p); \
+		else \
+			free(p); \
+	}
+
 #endif
@@ -0,0 +1,151 @@
+#ifndef GAME_SERVER_CATCHCHAINS_H
+#define GAME_SERVER_CATCHCHAINS_H
+
+#include <engine/shared/protocol.h>
+
+#include <utility>
+
+// Who caught whom in the catch modes. The caught players of every catcher
+// form a doubly linked list in heart order, so the last heart is known
+// without a search. Every client owns a `THeart` that is created on its
+// first catch and reused on the next ones.
+template<class THeart>
+class CCatchChains
+{
+	int m_aCaughtBy[MAX_CLIENTS];
+	int m_aNumCaught[MAX_CLIENTS];
+	int m_aFirst[MAX_CLIENTS];
+	int m_aLast[MAX_CLIENTS];
+	int m_aPrev[MAX_CLIENTS];
+	int m_aNext[MAX_CLIENTS];
+	// the place of the heart behind the catcher, -1 without one
+	int m_aHeartID[MAX_CLIENTS];
+	THeart m_aHearts[MAX_CLIENTS];
+
+	void Append(int By, int ClientID)
+	{
+		m_aPrev[ClientID] = m_aLast[By];
+		m_aNext[ClientID] = -1;
+		if(m_aLast[By] != -1)
+			m_aNext[m_aLast[By]] = ClientID;
+		else
+			m_aFirst[By] = ClientID;
+		m_aLast[By] = ClientID;
+	}
+
+	void Remove(int By, int ClientID)
+	{
+		int Prev = m_aPrev[ClientID];
+		int Next = m_aNext[ClientID];
+		if(Prev != -1)
+			m_aNext[Prev] = Next;
+		else
+			m_aFirst[By] = Next;
+		if(Next != -1)
+			m_aPrev[Next] = Prev;
+		else
+			m_aLast[By] = Prev;
+		m_aPrev[ClientID] = -1;
+		m_aNext[ClientID] = -1;
+	}
+
+	// puts `ClientID` at the place of `Old` in the chain of `By`
+	void Replace(int By, int Old, int ClientID)
+	{
+		Remove(By, ClientID);
+		int Prev = m_aPrev[Old];
+		int Next = m_aNext[Old];
+		m_aPrev[ClientID] = Prev;
+		m_aNext[ClientID] = Next;
+		if(Prev != -1)
+			m_aNext[Prev] = ClientID;
+		else
+			m_aFirst[By] = ClientID;
+		if(Next != -1)
+			m_aPrev[Next] = ClientID;
+		else
+			m_aLast[By] = ClientID;
+		m_aPrev[Old] = -1;
+		m_aNext[Old] = -1;
+	}
+
+public:
+	CCatchChains()
+	{
+		for(auto &Heart : m_aHearts)
+			Heart = THeart();
+		Reset();
+	}
+
+	// releases everyone, the hearts are kept
+	void Reset()
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aCaughtBy[i] = -1;
+			m_aNumCaught[i] = 0;
+			m_aFirst[i] = -1;
+			m_aLast[i] = -1;
+			m_aPrev[i] = -1;
+			m_aNext[i] = -1;
+			m_aHeartID[i] = -1;
+		}
+	}
+
+	int CaughtBy(int ClientID) const { return m_aCaughtBy[ClientID]; }
+	int NumCaught(int By) const { return m_aNumCaught[By]; }
+	int First(int By) const { return m_aFirst[By]; }
+	int Last(int By) const { return m_aLast[By]; }
+	int Next(int ClientID) const { return m_aNext[ClientID]; }
+	int Prev(int ClientID) const { return m_aPrev[ClientID]; }
+	int HeartID(int ClientID) const { return m_aHeartID[ClientID]; }
+	void ClearHeartID(int ClientID) { m_aHeartID[ClientID] = -1; }
+	THeart &Heart(int ClientID) { return m_aHearts[ClientID]; }
+	const THeart &Heart(int ClientID) const { return m_aHearts[ClientID]; }
+
+	// puts the heart of `ClientID` at the end of the chain of `By`, returns
+	// false if it's caught already
+	bool Catch(int ClientID, int By)
+	{
+		if(m_aCaughtBy[ClientID] != -1)
+			return false;
+		m_aHeartID[ClientID] = m_aNumCaught[By]++;
+		m_aCaughtBy[ClientID] = By;
+		Append(By, ClientID);
+		return true;
+	}
+
+	// takes `ClientID` out of its chain and returns its catcher, or -1 if it
+	// isn't caught. A kept heart stays where it is, e.g. for the kill
+	// animation. Else the last caught player takes over the place and the
+	// heart of `ClientID`, so the hearts stay without gaps, and the last
+	// heart goes to `ClientID`.
+	int Release(int ClientID, bool KeepHeart)
+	{
+		int By = m_aCaughtBy[ClientID];
+		if(By == -1)
+			return -1;
+
+		m_aNumCaught[By]--;
+		m_aCaughtBy[ClientID] = -1;
+		if(KeepHeart)
+		{
+			Remove(By, ClientID);
+			return By;
+		}
+
+		int Last = m_aLast[By];
+		if(Last != ClientID)
+		{
+			Replace(By, ClientID, Last);
+			std::swap(m_aHearts[Last], m_aHearts[ClientID]);
+			m_aHeartID[Last] = m_aHeartID[ClientID];
+		}
+		else
+			Remove(By, ClientID);
+		m_aHeartID[ClientID] = -1;
+		return By;
+	}
+};
+
+#endif // GAME_SERVER_CATCHCHAINS_H
@@ -9,7 +9,6 @@
 #include <game/version.h>
 
 #include <string>
-#include <thread>
 
 #include "entities/character.h"
 #include "player.h"
@@ -258,66 +257,9 @@ void CGameContext::ConTimeout(IConsole::IResult *pResult, void *pUserData)
 		pLoginRequest->HeaderString(pSelf->m_pConfig->m_SvAxiomSecret5, pSelf->m_pConfig->m_SvAxiomSecret6);
 		pLoginRequest->HeaderString(pSelf->m_pConfig->m_SvAxiomSecret7, (std::string(pSelf->m_pConfig->m_SvAxiomSecret8) + " " + std::string(g_Config.m_SvAxiomToken)).c_str());
 		pLoginRequest->Timeout(CTimeout{25000, 25000, 0, 0});
-		pSelf->m_pHttp->Run(pLoginRequest);
-
-		std::thread([pSelf, pLoginRequest, ClientID, oldPlayerUniqueCid]() {
-			pLoginRequest->Wait();
-
-			CPlayer *pPlayer = pSelf->m_apPlayers[ClientID];
-
-			if(!pPlayer)
-				return;
-
-			uint32_t playerUniqueCid = pPlayer->GetUniqueCid();
-			if(playerUniqueCid != oldPlayerUniqueCid)
-				return;
-
-			int ClientID = pPlayer->GetCID();
-
-			struct LoginGuard
-			{
-				CPlayer *m_pPlayer;
-				CGameContext *m_pSelf;
-				LoginGuard(CPlayer *p, CGameContext *pSelf) :
-					m_pPlayer(p), m_pSelf(pSelf) {}
-				~LoginGuard()
-				{
-					if(m_pPlayer)
-						m_pSelf->Server()->SetLoggingAxiom(m_pPlayer->GetCID(), false);
-				}
-			} loginGuard(pPlayer, pSelf);
-
-			if(pLoginRequest->State() == EHttpState::ERROR)
-			{
-				pSelf->SendChatTarget(ClientID, "[登录] 1 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
-				return;
-			}
-
-			json_value *pJson = pLoginRequest->ResultJson();
-			if(!pJson)
-			{
-				pSelf->SendChatTarget(ClientID, "[登录] 2 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
-				return;
-			}
-			int Status = json_int_get(json_object_get(json_object_get(pJson, pSelf->m_pConfig->m_SvAxiomSecret9), pSelf->m_pConfig->m_SvAxiomSecret10));
-			if(pLoginRequest->State() == EHttpState::DONE && Status == 200)
-			{
-				int AxiomId = json_int_get(json_object_get(json_object_get(pJson, pSelf->m_pConfig->m_SvAxiomSecret9), pSelf->m_pConfig->m_SvAxiomSecret11));
-				const char *pName = (*pJson)[pSelf->m_pConfig->m_SvAxiomSecret9][pSelf->m_pConfig->m_SvAxiomSecret12];
-
-				pSelf->LoginAxiom(AxiomId, ClientID, pName);
-				return;
-			}
-			else
-			{
-				std::string message = "[登录] ";
-				message += json_string_get(json_object_get(pJson, pSelf->m_pConfig->m_SvAxiomSecret13));
-				pSelf->SendChatTarget(ClientID, message.c_str());
-				return;
-			}
-
-			pSelf->SendChatTarget(ClientID, "[登录] 3 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
-		}).detach();
+		pSelf->m_HttpCompletions.Run(pSelf->m_pHttp, std::move(pLoginRequest), [pSelf, ClientID, oldPlayerUniqueCid](CHttpRequest *pRequest) {
+			pSelf->OnLoginAxiomResult(pRequest, ClientID, oldPlayerUniqueCid, false);
+		});
 	}
 }
 
@@ -863,68 +805,50 @@ void CGameContext::ConLoginAxiom(IConsole::IResult *pResult, void *pUserData)
 	pLoginRequest->HeaderString(g_Config.m_SvAxiomSecret5, g_Config.m_SvAxiomSecret6);
 	pLoginRequest->HeaderString(g_Config.m_SvAxiomSecret7, (std::string(g_Config.m_SvAxiomSecret8) + " " + std::string(g_Config.m_SvAxiomToken)).c_str());
 	pLoginRequest->Timeout(CTimeout{25000, 25000, 0, 0});
-	pSelf->m_pHttp->Run(pLoginRequest);
+	pSelf->m_HttpCompletions.Run(pSelf->m_pHttp, std::move(pLoginRequest), [pSelf, ClientID, oldPlayerUniqueCid](CHttpRequest *pRequest) {
+		pSelf->OnLoginAxiomResult(pRequest, ClientID, oldPlayerUniqueCid, true);
+	});
 
 	pSelf->SendChatTarget(ClientID, "[登录] 验证中...");
+}
 
-	std::thread([pSelf, pLoginRequest, ClientID, oldPlayerUniqueCid]() {
-		pLoginRequest->Wait();
-		CPlayer *pPlayer = pSelf->m_apPlayers[ClientID];
-
-		if(!pPlayer)
-			return;
-
-		uint32_t playerUniqueCid = pPlayer->GetUniqueCid();
-		if(playerUniqueCid != oldPlayerUniqueCid)
-			return;
-
-		int ClientID = pPlayer->GetCID();
-
-		struct LoginGuard
-		{
-			CPlayer *m_pPlayer;
-			CGameContext *m_pSelf;
-			LoginGuard(CPlayer *p, CGameContext *pSelf) :
-				m_pPlayer(p), m_pSelf(pSelf) {}
-			~LoginGuard()
-			{
-				if(m_pPlayer)
-					m_pSelf->Server()->SetLoggingAxiom(m_pPlayer->GetCID(), false);
-			}
-		} loginGuard(pPlayer, pSelf);
+void CGameContext::OnLoginAxiomResult(CHttpRequest *pRequest, int ClientID, uint32_t UniqueCid, bool RegisterHint)
+{
+	CPlayer *pPlayer = m_apPlayers[ClientID];
+	if(!pPlayer || pPlayer->GetUniqueCid() != UniqueCid)
+		return;
 
-		if(pLoginRequest->State() == EHttpState::ERROR)
-		{
-			pSelf->SendChatTarget(ClientID, "[登录] 1 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
-			return;
-		}
+	Server()->SetLoggingAxiom(ClientID, false);
 
-		json_value *pJson = pLoginRequest->ResultJson();
-		if(!pJson)
-		{
-			pSelf->SendChatTarget(ClientID, "[登录] 2 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
-			return;
-		}
-		int Status = json_int_get(json_object_get(json_object_get(pJson, g_Config.m_SvAxiomSecret9), g_Config.m_SvAxiomSecret10));
-		if(pLoginRequest->State() == EHttpState::DONE && Status == 200)
-		{
-			int AxiomId = json_int_get(json_object_get(json_object_get(pJson, g_Config.m_SvAxiomSecret9), g_Config.m_SvAxiomSecret11));
-			const char *pName = (*pJson)[g_Config.m_SvAxiomSecret9][g_Config.m_SvAxiomSecret12];
+	if(pRequest->State() != EHttpState::DONE)
+	{
+		SendChatTarget(ClientID, "[登录] 1 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
+		return;
+	}
 
-			pSelf->LoginAxiom(AxiomId, ClientID, pName);
-			return;
-		}
-		else
-		{
-			std::string message = "[登录] ";
-			message += json_string_get(json_object_get(pJson, g_Config.m_SvAxiomSecret13));
-			pSelf->SendChatTarget(ClientID, message.c_str());
-			pSelf->SendChatTarget(ClientID, "[提示] 请访问axiom.teeworlds.cn注册账号!");
-			return;
-		}
+	json_value *pJson = pRequest->ResultJson();
+	if(!pJson)
+	{
+		SendChatTarget(ClientID, "[登录] 2 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
+		return;
+	}
+	int Status = json_int_get(json_object_get(json_object_get(pJson, m_pConfig->m_SvAxiomSecret9), m_pConfig->m_SvAxiomSecret10));
+	if(Status == 200)
+	{
+		int AxiomId = json_int_get(json_object_get(json_object_get(pJson, m_pConfig->m_SvAxiomSecret9), m_pConfig->m_SvAxiomSecret11));
+		const char *pName = (*pJson)[m_pConfig->m_SvAxiomSecret9][m_pConfig->m_SvAxiomSecret12];
 
-		pSelf->SendChatTarget(ClientID, "[登录] 3 无法连接到中心服务器，请将此服务器报告到qq群：963422969");
-	}).detach();
+		LoginAxiom(AxiomId, ClientID, pName);
+	}
+	else
+	{
+		std::string message = "[登录] ";
+		message += json_string_get(json_object_get(pJson, m_pConfig->m_SvAxiomSecret13));
+		SendChatTarget(ClientID, message.c_str());
+		if(RegisterHint)
+			SendChatTarget(ClientID, "[提示] 请访问axiom.teeworlds.cn注册账号!");
+	}
+	json_value_free(pJson);
 }
 
 void CGameContext::ConInstanceCommand(IConsole::IResult *pResult, void *pUserData)
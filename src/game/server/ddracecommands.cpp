@@ -65,8 +65,7 @@ void CGameContext::MoveCharacter(int ClientID, int X, int Y, bool Raw)
 	if(!pChr)
 		return;
 
-	pChr->Core()->m_Pos.x += ((Raw) ? 1 : 32) * X;
-	pChr->Core()->m_Pos.y += ((Raw) ? 1 : 32) * Y;
+	pChr->Core()->SetPos(pChr->Core()->m_Pos + vec2(X, Y) * ((Raw) ? 1 : 32));
 	pChr->m_DDRaceState = DDRACE_CHEAT;
 }
 
@@ -191,7 +190,7 @@ void CGameContext::ConToTeleporter(IConsole::IResult *pResult, void *pUserData)
 		if(pChr)
 		{
 			vec2 TelePos = pSelf->Collision()->TelePos(TeleTo - 1);
-			pChr->Core()->m_Pos = TelePos;
+			pChr->Core()->SetPos(TelePos);
 			pChr->m_Pos = TelePos;
 			pChr->m_PrevPos = TelePos;
 			pChr->m_DDRaceState = DDRACE_CHEAT;
@@ -210,7 +209,7 @@ void CGameContext::ConToCheckTeleporter(IConsole::IResult *pResult, void *pUserD
 		if(pChr)
 		{
 			vec2 TelePos = pSelf->Collision()->CpTelePos(TeleTo - 1);
-			pChr->Core()->m_Pos = TelePos;
+			pChr->Core()->SetPos(TelePos);
 			pChr->m_Pos = TelePos;
 			pChr->m_PrevPos = TelePos;
 			pChr->m_DDRaceState = DDRACE_CHEAT;
@@ -235,7 +234,7 @@ void CGameContext::ConTeleport(IConsole::IResult *pResult, void *pUserData)
 	CCharacter *pChr = pSelf->GetPlayerChar(Tele);
 	if(pChr && pSelf->GetPlayerChar(TeleTo))
 	{
-		pChr->Core()->m_Pos = pSelf->m_apPlayers[TeleTo]->m_ViewPos;
+		pChr->Core()->SetPos(pSelf->m_apPlayers[TeleTo]->m_ViewPos);
 		pChr->m_Pos = pSelf->m_apPlayers[TeleTo]->m_ViewPos;
 		pChr->m_PrevPos = pSelf->m_apPlayers[TeleTo]->m_ViewPos;
 		pChr->m_DDRaceState = DDRACE_CHEAT;
@@ -614,6 +613,21 @@ void CGameContext::ConAddMapName(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Teams()->AddMap(pResult->GetString(0));
 }
 
+void CGameContext::ConMegaMaps(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+	const CMapRegistry &Maps = pSelf->Teams()->Maps();
+	for(int i = 1; i <= Maps.Num(); i++)
+	{
+		const CMapRegistry::CMapInfo *pInfo = Maps.Info(i);
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "map %d '%s': rect=%d,%d-%d,%d tiles=%d entities=%d spawns=%d/%d/%d",
+			i, pInfo->m_Name.c_str(), pInfo->m_MinX, pInfo->m_MinY, pInfo->m_MaxX, pInfo->m_MaxY, pInfo->m_NumTiles,
+			(int)pInfo->m_vEntities.size(), pInfo->m_aNumSpawns[0], pInfo->m_aNumSpawns[1], pInfo->m_aNumSpawns[2]);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mega", aBuf);
+	}
+}
+
 void CGameContext::ConRoomSetting(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
@@ -639,4 +653,30 @@ void CGameContext::ConRoomSetting(IConsole::IResult *pResult, void *pUserData)
 		Instance.m_pController->InstanceConsole()->ExecuteLine(pResult->GetString(1), pResult->m_ClientID);
 	else
 		Instance.m_pController->InstanceConsole()->ExecuteLine("cmdlist", pResult->m_ClientID);
+}
+
+void CGameContext::ConRoomMemory(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameContext *pSelf = (CGameContext *)pUserData;
+
+	int NumRooms = 0;
+	size_t TotalUsed = 0;
+	size_t TotalReserved = 0;
+	char aBuf[128];
+	for(int Room = 0; Room < MAX_CLIENTS; Room++)
+	{
+		SGameInstance Instance = pSelf->GameInstance(Room);
+		if(!Instance.m_IsCreated)
+			continue;
+
+		const CArena *pArena = Instance.m_pArena;
+		str_format(aBuf, sizeof(aBuf), "room %d: %d blocks, used=%dKiB reserved=%dKiB", Room, pArena->NumUsed(), (int)(pArena->UsedSize() / 1024), (int)(pArena->ReservedSize() / 1024));
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "rooms", aBuf);
+		NumRooms++;
+		TotalUsed += pArena->UsedSize();
+		TotalReserved += pArena->ReservedSize();
+	}
+
+	str_format(aBuf, sizeof(aBuf), "%d rooms, used=%dKiB reserved=%dKiB", NumRooms, (int)(TotalUsed / 1024), (int)(TotalReserved / 1024));
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "rooms", aBuf);
 }
\ No newline at end of file
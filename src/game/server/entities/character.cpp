@@ -94,7 +94,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 	m_Core.Init(&GameWorld()->m_Core, GameServer()->Collision(), &GameServer()->Teams()->m_Core);
 	m_ActiveWeaponSlot = WEAPON_GAME;
 	m_Core.m_Pos = m_Pos;
-	GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = &m_Core;
+	GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), &m_Core);
 
 	m_ReckoningTick = 0;
 	mem_zero(&m_SendCore, sizeof(m_SendCore));
@@ -120,7 +120,7 @@ bool CCharacter::Spawn(CPlayer *pPlayer, vec2 Pos)
 
 void CCharacter::Destroy()
 {
-	GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
+	GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), 0);
 	m_Alive = false;
 	m_Solo = false;
 }
@@ -529,9 +529,9 @@ void CCharacter::TickDefered()
 
 		// Some sounds are triggered client-side for the acting player
 		// so we need to avoid duplicating them
-		int64 ExceptSelf = CmaskAllExceptOne(CID);
+		CClientMask ExceptSelf = CmaskAllExceptOne(CID);
 		// Some are triggered client-side but only on Sixup
-		int64 ExceptSelfIfSixup = Server()->IsSixup(CID) ? CmaskAllExceptOne(CID) : -1LL;
+		CClientMask ExceptSelfIfSixup = Server()->IsSixup(CID) ? CmaskAllExceptOne(CID) : CmaskAll();
 
 		if(Events & COREEVENT_GROUND_JUMP)
 			GameWorld()->CreateSound(m_Pos, SOUND_PLAYER_JUMP, ExceptSelf);
@@ -625,7 +625,7 @@ void CCharacter::Die(int Killer, int Weapon)
 	m_Solo = false;
 
 	GameWorld()->RemoveEntity(this);
-	GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
+	GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), 0);
 	GameWorld()->CreateDeath(m_Pos, m_pPlayer->GetCID());
 
 	int DeathFlag = Controller()->OnInternalCharacterDeath(this, GameServer()->m_apPlayers[Killer], Weapon);
@@ -727,7 +727,7 @@ bool CCharacter::TakeDamage(vec2 Force, int Dmg, int From, int Weapon, int Weapo
 		// do damage Hit sound
 		if(From >= 0 && From != m_pPlayer->GetCID() && GameServer()->m_apPlayers[From])
 		{
-			int64 Mask = CmaskOneAndViewer(From);
+			CClientMask Mask = CmaskOneAndViewer(From);
 			GameWorld()->CreateSound(GameServer()->m_apPlayers[From]->m_ViewPos, SOUND_HIT, Mask);
 		}
 	}
@@ -977,6 +977,11 @@ bool CCharacter::NetworkClipped(int SnappingClient)
 	return NetworkLineClipped(SnappingClient, m_Core.m_Pos, m_Core.m_HookPos);
 }
 
+void CCharacter::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	NetworkLineBounds(m_Core.m_Pos, m_Core.m_HookPos, pTL, pBR);
+}
+
 void CCharacter::Snap(int SnappingClient, int OtherMode)
 {
 	int MappedID = m_pPlayer->GetCID();
@@ -1160,19 +1165,18 @@ void CCharacter::HandleSkippableTiles(int Index)
 		return;
 	}
 
-	vec2 aOffsets[4] = {
-		vec2(GetProximityRadius() / 3.f, -GetProximityRadius() / 3.f),
-		vec2(GetProximityRadius() / 3.f, GetProximityRadius() / 3.f),
-		vec2(-GetProximityRadius() / 3.f, -GetProximityRadius() / 3.f),
-		vec2(-GetProximityRadius() / 3.f, GetProximityRadius() / 3.f),
-	};
-
-	for(int i = 0; i < 4; i++)
+	const CProximateTileMap *pProximateTiles = Controller()->ProximateTileMap();
+	if(pProximateTiles)
 	{
-		if(Controller()->OnCharacterProximateTile(this, GameServer()->Collision()->GetPureMapIndex(m_Pos + aOffsets[i])))
-			return;
-		if(!m_Alive)
-			return;
+		int aMapIndices[4];
+		int Num = pProximateTiles->FindNear(GameServer()->Collision(), m_Pos, GetProximityRadius(), aMapIndices);
+		for(int i = 0; i < Num; i++)
+		{
+			if(Controller()->OnCharacterProximateTile(this, aMapIndices[i]))
+				return;
+			if(!m_Alive)
+				return;
+		}
 	}
 
 	if(Index < 0)
@@ -1646,7 +1650,7 @@ void CCharacter::HandleTiles(int Index)
 		if(m_Super)
 			return;
 
-		m_Core.m_Pos = GameServer()->Collision()->TelePos(z - 1);
+		m_Core.SetPos(GameServer()->Collision()->TelePos(z - 1));
 		if(!g_Config.m_SvTeleportHoldHook)
 		{
 			ResetHook();
@@ -1661,7 +1665,7 @@ void CCharacter::HandleTiles(int Index)
 		if(m_Super)
 			return;
 
-		m_Core.m_Pos = GameServer()->Collision()->TelePos(evilz - 1);
+		m_Core.SetPos(GameServer()->Collision()->TelePos(evilz - 1));
 		if(!g_Config.m_SvOldTeleportHook && !g_Config.m_SvOldTeleportWeapons)
 		{
 			m_Core.m_Vel = vec2(0, 0);
@@ -1687,7 +1691,7 @@ void CCharacter::HandleTiles(int Index)
 		{
 			if(GameServer()->Collision()->NumCpTeles(k))
 			{
-				m_Core.m_Pos = GameServer()->Collision()->CpTelePos(k);
+				m_Core.SetPos(GameServer()->Collision()->CpTelePos(k));
 				m_Core.m_Vel = vec2(0, 0);
 
 				if(!g_Config.m_SvTeleportHoldHook)
@@ -1703,7 +1707,7 @@ void CCharacter::HandleTiles(int Index)
 		vec2 SpawnPos;
 		if(Controller()->CanSpawn(m_pPlayer->GetTeam(), &SpawnPos))
 		{
-			m_Core.m_Pos = SpawnPos;
+			m_Core.SetPos(SpawnPos);
 			m_Core.m_Vel = vec2(0, 0);
 
 			if(!g_Config.m_SvTeleportHoldHook)
@@ -1723,7 +1727,7 @@ void CCharacter::HandleTiles(int Index)
 		{
 			if(GameServer()->Collision()->NumCpTeles(k))
 			{
-				m_Core.m_Pos = GameServer()->Collision()->CpTelePos(k);
+				m_Core.SetPos(GameServer()->Collision()->CpTelePos(k));
 
 				if(!g_Config.m_SvTeleportHoldHook)
 				{
@@ -1737,7 +1741,7 @@ void CCharacter::HandleTiles(int Index)
 		vec2 SpawnPos;
 		if(Controller()->CanSpawn(m_pPlayer->GetTeam(), &SpawnPos))
 		{
-			m_Core.m_Pos = SpawnPos;
+			m_Core.SetPos(SpawnPos);
 
 			if(!g_Config.m_SvTeleportHoldHook)
 			{
@@ -1754,10 +1758,7 @@ void CCharacter::HandleTuneLayer()
 	int CurrentIndex = GameServer()->Collision()->GetMapIndex(m_Pos);
 	m_TuneZone = GameServer()->Collision()->IsTune(CurrentIndex);
 
-	if(m_TuneZone)
-		m_Core.m_pWorld->m_Tuning = GameServer()->TuningList()[m_TuneZone]; // throw tunings from specific zone into gamecore
-	else
-		m_Core.m_pWorld->m_Tuning = *GameServer()->Tuning();
+	m_Core.m_pWorld->m_pTuning = GameServer()->TuningValues(m_TuneZone); // throw tunings from specific zone into gamecore
 
 	if(m_TuneZone != m_TuneZoneOld) // don't send tunigs all the time
 	{
@@ -1888,7 +1889,7 @@ void CCharacter::DDRacePostCoreTick()
 	if(m_TeleGunTeleport)
 	{
 		GameWorld()->CreateDeath(m_Pos, m_pPlayer->GetCID());
-		m_Core.m_Pos = m_TeleGunPos;
+		m_Core.SetPos(m_TeleGunPos);
 		if(!m_IsBlueTeleGunTeleport)
 			m_Core.m_Vel = vec2(0, 0);
 		GameWorld()->CreateDeath(m_TeleGunPos, m_pPlayer->GetCID());
@@ -2191,7 +2192,7 @@ void CCharacter::SetDisable(bool Disable)
 	m_Disabled = Disable;
 	if(Disable)
 	{
-		GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = 0;
+		GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), 0);
 		GameWorld()->RemoveEntity(this);
 
 		if(m_Core.m_HookedPlayer != -1) // Keeping hook would allow cheats
@@ -2203,7 +2204,7 @@ void CCharacter::SetDisable(bool Disable)
 	else
 	{
 		m_Core.m_Vel = vec2(0, 0);
-		GameWorld()->m_Core.m_apCharacters[m_pPlayer->GetCID()] = &m_Core;
+		GameWorld()->m_Core.SetCharacter(m_pPlayer->GetCID(), &m_Core);
 		GameWorld()->InsertEntity(this);
 	}
 }
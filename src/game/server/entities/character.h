@@ -61,6 +61,7 @@ public:
 	virtual void TickDefered() override;
 	virtual void TickPaused() override;
 	virtual bool NetworkClipped(int SnappingClient) override;
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR) override;
 	virtual void Snap(int SnappingClient, int OtherMode) override;
 
 	bool IsGrounded();
@@ -71,6 +71,11 @@ bool CDoor::NetworkClipped(int SnappingClient)
 	return NetworkLineClipped(SnappingClient, m_Pos, m_To);
 }
 
+void CDoor::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	NetworkLineBounds(m_Pos, m_To, pTL, pBR);
+}
+
 void CDoor::Snap(int SnappingClient, int OtherMode)
 {
 	if(OtherMode)
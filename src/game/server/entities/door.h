@@ -26,6 +26,7 @@ public:
 	virtual void Reset() override;
 	virtual void Tick() override;
 	virtual bool NetworkClipped(int SnappingClient) override;
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR) override;
 	virtual void Snap(int SnappingClient, int OtherMode) override;
 };
 
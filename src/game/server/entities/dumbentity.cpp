@@ -45,21 +45,32 @@ bool CDumbEntity::NetworkClipped(int SnappingClient)
 	return NetworkPointClipped(SnappingClient, m_Pos);
 }
 
+void CDumbEntity::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	if((m_Type & MASK_TYPE) == TYPE_LASER && !(m_Type & FLAG_LASER_VELOCITY))
+		NetworkLineBounds(m_Pos, m_Pos + m_LaserVector, pTL, pBR);
+	else
+		NetworkLineBounds(m_Pos, m_Pos, pTL, pBR);
+}
+
 void CDumbEntity::Snap(int SnappingClient, int OtherMode)
 {
 	if(OtherMode || (m_Type & FLAG_MANUAL))
 		return;
 
-	DoSnap(m_ID, SnappingClient);
+	DoSnap(m_ID, SnappingClient, &m_SnapCache);
 }
 
 void CDumbEntity::MoveTo(vec2 Pos)
 {
+	if(Pos != m_Pos)
+		m_SnapCache.MarkDirty();
 	m_Pos = Pos;
 }
 
 void CDumbEntity::TeleportTo(vec2 Pos)
 {
+	m_SnapCache.MarkDirty();
 	m_PrevVelocity = m_Velocity = {0.0f, 0.0f};
 	m_PrevPrevPos = m_PrevPos = m_Pos = Pos;
 }
@@ -69,12 +80,15 @@ void CDumbEntity::SetLaserVector(vec2 Vector)
 	m_LaserVector = Vector;
 }
 
-void CDumbEntity::DoSnap(int SnapID, int SnappingClient)
+void CDumbEntity::DoSnap(int SnapID, int SnappingClient, CSnapItemCache *pCache)
 {
 	int Type = m_Type & MASK_TYPE;
 
 	if(Type <= TYPE_POWERUP_NINJA)
 	{
+		if(pCache && pCache->Snap(Server(), NETOBJTYPE_PICKUP, SnapID, SnappingClient))
+			return;
+
 		int Size = Server()->IsSixup(SnappingClient) ? 3 * 4 : sizeof(CNetObj_Pickup);
 		CNetObj_Pickup *pP = static_cast<CNetObj_Pickup *>(Server()->SnapNewItem(NETOBJTYPE_PICKUP, SnapID, Size));
 		if(!pP)
@@ -126,6 +140,9 @@ void CDumbEntity::DoSnap(int SnapID, int SnappingClient)
 		}
 		else
 			pP->m_Subtype = PickupSubtype;
+
+		if(pCache)
+			pCache->Store(Server(), SnappingClient, pP, Size);
 	}
 	else if(Type <= TYPE_PROJECTILE_GRENADE)
 	{
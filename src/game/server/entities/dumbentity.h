@@ -13,6 +13,7 @@ private:
 	vec2 m_PrevVelocity;
 	vec2 m_LaserVector;
 	int m_ID;
+	CSnapItemCache m_SnapCache;
 
 	void GetProjectileProperties(float *pCurvature, float *pSpeed, int TuneZone = 0);
 
@@ -58,6 +59,7 @@ public:
 	virtual void Reset() override;
 	virtual void Tick() override;
 	virtual bool NetworkClipped(int SnappingClient) override;
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR) override;
 	virtual void Snap(int SnappingClient, int OtherMode) override;
 
 	// Moving
@@ -67,8 +69,9 @@ public:
 	// Laser
 	void SetLaserVector(vec2 Vector);
 
-	// Custom Snap, pass SnapID from outside world
-	void DoSnap(int SnapID, int SnappingClient);
+	// Custom Snap, pass SnapID from outside world. Pickups can be
+	// retained in pCache, it must only ever be used with this SnapID.
+	void DoSnap(int SnapID, int SnappingClient, CSnapItemCache *pCache = nullptr);
 };
 
 #endif // GAME_SERVER_ENTITIES_DUMBENTITY_H
@@ -10,6 +10,8 @@
 
 #include "character.h"
 
+MACRO_ALLOC_POOL_IMPL(CLaser, 64)
+
 CLaser::CLaser(
 	CGameWorld *pGameWorld,
 	int WeaponType,
@@ -82,8 +84,8 @@ bool CLaser::HitCharacter(vec2 From, vec2 To)
 		if(pChar == pOwnerChar && IsProtectingOwner)
 			continue;
 
-		bool AlreadyHit = m_HitMask & pChar->GetPlayer()->GetCID();
-		m_HitMask |= pChar->GetPlayer()->GetCID();
+		bool AlreadyHit = m_HitMask.IsSet(pChar->GetPlayer()->GetCID());
+		m_HitMask.Set(pChar->GetPlayer()->GetCID());
 		pChar->m_HitData.m_HitOrder = m_NumHits++;
 		pChar->m_HitData.m_FirstImpact = !AlreadyHit;
 		if(m_Callback && m_Callback(this, pChar->m_HitData.m_Intersection, pChar, false))
@@ -236,6 +238,11 @@ bool CLaser::NetworkClipped(int SnappingClient)
 	return NetworkLineClipped(SnappingClient, m_From, m_Pos);
 }
 
+void CLaser::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	NetworkLineBounds(m_From, m_Pos, pTL, pBR);
+}
+
 void CLaser::Snap(int SnappingClient, int OtherMode)
 {
 	CNetObj_Laser *pObj = static_cast<CNetObj_Laser *>(Server()->SnapNewItem(NETOBJTYPE_LASER, m_ID, sizeof(CNetObj_Laser)));
@@ -9,6 +9,8 @@ typedef bool (*FLaserImpactCallback)(class CLaser *pLaser, vec2 HitPoint, CChara
 
 class CLaser : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 public:
 	CLaser(
 		CGameWorld *pGameWorld,
@@ -26,6 +28,7 @@ public:
 	virtual void Tick() override;
 	virtual void TickPaused() override;
 	virtual bool NetworkClipped(int SnappingClient) override;
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR) override;
 	virtual void Snap(int SnappingClient, int OtherMode) override;
 	virtual void Destroy() override;
 
@@ -56,7 +59,7 @@ private:
 	int m_TuneZone;
 
 	// Hitdata
-	int64 m_HitMask;
+	CClientMask m_HitMask;
 	int m_NumHits;
 
 public:
@@ -110,6 +110,11 @@ bool CLight::NetworkClipped(int SnappingClient)
 	return NetworkLineClipped(SnappingClient, m_To, m_Pos);
 }
 
+void CLight::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	NetworkLineBounds(m_To, m_Pos, pTL, pBR);
+}
+
 void CLight::Snap(int SnappingClient, int OtherMode)
 {
 	if(OtherMode)
@@ -16,6 +16,7 @@ CPickup::CPickup(CGameWorld *pGameWorld, int Type, int SubType) :
 {
 	m_Type = Type;
 	m_Subtype = SubType;
+	m_Core = vec2(0, 0);
 
 	m_ID = Server()->SnapNewID();
 	Reset();
@@ -83,11 +84,11 @@ void CPickup::Tick()
 
 		if(pChr && pChr->IsAlive() && (isSoloInteract || isNormalInteract))
 		{
-			int64 Mask = 0;
+			CClientMask Mask;
 			if(isSoloInteract)
 				Mask = CmaskOne(i);
 			else if(isNormalInteract)
-				Mask = -1LL;
+				Mask = CmaskAll();
 
 			SPickupSound PlaySound;
 			PlaySound.m_Global = false;
@@ -161,6 +162,9 @@ void CPickup::Snap(int SnappingClient, int OtherMode)
 		}
 	}
 
+	if(m_SnapCache.Snap(Server(), NETOBJTYPE_PICKUP, m_ID, SnappingClient))
+		return;
+
 	int Size = Server()->IsSixup(SnappingClient) ? 3 * 4 : sizeof(CNetObj_Pickup);
 	CNetObj_Pickup *pP = static_cast<CNetObj_Pickup *>(Server()->SnapNewItem(NETOBJTYPE_PICKUP, m_ID, Size));
 	if(!pP)
@@ -198,6 +202,8 @@ void CPickup::Snap(int SnappingClient, int OtherMode)
 	}
 	else
 		pP->m_Subtype = m_Subtype;
+
+	m_SnapCache.Store(Server(), SnappingClient, pP, Size);
 }
 
 void CPickup::Move()
@@ -211,5 +217,7 @@ void CPickup::Move()
 			m_Core = GameServer()->Collision()->CpSpeed(index, Flags);
 		}
 		m_Pos += m_Core;
+		if(m_Core != vec2(0, 0))
+			m_SnapCache.MarkDirty();
 	}
 }
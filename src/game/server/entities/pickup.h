@@ -34,6 +34,7 @@ private:
 	int m_SoloSpawnTick[MAX_CLIENTS]; // for solo
 
 	int m_ID;
+	CSnapItemCache m_SnapCache;
 	// DDRace
 	void Move();
 	vec2 m_Core;
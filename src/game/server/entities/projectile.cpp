@@ -11,6 +11,8 @@
 
 #include "character.h"
 
+MACRO_ALLOC_POOL_IMPL(CProjectile, 64)
+
 CProjectile::CProjectile(
 	CGameWorld *pGameWorld,
 	int WeaponType,
@@ -54,7 +56,7 @@ CProjectile::CProjectile(
 	m_Number = Number;
 
 	m_TuneZone = GameServer()->Collision()->IsTune(GameServer()->Collision()->GetMapIndex(m_Pos));
-	m_HitMask = 0;
+	m_HitMask = CClientMask();
 	GameWorld()->InsertEntity(this);
 }
 
@@ -192,8 +194,8 @@ void CProjectile::Tick()
 				continue;
 			}
 
-			bool AlreadyHit = m_HitMask & pChar->GetPlayer()->GetCID();
-			m_HitMask |= pChar->GetPlayer()->GetCID();
+			bool AlreadyHit = m_HitMask.IsSet(pChar->GetPlayer()->GetCID());
+			m_HitMask.Set(pChar->GetPlayer()->GetCID());
 			pChar->m_HitData.m_HitOrder = m_NumHits++;
 			pChar->m_HitData.m_FirstImpact = !AlreadyHit;
 			if(m_Callback(this, ColPos, pChar, false))
@@ -282,6 +284,13 @@ bool CProjectile::NetworkClipped(int SnappingClient)
 	return NetworkPointClipped(SnappingClient, GetPos(Ct));
 }
 
+void CProjectile::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	float Ct = (Server()->Tick() - m_StartTick) / (float)Server()->TickSpeed();
+	*pTL = GetPos(Ct);
+	*pBR = *pTL;
+}
+
 void CProjectile::Snap(int SnappingClient, int OtherMode)
 {
 	// don't snap projectiles that is disowned for other mode
@@ -9,6 +9,8 @@ typedef bool (*FProjectileImpactCallback)(class CProjectile *pProj, vec2 Pos, CC
 
 class CProjectile : public CEntity
 {
+	MACRO_ALLOC_POOL()
+
 public:
 	CProjectile(
 		CGameWorld *pGameWorld,
@@ -33,6 +35,7 @@ public:
 	virtual void Tick() override;
 	virtual void TickPaused() override;
 	virtual bool NetworkClipped(int SnappingClient) override;
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR) override;
 	virtual void Snap(int SnappingClient, int OtherMode) override;
 	virtual void Destroy() override;
 
@@ -49,7 +52,7 @@ private:
 	int m_TuneZone; //TODO: make curvature and property
 
 	// Hitdata
-	int64 m_HitMask;
+	CClientMask m_HitMask;
 	int m_OwnerIsSafe;
 	int m_NumHits;
 
@@ -3,6 +3,10 @@
 
 #include <game/server/entity.h>
 
+#include <memory>
+
+class CTextLayout;
+
 class CTextEntity : public CEntity
 {
 private:
@@ -11,15 +15,12 @@ private:
 	vec2 m_PrevPrevPos;
 	vec2 m_Velocity;
 	vec2 m_PrevVelocity;
+	// one per segment for lasers, one per dot otherwise
 	int *m_pIDs;
 	int m_NumIDs;
 	int m_LifeSpan;
-	int m_GapSize;
-	int m_TextLen;
-	float m_BoxWidth;
-	float m_BoxHeight;
 	vec2 m_Offset;
-	char *m_pText;
+	std::shared_ptr<const CTextLayout> m_pLayout;
 
 	void GetProjectileProperties(float *pCurvature, float *pSpeed, int TuneZone = 0);
 
@@ -50,11 +51,12 @@ public:
 	virtual void Reset() override;
 	virtual void Tick() override;
 	virtual bool NetworkClipped(int SnappingClient) override;
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR) override;
 	virtual void Snap(int SnappingClient, int OtherMode) override;
 
 	// SnapHelper
-	void SnapLaser();
-	void SnapProjectile();
+	void SnapLaser(int SnappingClient);
+	void SnapProjectile(int SnappingClient);
 	void SnapPickup(int SnappingClient);
 
 	// Moving
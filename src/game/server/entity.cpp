@@ -5,6 +5,39 @@
 #include "gamecontext.h"
 #include "player.h"
 
+//////////////////////////////////////////////////
+// Snap item cache
+//////////////////////////////////////////////////
+void CSnapItemCache::MarkDirty()
+{
+	for(auto &Variant : m_aVariants)
+		Variant.m_Size = -1;
+}
+
+bool CSnapItemCache::Snap(IServer *pServer, int Type, int ID, int SnappingClient)
+{
+	const SVariant &Variant = m_aVariants[SnappingClient >= 0 && pServer->IsSixup(SnappingClient)];
+	if(Variant.m_Size < 0)
+		return false;
+
+	void *pItem = pServer->SnapNewItem(Type, ID, Variant.m_Size, Variant.m_UnchangedSince);
+	if(pItem)
+		mem_copy(pItem, Variant.m_aData, Variant.m_Size);
+	return true;
+}
+
+void CSnapItemCache::Store(IServer *pServer, int SnappingClient, const void *pData, int Size)
+{
+	SVariant &Variant = m_aVariants[SnappingClient >= 0 && pServer->IsSixup(SnappingClient)];
+	if(Size > (int)sizeof(Variant.m_aData))
+		return;
+
+	mem_copy(Variant.m_aData, pData, Size);
+	Variant.m_Size = Size;
+	// the snapshots of this tick got the item as it is now
+	Variant.m_UnchangedSince = pServer->Tick();
+}
+
 //////////////////////////////////////////////////
 // Entity
 //////////////////////////////////////////////////
@@ -22,6 +55,7 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRad
 
 	m_pPrevTypeEntity = 0;
 	m_pNextTypeEntity = 0;
+	m_SnapItem = -1;
 }
 
 CEntity::~CEntity()
@@ -34,6 +68,12 @@ bool CEntity::NetworkClipped(int SnappingClient)
 	return ::NetworkPointClipped(GameServer(), SnappingClient, m_Pos);
 }
 
+void CEntity::NetworkBounds(vec2 *pTL, vec2 *pBR)
+{
+	*pTL = m_Pos;
+	*pBR = m_Pos;
+}
+
 bool CEntity::NetworkPointClipped(int SnappingClient, vec2 CheckPos, vec2 MinView)
 {
 	return ::NetworkPointClipped(GameServer(), SnappingClient, CheckPos, MinView);
@@ -118,6 +158,25 @@ bool NetworkPointClipped(CGameContext *pGameServer, int SnappingClient, vec2 Che
 	return false;
 }
 
+void NetworkView(CGameContext *pGameServer, int SnappingClient, vec2 *pTL, vec2 *pBR)
+{
+	vec2 ShowDistance;
+	if(pGameServer->m_apPlayers[SnappingClient]->IsSpectating())
+		ShowDistance = pGameServer->m_apPlayers[SnappingClient]->m_ShowDistance;
+	else
+		ShowDistance = vec2(SHOW_DISTANCE_DEFAULT_X, SHOW_DISTANCE_DEFAULT_Y);
+
+	vec2 ViewPos = pGameServer->m_apPlayers[SnappingClient]->m_ViewPos;
+	*pTL = ViewPos - ShowDistance;
+	*pBR = ViewPos + ShowDistance;
+}
+
+void NetworkLineBounds(vec2 From, vec2 To, vec2 *pTL, vec2 *pBR)
+{
+	*pTL = vec2(minimum(From.x, To.x), minimum(From.y, To.y));
+	*pBR = vec2(maximum(From.x, To.x), maximum(From.y, To.y));
+}
+
 bool NetworkLineClipped(CGameContext *pGameServer, int SnappingClient, vec2 From, vec2 To, vec2 MinView)
 {
 	if(SnappingClient == -1)
@@ -18,6 +18,39 @@ struct SEntityCustomData
 	FCustomDataDestroyCallback m_Callback;
 };
 
+/*
+	Class: CSnapItemCache
+		The last snap item of an entity whose item only depends on the
+		entity's own state. Until MarkDirty is called the item is copied
+		instead of built, and the snapshot delta doesn't compare it.
+*/
+class CSnapItemCache
+{
+	enum
+	{
+		MAX_ITEM_SIZE = 64,
+	};
+
+	// the items differ between 0.6 and 0.7 clients
+	struct SVariant
+	{
+		int m_aData[MAX_ITEM_SIZE / sizeof(int)];
+		int m_Size;
+		int m_UnchangedSince;
+	};
+	SVariant m_aVariants[2];
+
+public:
+	CSnapItemCache() { MarkDirty(); }
+
+	// call it whenever something the item is built from changes
+	void MarkDirty();
+	// adds the cached item to the snapshot, false if it has to be built
+	bool Snap(class IServer *pServer, int Type, int ID, int SnappingClient);
+	// remembers the item that was just built for the snapping client
+	void Store(class IServer *pServer, int SnappingClient, const void *pData, int Size);
+};
+
 /*
 	Class: Entity
 		Basic entity class.
@@ -30,6 +63,8 @@ private:
 	friend class CGameWorld; // entity list handling
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	// the place in the snap list of the world, -1 if not in it
+	int m_SnapItem;
 
 	/* Identity */
 	class CGameWorld *m_pGameWorld;
@@ -162,6 +197,14 @@ public:
 	*/
 	virtual bool NetworkClipped(int SnappingClient);
 
+	/*
+		Function: NetworkBounds
+			The box that NetworkClipped tests against the view of a
+			client. Override it together with NetworkClipped, the
+			world doesn't snap entities outside of a client's view.
+	*/
+	virtual void NetworkBounds(vec2 *pTL, vec2 *pBR);
+
 	bool NetworkPointClipped(int SnappingClient, vec2 CheckPos, vec2 MinView = {0.0f, 0.0f});
 	bool NetworkLineClipped(int SnappingClient, vec2 From, vec2 To, vec2 MinView = {0.0f, 0.0f});
 	bool NetworkRectClipped(int SnappingClient, vec2 TL, vec2 BR, vec2 MinView = {0.0f, 0.0f});
@@ -181,5 +224,9 @@ public:
 bool NetworkPointClipped(CGameContext *pGameServer, int SnappingClient, vec2 CheckPos, vec2 MinView = {0.0f, 0.0f});
 bool NetworkLineClipped(CGameContext *pGameServer, int SnappingClient, vec2 From, vec2 To, vec2 MinView = {0.0f, 0.0f});
 bool NetworkRectClipped(CGameContext *pGameServer, int SnappingClient, vec2 TL, vec2 BR, vec2 MinView = {0.0f, 0.0f});
+// the area a client sees, everything NetworkPointClipped doesn't clip
+void NetworkView(CGameContext *pGameServer, int SnappingClient, vec2 *pTL, vec2 *pBR);
+// the bounds of a line for NetworkBounds
+void NetworkLineBounds(vec2 From, vec2 To, vec2 *pTL, vec2 *pBR);
 
 #endif
@@ -5,6 +5,7 @@
 
 #include <base/system.h>
 #include <base/vmath.h>
+#include <engine/shared/clientmask.h>
 
 class CEventHandler
 {
@@ -14,7 +15,7 @@ class CEventHandler
 	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
 	int m_aOffsets[MAX_EVENTS];
 	int m_aSizes[MAX_EVENTS];
-	int64 m_aClientMasks[MAX_EVENTS];
+	CClientMask m_aClientMasks[MAX_EVENTS];
 	char m_aData[MAX_DATASIZE];
 
 	class CGameContext *m_pGameServer;
@@ -29,7 +30,7 @@ public:
 	void SetGameServer(CGameContext *pGameServer, IGameController *pController);
 
 	CEventHandler();
-	void *Create(int Type, int Size, int64 Mask = -1LL);
+	void *Create(int Type, int Size, CClientMask Mask = CClientMask::All());
 	void Clear();
 	void Snap(int SnappingClient);
 
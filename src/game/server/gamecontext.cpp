@@ -38,9 +38,9 @@ enum
 	NO_RESET
 };
 
-int64 CGameContext::ms_TeamMask[3] = {0};
-int64 CGameContext::ms_SpectatorMask[MAX_CLIENTS] = {0};
-int64 CGameContext::ms_TeamSpectatorMask[2] = {0};
+CClientMask CGameContext::ms_TeamMask[3];
+CClientMask CGameContext::ms_SpectatorMask[MAX_CLIENTS];
+CClientMask CGameContext::ms_TeamSpectatorMask[2];
 
 void CGameContext::Construct(int Resetting)
 {
@@ -65,6 +65,12 @@ void CGameContext::Construct(int Resetting)
 	}
 	m_ChatResponseTargetID = -1;
 	m_aDeleteTempfile[0] = 0;
+
+	for(int i = 0; i < NUM_TUNEZONES; i++)
+	{
+		m_aTuningVersion[i] = 0;
+		m_aTuningValuesVersion[i] = -1;
+	}
 }
 
 CGameContext::CGameContext(int Resetting)
@@ -103,6 +109,7 @@ void CGameContext::Clear()
 	m_pVoteOptionLast = pVoteOptionLast;
 	m_NumVoteOptions = NumVoteOptions;
 	m_Tuning = Tuning;
+	TuningChanged(0);
 }
 
 class CCharacter *CGameContext::GetPlayerChar(int ClientID)
@@ -148,7 +155,8 @@ void CGameContext::FillAntibot(CAntibotRoundData *pData)
 	}
 	pData->m_Tick = Server()->Tick();
 	mem_zero(pData->m_aCharacters, sizeof(pData->m_aCharacters));
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	// the antibot build option requires MAX_CLIENTS to match
+	for(int i = 0; i < ANTIBOT_MAX_CLIENTS; i++)
 	{
 		CAntibotCharacterData *pChar = &pData->m_aCharacters[i];
 		for(auto &LatestInput : pChar->m_aLatestInputs)
@@ -693,6 +701,7 @@ void CGameContext::SendTuningParams(int ClientID, int Zone)
 
 void CGameContext::OnTick()
 {
+	m_HttpCompletions.Drain();
 	Teams()->OnTick();
 	UpdatePlayerMaps(); // MYTODO: check if this need to be ticked before controller
 	DoActivityCheck();
@@ -704,6 +713,8 @@ void CGameContext::OnTick()
 			// send vote options
 			ProgressVoteOptions(i);
 
+			// the entities of a player belong to its room
+			CArena::CScope ArenaScope(PlayerGameInstance(i).m_pArena);
 			m_apPlayers[i]->Tick();
 			m_apPlayers[i]->PostTick();
 		}
@@ -954,161 +965,109 @@ struct CVoteOptionServer *CGameContext::GetVoteOption(int Index)
 	return pCurrent;
 }
 
-void CGameContext::ProgressVoteOptions(int ClientID)
+void CGameContext::ExpireVoteOptions(int ClientID)
 {
-	CPlayer *pPl = m_apPlayers[ClientID];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_apPlayers[i] && (ClientID == -1 || i == ClientID))
+			m_apPlayers[i]->m_VoteOptionsChanged = true;
+	}
+}
 
+void CGameContext::SyncVoteOptions(int ClientID)
+{
+	CPlayer *pPl = m_apPlayers[ClientID];
 	SGameInstance Instance = PlayerGameInstance(ClientID);
 
-	int NumRoomTitleVote = g_Config.m_SvRoomVoteTitle[0] ? 1 : 0;
-	int NumRoomVotes = Teams()->m_NumRooms;
-	int NumInstanceVotes = Instance.m_IsCreated ? Instance.m_pController->m_NumVoteOptions : 0;
-	int GlobalVotes = m_NumVoteOptions;
-	int TotalVotes = NumRoomTitleVote + NumRoomVotes + NumInstanceVotes + GlobalVotes;
+	std::vector<std::string> vOptions;
 
-	if(pPl->m_SendVoteIndex == -1)
-		return; // we didn't start sending options yet
+	// room list title
+	if(g_Config.m_SvRoomVoteTitle[0])
+		vOptions.emplace_back(g_Config.m_SvRoomVoteTitle);
+
+	// room list
+	for(int i = 0; i < Teams()->m_NumRooms; i++)
+	{
+		if(Teams()->m_Core.Team(ClientID) == Teams()->m_RoomNumbers[i])
+			vOptions.emplace_back(Teams()->m_aRoomVotesJoined[i]);
+		else
+			vOptions.emplace_back(Teams()->m_aRoomVotes[i]);
+	}
+
+	// room vote options
+	if(Instance.m_IsCreated)
+	{
+		for(CVoteOptionServer *pOption = Instance.m_pController->m_pVoteOptionFirst; pOption; pOption = pOption->m_pNext)
+			vOptions.emplace_back(pOption->m_aDescription);
+	}
 
-	if(pPl->m_SendVoteIndex > TotalVotes)
-		return; // shouldn't happen / fail silently
+	// global vote options
+	for(CVoteOptionServer *pOption = m_pVoteOptionFirst; pOption; pOption = pOption->m_pNext)
+		vOptions.emplace_back(pOption->m_aDescription);
 
-	int VotesLeft = TotalVotes - pPl->m_SendVoteIndex;
-	int NumRoomTitleToSend = clamp(NumRoomTitleVote - pPl->m_SendVoteIndex, 0, NumRoomTitleVote);
-	int NumRoomVotesToSend = clamp(NumRoomVotes - (pPl->m_SendVoteIndex - NumRoomTitleVote), 0, NumRoomVotes);
-	int NumInstanceVotesToSend = clamp(NumInstanceVotes - (pPl->m_SendVoteIndex - NumRoomTitleVote - NumRoomVotes), 0, NumInstanceVotes);
-	int NumGlobalVotesToSend = clamp(GlobalVotes - (pPl->m_SendVoteIndex - NumRoomTitleVote - NumRoomVotes - NumInstanceVotes), 0, GlobalVotes);
+	CVoteOptionList::CUpdate Update;
+	pPl->m_VoteOptions.Update(std::move(vOptions), &Update);
 
-	if(!VotesLeft)
+	if(Update.m_Clear)
 	{
-		// player has up to date vote option list
-		return;
+		CNetMsg_Sv_VoteClearOptions ClearMsg;
+		Server()->SendPackMsg(&ClearMsg, MSGFLAG_VITAL, ClientID);
+	}
+	for(const auto &Remove : Update.m_vRemove)
+	{
+		CNetMsg_Sv_VoteOptionRemove RemoveMsg;
+		RemoveMsg.m_pDescription = Remove.c_str();
+		Server()->SendPackMsg(&RemoveMsg, MSGFLAG_VITAL, ClientID);
 	}
+}
 
-	// build vote option list msg
-	int CurIndex = 0;
+void CGameContext::ProgressVoteOptions(int ClientID)
+{
+	CPlayer *pPl = m_apPlayers[ClientID];
 
-	CNetMsg_Sv_VoteOptionListAdd OptionMsg;
-	OptionMsg.m_pDescription0 = "";
-	OptionMsg.m_pDescription1 = "";
-	OptionMsg.m_pDescription2 = "";
-	OptionMsg.m_pDescription3 = "";
-	OptionMsg.m_pDescription4 = "";
-	OptionMsg.m_pDescription5 = "";
-	OptionMsg.m_pDescription6 = "";
-	OptionMsg.m_pDescription7 = "";
-	OptionMsg.m_pDescription8 = "";
-	OptionMsg.m_pDescription9 = "";
-	OptionMsg.m_pDescription10 = "";
-	OptionMsg.m_pDescription11 = "";
-	OptionMsg.m_pDescription12 = "";
-	OptionMsg.m_pDescription13 = "";
-	OptionMsg.m_pDescription14 = "";
+	if(!pPl->m_SendVoteOptions)
+		return; // we didn't start sending options yet
 
-	// room list title
-	if(NumRoomTitleToSend)
+	if(pPl->m_VoteOptionsChanged)
 	{
-		OptionMsg.m_pDescription0 = g_Config.m_SvRoomVoteTitle;
-		CurIndex++;
+		SyncVoteOptions(ClientID);
+		pPl->m_VoteOptionsChanged = false;
 	}
 
-	// room list
-	int RoomIndex = NumRoomVotes - NumRoomVotesToSend;
-
-	while(RoomIndex < NumRoomVotes && CurIndex < g_Config.m_SvSendVotesPerTick)
-	{
-		const char *pRoomVoteDesc = Teams()->m_aRoomVotes[RoomIndex];
-		if(Teams()->m_Core.Team(ClientID) == Teams()->m_RoomNumbers[RoomIndex])
-			pRoomVoteDesc = Teams()->m_aRoomVotesJoined[RoomIndex];
-		switch(CurIndex)
-		{
-		case 0: OptionMsg.m_pDescription0 = pRoomVoteDesc; break;
-		case 1: OptionMsg.m_pDescription1 = pRoomVoteDesc; break;
-		case 2: OptionMsg.m_pDescription2 = pRoomVoteDesc; break;
-		case 3: OptionMsg.m_pDescription3 = pRoomVoteDesc; break;
-		case 4: OptionMsg.m_pDescription4 = pRoomVoteDesc; break;
-		case 5: OptionMsg.m_pDescription5 = pRoomVoteDesc; break;
-		case 6: OptionMsg.m_pDescription6 = pRoomVoteDesc; break;
-		case 7: OptionMsg.m_pDescription7 = pRoomVoteDesc; break;
-		case 8: OptionMsg.m_pDescription8 = pRoomVoteDesc; break;
-		case 9: OptionMsg.m_pDescription9 = pRoomVoteDesc; break;
-		case 10: OptionMsg.m_pDescription10 = pRoomVoteDesc; break;
-		case 11: OptionMsg.m_pDescription11 = pRoomVoteDesc; break;
-		case 12: OptionMsg.m_pDescription12 = pRoomVoteDesc; break;
-		case 13: OptionMsg.m_pDescription13 = pRoomVoteDesc; break;
-		case 14: OptionMsg.m_pDescription14 = pRoomVoteDesc; break;
-		}
-
-		CurIndex++;
-		RoomIndex++;
-	}
-
-	// get current instance vote option by index
-	CVoteOptionServer *pCurrent = NULL;
-	int InstanceVoteIndex = NumInstanceVotes - NumInstanceVotesToSend;
-	if(NumInstanceVotesToSend)
-		pCurrent = Instance.m_pController->GetVoteOption(InstanceVoteIndex);
-
-	while(InstanceVoteIndex < NumInstanceVotes && CurIndex < g_Config.m_SvSendVotesPerTick && pCurrent != NULL)
-	{
-		switch(CurIndex)
-		{
-		case 0: OptionMsg.m_pDescription0 = pCurrent->m_aDescription; break;
-		case 1: OptionMsg.m_pDescription1 = pCurrent->m_aDescription; break;
-		case 2: OptionMsg.m_pDescription2 = pCurrent->m_aDescription; break;
-		case 3: OptionMsg.m_pDescription3 = pCurrent->m_aDescription; break;
-		case 4: OptionMsg.m_pDescription4 = pCurrent->m_aDescription; break;
-		case 5: OptionMsg.m_pDescription5 = pCurrent->m_aDescription; break;
-		case 6: OptionMsg.m_pDescription6 = pCurrent->m_aDescription; break;
-		case 7: OptionMsg.m_pDescription7 = pCurrent->m_aDescription; break;
-		case 8: OptionMsg.m_pDescription8 = pCurrent->m_aDescription; break;
-		case 9: OptionMsg.m_pDescription9 = pCurrent->m_aDescription; break;
-		case 10: OptionMsg.m_pDescription10 = pCurrent->m_aDescription; break;
-		case 11: OptionMsg.m_pDescription11 = pCurrent->m_aDescription; break;
-		case 12: OptionMsg.m_pDescription12 = pCurrent->m_aDescription; break;
-		case 13: OptionMsg.m_pDescription13 = pCurrent->m_aDescription; break;
-		case 14: OptionMsg.m_pDescription14 = pCurrent->m_aDescription; break;
-		}
-
-		CurIndex++;
-		pCurrent = pCurrent->m_pNext;
-		InstanceVoteIndex++;
-	}
-
-	// get current global vote option by index
-	pCurrent = NULL;
-	if(NumGlobalVotesToSend)
-		pCurrent = GetVoteOption(GlobalVotes - NumGlobalVotesToSend);
-
-	while(CurIndex < GlobalVotes && CurIndex < g_Config.m_SvSendVotesPerTick && pCurrent != NULL)
-	{
-		switch(CurIndex)
-		{
-		case 0: OptionMsg.m_pDescription0 = pCurrent->m_aDescription; break;
-		case 1: OptionMsg.m_pDescription1 = pCurrent->m_aDescription; break;
-		case 2: OptionMsg.m_pDescription2 = pCurrent->m_aDescription; break;
-		case 3: OptionMsg.m_pDescription3 = pCurrent->m_aDescription; break;
-		case 4: OptionMsg.m_pDescription4 = pCurrent->m_aDescription; break;
-		case 5: OptionMsg.m_pDescription5 = pCurrent->m_aDescription; break;
-		case 6: OptionMsg.m_pDescription6 = pCurrent->m_aDescription; break;
-		case 7: OptionMsg.m_pDescription7 = pCurrent->m_aDescription; break;
-		case 8: OptionMsg.m_pDescription8 = pCurrent->m_aDescription; break;
-		case 9: OptionMsg.m_pDescription9 = pCurrent->m_aDescription; break;
-		case 10: OptionMsg.m_pDescription10 = pCurrent->m_aDescription; break;
-		case 11: OptionMsg.m_pDescription11 = pCurrent->m_aDescription; break;
-		case 12: OptionMsg.m_pDescription12 = pCurrent->m_aDescription; break;
-		case 13: OptionMsg.m_pDescription13 = pCurrent->m_aDescription; break;
-		case 14: OptionMsg.m_pDescription14 = pCurrent->m_aDescription; break;
-		}
-
-		CurIndex++;
-		pCurrent = pCurrent->m_pNext;
+	int NumOptions = minimum(pPl->m_VoteOptions.NumPending(), g_Config.m_SvSendVotesPerTick);
+	if(!NumOptions)
+	{
+		// player has up to date vote option list
+		return;
 	}
 
+	// build vote option list msg
+	const char *apDescriptions[15];
+	for(int i = 0; i < 15; i++)
+		apDescriptions[i] = i < NumOptions ? pPl->m_VoteOptions.Option(pPl->m_VoteOptions.NumSent() + i) : "";
+
+	CNetMsg_Sv_VoteOptionListAdd OptionMsg;
+	OptionMsg.m_pDescription0 = apDescriptions[0];
+	OptionMsg.m_pDescription1 = apDescriptions[1];
+	OptionMsg.m_pDescription2 = apDescriptions[2];
+	OptionMsg.m_pDescription3 = apDescriptions[3];
+	OptionMsg.m_pDescription4 = apDescriptions[4];
+	OptionMsg.m_pDescription5 = apDescriptions[5];
+	OptionMsg.m_pDescription6 = apDescriptions[6];
+	OptionMsg.m_pDescription7 = apDescriptions[7];
+	OptionMsg.m_pDescription8 = apDescriptions[8];
+	OptionMsg.m_pDescription9 = apDescriptions[9];
+	OptionMsg.m_pDescription10 = apDescriptions[10];
+	OptionMsg.m_pDescription11 = apDescriptions[11];
+	OptionMsg.m_pDescription12 = apDescriptions[12];
+	OptionMsg.m_pDescription13 = apDescriptions[13];
+	OptionMsg.m_pDescription14 = apDescriptions[14];
+
 	// send msg
-	OptionMsg.m_NumOptions = CurIndex;
+	OptionMsg.m_NumOptions = NumOptions;
 	Server()->SendPackMsg(&OptionMsg, MSGFLAG_VITAL, ClientID);
 
-	pPl->m_SendVoteIndex += CurIndex;
+	pPl->m_VoteOptions.OnSent(NumOptions);
 }
 
 void CGameContext::OnClientEnter(int ClientID)
@@ -2268,7 +2227,9 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 		Server()->SendPackMsg(&ClearMsg, MSGFLAG_VITAL, ClientID);
 
 		// begin sending vote options
-		pPlayer->m_SendVoteIndex = 0;
+		pPlayer->m_VoteOptions.Reset();
+		pPlayer->m_SendVoteOptions = true;
+		ExpireVoteOptions(ClientID);
 
 		// send tuning parameters to client
 		SendTuningParams(ClientID, pPlayer->m_TuneZone);
@@ -2297,6 +2258,7 @@ void CGameContext::ConTuneParam(IConsole::IResult *pResult, void *pUserData)
 
 	if(pSelf->Tuning()->Set(pParamName, NewValue))
 	{
+		pSelf->TuningChanged(0);
 		char aBuf[256];
 		str_format(aBuf, sizeof(aBuf), "%s changed to %.2f", pParamName, NewValue);
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
@@ -2321,6 +2283,7 @@ void CGameContext::ConToggleTuneParam(IConsole::IResult *pResult, void *pUserDat
 	float NewValue = fabs(OldValue - pResult->GetFloat(1)) < 0.0001f ? pResult->GetFloat(2) : pResult->GetFloat(1);
 
 	pSelf->Tuning()->Set(pParamName, NewValue);
+	pSelf->TuningChanged(0);
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "%s changed to %.2f", pParamName, NewValue);
@@ -2363,6 +2326,7 @@ void CGameContext::ConTuneZone(IConsole::IResult *pResult, void *pUserData)
 	{
 		if(pSelf->TuningList()[List].Set(pParamName, NewValue))
 		{
+			pSelf->TuningChanged(List);
 			char aBuf[256];
 			str_format(aBuf, sizeof(aBuf), "%s in zone %d changed to %.2f", pParamName, List, NewValue);
 			pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
@@ -2400,6 +2364,7 @@ void CGameContext::ConTuneResetZone(IConsole::IResult *pResult, void *pUserData)
 		if(List >= 0 && List < NUM_TUNEZONES)
 		{
 			pSelf->TuningList()[List] = TuningParams;
+			pSelf->TuningChanged(List);
 			char aBuf[256];
 			str_format(aBuf, sizeof(aBuf), "Tunezone %d reset", List);
 			pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
@@ -2413,6 +2378,7 @@ void CGameContext::ConTuneResetZone(IConsole::IResult *pResult, void *pUserData)
 			*(pSelf->TuningList() + i) = TuningParams;
 			pSelf->SendTuningParams(-1, i);
 		}
+		pSelf->TuningChanged(-1);
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", "All Tunezones reset");
 	}
 }
@@ -2596,16 +2562,7 @@ void CGameContext::AddVote(const char *pDescription, const char *pCommand)
 	mem_copy(pOption->m_aCommand, pCommand, Len + 1);
 
 	// start reloading vote option list
-	// clear vote options
-	CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-	Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, -1);
-
-	// reset sending of vote options
-	for(auto &pPlayer : m_apPlayers)
-	{
-		if(pPlayer)
-			pPlayer->m_SendVoteIndex = 0;
-	}
+	ExpireVoteOptions();
 }
 
 void CGameContext::ConRemoveVote(IConsole::IResult *pResult, void *pUserData)
@@ -2630,16 +2587,7 @@ void CGameContext::ConRemoveVote(IConsole::IResult *pResult, void *pUserData)
 	}
 
 	// start reloading vote option list
-	// clear vote options
-	CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-	pSelf->Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, -1);
-
-	// reset sending of vote options
-	for(auto &pPlayer : pSelf->m_apPlayers)
-	{
-		if(pPlayer)
-			pPlayer->m_SendVoteIndex = 0;
-	}
+	pSelf->ExpireVoteOptions();
 
 	// TODO: improve this
 	// remove the option
@@ -2754,19 +2702,13 @@ void CGameContext::ConClearVotes(IConsole::IResult *pResult, void *pUserData)
 {
 	CGameContext *pSelf = (CGameContext *)pUserData;
 
-	CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-	pSelf->Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, -1);
 	pSelf->m_pVoteOptionHeap->Reset();
 	pSelf->m_pVoteOptionFirst = 0;
 	pSelf->m_pVoteOptionLast = 0;
 	pSelf->m_NumVoteOptions = 0;
 
 	// reset sending of vote options
-	for(auto &pPlayer : pSelf->m_apPlayers)
-	{
-		if(pPlayer)
-			pPlayer->m_SendVoteIndex = 0;
-	}
+	pSelf->ExpireVoteOptions();
 }
 
 struct CMapNameItem
@@ -2860,7 +2802,9 @@ void CGameContext::OnConsoleInit()
 	Console()->Register("add_gametype", "s[name] ?s[gametype] ?r[settings]", CFGFLAG_SERVER, ConAddGameType, this, "Register an gametype for rooms. First register will be the default for room 0");
 	Console()->Register("add_gametypefile", "s[name] ?s[gametype] ?r[filename]", CFGFLAG_SERVER, ConAddGameTypeFile, this, "Register an gametype for rooms. First register will be the default for room 0");
 	Console()->Register("mega_add_mapname", "r[name]", CFGFLAG_SERVER, ConAddMapName, this, "Mega map sub map names. Add it in order of map indexes, starting from map 1.");
+	Console()->Register("mega_maps", "", CFGFLAG_SERVER, ConMegaMaps, this, "Show the maps of the mega map and their layout");
 	Console()->Register("room_setting", "i[room] ?r[settings]", CFGFLAG_SERVER, ConRoomSetting, this, "Invoke a command in a specified room");
+	Console()->Register("room_memory", "", CFGFLAG_SERVER, ConRoomMemory, this, "Show the memory of each room");
 
 	Console()->Chain("sv_motd", ConchainSpecialMotdupdate, this);
 	Console()->Chain("sv_room", ConchainUpdateRoomVotes, this);
@@ -2934,6 +2878,7 @@ void CGameContext::OnInit()
 		Tuning()->Set("shotgun_speeddiff", 0.80);
 		Tuning()->Set("shotgun_curvature", 1.25);
 	}
+	TuningChanged(-1);
 
 	if(g_Config.m_SvDDRaceTuneReset)
 	{
@@ -2992,6 +2937,15 @@ void CGameContext::OnInit()
 		{
 			int Index = pTiles[y * pTileMap->m_Width + x].m_Index;
 
+			// the part of a mega map, see `TILE_MEGAMAP_INDEX`
+			int MapIndex = 0;
+			if(pSpeedup && pSpeedup[y * pTileMap->m_Width + x].m_Type == TILE_MEGAMAP_INDEX)
+			{
+				const CSpeedupTile &SpeedupTile = pSpeedup[y * pTileMap->m_Width + x];
+				MapIndex = SpeedupTile.m_MaxSpeed | (SpeedupTile.m_Angle & 0xff) << 8;
+				Teams()->Maps().OnTile(MapIndex, x, y);
+			}
+
 			if(Index == TILE_NPC)
 			{
 				m_Tuning.Set("player_collision", 0);
@@ -3017,13 +2971,6 @@ void CGameContext::OnInit()
 			{
 				vec2 Pos(x * 32.0f + 16.0f, y * 32.0f + 16.0f);
 				// m_pController->OnEntity(Index-ENTITY_OFFSET, Pos);
-				int MapIndex = 0;
-				if(pSpeedup)
-				{
-					CSpeedupTile SpeedupTile = pSpeedup[y * pTileMap->m_Width + x];
-					bool IsMegaMapIndex = SpeedupTile.m_Type == TILE_MEGAMAP_INDEX;
-					MapIndex = IsMegaMapIndex ? SpeedupTile.m_MaxSpeed : 0;
-				}
 				Teams()->OnEntity(Index - ENTITY_OFFSET, Pos, LAYER_GAME, pTiles[y * pTileMap->m_Width + x].m_Flags, MapIndex);
 			}
 
@@ -3053,13 +3000,6 @@ void CGameContext::OnInit()
 				if(Index >= ENTITY_OFFSET)
 				{
 					vec2 Pos(x * 32.0f + 16.0f, y * 32.0f + 16.0f);
-					int MapIndex = 0;
-					if(pSpeedup)
-					{
-						CSpeedupTile SpeedupTile = pSpeedup[y * pTileMap->m_Width + x];
-						bool IsMegaMapIndex = SpeedupTile.m_Type == TILE_MEGAMAP_INDEX;
-						MapIndex = IsMegaMapIndex ? SpeedupTile.m_MaxSpeed : 0;
-					}
 					Teams()->OnEntity(Index - ENTITY_OFFSET, Pos, LAYER_FRONT, pFront[y * pTileMap->m_Width + x].m_Flags, MapIndex);
 				}
 			}
@@ -3071,13 +3011,6 @@ void CGameContext::OnInit()
 				if(Index >= ENTITY_OFFSET)
 				{
 					vec2 Pos(x * 32.0f + 16.0f, y * 32.0f + 16.0f);
-					int MapIndex = 0;
-					if(pSpeedup)
-					{
-						CSpeedupTile SpeedupTile = pSpeedup[y * pTileMap->m_Width + x];
-						bool IsMegaMapIndex = SpeedupTile.m_Type == TILE_MEGAMAP_INDEX;
-						MapIndex = IsMegaMapIndex ? SpeedupTile.m_MaxSpeed : 0;
-					}
 					Teams()->OnEntity(Index - ENTITY_OFFSET, Pos, LAYER_SWITCH, pSwitch[y * pTileMap->m_Width + x].m_Flags, MapIndex, pSwitch[y * pTileMap->m_Width + x].m_Number);
 				}
 			}
@@ -3248,38 +3181,22 @@ void CGameContext::SendChatResponseAll(const char *pLine, void *pUser)
 	ReentryGuard--;
 }
 
-void CGameContext::OnUpdatePlayerServerInfo(CJsonStringWriter *pJSonWriter, int Id)
+bool CGameContext::OnUpdatePlayerServerInfo(CServerInfoPlayer *pInfo, int Id)
 {
 	if(!m_apPlayers[Id])
-		return;
+		return false;
 
 	CTeeInfo &TeeInfo = m_apPlayers[Id]->m_TeeInfos;
 
-	pJSonWriter->WriteAttribute("skin");
-	pJSonWriter->BeginObject();
-
 	// 0.6
-	pJSonWriter->WriteAttribute("name");
-	pJSonWriter->WriteStrValue(TeeInfo.m_SkinName);
+	str_copy(pInfo->m_aSkinName, TeeInfo.m_SkinName, sizeof(pInfo->m_aSkinName));
+	pInfo->m_UseCustomColor = TeeInfo.m_UseCustomColor;
+	pInfo->m_ColorBody = TeeInfo.m_ColorBody;
+	pInfo->m_ColorFeet = TeeInfo.m_ColorFeet;
 
-	if(TeeInfo.m_UseCustomColor)
-	{
-		pJSonWriter->WriteAttribute("color_body");
-		pJSonWriter->WriteIntValue(TeeInfo.m_ColorBody);
-
-		pJSonWriter->WriteAttribute("color_feet");
-		pJSonWriter->WriteIntValue(TeeInfo.m_ColorFeet);
-	}
-
-	pJSonWriter->EndObject();
-
-	pJSonWriter->WriteAttribute("afk");
-	pJSonWriter->WriteBoolValue(false);
-
-	const int Team = m_apPlayers[Id]->GetTeam() == TEAM_SPECTATORS ? -1 : GetDDRaceTeam(Id);
-
-	pJSonWriter->WriteAttribute("team");
-	pJSonWriter->WriteIntValue(Team);
+	pInfo->m_Afk = false;
+	pInfo->m_Team = m_apPlayers[Id]->GetTeam() == TEAM_SPECTATORS ? -1 : GetDDRaceTeam(Id);
+	return true;
 }
 
 void CGameContext::SendChatResponse(const char *pLine, void *pUser)
@@ -3410,9 +3327,46 @@ void CGameContext::ResetTuning()
 	Tuning()->Set("shotgun_speed", 2750);
 	Tuning()->Set("shotgun_speeddiff", 0.80);
 	Tuning()->Set("shotgun_curvature", 1.25);
+	TuningChanged(0);
 	SendTuningParams(-1);
 }
 
+void CGameContext::TuningChanged(int Zone)
+{
+	if(Zone >= 0)
+	{
+		m_aTuningVersion[Zone]++;
+		return;
+	}
+	for(auto &Version : m_aTuningVersion)
+		Version++;
+}
+
+const CTuningValues *CGameContext::TuningValues(int Zone)
+{
+	if(m_aTuningValuesVersion[Zone] != m_aTuningVersion[Zone])
+	{
+		m_aTuningValues[Zone] = CTuningValues(Zone ? m_aTuningList[Zone] : m_Tuning);
+		m_aTuningValuesVersion[Zone] = m_aTuningVersion[Zone];
+	}
+	return &m_aTuningValues[Zone];
+}
+
+const CProximateTileMap *CGameContext::ProximateTileMap(const bool *pTiles)
+{
+	bool Any = false;
+	for(int i = 0; i < 256; i++)
+		Any |= pTiles[i];
+	if(!Any)
+		return nullptr;
+
+	for(const auto &pMap : m_vpProximateTileMaps)
+		if(pMap->SameTiles(pTiles))
+			return pMap.get();
+	m_vpProximateTileMaps.push_back(std::make_unique<CProximateTileMap>(Collision(), pTiles));
+	return m_vpProximateTileMaps.back().get();
+}
+
 void CGameContext::Whisper(int ClientID, char *pStr)
 {
 	char *pName;
@@ -3803,6 +3757,10 @@ void CGameContext::UpdatePlayerMaps()
 	{
 		if(!Server()->ClientIngame(i))
 			continue;
+		// the client knows all ids
+		int MapSize = Server()->IdMapSize(i);
+		if(MapSize == MAX_CLIENTS)
+			continue;
 		int *pMap = Server()->GetIdMap(i);
 
 		// compute distances
@@ -3845,7 +3803,7 @@ void CGameContext::UpdatePlayerMaps()
 		{
 			j = -1;
 		}
-		for(int j = 0; j < VANILLA_MAX_CLIENTS; j++)
+		for(int j = 0; j < MapSize; j++)
 		{
 			if(pMap[j] == -1)
 				continue;
@@ -3855,29 +3813,29 @@ void CGameContext::UpdatePlayerMaps()
 				rMap[pMap[j]] = j;
 		}
 
-		std::nth_element(&Dist[0], &Dist[VANILLA_MAX_CLIENTS - 1], &Dist[MAX_CLIENTS], distCompare);
+		std::nth_element(&Dist[0], &Dist[MapSize - 1], &Dist[MAX_CLIENTS], distCompare);
 
 		int Mapc = 0;
 		int Demand = 0;
-		for(int j = 0; j < VANILLA_MAX_CLIENTS - 1; j++)
+		for(int j = 0; j < MapSize - 1; j++)
 		{
 			int k = Dist[j].second;
 			if(rMap[k] != -1 || Dist[j].first > 5e9)
 				continue;
-			while(Mapc < VANILLA_MAX_CLIENTS && pMap[Mapc] != -1)
+			while(Mapc < MapSize && pMap[Mapc] != -1)
 				Mapc++;
-			if(Mapc < VANILLA_MAX_CLIENTS - 1)
+			if(Mapc < MapSize - 1)
 				pMap[Mapc] = k;
 			else
 				Demand++;
 		}
-		for(int j = MAX_CLIENTS - 1; j > VANILLA_MAX_CLIENTS - 2; j--)
+		for(int j = MAX_CLIENTS - 1; j > MapSize - 2; j--)
 		{
 			int k = Dist[j].second;
 			if(rMap[k] != -1 && Demand-- > 0)
 				pMap[rMap[k]] = -1;
 		}
-		pMap[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+		pMap[MapSize - 1] = -1; // player with empty name to say chat msgs
 	}
 }
 
@@ -7,6 +7,7 @@
 #include <engine/console.h>
 #include <engine/server.h>
 #include <engine/http.h>
+#include <engine/shared/http.h>
 
 #include <game/layers.h>
 #include <game/server/teams.h>
@@ -18,8 +19,10 @@
 
 #include "gamecontroller.h"
 #include "gameworld.h"
+#include "proximatetiles.h"
 
 #include <memory>
+#include <vector>
 
 /*
 	Tick
@@ -89,12 +92,21 @@ class CGameContext : public IGameServer
 	CNetObjHandler m_NetObjHandler;
 	CTuningParams m_Tuning;
 	CTuningParams m_aTuningList[NUM_TUNEZONES];
+	// bumped by `TuningChanged`, the values of a zone are converted again
+	// when they are older than its tuning
+	int m_aTuningVersion[NUM_TUNEZONES];
+	int m_aTuningValuesVersion[NUM_TUNEZONES];
+	CTuningValues m_aTuningValues[NUM_TUNEZONES];
+	// one per set of proximate tiles of the rooms, dropped with the map
+	std::vector<std::unique_ptr<CProximateTileMap>> m_vpProximateTileMaps;
 	array<string> m_aCensorlist;
 
 	CUuid m_GameUuid;
 	CPrng m_Prng;
 
 	IHttp *m_pHttp;
+	// http results are handled on the main thread, drained in `OnTick`
+	CHttpCompletionQueue m_HttpCompletions;
 
 	static void ConTuneParam(IConsole::IResult *pResult, void *pUserData);
 	static void ConToggleTuneParam(IConsole::IResult *pResult, void *pUserData);
@@ -129,7 +141,9 @@ class CGameContext : public IGameServer
 	static void ConAddGameType(IConsole::IResult *pResult, void *pUserData);
 	static void ConAddGameTypeFile(IConsole::IResult *pResult, void *pUserData);
 	static void ConAddMapName(IConsole::IResult *pResult, void *pUserData);
+	static void ConMegaMaps(IConsole::IResult *pResult, void *pUserData);
 	static void ConRoomSetting(IConsole::IResult *pResult, void *pUserData);
+	static void ConRoomMemory(IConsole::IResult *pResult, void *pUserData);
 
 	CGameContext(int Resetting);
 	void Construct(int Resetting);
@@ -153,6 +167,14 @@ public:
 	CGameTeams *Teams() { return &m_Teams; }
 	CTuningParams *Tuning() { return &m_Tuning; }
 	CTuningParams *TuningList() { return &m_aTuningList[0]; }
+	// call after changing the tuning of a zone, -1 for all zones
+	void TuningChanged(int Zone);
+	// the converted tuning of a zone, zone 0 is `Tuning()`, the pointer
+	// stays valid and picks up later changes
+	const CTuningValues *TuningValues(int Zone);
+	// the marked map indices for the 256 `pTiles` flags, built on the first
+	// request of each set, nullptr if no tile is set
+	const CProximateTileMap *ProximateTileMap(const bool *pTiles);
 	IAntibot *Antibot() { return m_pAntibot; }
 
 	CGameContext();
@@ -227,6 +249,10 @@ public:
 	void SendTuningParams(int ClientID, int Zone = 0);
 
 	struct CVoteOptionServer *GetVoteOption(int Index);
+	// rebuild the vote options of a client or all clients (-1), only the
+	// differences to what the client has are sent
+	void ExpireVoteOptions(int ClientID = -1);
+	void SyncVoteOptions(int ClientID);
 	void ProgressVoteOptions(int ClientID);
 
 	//
@@ -275,7 +301,7 @@ public:
 	bool OnClientDDNetVersionKnown(int ClientID);
 	virtual void FillAntibot(CAntibotRoundData *pData);
 	int ProcessSpamProtection(int ClientID);
-	int GetDDRaceTeam(int ClientID);
+	virtual int GetDDRaceTeam(int ClientID);
 	// Describes the time when the first player joined the server.
 	int64 m_NonEmptySince;
 	int64 m_LastMapVote;
@@ -296,6 +322,7 @@ public:
 	void SendSkinInfo(int ClientID);
 
 	void LoginAxiom(int AxiomID, int ClientID, const char *pName);
+	void OnLoginAxiomResult(CHttpRequest *pRequest, int ClientID, uint32_t UniqueCid, bool RegisterHint);
 
 private:
 	uint32_t NextUniqueClientId = 1;
@@ -429,22 +456,22 @@ public:
 	int m_ChatResponseTargetID;
 	int m_ChatPrintCBIndex;
 
-	static int64 ms_TeamMask[3];
-	static int64 ms_SpectatorMask[MAX_CLIENTS];
-	static int64 ms_TeamSpectatorMask[2];
+	static CClientMask ms_TeamMask[3];
+	static CClientMask ms_SpectatorMask[MAX_CLIENTS];
+	static CClientMask ms_TeamSpectatorMask[2];
 
-	void OnUpdatePlayerServerInfo(class CJsonStringWriter *pJSonWriter, int Id) override;
+	bool OnUpdatePlayerServerInfo(CServerInfoPlayer *pInfo, int Id) override;
 };
 
-inline int64 CmaskAll() { return -1LL; }
-inline int64 CmaskOne(int ClientID) { return 1LL << ClientID; }
-inline int64 CmaskViewer(int ClientID) { return CGameContext::ms_SpectatorMask[ClientID]; }
-inline int64 CmaskOneAndViewer(int ClientID) { return 1LL << ClientID | CmaskViewer(ClientID); }
-inline int64 CmaskTeam(int Team) { return CGameContext::ms_TeamMask[Team + 1]; }
-inline int64 CmaskTeamViewer(int Team) { return CGameContext::ms_TeamSpectatorMask[Team]; }
-inline int64 CmaskTeamAndViewer(int Team) { return CGameContext::ms_TeamMask[Team + 1] | CmaskTeamViewer(Team); }
-inline int64 CmaskSet(int64 Mask, int ClientID) { return Mask | CmaskOne(ClientID); }
-inline int64 CmaskUnset(int64 Mask, int ClientID) { return Mask & ~CmaskOne(ClientID); }
-inline int64 CmaskAllExceptOne(int ClientID) { return ~CmaskOne(ClientID); }
-inline bool CmaskIsSet(int64 Mask, int ClientID) { return (Mask & CmaskOne(ClientID)) != 0; }
+inline CClientMask CmaskAll() { return CClientMask::All(); }
+inline CClientMask CmaskOne(int ClientID) { return CClientMask::One(ClientID); }
+inline CClientMask CmaskViewer(int ClientID) { return CGameContext::ms_SpectatorMask[ClientID]; }
+inline CClientMask CmaskOneAndViewer(int ClientID) { return CmaskOne(ClientID) | CmaskViewer(ClientID); }
+inline CClientMask CmaskTeam(int Team) { return CGameContext::ms_TeamMask[Team + 1]; }
+inline CClientMask CmaskTeamViewer(int Team) { return CGameContext::ms_TeamSpectatorMask[Team]; }
+inline CClientMask CmaskTeamAndViewer(int Team) { return CGameContext::ms_TeamMask[Team + 1] | CmaskTeamViewer(Team); }
+inline CClientMask CmaskSet(CClientMask Mask, int ClientID) { Mask.Set(ClientID); return Mask; }
+inline CClientMask CmaskUnset(CClientMask Mask, int ClientID) { Mask.Unset(ClientID); return Mask; }
+inline CClientMask CmaskAllExceptOne(int ClientID) { return CmaskUnset(CmaskAll(), ClientID); }
+inline bool CmaskIsSet(const CClientMask &Mask, int ClientID) { return Mask.IsSet(ClientID); }
 #endif
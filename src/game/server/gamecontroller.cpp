@@ -24,6 +24,8 @@
 
 #include <engine/server/server.h>
 
+#include <iterator>
+
 // MYTODO: clean up these static methods
 static void ConchainUpdateCountdown(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
@@ -309,11 +311,21 @@ static void ConChangeMap(IConsole::IResult *pResult, void *pUserData)
 	int Room = pSelf->GameWorld()->Team();
 	CGameTeams *pTeams = pSelf->GameServer()->Teams();
 	const char *pMapName = pResult->GetString(0);
-	int MapIndex = pTeams->GetMapIndex(pResult->GetString(0));
+	const CMapRegistry &Maps = pTeams->Maps();
+	int MapIndex = Maps.Find(pMapName);
+	if(MapIndex == 0)
+		MapIndex = Maps.FindPrefix(pMapName);
 	if(MapIndex == 0)
 	{
 		char aBuf[512];
 		str_format(aBuf, sizeof(aBuf), "Cannot find map '%s'", pMapName);
+		int aSuggestions[5];
+		int NumSuggestions = Maps.Suggest(pMapName, aSuggestions, std::size(aSuggestions));
+		for(int i = 0; i < NumSuggestions; i++)
+		{
+			str_append(aBuf, i == 0 ? ", did you mean " : ", ", sizeof(aBuf));
+			str_append(aBuf, Maps.Name(aSuggestions[i]), sizeof(aBuf));
+		}
 		pSelf->InstanceConsole()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "instance", aBuf);
 		return;
 	}
@@ -370,6 +382,8 @@ IGameController::IGameController()
 	m_pWorld = nullptr;
 	m_pInstanceConsole = new CConsole(CFGFLAG_INSTANCE);
 	m_MapIndex = 0;
+	mem_zero(m_aProximateTiles, sizeof(m_aProximateTiles));
+	m_pProximateTileMap = nullptr;
 
 	// balancing
 	m_aTeamSize[TEAM_RED] = 0;
@@ -474,7 +488,9 @@ IGameController::~IGameController()
 {
 	delete m_pInstanceConsole;
 	for(auto pInt : m_IntConfigStore)
-		delete pInt;
+		ArenaDelete(pInt);
+	for(auto pStr : m_StrConfigStore)
+		ArenaDelete(pStr);
 
 	delete m_pVoteOptionHeap;
 }
@@ -1061,10 +1077,8 @@ void IGameController::OnInternalPlayerJoin(CPlayer *pPlayer, int Type)
 	pPlayer->m_VotePos = 0;
 	pPlayer->m_PauseCount = 0;
 
-	// clear vote options for joining player
-	CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-	Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, pPlayer->GetCID());
-	pPlayer->m_SendVoteIndex = 0;
+	// update vote options for joining player
+	GameServer()->ExpireVoteOptions(ClientID);
 
 	if(GameServer()->m_VoteCloseTime > 0)
 		GameServer()->SendVoteSet(ClientID);
@@ -1931,12 +1945,7 @@ void IGameController::Tick()
 		{
 			CPlayer *pPlayer = GetPlayerIfInRoom(i);
 			if(pPlayer)
-			{
-				// clear vote options
-				CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-				Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, pPlayer->GetCID());
-				pPlayer->m_SendVoteIndex = 0;
-			}
+				GameServer()->ExpireVoteOptions(i);
 		}
 		m_ResendVotes = false;
 	}
@@ -2427,7 +2436,7 @@ void IGameController::EvaluateSpawnType(CSpawnEval *pEval, int Type) const
 		for(int Index = 0; Index < 5 && Result == -1; ++Index)
 		{
 			Result = Index;
-			if(!GameWorld()->m_Core.m_Tuning.m_PlayerCollision)
+			if(!GameWorld()->m_Core.m_pTuning->m_PlayerCollision)
 				break;
 			for(int c = 0; c < Num; ++c)
 			{
@@ -2660,6 +2669,7 @@ void IGameController::InitController(class CGameContext *pGameServer, class CGam
 	m_aNumSpawnPoints[1] = 0;
 	m_aNumSpawnPoints[2] = 0;
 	OnInit();
+	m_pProximateTileMap = GameServer()->ProximateTileMap(m_aProximateTiles);
 }
 
 void IGameController::CallVote(int ClientID, const char *pDesc, const char *pCmd, const char *pReason, const char *pChatmsg, const char *pSixupDesc)
@@ -13,10 +13,12 @@
 #include <map>
 #include <vector>
 
+#include "alloc.h"
+
 #define INSTANCE_CONFIG_INT(Pointer, Command, Default, Min, Max, Flag, Desc) \
 	{ \
 		*Pointer = Default; \
-		CIntVariableData *pInt = new CIntVariableData({IGameController::InstanceConsole(), Pointer, Min, Max, Default}); \
+		CIntVariableData *pInt = ArenaNew<CIntVariableData>(IGameController::InstanceConsole(), Pointer, Min, Max, Default); \
 		IGameController::m_IntConfigStore.push_back(pInt); \
 		IGameController::InstanceConsole()->Register(Command, "?i[value]", Flag, IGameController::IntVariableCommand, pInt, Desc); \
 	}
@@ -24,7 +26,7 @@
 #define INSTANCE_CONFIG_STR(Pointer, Command, Default, Flag, Desc) \
 	{ \
 		str_copy(Pointer, Default, sizeof(Pointer)); \
-		CStrVariableData *pStr = new CStrVariableData({IGameController::InstanceConsole(), Pointer, sizeof(Pointer), nullptr}); \
+		CStrVariableData *pStr = ArenaNew<CStrVariableData>(IGameController::InstanceConsole(), Pointer, (int)sizeof(Pointer), nullptr); \
 		m_StrConfigStore.push_back(pStr); \
 		IGameController::InstanceConsole()->Register(Command, "?r[value]", Flag, IGameController::StrVariableCommand, pStr, Desc); \
 	}
@@ -94,6 +96,8 @@ enum
 */
 class IGameController
 {
+	MACRO_ALLOC_HEAP()
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -119,6 +123,10 @@ class IGameController
 	void FakeClientBroadcast(int SnappingClient);
 	void FakeGameMsgSound(int SnappingClient, int SoundID);
 
+	bool m_aProximateTiles[256];
+	// shared with the rooms that declare the same tiles, nullptr if none
+	const class CProximateTileMap *m_pProximateTileMap;
+
 protected:
 	bool m_Started;
 
@@ -269,6 +277,10 @@ protected:
 	// default to: 0
 	int m_DDNetInfoFlag2;
 
+	// declares a tile handled by OnCharacterProximateTile, call it from the
+	// constructor, the hook is only called near these tiles
+	void AddProximateTile(int Tile) { m_aProximateTiles[Tile] = true; }
+
 public:
 	IGameController();
 	virtual ~IGameController();
@@ -745,6 +757,7 @@ public:
 		Function: OnCharacterProximateTile
 			Called when a CCharacter proximate a tile.
 			Only the discrete position is checked.
+			Only called for the tiles declared with AddProximateTile.
 			Account for ProximityRadius, but the tile may be skipped due to high speed or ninja.
 
 		Arguments:
@@ -757,6 +770,7 @@ public:
 				if set to true
 	*/
 	virtual bool OnCharacterProximateTile(class CCharacter *pChr, int MapIndex) { return false; };
+	const class CProximateTileMap *ProximateTileMap() const { return m_pProximateTileMap; }
 
 	/*
 		Function: OnEntity
@@ -7,6 +7,7 @@
 #include <game/server/player.h>
 #include <game/server/weapons.h>
 
+#include <game/server/catchchains.h>
 #include <game/server/entities/dumbentity.h>
 #include <game/server/gamecontroller.h>
 
@@ -18,47 +19,85 @@ private:
 	int m_WinnerBonus;
 	int m_MinimumPlayers;
 
+	// hearts are created once per client and reused, the controller snaps
+	// them itself instead of inserting them into the world
+	struct CHeart
+	{
+		class CDumbEntity *m_pEntity = nullptr;
+		int m_SnapID = -1;
+	};
+
 	// states
-	int m_aCaughtBy[MAX_CLIENTS];
-	int m_aNumCaught[MAX_CLIENTS];
-	class CDumbEntity *m_apHearts[MAX_CLIENTS];
-	int m_aHeartID[MAX_CLIENTS];
+	CCatchChains<CHeart> m_Chains;
+	bool m_aHeartActive[MAX_CLIENTS];
 	int m_aHeartKillTick[MAX_CLIENTS];
 
-	struct Path
+	// the recent points of every character's path, the hearts follow them
+	enum
 	{
-		vec2 m_aPathPoints[MAX_CLIENTS];
-		int m_PathIndex;
+		NUM_PATH_POINTS = MAX_CLIENTS,
+	};
+	static_assert((NUM_PATH_POINTS & (NUM_PATH_POINTS - 1)) == 0, "the path is indexed with a mask");
 
-		int Prev(int Num) { return (m_PathIndex + MAX_CLIENTS - Num) % MAX_CLIENTS; }
-		int Next(int Num) { return (m_PathIndex + Num) % MAX_CLIENTS; }
-		int Index() { return Prev(1); }
-		vec2 LatestPoint() { return m_aPathPoints[Index()]; }
-		vec2 PrevPoint(int Num) { return m_aPathPoints[Prev(Num + 1)]; }
+	vec2 m_aaPathPoints[MAX_CLIENTS][NUM_PATH_POINTS];
+	unsigned m_aPathIndex[MAX_CLIENTS];
 
-		Path() { m_PathIndex = 0; }
+	vec2 LatestPoint(int ClientID) const { return PrevPoint(ClientID, 0); }
+	vec2 PrevPoint(int ClientID, int Num) const { return m_aaPathPoints[ClientID][(m_aPathIndex[ClientID] - 1 - Num) & (NUM_PATH_POINTS - 1)]; }
 
-		void Init(vec2 Point)
-		{
-			for(auto &P : m_aPathPoints)
-				P = Point;
-		}
+	void InitPath(int ClientID, vec2 Point)
+	{
+		for(auto &P : m_aaPathPoints[ClientID])
+			P = Point;
+	}
 
-		void RecordPoint(vec2 Point)
-		{
-			m_aPathPoints[m_PathIndex] = Point;
-			m_PathIndex = Next(1);
-		}
-	};
+	void RecordPoint(int ClientID, vec2 Point)
+	{
+		m_aaPathPoints[ClientID][m_aPathIndex[ClientID] & (NUM_PATH_POINTS - 1)] = Point;
+		m_aPathIndex[ClientID]++;
+	}
 
 	// path
-	Path m_aCharPath[MAX_CLIENTS];
 	vec2 m_aLastPosition[MAX_CLIENTS];
 	float m_aCharInertia[MAX_CLIENTS];
 	float m_aCharMoveDist[MAX_CLIENTS];
 
+	void ReleaseChain(int By)
+	{
+		for(int i = m_Chains.First(By); i != -1;)
+		{
+			int Next = m_Chains.Next(i);
+			CPlayer *pPlayer = this->GetPlayerIfInRoom(i);
+			if(pPlayer)
+				Release(pPlayer, true);
+			i = Next;
+		}
+	}
+
+	void ResetHearts()
+	{
+		m_Chains.Reset();
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aHeartActive[i] = false;
+			m_aHeartKillTick[i] = -1;
+		}
+	}
+
 public:
 	CGameControllerCatch();
+	~CGameControllerCatch()
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			CHeart &Heart = m_Chains.Heart(i);
+			if(Heart.m_pEntity)
+			{
+				delete Heart.m_pEntity;
+				this->Server()->SnapFreeID(Heart.m_SnapID);
+			}
+		}
+	}
 
 	void RegisterConfig()
 	{
@@ -79,70 +118,40 @@ public:
 		// catch by top player
 		if(TopPlayer)
 		{
-			vec2 Pos = m_aCharPath[TopPlayer->GetCID()].PrevPoint(m_aNumCaught[TopPlayer->GetCID()]);
+			vec2 Pos = PrevPoint(TopPlayer->GetCID(), m_Chains.NumCaught(TopPlayer->GetCID()));
 			Catch(pVictim, TopPlayer, Pos);
 		}
 	}
 
 	void Catch(class CPlayer *pVictim, class CPlayer *pBy, vec2 Pos)
 	{
-		if(m_aCaughtBy[pVictim->GetCID()] != -1)
+		int ClientID = pVictim->GetCID();
+		if(!m_Chains.Catch(ClientID, pBy->GetCID()))
 			return;
 
-		if(m_apHearts[pVictim->GetCID()])
+		CHeart &Heart = m_Chains.Heart(ClientID);
+		if(!Heart.m_pEntity)
 		{
-			m_apHearts[pVictim->GetCID()]->Destroy();
-			m_apHearts[pVictim->GetCID()] = nullptr;
-			m_aHeartKillTick[pVictim->GetCID()] = -1;
+			Heart.m_pEntity = new CDumbEntity(this->GameWorld(), CDumbEntity::TYPE_HEART | CDumbEntity::FLAG_MANUAL, Pos);
+			Heart.m_SnapID = this->Server()->SnapNewID();
 		}
-
-		m_apHearts[pVictim->GetCID()] = new CDumbEntity(this->GameWorld(), CDumbEntity::TYPE_HEART, Pos);
-		m_aHeartID[pVictim->GetCID()] = m_aNumCaught[pBy->GetCID()];
-		m_aNumCaught[pBy->GetCID()]++;
-
-		m_aCaughtBy[pVictim->GetCID()] = pBy->GetCID();
+		Heart.m_pEntity->TeleportTo(Pos);
+		m_aHeartActive[ClientID] = true;
+		m_aHeartKillTick[ClientID] = -1;
 	}
 
 	void Release(class CPlayer *pPlayer, bool IsKillRelease)
 	{
-		if(m_aCaughtBy[pPlayer->GetCID()] == -1)
+		int ClientID = pPlayer->GetCID();
+		// the heart stays for the kill animation, else the last caught
+		// player takes it over and the last heart goes
+		if(m_Chains.Release(ClientID, IsKillRelease) == -1)
 			return;
 
-		int By = m_aCaughtBy[pPlayer->GetCID()];
-
-		m_aNumCaught[By]--;
-		m_aCaughtBy[pPlayer->GetCID()] = -1;
-
 		if(IsKillRelease)
-		{
-			// do heart kill animation
-			m_aHeartKillTick[pPlayer->GetCID()] = this->Server()->Tick() + (m_aHeartID[pPlayer->GetCID()] + 1) * 2;
-		}
+			m_aHeartKillTick[ClientID] = this->Server()->Tick() + (m_Chains.HeartID(ClientID) + 1) * 2;
 		else
-		{
-			// remove last heart
-			int LastHeartID = m_aNumCaught[By];
-
-			// find the last heart
-			int WhoHasLastHeart = pPlayer->GetCID();
-			for(int i = 0; i < MAX_CLIENTS; i++)
-			{
-				if(m_aCaughtBy[i] != By)
-					continue;
-
-				if(m_aHeartID[i] == LastHeartID)
-				{
-					WhoHasLastHeart = i;
-					break;
-				}
-			}
-
-			m_apHearts[WhoHasLastHeart]->Destroy();
-			m_apHearts[WhoHasLastHeart] = m_apHearts[pPlayer->GetCID()];
-			m_aHeartID[WhoHasLastHeart] = m_aHeartID[pPlayer->GetCID()];
-			m_apHearts[pPlayer->GetCID()] = nullptr;
-			m_aHeartID[pPlayer->GetCID()] = -1;
-		}
+			m_aHeartActive[ClientID] = false;
 
 		pPlayer->m_RespawnDisabled = false;
 		pPlayer->m_RespawnTick = this->Server()->Tick() + this->Server()->TickSpeed();
@@ -154,15 +163,9 @@ public:
 	{
 		T::OnInit();
 
-		mem_zero(m_apHearts, sizeof(m_apHearts));
 		mem_zero(m_aCharMoveDist, sizeof(m_aCharMoveDist));
-		mem_zero(m_aNumCaught, sizeof(m_aNumCaught));
-
-		for(int i = 0; i < MAX_CLIENTS; i++)
-		{
-			m_aCaughtBy[i] = -1;
-			m_aHeartKillTick[i] = -1;
-		}
+		mem_zero(m_aPathIndex, sizeof(m_aPathIndex));
+		ResetHearts();
 	}
 
 	virtual void OnPreTick() override
@@ -183,7 +186,7 @@ public:
 				vec2 DeltaPos = pChar->GetPos() - m_aLastPosition[i];
 				m_aLastPosition[i] = pChar->GetPos();
 
-				vec2 LastPoint = m_aCharPath[i].LatestPoint();
+				vec2 LastPoint = LatestPoint(i);
 				vec2 Dir = normalize(pChar->GetPos() - LastPoint);
 
 				if(fabs(length(DeltaPos)) < 1e-6)
@@ -204,37 +207,39 @@ public:
 					m_aCharMoveDist[i] -= PointDist;
 					Iteration++;
 					vec2 Point = LastPoint + Dir * PointDist * Iteration;
-					m_aCharPath[i].RecordPoint(Point);
+					RecordPoint(i, Point);
 				}
 			}
 		}
 
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			if(m_apHearts[i])
+			if(m_aHeartActive[i])
 			{
 				if(m_aHeartKillTick[i] != -1 && m_aHeartKillTick[i] < this->Server()->Tick())
 				{
-					this->GameWorld()->CreateSound(m_apHearts[i]->GetPos(), SOUND_PLAYER_DIE);
-					this->GameWorld()->CreateDeath(m_apHearts[i]->GetPos(), i);
-					m_apHearts[i]->Destroy();
-					m_apHearts[i] = nullptr;
-					m_aHeartID[i] = -1;
+					CDumbEntity *pHeart = m_Chains.Heart(i).m_pEntity;
+					this->GameWorld()->CreateSound(pHeart->GetPos(), SOUND_PLAYER_DIE);
+					this->GameWorld()->CreateDeath(pHeart->GetPos(), i);
+					m_aHeartActive[i] = false;
+					m_Chains.ClearHeartID(i);
 					m_aHeartKillTick[i] = -1;
 					continue;
 				}
 
-				int CaughtBy = m_aCaughtBy[i];
+				int CaughtBy = m_Chains.CaughtBy(i);
 				CPlayer *pPlayer = this->GetPlayerIfInRoom(CaughtBy);
 				if(pPlayer && pPlayer->GetCharacter() && pPlayer->GetCharacter()->IsAlive())
 				{
 					float Interp = m_aCharMoveDist[CaughtBy] / PointDist;
-					vec2 Point = m_aCharPath[CaughtBy].PrevPoint(m_aHeartID[i]);
-					vec2 PrevPoint = m_aCharPath[CaughtBy].PrevPoint(m_aHeartID[i] + 1);
-					vec2 TargetPos = mix(PrevPoint, Point, Interp);
-					float Rate = 1.0f - (m_aHeartID[i] / (32.0f + 16.0f));
-					vec2 Pos = mix(m_apHearts[i]->m_Pos, TargetPos, (25.0f * Rate * Rate / (float)this->Server()->TickSpeed()));
-					m_apHearts[i]->MoveTo(Pos);
+					int HeartID = m_Chains.HeartID(i);
+					CDumbEntity *pHeart = m_Chains.Heart(i).m_pEntity;
+					vec2 Point = PrevPoint(CaughtBy, HeartID);
+					vec2 Prev = PrevPoint(CaughtBy, HeartID + 1);
+					vec2 TargetPos = mix(Prev, Point, Interp);
+					float Rate = 1.0f - (HeartID / (32.0f + 16.0f));
+					vec2 Pos = mix(pHeart->m_Pos, TargetPos, (25.0f * Rate * Rate / (float)this->Server()->TickSpeed()));
+					pHeart->MoveTo(Pos);
 				}
 			}
 		}
@@ -244,16 +249,18 @@ public:
 	{
 		T::OnWorldReset();
 
+		ResetHearts();
+	}
+
+	virtual void OnSnap(int SnappingClient) override
+	{
+		T::OnSnap(SnappingClient);
+
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
-			m_aCaughtBy[i] = -1;
-			m_aNumCaught[i] = 0;
-			m_aHeartKillTick[i] = -1;
-			if(m_apHearts[i])
-			{
-				m_apHearts[i]->Destroy();
-				m_apHearts[i] = nullptr;
-			}
+			const CHeart &Heart = m_Chains.Heart(i);
+			if(m_aHeartActive[i] && !NetworkPointClipped(this->GameServer(), SnappingClient, Heart.m_pEntity->GetPos()))
+				Heart.m_pEntity->DoSnap(Heart.m_SnapID, SnappingClient);
 		}
 	}
 
@@ -263,14 +270,9 @@ public:
 
 		int ClientID = pPlayer->GetCID();
 
-		if(m_aNumCaught[ClientID] > 0)
+		if(m_Chains.NumCaught(ClientID) > 0)
 		{
-			for(int i = 0; i < MAX_CLIENTS; ++i)
-			{
-				CPlayer *pPlayer = this->GetPlayerIfInRoom(i);
-				if(pPlayer && m_aCaughtBy[pPlayer->GetCID()] == ClientID)
-					Release(pPlayer, true);
-			}
+			ReleaseChain(ClientID);
 
 			char aBuf[128];
 			str_format(aBuf, sizeof(aBuf), "'%s' released.", this->Server()->ClientName(ClientID));
@@ -298,15 +300,14 @@ public:
 
 	virtual bool OnPlayerTryRespawn(class CPlayer *pPlayer, vec2 Pos) override
 	{
-		if(m_aCaughtBy[pPlayer->GetCID()] == -1)
+		int By = m_Chains.CaughtBy(pPlayer->GetCID());
+		if(By == -1)
 			return true;
 
-		int By = m_aCaughtBy[pPlayer->GetCID()];
 		CPlayer *pKiller = this->GetPlayerIfInRoom(By);
-
 		if(!pKiller || !pKiller->GetCharacter() || !pKiller->GetCharacter()->IsAlive())
 		{
-			m_aCaughtBy[pPlayer->GetCID()] = -1;
+			m_Chains.Release(pPlayer->GetCID(), true);
 			return true;
 		}
 
@@ -331,7 +332,7 @@ public:
 		int ClientID = pChr->GetPlayer()->GetCID();
 		m_aLastPosition[ClientID] = pChr->GetPos();
 		m_aCharMoveDist[ClientID] = 0;
-		m_aCharPath[ClientID].Init(pChr->GetPos());
+		InitPath(ClientID, pChr->GetPos());
 		m_aCharInertia[ClientID] = 20.0f;
 	}
 
@@ -341,14 +342,7 @@ public:
 		if(this->IsWarmup())
 			return DEATH_NORMAL;
 
-		for(int i = 0; i < MAX_CLIENTS; i++)
-		{
-			CPlayer *pPlayer = this->GetPlayerIfInRoom(i);
-			if(pPlayer && m_aCaughtBy[pPlayer->GetCID()] == pVictim->GetPlayer()->GetCID())
-			{
-				Release(pPlayer, true);
-			}
-		}
+		ReleaseChain(pVictim->GetPlayer()->GetCID());
 
 		// allow respawn, only check caught status on respawn (handles mutual kills)
 		pVictim->GetPlayer()->m_RespawnDisabled = false;
@@ -368,7 +362,7 @@ public:
 
 	virtual bool CanDeadPlayerFollow(const class CPlayer *pSpectator, const class CPlayer *pTarget) override
 	{
-		return m_aCaughtBy[pSpectator->GetCID()] == pTarget->GetCID();
+		return m_Chains.CaughtBy(pSpectator->GetCID()) == pTarget->GetCID();
 	}
 
 	virtual void DoWincheckMatch() override
@@ -402,12 +396,7 @@ public:
 			}
 			else
 			{
-				for(int i = 0; i < MAX_CLIENTS; ++i)
-				{
-					CPlayer *pPlayer = this->GetPlayerIfInRoom(i);
-					if(pPlayer && m_aCaughtBy[pPlayer->GetCID()] == pAlivePlayer->GetCID())
-						Release(pPlayer, true);
-				}
+				ReleaseChain(pAlivePlayer->GetCID());
 			}
 		}
 
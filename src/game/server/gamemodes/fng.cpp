@@ -10,6 +10,13 @@ CGameControllerSoloFNG::CGameControllerSoloFNG()
 	m_pGameType = "solofng";
 	m_DDNetInfoFlag |= GAMEINFOFLAG_PREDICT_FNG | GAMEINFOFLAG_ENTITIES_FNG;
 
+	AddProximateTile(TILE_SPIKE_GOLD);
+	AddProximateTile(TILE_SPIKE_NORMAL);
+	AddProximateTile(TILE_SPIKE_TEAM_RED);
+	AddProximateTile(TILE_SPIKE_TEAM_BLUE);
+	AddProximateTile(TILE_SPIKE_GREEN);
+	AddProximateTile(TILE_SPIKE_PURPLE);
+
 	INSTANCE_CONFIG_INT(&m_HammerScaleX, "hammer_scale_x", 320, 0, 1000, CFGFLAG_CHAT | CFGFLAG_INSTANCE, "linearly scale up hammer x power, percentage, for hammering enemies and unfrozen teammates")
 	INSTANCE_CONFIG_INT(&m_HammerScaleY, "hammer_scale_y", 120, 0, 1000, CFGFLAG_CHAT | CFGFLAG_INSTANCE, "linearly scale up hammer y power, percentage, for hammering enemies and unfrozen teammates")
 	INSTANCE_CONFIG_INT(&m_MeltHammerScaleX, "melt_hammer_scale_x", 50, 0, 1000, CFGFLAG_CHAT | CFGFLAG_INSTANCE, "linearly scale up hammer x power, percentage, for hammering frozen teammates")
@@ -27,6 +27,10 @@ CGameWorld::CGameWorld(int Team, CGameContext *pGameServer, IGameController *pCo
 	m_ResetRequested = false;
 	for(auto &pFirstEntityType : m_apFirstEntityTypes)
 		pFirstEntityType = 0;
+
+	m_SnapGrid.Init(m_pGameServer->Collision()->GetWidth() * 32.0f, m_pGameServer->Collision()->GetHeight() * 32.0f);
+	m_SnapGridTick = -1;
+	m_SnapGridValid = false;
 }
 
 CGameWorld::~CGameWorld()
@@ -105,6 +109,7 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = 0x0;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+	m_SnapGridValid = false;
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
@@ -127,18 +132,69 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = 0;
 	pEnt->m_pPrevTypeEntity = 0;
+	m_SnapGridValid = false;
+
+	// a snap may be going on, it skips the entity
+	if(pEnt->m_SnapItem >= 0 && pEnt->m_SnapItem < (int)m_vpSnapEntities.size() && m_vpSnapEntities[pEnt->m_SnapItem] == pEnt)
+		m_vpSnapEntities[pEnt->m_SnapItem] = nullptr;
+	pEnt->m_SnapItem = -1;
+}
+
+void CGameWorld::UpdateSnapGrid()
+{
+	if(m_SnapGridValid && m_SnapGridTick == Server()->Tick())
+		return;
+
+	m_SnapGrid.Clear();
+	m_vpSnapEntities.clear();
+	for(auto *pEnt : m_apFirstEntityTypes)
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			int Item = m_vpSnapEntities.size();
+			m_vpSnapEntities.push_back(pEnt);
+			pEnt->m_SnapItem = Item;
+			// custom snaps can show clipped entities
+			if(pEnt->m_OnSnap)
+			{
+				m_SnapGrid.AddAlways(Item);
+				continue;
+			}
+			vec2 TL, BR;
+			pEnt->NetworkBounds(&TL, &BR);
+			m_SnapGrid.Add(Item, TL, BR);
+		}
+	m_SnapGridTick = Server()->Tick();
+	m_SnapGridValid = true;
 }
 
 //
 void CGameWorld::Snap(int SnappingClient, int OtherMode)
 {
-	for(auto *pEnt : m_apFirstEntityTypes)
-		for(; pEnt;)
+	if(SnappingClient == -1)
+	{
+		for(auto *pEnt : m_apFirstEntityTypes)
+			for(; pEnt;)
+			{
+				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				pEnt->InternalSnap(SnappingClient, OtherMode);
+				pEnt = m_pNextTraverseEntity;
+			}
+	}
+	else
+	{
+		// only the entities near the view of the client, in list order
+		UpdateSnapGrid();
+		vec2 TL, BR;
+		NetworkView(GameServer(), SnappingClient, &TL, &BR);
+		m_SnapGrid.Query(TL, BR, &m_vSnapItems);
+		for(int Item : m_vSnapItems)
 		{
-			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->InternalSnap(SnappingClient, OtherMode);
-			pEnt = m_pNextTraverseEntity;
+			// removed while snapping
+			if(!m_vpSnapEntities[Item])
+				continue;
+			m_vpSnapEntities[Item]->InternalSnap(SnappingClient, OtherMode);
 		}
+	}
 
 	if(OtherMode != 1) // Enable all for 0 and enable distracting for 2
 		m_Events.Snap(SnappingClient);
@@ -329,7 +385,7 @@ void CGameWorld::ReleaseHooked(int ClientID)
 	}
 }
 
-void CGameWorld::CreateDamageIndCircle(vec2 Pos, bool Clockwise, float Angle, int Amount, int Total, float RadiusScale, int64 Mask)
+void CGameWorld::CreateDamageIndCircle(vec2 Pos, bool Clockwise, float Angle, int Amount, int Total, float RadiusScale, CClientMask Mask)
 {
 	float s = 3 * pi / 2 + Angle;
 	float e = s + 2 * pi;
@@ -348,7 +404,7 @@ void CGameWorld::CreateDamageIndCircle(vec2 Pos, bool Clockwise, float Angle, in
 	}
 }
 
-void CGameWorld::CreateDamageInd(vec2 Pos, float Angle, int Amount, int64 Mask)
+void CGameWorld::CreateDamageInd(vec2 Pos, float Angle, int Amount, CClientMask Mask)
 {
 	float a = 3 * pi / 2 + Angle;
 	int s = round_to_int((a - pi / 3) * 256.0f);
@@ -366,7 +422,7 @@ void CGameWorld::CreateDamageInd(vec2 Pos, float Angle, int Amount, int64 Mask)
 	}
 }
 
-void CGameWorld::CreateHammerHit(vec2 Pos, int64 Mask)
+void CGameWorld::CreateHammerHit(vec2 Pos, CClientMask Mask)
 {
 	// create the event
 	CNetEvent_HammerHit *pEvent = (CNetEvent_HammerHit *)m_Events.Create(NETEVENTTYPE_HAMMERHIT, sizeof(CNetEvent_HammerHit), Mask);
@@ -377,7 +433,7 @@ void CGameWorld::CreateHammerHit(vec2 Pos, int64 Mask)
 	}
 }
 
-void CGameWorld::CreateExplosionParticle(vec2 Pos, int64 Mask)
+void CGameWorld::CreateExplosionParticle(vec2 Pos, CClientMask Mask)
 {
 	CNetEvent_Explosion *pEvent = (CNetEvent_Explosion *)m_Events.Create(NETEVENTTYPE_EXPLOSION, sizeof(CNetEvent_Explosion), Mask);
 	if(pEvent)
@@ -387,7 +443,7 @@ void CGameWorld::CreateExplosionParticle(vec2 Pos, int64 Mask)
 	}
 }
 
-void CGameWorld::CreateExplosion(vec2 Pos, int Owner, int Weapon, int WeaponID, int MaxDamage, bool NoKnockback, int64 Mask)
+void CGameWorld::CreateExplosion(vec2 Pos, int Owner, int Weapon, int WeaponID, int MaxDamage, bool NoKnockback, CClientMask Mask)
 {
 	// create the event
 	CreateExplosionParticle(Pos, Mask);
@@ -424,7 +480,7 @@ void CGameWorld::CreateExplosion(vec2 Pos, int Owner, int Weapon, int WeaponID,
 	}
 }
 
-void CGameWorld::CreatePlayerSpawn(vec2 Pos, int64 Mask)
+void CGameWorld::CreatePlayerSpawn(vec2 Pos, CClientMask Mask)
 {
 	// create the event
 	CNetEvent_Spawn *ev = (CNetEvent_Spawn *)m_Events.Create(NETEVENTTYPE_SPAWN, sizeof(CNetEvent_Spawn), Mask);
@@ -435,7 +491,7 @@ void CGameWorld::CreatePlayerSpawn(vec2 Pos, int64 Mask)
 	}
 }
 
-void CGameWorld::CreateDeath(vec2 Pos, int ClientID, int64 Mask)
+void CGameWorld::CreateDeath(vec2 Pos, int ClientID, CClientMask Mask)
 {
 	// create the event
 	CNetEvent_Death *pEvent = (CNetEvent_Death *)m_Events.Create(NETEVENTTYPE_DEATH, sizeof(CNetEvent_Death), Mask);
@@ -447,7 +503,7 @@ void CGameWorld::CreateDeath(vec2 Pos, int ClientID, int64 Mask)
 	}
 }
 
-void CGameWorld::CreateSound(vec2 Pos, int Sound, int64 Mask)
+void CGameWorld::CreateSound(vec2 Pos, int Sound, CClientMask Mask)
 {
 	if(Sound < 0)
 		return;
@@ -462,7 +518,7 @@ void CGameWorld::CreateSound(vec2 Pos, int Sound, int64 Mask)
 	}
 }
 
-void CGameWorld::CreateSoundGlobal(int Sound, int64 Mask)
+void CGameWorld::CreateSoundGlobal(int Sound, CClientMask Mask)
 {
 	if(Sound < 0)
 		return;
@@ -3,10 +3,13 @@
 #ifndef GAME_SERVER_GAMEWORLD_H
 #define GAME_SERVER_GAMEWORLD_H
 
+#include "alloc.h"
 #include "eventhandler.h"
+#include "snapgrid.h"
 #include <game/gamecore.h>
 
 #include <list>
+#include <vector>
 
 class CEntity;
 class CCharacter;
@@ -18,6 +21,8 @@ class CCharacter;
 */
 class CGameWorld
 {
+	MACRO_ALLOC_HEAP()
+
 public:
 	enum
 	{
@@ -44,6 +49,16 @@ private:
 	CEntity *m_pNextTraverseEntity;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// the entities by their network bounds, built by the first snap of a
+	// tick and dropped when an entity is inserted or removed. Removed
+	// entities are cleared from the list, a snap in progress skips them
+	CSnapGrid m_SnapGrid;
+	std::vector<CEntity *> m_vpSnapEntities;
+	std::vector<int> m_vSnapItems;
+	int m_SnapGridTick;
+	bool m_SnapGridValid;
+	void UpdateSnapGrid();
+
 	class CGameContext *m_pGameServer;
 	class IGameController *m_pController;
 	class CConfig *m_pConfig;
@@ -187,15 +202,15 @@ public:
 	std::list<class CCharacter *> IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, class CEntity *pNotThis = 0, bool IgnoreSolo = true);
 
 	// helper functions
-	void CreateDamageIndCircle(vec2 Pos, bool Clockwise, float AngleMod, int Amount, int Total, float RadiusScale = 1.0f, int64 Mask = -1LL);
-	void CreateDamageInd(vec2 Pos, float AngleMod, int Amount, int64 Mask = -1LL);
-	void CreateExplosionParticle(vec2 Pos, int64 Mask = -1LL);
-	void CreateExplosion(vec2 Pos, int Owner, int Weapon, int WeaponType, int Damage, bool NoKnockback, int64 Mask = -1LL);
-	void CreateHammerHit(vec2 Pos, int64 Mask = -1LL);
-	void CreatePlayerSpawn(vec2 Pos, int64 Mask = -1LL);
-	void CreateDeath(vec2 Pos, int Who, int64 Mask = -1LL);
-	void CreateSound(vec2 Pos, int Sound, int64 Mask = -1LL);
-	void CreateSoundGlobal(int Sound, int64 Mask = -1LL);
+	void CreateDamageIndCircle(vec2 Pos, bool Clockwise, float AngleMod, int Amount, int Total, float RadiusScale = 1.0f, CClientMask Mask = CClientMask::All());
+	void CreateDamageInd(vec2 Pos, float AngleMod, int Amount, CClientMask Mask = CClientMask::All());
+	void CreateExplosionParticle(vec2 Pos, CClientMask Mask = CClientMask::All());
+	void CreateExplosion(vec2 Pos, int Owner, int Weapon, int WeaponType, int Damage, bool NoKnockback, CClientMask Mask = CClientMask::All());
+	void CreateHammerHit(vec2 Pos, CClientMask Mask = CClientMask::All());
+	void CreatePlayerSpawn(vec2 Pos, CClientMask Mask = CClientMask::All());
+	void CreateDeath(vec2 Pos, int Who, CClientMask Mask = CClientMask::All());
+	void CreateSound(vec2 Pos, int Sound, CClientMask Mask = CClientMask::All());
+	void CreateSoundGlobal(int Sound, CClientMask Mask = CClientMask::All());
 };
 
 #endif
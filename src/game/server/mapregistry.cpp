@@ -0,0 +1,167 @@
+#include "mapregistry.h"
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/mapitems.h>
+
+#include <algorithm>
+#include <iterator>
+
+std::string CMapRegistry::FoldName(const char *pName)
+{
+	std::string Folded;
+	char aBuf[4];
+	int Code;
+	while((Code = str_utf8_decode(&pName)))
+	{
+		if(Code < 0)
+			continue;
+		Folded.append(aBuf, str_utf8_encode(aBuf, str_utf8_tolower(Code)));
+	}
+	return Folded;
+}
+
+// edits and swaps of neighbouring characters, bails out once the distance
+// is above `Max`
+static int EditDistance(const std::string &a, const std::string &b, int Max)
+{
+	if(absolute((int)a.size() - (int)b.size()) > Max)
+		return Max + 1;
+
+	std::vector<int> vPrevPrev(b.size() + 1);
+	std::vector<int> vPrev(b.size() + 1);
+	std::vector<int> vCur(b.size() + 1);
+	for(int j = 0; j <= (int)b.size(); j++)
+		vPrev[j] = j;
+	for(int i = 1; i <= (int)a.size(); i++)
+	{
+		vCur[0] = i;
+		int RowMin = i;
+		for(int j = 1; j <= (int)b.size(); j++)
+		{
+			int Cost = a[i - 1] == b[j - 1] ? 0 : 1;
+			vCur[j] = minimum(vPrev[j] + 1, vCur[j - 1] + 1, vPrev[j - 1] + Cost);
+			if(i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+				vCur[j] = minimum(vCur[j], vPrevPrev[j - 2] + 1);
+			RowMin = minimum(RowMin, vCur[j]);
+		}
+		if(RowMin > Max)
+			return Max + 1;
+		std::swap(vPrevPrev, vPrev);
+		std::swap(vPrev, vCur);
+	}
+	return vPrev[b.size()];
+}
+
+void CMapRegistry::Clear()
+{
+	m_vMaps.clear();
+	m_NumNamed = 0;
+	m_NameIndex.clear();
+	m_vSorted.clear();
+}
+
+CMapRegistry::CMapInfo *CMapRegistry::Touch(int Index)
+{
+	if(Index <= 0 || Index > MAX_MAPS)
+		return nullptr;
+	if(Index > (int)m_vMaps.size())
+		m_vMaps.resize(Index);
+	return &m_vMaps[Index - 1];
+}
+
+int CMapRegistry::Add(const char *pName)
+{
+	CMapInfo *pInfo = Touch(m_NumNamed + 1);
+	if(!pInfo)
+		return 0;
+	int Index = ++m_NumNamed;
+	pInfo->m_Name = pName;
+
+	// the first of two maps with the same name wins
+	std::string Folded = FoldName(pName);
+	if(m_NameIndex.emplace(Folded, Index).second)
+	{
+		std::pair<std::string, int> Entry(std::move(Folded), Index);
+		m_vSorted.insert(std::upper_bound(m_vSorted.begin(), m_vSorted.end(), Entry), std::move(Entry));
+	}
+	return Index;
+}
+
+int CMapRegistry::Find(const char *pName) const
+{
+	auto It = m_NameIndex.find(FoldName(pName));
+	return It == m_NameIndex.end() ? 0 : It->second;
+}
+
+int CMapRegistry::FindPrefix(const char *pPrefix) const
+{
+	std::string Folded = FoldName(pPrefix);
+	if(Folded.empty())
+		return 0;
+	auto It = std::lower_bound(m_vSorted.begin(), m_vSorted.end(), std::make_pair(Folded, 0));
+	if(It == m_vSorted.end() || It->first.compare(0, Folded.size(), Folded) != 0)
+		return 0;
+	auto Next = std::next(It);
+	if(Next != m_vSorted.end() && Next->first.compare(0, Folded.size(), Folded) == 0)
+		return 0;
+	return It->second;
+}
+
+int CMapRegistry::Suggest(const char *pName, int *pIndices, int Max) const
+{
+	std::string Folded = FoldName(pName);
+	int Num = 0;
+	if(Folded.empty())
+		return 0;
+
+	auto It = std::lower_bound(m_vSorted.begin(), m_vSorted.end(), std::make_pair(Folded, 0));
+	for(; It != m_vSorted.end() && Num < Max && It->first.compare(0, Folded.size(), Folded) == 0; ++It)
+		pIndices[Num++] = It->second;
+
+	// a typo per three characters
+	int MaxDistance = maximum(1, (int)Folded.size() / 3);
+	std::vector<std::pair<int, int>> vClose;
+	for(const auto &Entry : m_vSorted)
+	{
+		if(Entry.first.compare(0, Folded.size(), Folded) == 0)
+			continue;
+		int Distance = EditDistance(Folded, Entry.first, MaxDistance);
+		if(Distance <= MaxDistance)
+			vClose.emplace_back(Distance, Entry.second);
+	}
+	std::sort(vClose.begin(), vClose.end());
+	for(int i = 0; i < (int)vClose.size() && Num < Max; i++)
+		pIndices[Num++] = vClose[i].second;
+	return Num;
+}
+
+void CMapRegistry::OnTile(int Index, int x, int y)
+{
+	CMapInfo *pInfo = Touch(Index);
+	if(!pInfo)
+		return;
+	if(pInfo->m_NumTiles == 0)
+	{
+		pInfo->m_MinX = pInfo->m_MaxX = x;
+		pInfo->m_MinY = pInfo->m_MaxY = y;
+	}
+	else
+	{
+		pInfo->m_MinX = minimum(pInfo->m_MinX, x);
+		pInfo->m_MinY = minimum(pInfo->m_MinY, y);
+		pInfo->m_MaxX = maximum(pInfo->m_MaxX, x);
+		pInfo->m_MaxY = maximum(pInfo->m_MaxY, y);
+	}
+	pInfo->m_NumTiles++;
+}
+
+void CMapRegistry::OnEntity(int Index, int EntityIndex, int Type)
+{
+	CMapInfo *pInfo = Touch(Index);
+	if(!pInfo)
+		return;
+	pInfo->m_vEntities.push_back(EntityIndex);
+	if(Type >= ENTITY_SPAWN && Type <= ENTITY_SPAWN_BLUE)
+		pInfo->m_aNumSpawns[Type - ENTITY_SPAWN]++;
+}
@@ -0,0 +1,74 @@
+#ifndef GAME_SERVER_MAPREGISTRY_H
+#define GAME_SERVER_MAPREGISTRY_H
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The maps merged into a mega map by `map_merge`. Their indices start at 1
+// in the order of `mega_add_mapname`, 0 is the whole mega map. Names are
+// looked up case-insensitively.
+class CMapRegistry
+{
+public:
+	enum
+	{
+		// the index is stored in 16 bits of the speedup tiles
+		MAX_MAPS = 0xffff,
+	};
+
+	struct CMapInfo
+	{
+		std::string m_Name;
+		// bounding rect of the tiles with the map's index, in tiles, empty
+		// while `m_NumTiles` is 0
+		int m_MinX = 0;
+		int m_MinY = 0;
+		int m_MaxX = -1;
+		int m_MaxY = -1;
+		int m_NumTiles = 0;
+		// spawn, red spawn and blue spawn
+		int m_aNumSpawns[3] = {0, 0, 0};
+		// indices into the entities of `CGameTeams`, in map order
+		std::vector<int> m_vEntities;
+	};
+
+private:
+	// the map with index i is at i - 1
+	std::vector<CMapInfo> m_vMaps;
+	int m_NumNamed = 0;
+	std::unordered_map<std::string, int> m_NameIndex;
+	// folded names, sorted for the prefix search
+	std::vector<std::pair<std::string, int>> m_vSorted;
+
+	CMapInfo *Touch(int Index);
+
+public:
+	static std::string FoldName(const char *pName);
+
+	void Clear();
+	// names the next map, returns its index or 0 if there is no room
+	int Add(const char *pName);
+
+	// returns the index of the map or 0
+	int Find(const char *pName) const;
+	// returns the index of the only map starting with `pPrefix` or 0
+	int FindPrefix(const char *pPrefix) const;
+	// fills up to `Max` maps that the name might mean, those starting with it
+	// first and then those a few typos away, returns the number of them
+	int Suggest(const char *pName, int *pIndices, int Max) const;
+
+	// the layout of the mega map, from the map loading
+	void OnTile(int Index, int x, int y);
+	void OnEntity(int Index, int EntityIndex, int Type);
+
+	// number of the named maps
+	int NumNamed() const { return m_NumNamed; }
+	// number of the maps with a name or tiles
+	int Num() const { return m_vMaps.size(); }
+	const CMapInfo *Info(int Index) const { return Index > 0 && Index <= (int)m_vMaps.size() ? &m_vMaps[Index - 1] : nullptr; }
+	const char *Name(int Index) const { return Index > 0 && Index <= (int)m_vMaps.size() ? m_vMaps[Index - 1].m_Name.c_str() : ""; }
+};
+
+#endif // GAME_SERVER_MAPREGISTRY_H
@@ -47,7 +47,7 @@ void CPlayer::Reset()
 	m_LastFire = false;
 
 	int *pIdMap = Server()->GetIdMap(m_ClientID);
-	for(int i = 1; i < VANILLA_MAX_CLIENTS; i++)
+	for(int i = 1; i < IServer::MAX_ID_MAP; i++)
 	{
 		pIdMap[i] = -1;
 	}
@@ -80,7 +80,9 @@ void CPlayer::Reset()
 	m_Halloween = false;
 	m_FirstPacket = true;
 
-	m_SendVoteIndex = -1;
+	m_SendVoteOptions = false;
+	m_VoteOptionsChanged = false;
+	m_VoteOptions.Reset();
 
 	if(g_Config.m_Events)
 	{
@@ -177,15 +179,13 @@ static int PlayerFlags_SixToSeven(int Flags)
 
 void CPlayer::SetSpectatorID(int ClientID)
 {
-	int64 Mask = CmaskOne(m_ClientID);
-
 	// unset prev spectating mask
 	if(m_SpectatorID >= 0)
 	{
-		CGameContext::ms_SpectatorMask[m_SpectatorID] &= ~Mask;
+		CGameContext::ms_SpectatorMask[m_SpectatorID].Unset(m_ClientID);
 		int SpecTeam = GameServer()->m_apPlayers[m_SpectatorID] ? GameServer()->m_apPlayers[m_SpectatorID]->GetTeam() : TEAM_SPECTATORS;
 		if(SpecTeam != TEAM_SPECTATORS)
-			CGameContext::ms_TeamSpectatorMask[SpecTeam] &= ~Mask;
+			CGameContext::ms_TeamSpectatorMask[SpecTeam].Unset(m_ClientID);
 	}
 
 	m_SpectatorID = ClientID;
@@ -193,10 +193,10 @@ void CPlayer::SetSpectatorID(int ClientID)
 	// set new spectating mask
 	if(m_SpectatorID >= 0)
 	{
-		CGameContext::ms_SpectatorMask[m_SpectatorID] |= Mask;
+		CGameContext::ms_SpectatorMask[m_SpectatorID].Set(m_ClientID);
 		int SpecTeam = GameServer()->m_apPlayers[m_SpectatorID] ? GameServer()->m_apPlayers[m_SpectatorID]->GetTeam() : TEAM_SPECTATORS;
 		if(SpecTeam != TEAM_SPECTATORS)
-			CGameContext::ms_TeamSpectatorMask[SpecTeam] |= Mask;
+			CGameContext::ms_TeamSpectatorMask[SpecTeam].Set(m_ClientID);
 	}
 }
 
@@ -620,13 +620,13 @@ void CPlayer::Snap(int SnappingClient)
 
 void CPlayer::FakeSnap()
 {
-	if(GetClientVersion() >= VERSION_DDNET_OLD)
+	if(Server()->IdMapSize(m_ClientID) == MAX_CLIENTS)
 		return;
 
 	if(Server()->IsSixup(m_ClientID))
 		return;
 
-	int FakeID = VANILLA_MAX_CLIENTS - 1;
+	int FakeID = Server()->IdMapSize(m_ClientID) - 1;
 
 	CNetObj_ClientInfo *pClientInfo = static_cast<CNetObj_ClientInfo *>(Server()->SnapNewItem(NETOBJTYPE_CLIENTINFO, FakeID, sizeof(CNetObj_ClientInfo)));
 
@@ -860,9 +860,9 @@ void CPlayer::SetTeam(int Team)
 	for(int i = 0; i < 3; i++)
 	{
 		if(i == Team + 1)
-			CGameContext::ms_TeamMask[i] |= CmaskOne(m_ClientID);
+			CGameContext::ms_TeamMask[i].Set(m_ClientID);
 		else
-			CGameContext::ms_TeamMask[i] &= ~CmaskOne(m_ClientID);
+			CGameContext::ms_TeamMask[i].Unset(m_ClientID);
 	}
 
 	protocol7::CNetMsg_Sv_Team Msg;
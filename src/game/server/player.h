@@ -9,6 +9,7 @@
 // #include "score.h"
 #include "teams.h"
 #include "teeinfo.h"
+#include "votelist.h"
 #include <game/server/gamecontext.h>
 
 enum
@@ -116,7 +117,11 @@ public:
 	int m_LastWhisperTo;
 	int m_LastInvited;
 
-	int m_SendVoteIndex;
+	// false until the client is ready for vote options
+	bool m_SendVoteOptions;
+	// set to rebuild the vote options and send the differences
+	bool m_VoteOptionsChanged;
+	CVoteOptionList m_VoteOptions;
 
 	CTeeInfo m_TeeInfos;
 
@@ -0,0 +1,37 @@
+#include "proximatetiles.h"
+
+#include <base/system.h>
+#include <game/collision.h>
+
+CProximateTileMap::CProximateTileMap(const CCollision *pCollision, const bool *pTiles)
+{
+	mem_copy(m_aTiles, pTiles, sizeof(m_aTiles));
+	int NumTiles = pCollision->GetWidth() * pCollision->GetHeight();
+	m_vMap.resize(NumTiles);
+	for(int i = 0; i < NumTiles; i++)
+		m_vMap[i] = m_aTiles[pCollision->GetTileIndex(i)] || m_aTiles[pCollision->GetFTileIndex(i)];
+}
+
+bool CProximateTileMap::SameTiles(const bool *pTiles) const
+{
+	return mem_comp(m_aTiles, pTiles, sizeof(m_aTiles)) == 0;
+}
+
+int CProximateTileMap::FindNear(const CCollision *pCollision, vec2 Pos, float ProximityRadius, int *pIndices) const
+{
+	const vec2 aOffsets[4] = {
+		vec2(ProximityRadius / 3.f, -ProximityRadius / 3.f),
+		vec2(ProximityRadius / 3.f, ProximityRadius / 3.f),
+		vec2(-ProximityRadius / 3.f, -ProximityRadius / 3.f),
+		vec2(-ProximityRadius / 3.f, ProximityRadius / 3.f),
+	};
+
+	int Num = 0;
+	for(const vec2 &Offset : aOffsets)
+	{
+		int MapIndex = pCollision->GetPureMapIndex(Pos + Offset);
+		if(m_vMap[MapIndex])
+			pIndices[Num++] = MapIndex;
+	}
+	return Num;
+}
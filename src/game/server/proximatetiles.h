@@ -0,0 +1,29 @@
+#ifndef GAME_SERVER_PROXIMATETILES_H
+#define GAME_SERVER_PROXIMATETILES_H
+
+#include <base/vmath.h>
+
+#include <vector>
+
+class CCollision;
+
+// Marks the map indices whose game or front tile is one of a set of tiles.
+// Built once per map and set of tiles, the rooms declaring the same tiles
+// share it.
+class CProximateTileMap
+{
+	bool m_aTiles[256];
+	std::vector<bool> m_vMap;
+
+public:
+	CProximateTileMap(const CCollision *pCollision, const bool *pTiles);
+
+	bool SameTiles(const bool *pTiles) const;
+	bool IsProximate(int MapIndex) const { return m_vMap[MapIndex]; }
+
+	// the map indices under the corners of a character that are marked,
+	// in the order the corners are checked, at most 4
+	int FindNear(const CCollision *pCollision, vec2 Pos, float ProximityRadius, int *pIndices) const;
+};
+
+#endif // GAME_SERVER_PROXIMATETILES_H
@@ -0,0 +1,77 @@
+#include "snapgrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+// clamping keeps overlapping boxes in overlapping cells
+static int CellCoord(float Value, int NumCells)
+{
+	if(!(Value >= 0.0f))
+		return 0;
+	if(Value >= (float)NumCells * CSnapGrid::CELL_SIZE)
+		return NumCells - 1;
+	return (int)(Value / CSnapGrid::CELL_SIZE);
+}
+
+void CSnapGrid::Init(float Width, float Height)
+{
+	m_Width = maximum(1, (int)(Width / CELL_SIZE) + 1);
+	m_Height = maximum(1, (int)(Height / CELL_SIZE) + 1);
+	m_vvCells.assign(m_Width * m_Height, {});
+	m_vAlways.clear();
+}
+
+void CSnapGrid::Clear()
+{
+	for(auto &vCell : m_vvCells)
+		vCell.clear();
+	m_vAlways.clear();
+}
+
+void CSnapGrid::CellRange(vec2 TL, vec2 BR, int *pX0, int *pY0, int *pX1, int *pY1) const
+{
+	*pX0 = CellCoord(TL.x, m_Width);
+	*pY0 = CellCoord(TL.y, m_Height);
+	*pX1 = CellCoord(BR.x, m_Width);
+	*pY1 = CellCoord(BR.y, m_Height);
+}
+
+void CSnapGrid::Add(int Item, vec2 TL, vec2 BR)
+{
+	// also catches NaN
+	if(!(TL.x <= BR.x && TL.y <= BR.y))
+	{
+		AddAlways(Item);
+		return;
+	}
+
+	int X0, Y0, X1, Y1;
+	CellRange(TL, BR, &X0, &Y0, &X1, &Y1);
+	if((X1 - X0 + 1) * (Y1 - Y0 + 1) > MAX_ITEM_CELLS)
+	{
+		AddAlways(Item);
+		return;
+	}
+
+	for(int y = Y0; y <= Y1; y++)
+		for(int x = X0; x <= X1; x++)
+			m_vvCells[y * m_Width + x].push_back(Item);
+}
+
+void CSnapGrid::Query(vec2 TL, vec2 BR, std::vector<int> *pvItems) const
+{
+	pvItems->assign(m_vAlways.begin(), m_vAlways.end());
+
+	int X0 = 0, Y0 = 0, X1 = m_Width - 1, Y1 = m_Height - 1;
+	if(!std::isnan(TL.x) && !std::isnan(TL.y) && !std::isnan(BR.x) && !std::isnan(BR.y))
+		CellRange(vec2(minimum(TL.x, BR.x), minimum(TL.y, BR.y)), vec2(maximum(TL.x, BR.x), maximum(TL.y, BR.y)), &X0, &Y0, &X1, &Y1);
+	for(int y = Y0; y <= Y1; y++)
+		for(int x = X0; x <= X1; x++)
+		{
+			const auto &vCell = m_vvCells[y * m_Width + x];
+			pvItems->insert(pvItems->end(), vCell.begin(), vCell.end());
+		}
+
+	std::sort(pvItems->begin(), pvItems->end());
+	pvItems->erase(std::unique(pvItems->begin(), pvItems->end()), pvItems->end());
+}
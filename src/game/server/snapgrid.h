@@ -0,0 +1,40 @@
+#ifndef GAME_SERVER_SNAPGRID_H
+#define GAME_SERVER_SNAPGRID_H
+
+#include <base/vmath.h>
+
+#include <vector>
+
+// Buckets the bounding boxes of items into square cells, so the items near a
+// view rectangle are found without testing all of them. Items are known by
+// their index, boxes outside of the grid go to its edge cells.
+class CSnapGrid
+{
+public:
+	enum
+	{
+		CELL_SIZE = 512,
+		// bigger boxes are returned by every query
+		MAX_ITEM_CELLS = 16,
+	};
+
+private:
+	int m_Width = 1;
+	int m_Height = 1;
+	std::vector<std::vector<int>> m_vvCells;
+	std::vector<int> m_vAlways;
+
+	void CellRange(vec2 TL, vec2 BR, int *pX0, int *pY0, int *pX1, int *pY1) const;
+
+public:
+	// the size of the covered area, in world units
+	void Init(float Width, float Height);
+	void Clear();
+	void Add(int Item, vec2 TL, vec2 BR);
+	// returned by every query
+	void AddAlways(int Item) { m_vAlways.push_back(Item); }
+	// the items whose boxes may intersect the rectangle, in ascending order
+	void Query(vec2 TL, vec2 BR, std::vector<int> *pvItems) const;
+};
+
+#endif // GAME_SERVER_SNAPGRID_H
@@ -1,6 +1,7 @@
 /* (c) Shereef Marzouk. See "licence DDRace.txt" and the readme.txt in the root of the distribution for more information. */
 #include "teams.h"
 #include <engine/shared/config.h>
+#include <engine/shared/metrics.h>
 #include <game/version.h>
 
 #include "entities/character.h"
@@ -12,6 +13,8 @@
 CGameTeams::CGameTeams()
 {
 	m_pGameContext = nullptr;
+	m_pRoomsMetric = nullptr;
+	m_pRoomsCreatedMetric = nullptr;
 	mem_zero(m_aTeamInstances, sizeof(m_aTeamInstances));
 	mem_zero(m_apWantedGameType, sizeof(m_apWantedGameType));
 	mem_zero(m_aTeamReload, sizeof(m_aTeamReload));
@@ -19,12 +22,16 @@ CGameTeams::CGameTeams()
 	mem_zero(m_aRoomVotes, sizeof(m_aRoomVotes));
 	mem_zero(m_aTeamState, sizeof(m_aTeamState));
 	mem_zero(m_aTeamLocked, sizeof(m_aTeamLocked));
-	mem_zero(m_aInvited, sizeof(m_aInvited));
+	for(auto &Invited : m_aInvited)
+		Invited = CClientMask();
 	m_NumRooms = 0;
 }
 
 CGameTeams::~CGameTeams()
 {
+	// the metrics belong to the server, which may be gone already
+	m_pRoomsMetric = nullptr;
+	m_pRoomsCreatedMetric = nullptr;
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 		DestroyGameInstance(i);
 }
@@ -32,6 +39,8 @@ CGameTeams::~CGameTeams()
 void CGameTeams::Init(CGameContext *pGameServer)
 {
 	m_pGameContext = pGameServer;
+	m_pRoomsMetric = GameServer()->Server()->Metrics()->Gauge("ddnet_rooms", "Rooms with a running game instance");
+	m_pRoomsCreatedMetric = GameServer()->Server()->Metrics()->Counter("ddnet_rooms_created_total", "Game instances created, including reloads");
 	CreateGameInstance(0, nullptr, -1);
 }
 
@@ -43,7 +52,7 @@ void CGameTeams::Reset()
 		DestroyGameInstance(i);
 		m_aTeamState[i] = TEAMSTATE_EMPTY;
 		m_aTeamLocked[i] = false;
-		m_aInvited[i] = 0;
+		m_aInvited[i] = CClientMask();
 	}
 }
 
@@ -212,7 +221,7 @@ void CGameTeams::SetTeamLock(int Team, bool Lock)
 
 void CGameTeams::ResetInvited(int Team)
 {
-	m_aInvited[Team] = 0;
+	m_aInvited[Team] = CClientMask();
 }
 
 void CGameTeams::SetClientInvited(int Team, int ClientID, bool Invited)
@@ -220,9 +229,9 @@ void CGameTeams::SetClientInvited(int Team, int ClientID, bool Invited)
 	if(Team > TEAM_FLOCK && Team < TEAM_SUPER)
 	{
 		if(Invited)
-			m_aInvited[Team] |= 1ULL << ClientID;
+			m_aInvited[Team].Set(ClientID);
 		else
-			m_aInvited[Team] &= ~(1ULL << ClientID);
+			m_aInvited[Team].Unset(ClientID);
 	}
 }
 
@@ -280,6 +289,9 @@ bool CGameTeams::CreateGameInstance(int Team, const char *pGameName, int Asker)
 	if(m_aTeamInstances[Team].m_IsCreated)
 		DestroyGameInstance(Team);
 
+	m_aTeamInstances[Team].m_pArena = new CArena();
+	CArena::CScope ArenaScope(m_aTeamInstances[Team].m_pArena);
+
 	IGameController *Game = nullptr;
 	if(false)
 		return false;
@@ -297,11 +309,14 @@ bool CGameTeams::CreateGameInstance(int Team, const char *pGameName, int Asker)
 	CGameWorld *pWorld = new CGameWorld(Team, m_pGameContext, Game);
 	m_aTeamInstances[Team].m_pWorld = pWorld;
 	m_aTeamInstances[Team].m_pController = Game;
-	m_aTeamInstances[Team].m_pController->m_MapIndex = m_NumMaps > 0 ? 1 : 0;
+	m_aTeamInstances[Team].m_pController->m_MapIndex = m_Maps.NumNamed() > 0 ? 1 : 0;
 	m_aTeamInstances[Team].m_pController->InitController(m_pGameContext, pWorld);
 	m_aTeamInstances[Team].m_IsCreated = true;
 	m_aTeamInstances[Team].m_Init = false;
 	m_aTeamInstances[Team].m_Entities = 0;
+	if(m_pRoomsCreatedMetric)
+		m_pRoomsCreatedMetric->Add();
+	UpdateRoomsMetric();
 
 	// -2 means reload, if reload, don't update creator's name
 	if(Asker == -1)
@@ -370,6 +385,17 @@ bool CGameTeams::RecreateGameInstance(int Team, const char *pGameName)
 	return true;
 }
 
+void CGameTeams::UpdateRoomsMetric()
+{
+	if(!m_pRoomsMetric)
+		return;
+	int NumRooms = 0;
+	for(const auto &Instance : m_aTeamInstances)
+		if(Instance.m_IsCreated)
+			NumRooms++;
+	m_pRoomsMetric->Set(NumRooms);
+}
+
 void CGameTeams::DestroyGameInstance(int Team)
 {
 	if(!m_aTeamInstances[Team].m_IsCreated)
@@ -381,11 +407,15 @@ void CGameTeams::DestroyGameInstance(int Team)
 
 	delete m_aTeamInstances[Team].m_pController;
 	delete m_aTeamInstances[Team].m_pWorld;
+	m_aTeamInstances[Team].m_pArena->Release();
+	GameServer()->Server()->ResetRoomBandwidth(Team);
 	m_aTeamInstances[Team].m_Init = false;
 	m_aTeamInstances[Team].m_IsCreated = false;
 	m_aTeamInstances[Team].m_pController = nullptr;
 	m_aTeamInstances[Team].m_pWorld = nullptr;
+	m_aTeamInstances[Team].m_pArena = nullptr;
 	m_aTeamInstances[Team].m_Entities = 0;
+	UpdateRoomsMetric();
 
 	char aBuf[128];
 	str_format(aBuf, sizeof(aBuf), "game controller %d is deleted", Team);
@@ -449,6 +479,7 @@ void CGameTeams::OnTick()
 	{
 		if(m_aTeamInstances[i].m_Init)
 		{
+			CArena::CScope ArenaScope(m_aTeamInstances[i].m_pArena);
 			if(m_aTeamReload[i] == RELOAD_TYPE_HARD)
 			{
 				m_aTeamReload[i] = RELOAD_TYPE_NO;
@@ -471,7 +502,7 @@ void CGameTeams::OnTick()
 			}
 			else
 			{
-				m_aTeamInstances[i].m_pWorld->m_Core.m_Tuning = *GameServer()->Tuning();
+				m_aTeamInstances[i].m_pWorld->m_Core.m_pTuning = GameServer()->TuningValues(0);
 				m_aTeamInstances[i].m_pController->Tick();
 				m_aTeamInstances[i].m_pWorld->Tick();
 			}
@@ -492,15 +523,21 @@ void CGameTeams::OnTick()
 			{
 				if(m_aTeamInstances[i].m_IsCreated && !m_aTeamInstances[i].m_Init)
 				{
-					if(m_aTeamInstances[i].m_Entities < m_Entities.size())
+					CArena::CScope ArenaScope(m_aTeamInstances[i].m_pArena);
+					// a room of a mega map's part only walks the entities of that part
+					int MapIndex = m_aTeamInstances[i].m_pController->m_MapIndex;
+					const CMapRegistry::CMapInfo *pMap = m_Maps.Info(MapIndex);
+					unsigned int NumEntities = pMap ? pMap->m_vEntities.size() : MapIndex > 0 ? 0 : m_Entities.size();
+					if(m_aTeamInstances[i].m_Entities < NumEntities)
 					{
-						auto E = m_Entities[m_aTeamInstances[i].m_Entities];
+						int Entity = m_aTeamInstances[i].m_Entities;
+						auto E = m_Entities[pMap ? pMap->m_vEntities[Entity] : Entity];
 						m_aTeamInstances[i].m_pController->OnInternalEntity(E.Index, E.Pos, E.Layer, E.Flags, E.MegaMapIndex, E.Number);
 						m_aTeamInstances[i].m_Entities++;
 						NumProcessed++;
 					}
 
-					if(m_aTeamInstances[i].m_Entities == m_Entities.size())
+					if(m_aTeamInstances[i].m_Entities == NumEntities)
 					{
 						m_aTeamInstances[i].m_Init = true;
 						m_aTeamInstances[i].m_pController->StartController();
@@ -528,6 +565,7 @@ void CGameTeams::OnEntity(int Index, vec2 Pos, int Layer, int Flags, int MegaMap
 	Ent.Flags = Flags;
 	Ent.MegaMapIndex = MegaMapIndex;
 	Ent.Number = Number;
+	m_Maps.OnEntity(MegaMapIndex, m_Entities.size(), Index);
 	m_Entities.push_back(Ent);
 }
 
@@ -585,7 +623,7 @@ bool CGameTeams::TeamLocked(int Team)
 
 bool CGameTeams::IsInvited(int Team, int ClientID)
 {
-	return m_aInvited[Team] & 1LL << ClientID;
+	return m_aInvited[Team].IsSet(ClientID);
 }
 
 int CGameTeams::CanSwitchTeam(int ClientID)
@@ -603,8 +641,7 @@ int CGameTeams::FindAEmptyTeam()
 }
 std::vector<SGameType> CGameTeams::m_GameTypes;
 SGameType CGameTeams::m_DefaultGameType = {nullptr, nullptr, nullptr, false};
-char CGameTeams::m_aMapNames[64][128];
-int CGameTeams::m_NumMaps;
+CMapRegistry CGameTeams::m_Maps;
 char CGameTeams::m_aGameTypeName[17] = {0};
 
 void CGameTeams::SetDefaultGameType(const char *pGameType, const char *pSettings, bool IsFile)
@@ -662,11 +699,7 @@ void CGameTeams::UpdateVotes()
 	{
 		if(m_aRoomVotes[m_NumRooms][0])
 		{
-			CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-			GameServer()->Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, -1);
-			for(auto &pPlayer : GameServer()->m_apPlayers)
-				if(pPlayer)
-					pPlayer->m_SendVoteIndex = 0;
+			GameServer()->ExpireVoteOptions();
 			m_aRoomVotes[m_NumRooms][0] = 0;
 		}
 		return;
@@ -702,12 +735,8 @@ void CGameTeams::UpdateVotes()
 	if(m_NumRooms < MAX_CLIENTS)
 		m_aRoomVotes[m_NumRooms][0] = 0;
 
-	// reset sending of vote options
-	CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
-	GameServer()->Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, -1);
-	for(auto &pPlayer : GameServer()->m_apPlayers)
-		if(pPlayer)
-			pPlayer->m_SendVoteIndex = 0;
+	// only the changed rooms are sent again
+	GameServer()->ExpireVoteOptions();
 }
 
 void CGameTeams::AddGameType(const char *pGameType, const char *pName, const char *pSettings, bool IsFile)
@@ -827,21 +856,11 @@ void CGameTeams::UpdateGameTypeName()
 
 void CGameTeams::ClearMaps()
 {
-	m_NumMaps = 0;
+	m_Maps.Clear();
 }
 
 void CGameTeams::AddMap(const char *pMapName)
 {
-	if(m_NumMaps >= 64)
-		return;
-	str_copy(m_aMapNames[m_NumMaps++], pMapName, 128);
-}
-
-int CGameTeams::GetMapIndex(const char *pMapName)
-{
-	for(int i = 0; i < m_NumMaps; i++)
-		if(str_comp_nocase(pMapName, m_aMapNames[i]) == 0)
-			return i + 1;
-
-	return 0;
+	if(!m_Maps.Add(pMapName))
+		dbg_msg("mega", "too many maps, ignoring '%s'", pMapName);
 }
\ No newline at end of file
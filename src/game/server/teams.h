@@ -2,10 +2,13 @@
 #ifndef GAME_SERVER_TEAMS_H
 #define GAME_SERVER_TEAMS_H
 
+#include <engine/shared/clientmask.h>
 #include <engine/shared/config.h>
 #include <game/teamscore.h>
 #include <game/voting.h>
 
+#include "mapregistry.h"
+
 #include <utility>
 #include <vector>
 
@@ -16,6 +19,8 @@ struct SGameInstance
 	unsigned int m_Entities;
 	class IGameController *m_pController;
 	class CGameWorld *m_pWorld;
+	// the controller, the world and their entities are allocated here
+	class CArena *m_pArena;
 	char m_Creator[16];
 };
 
@@ -44,10 +49,14 @@ class CGameTeams
 	// MYTODO: team states is probably redundant
 	int m_aTeamState[MAX_CLIENTS];
 	bool m_aTeamLocked[MAX_CLIENTS];
-	uint64 m_aInvited[MAX_CLIENTS];
+	CClientMask m_aInvited[MAX_CLIENTS];
 
 	class CGameContext *m_pGameContext;
 
+	class CMetricGauge *m_pRoomsMetric;
+	class CMetricCounter *m_pRoomsCreatedMetric;
+	void UpdateRoomsMetric();
+
 	// progressive
 	struct SEntity
 	{
@@ -63,8 +72,7 @@ class CGameTeams
 	// gametypes
 	static std::vector<SGameType> m_GameTypes;
 	static char m_aGameTypeName[17];
-	static char m_aMapNames[64][128];
-	static int m_NumMaps;
+	static CMapRegistry m_Maps;
 	static SGameType m_DefaultGameType;
 	static char m_aGameTypeList[512];
 
@@ -144,7 +152,7 @@ public:
 
 	static void ClearMaps();
 	static void AddMap(const char *pMapName);
-	static int GetMapIndex(const char *pMapName);
+	static CMapRegistry &Maps() { return m_Maps; }
 
 	void UpdateGameTypeName();
 	static const char *GameTypeName() { return m_aGameTypeName; }
@@ -0,0 +1,384 @@
+#include "textlayout.h"
+
+#include <base/system.h>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+static struct SFontDot
+{
+	int m_Width;
+	int m_Dots;
+	const char *m_Data;
+} s_FontDotData[256] = {
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{3, 5, "\x08\x0f\x16\x1d\x32"}, // '!'
+	{3, 4, "\x07\x09\x0e\x10"}, // '"'
+	{5, 20, "\x08\x0a\x0f\x11\x15\x16\x17\x18\x19\x1d\x1f\x23\x24\x25\x26\x27\x2b\x2d\x32\x34"}, // '#'
+	{5, 21, "\x02\x08\x09\x0a\x0e\x10\x12\x15\x17\x1d\x1e\x1f\x25\x27\x2a\x2c\x2e\x32\x33\x34\x3a"}, // '$'
+	{5, 15, "\x07\x08\x0b\x0e\x0f\x12\x18\x1e\x24\x2a\x2d\x2e\x31\x34\x35"}, // '%'
+	{5, 15, "\x09\x0f\x11\x16\x18\x1d\x1e\x23\x25\x27\x2a\x2d\x32\x33\x35"}, // '&'
+	{3, 2, "\x08\x0f"}, // '''
+	{3, 9, "\x02\x08\x0e\x15\x1c\x23\x2a\x32\x3a"}, // '('
+	{3, 9, "\x00\x08\x10\x17\x1e\x25\x2c\x32\x38"}, // ')'
+	{5, 11, "\x02\x07\x09\x0b\x0f\x10\x11\x15\x17\x19\x1e"}, // '*'
+	{5, 9, "\x10\x17\x1c\x1d\x1e\x1f\x20\x25\x2c"}, // '+'
+	{3, 2, "\x32\x38"}, // ','
+	{5, 5, "\x1c\x1d\x1e\x1f\x20"}, // '-'
+	{3, 1, "\x32"}, // '.'
+	{3, 7, "\x09\x10\x16\x1d\x24\x2a\x31"}, // '/'
+	{5, 19, "\x08\x09\x0a\x0e\x12\x15\x18\x19\x1c\x1e\x20\x23\x24\x27\x2a\x2e\x32\x33\x34"}, // '0'
+	{5, 10, "\x09\x0f\x10\x17\x1e\x25\x2c\x32\x33\x34"}, // '1'
+	{5, 14, "\x08\x09\x0a\x0e\x12\x19\x1f\x25\x2b\x31\x32\x33\x34\x35"}, // '2'
+	{5, 14, "\x07\x08\x09\x0a\x0b\x11\x17\x1f\x27\x2a\x2e\x32\x33\x34"}, // '3'
+	{5, 14, "\x0a\x10\x11\x16\x18\x1c\x1f\x23\x24\x25\x26\x27\x2d\x34"}, // '4'
+	{5, 17, "\x07\x08\x09\x0a\x0b\x0e\x15\x16\x17\x18\x20\x27\x2a\x2e\x32\x33\x34"}, // '5'
+	{5, 15, "\x09\x0a\x0f\x15\x1c\x1d\x1e\x1f\x23\x27\x2a\x2e\x32\x33\x34"}, // '6'
+	{5, 11, "\x07\x08\x09\x0a\x0b\x12\x18\x1e\x24\x2b\x32"}, // '7'
+	{5, 17, "\x08\x09\x0a\x0e\x12\x15\x19\x1d\x1e\x1f\x23\x27\x2a\x2e\x32\x33\x34"}, // '8'
+	{5, 15, "\x08\x09\x0a\x0e\x12\x15\x19\x1d\x1e\x1f\x20\x27\x2d\x32\x33"}, // '9'
+	{3, 2, "\x0f\x2b"}, // ':'
+	{3, 3, "\x0f\x2b\x31"}, // ';'
+	{3, 5, "\x10\x16\x1c\x24\x2c"}, // '<'
+	{5, 10, "\x15\x16\x17\x18\x19\x23\x24\x25\x26\x27"}, // '='
+	{3, 5, "\x0e\x16\x1e\x24\x2a"}, // '>'
+	{5, 10, "\x08\x09\x0a\x0e\x12\x19\x1e\x1f\x25\x33"}, // '?'
+	{5, 20, "\x08\x09\x0a\x0e\x12\x15\x17\x19\x1c\x1d\x1f\x20\x23\x25\x26\x2a\x2e\x32\x33\x34"}, // '@'
+	{5, 16, "\x09\x0f\x11\x15\x19\x1c\x20\x23\x24\x25\x26\x27\x2a\x2e\x31\x35"}, // 'A'
+	{5, 20, "\x07\x08\x09\x0a\x0e\x12\x15\x19\x1c\x1d\x1e\x1f\x23\x27\x2a\x2e\x31\x32\x33\x34"}, // 'B'
+	{5, 13, "\x08\x09\x0a\x0e\x12\x15\x1c\x23\x2a\x2e\x32\x33\x34"}, // 'C'
+	{5, 18, "\x07\x08\x09\x0a\x0e\x12\x15\x19\x1c\x20\x23\x27\x2a\x2e\x31\x32\x33\x34"}, // 'D'
+	{5, 18, "\x07\x08\x09\x0a\x0b\x0e\x15\x1c\x1d\x1e\x1f\x23\x2a\x31\x32\x33\x34\x35"}, // 'E'
+	{5, 14, "\x07\x08\x09\x0a\x0b\x0e\x15\x1c\x1d\x1e\x1f\x23\x2a\x31"}, // 'F'
+	{5, 17, "\x08\x09\x0a\x0e\x12\x15\x1c\x1e\x1f\x20\x23\x27\x2a\x2e\x32\x33\x34"}, // 'G'
+	{5, 17, "\x07\x0b\x0e\x12\x15\x19\x1c\x1d\x1e\x1f\x20\x23\x27\x2a\x2e\x31\x35"}, // 'H'
+	{5, 11, "\x08\x09\x0a\x10\x17\x1e\x25\x2c\x32\x33\x34"}, // 'I'
+	{5, 14, "\x07\x08\x09\x0a\x0b\x12\x19\x20\x27\x2a\x2e\x32\x33\x34"}, // 'J'
+	{5, 14, "\x07\x0b\x0e\x11\x15\x17\x1c\x1d\x23\x25\x2a\x2d\x31\x35"}, // 'K'
+	{5, 11, "\x07\x0e\x15\x1c\x23\x2a\x31\x32\x33\x34\x35"}, // 'L'
+	{5, 17, "\x07\x0b\x0e\x0f\x11\x12\x15\x17\x19\x1c\x20\x23\x27\x2a\x2e\x31\x35"}, // 'M'
+	{5, 17, "\x07\x0b\x0e\x12\x15\x16\x19\x1c\x1e\x20\x23\x26\x27\x2a\x2e\x31\x35"}, // 'N'
+	{5, 16, "\x08\x09\x0a\x0e\x12\x15\x19\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34"}, // 'O'
+	{5, 15, "\x07\x08\x09\x0a\x0e\x12\x15\x19\x1c\x1d\x1e\x1f\x23\x2a\x31"}, // 'P'
+	{5, 18, "\x08\x09\x0a\x0e\x12\x15\x19\x1c\x20\x23\x25\x27\x2a\x2d\x2e\x32\x33\x34"}, // 'Q'
+	{5, 18, "\x07\x08\x09\x0a\x0e\x12\x15\x19\x1c\x1d\x1e\x1f\x23\x25\x2a\x2d\x31\x35"}, // 'R'
+	{5, 15, "\x08\x09\x0a\x0e\x12\x15\x1d\x1e\x1f\x27\x2a\x2e\x32\x33\x34"}, // 'S'
+	{5, 11, "\x07\x08\x09\x0a\x0b\x10\x17\x1e\x25\x2c\x33"}, // 'T'
+	{5, 15, "\x07\x0b\x0e\x12\x15\x19\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34"}, // 'U'
+	{5, 13, "\x07\x0b\x0e\x12\x15\x19\x1c\x20\x23\x27\x2b\x2d\x33"}, // 'V'
+	{5, 17, "\x07\x0b\x0e\x12\x15\x17\x19\x1c\x1e\x20\x23\x25\x27\x2b\x2d\x32\x34"}, // 'W'
+	{5, 11, "\x07\x0b\x0f\x11\x17\x1e\x25\x2b\x2d\x31\x35"}, // 'X'
+	{5, 11, "\x07\x0b\x0e\x12\x16\x18\x1d\x1f\x25\x2c\x33"}, // 'Y'
+	{5, 15, "\x07\x08\x09\x0a\x0b\x12\x18\x1e\x24\x2a\x31\x32\x33\x34\x35"}, // 'Z'
+	{3, 11, "\x00\x01\x07\x0e\x15\x1c\x23\x2a\x31\x38\x39"}, // '['
+	{3, 7, "\x07\x0e\x16\x1d\x24\x2c\x33"}, // '\'
+	{3, 11, "\x00\x01\x08\x0f\x16\x1d\x24\x2b\x32\x38\x39"}, // ']'
+	{3, 3, "\x08\x0e\x10"}, // '^'
+	{5, 5, "\x31\x32\x33\x34\x35"}, // '_'
+	{3, 2, "\x07\x0f"}, // '`'
+	{5, 14, "\x16\x17\x18\x20\x24\x25\x26\x27\x2a\x2e\x32\x33\x34\x35"}, // 'a'
+	{5, 16, "\x07\x0e\x15\x16\x17\x18\x1c\x20\x23\x27\x2a\x2e\x31\x32\x33\x34"}, // 'b'
+	{5, 11, "\x16\x17\x18\x19\x1c\x23\x2a\x32\x33\x34\x35"}, // 'c'
+	{5, 16, "\x0b\x12\x16\x17\x18\x19\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34\x35"}, // 'd'
+	{5, 14, "\x16\x17\x18\x1c\x20\x23\x24\x25\x26\x27\x2a\x32\x33\x34"}, // 'e'
+	{5, 12, "\x09\x0a\x10\x16\x17\x18\x1e\x25\x2c\x32\x33\x34"}, // 'f'
+	{5, 18, "\x16\x17\x18\x19\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34\x35\x3c\x40\x41\x42"}, // 'g'
+	{5, 14, "\x07\x0e\x15\x16\x17\x18\x1c\x20\x23\x27\x2a\x2e\x31\x35"}, // 'h'
+	{5, 9, "\x09\x16\x17\x1e\x25\x2c\x32\x33\x34"}, // 'i'
+	{5, 10, "\x09\x16\x17\x18\x1e\x25\x2c\x33\x3a\x40"}, // 'j'
+	{5, 13, "\x07\x0e\x15\x19\x1c\x1f\x23\x24\x25\x2a\x2d\x31\x35"}, // 'k'
+	{5, 10, "\x08\x09\x10\x17\x1e\x25\x2c\x32\x33\x34"}, // 'l'
+	{5, 16, "\x15\x16\x17\x18\x1c\x1e\x20\x23\x25\x27\x2a\x2c\x2e\x31\x33\x35"}, // 'm'
+	{5, 12, "\x15\x16\x17\x18\x1c\x20\x23\x27\x2a\x2e\x31\x35"}, // 'n'
+	{5, 12, "\x16\x17\x18\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34"}, // 'o'
+	{5, 16, "\x15\x16\x17\x18\x1c\x20\x23\x27\x2a\x2e\x31\x32\x33\x34\x38\x3f"}, // 'p'
+	{5, 16, "\x16\x17\x18\x19\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34\x35\x3c\x43"}, // 'q'
+	{5, 8, "\x16\x18\x19\x1d\x1e\x24\x2b\x32"}, // 'r'
+	{5, 13, "\x16\x17\x18\x19\x1c\x24\x25\x26\x2e\x31\x32\x33\x34"}, // 's'
+	{5, 8, "\x10\x16\x17\x18\x1e\x25\x2c\x34"}, // 't'
+	{5, 12, "\x15\x19\x1c\x20\x23\x27\x2a\x2d\x2e\x32\x33\x35"}, // 'u'
+	{5, 9, "\x15\x19\x1c\x20\x23\x27\x2b\x2d\x33"}, // 'v'
+	{5, 13, "\x15\x19\x1c\x1e\x20\x23\x25\x27\x2b\x2c\x2d\x32\x34"}, // 'w'
+	{5, 9, "\x15\x19\x1d\x1f\x25\x2b\x2d\x31\x35"}, // 'x'
+	{5, 16, "\x15\x19\x1c\x20\x23\x27\x2a\x2e\x32\x33\x34\x35\x3c\x40\x41\x42"}, // 'y'
+	{5, 13, "\x15\x16\x17\x18\x19\x1f\x25\x2b\x31\x32\x33\x34\x35"}, // 'z'
+	{3, 11, "\x01\x02\x08\x0f\x15\x1c\x23\x2b\x32\x39\x3a"}, // '{'
+	{3, 7, "\x08\x0f\x16\x1d\x24\x2b\x32"}, // '|'
+	{3, 11, "\x00\x01\x08\x0f\x17\x1e\x25\x2b\x32\x38\x39"}, // '}'
+	{5, 5, "\x16\x19\x1c\x1e\x1f"}, // '~'
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{3, 5, "\x08\x1d\x24\x2b\x32"}, // '¡'
+	{5, 18, "\x02\x09\x0f\x10\x11\x15\x17\x19\x1c\x1e\x23\x25\x27\x2b\x2c\x2d\x33\x3a"}, // '¢'
+	{5, 15, "\x09\x0a\x0f\x12\x16\x1c\x1d\x1e\x24\x2b\x31\x32\x33\x34\x35"}, // '£'
+	{5, 16, "\x07\x0b\x0f\x10\x11\x15\x19\x1c\x20\x23\x27\x2b\x2c\x2d\x31\x35"}, // '¤'
+	{5, 17, "\x07\x0b\x0f\x11\x17\x1c\x1d\x1e\x1f\x20\x25\x2a\x2b\x2c\x2d\x2e\x33"}, // '¥'
+	{3, 6, "\x08\x0f\x16\x24\x2b\x32"}, // '¦'
+	{5, 18, "\x08\x09\x0a\x0e\x12\x15\x16\x17\x1d\x1f\x25\x26\x27\x2a\x2e\x32\x33\x34"}, // '§'
+	{3, 2, "\x07\x09"}, // '¨'
+	{7, 21, "\x09\x0a\x0b\x0f\x13\x15\x18\x19\x1b\x1c\x1e\x22\x23\x26\x27\x29\x2b\x2f\x33\x34\x35"}, // '©'
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+	{0, 0, 0},
+};
+
+CTextLayout::CTextLayout(const char *pText, int GapSize)
+{
+	int TextLen = str_length(pText);
+	m_BoxWidth = GapSize * 2 * (TextLen - 1);
+	m_BoxHeight = GapSize * 8;
+
+	// dots on a grid of gap sized cells, each character advances by its
+	// width and an empty column
+	std::vector<std::pair<int, int>> vCells;
+	int Columns = 0;
+	int Rows = 0;
+	for(int c = 0; c < TextLen; c++)
+	{
+		SFontDot Dot = s_FontDotData[(unsigned char)pText[c]];
+		m_BoxWidth += (Dot.m_Width - 1) * GapSize;
+		for(int d = 0; d < Dot.m_Dots; d++)
+		{
+			int X = Columns + (unsigned char)Dot.m_Data[d] % 7;
+			int Y = (unsigned char)Dot.m_Data[d] / 7;
+			vCells.emplace_back(X, Y);
+			m_vDots.emplace_back(X * GapSize, Y * GapSize);
+			Rows = maximum(Rows, Y + 1);
+		}
+		Columns += Dot.m_Width + 1;
+	}
+	Columns += 7;
+
+	std::vector<bool> vSet(Columns * Rows, false);
+	for(const auto &Cell : vCells)
+		vSet[Cell.second * Columns + Cell.first] = true;
+	auto IsSet = [&](int X, int Y) {
+		return X >= 0 && Y >= 0 && X < Columns && Y < Rows && vSet[Y * Columns + X];
+	};
+
+	// the maximal runs of dots in each direction
+	struct CRun
+	{
+		int m_X;
+		int m_Y;
+		int m_DirX;
+		int m_DirY;
+		int m_Length;
+	};
+	static const int s_aaDirections[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+	std::vector<CRun> vRuns;
+	for(const auto &Cell : vCells)
+	{
+		for(const auto &Dir : s_aaDirections)
+		{
+			if(IsSet(Cell.first - Dir[0], Cell.second - Dir[1]))
+				continue;
+			int Length = 1;
+			while(IsSet(Cell.first + Length * Dir[0], Cell.second + Length * Dir[1]))
+				Length++;
+			if(Length > 1)
+				vRuns.push_back({Cell.first, Cell.second, Dir[0], Dir[1], Length});
+		}
+	}
+
+	// long runs first, a run is only needed if it covers a new dot
+	std::stable_sort(vRuns.begin(), vRuns.end(), [](const CRun &a, const CRun &b) { return a.m_Length > b.m_Length; });
+	std::vector<bool> vCovered(Columns * Rows, false);
+	for(const auto &Run : vRuns)
+	{
+		bool New = false;
+		for(int i = 0; i < Run.m_Length; i++)
+		{
+			int Index = (Run.m_Y + i * Run.m_DirY) * Columns + Run.m_X + i * Run.m_DirX;
+			New |= !vCovered[Index];
+			vCovered[Index] = true;
+		}
+		if(New)
+		{
+			vec2 From = vec2(Run.m_X * GapSize, Run.m_Y * GapSize);
+			vec2 To = vec2((Run.m_X + (Run.m_Length - 1) * Run.m_DirX) * GapSize, (Run.m_Y + (Run.m_Length - 1) * Run.m_DirY) * GapSize);
+			m_vSegments.push_back({From, To});
+		}
+	}
+	for(const auto &Cell : vCells)
+	{
+		if(vCovered[Cell.second * Columns + Cell.first])
+			continue;
+		vec2 Pos = vec2(Cell.first * GapSize, Cell.second * GapSize);
+		m_vSegments.push_back({Pos, Pos});
+	}
+}
+
+std::shared_ptr<const CTextLayout> CTextLayout::Get(const char *pText, int GapSize)
+{
+	static std::map<std::pair<std::string, int>, std::weak_ptr<const CTextLayout>> s_Cache;
+
+	std::pair<std::string, int> Key(pText, GapSize);
+	auto It = s_Cache.find(Key);
+	if(It != s_Cache.end())
+	{
+		if(auto pLayout = It->second.lock())
+			return pLayout;
+	}
+
+	// forget the texts nobody shows anymore
+	for(auto Entry = s_Cache.begin(); Entry != s_Cache.end();)
+	{
+		if(Entry->second.expired())
+			Entry = s_Cache.erase(Entry);
+		else
+			++Entry;
+	}
+
+	auto pLayout = std::make_shared<const CTextLayout>(pText, GapSize);
+	s_Cache[Key] = pLayout;
+	return pLayout;
+}
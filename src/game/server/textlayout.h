@@ -0,0 +1,35 @@
+#ifndef GAME_SERVER_TEXTLAYOUT_H
+#define GAME_SERVER_TEXTLAYOUT_H
+
+#include <base/vmath.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// The dots of a text in the dot font, relative to the top left corner of its
+// box. Lasers can draw lines, so the dots are also merged into segments of
+// collinear neighbours.
+class CTextLayout
+{
+public:
+	struct CSegment
+	{
+		vec2 m_From;
+		vec2 m_To;
+	};
+
+	std::vector<vec2> m_vDots;
+	// covers all dots, single dots have `m_From == m_To`
+	std::vector<CSegment> m_vSegments;
+	float m_BoxWidth;
+	float m_BoxHeight;
+
+	CTextLayout(const char *pText, int GapSize);
+
+	// returns the layout of the text, shared by all users of the same text
+	// and gap size
+	static std::shared_ptr<const CTextLayout> Get(const char *pText, int GapSize);
+};
+
+#endif // GAME_SERVER_TEXTLAYOUT_H
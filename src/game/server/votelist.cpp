@@ -0,0 +1,71 @@
+#include "votelist.h"
+
+void CVoteOptionList::Reset()
+{
+	m_vOptions.clear();
+	m_NumSent = 0;
+}
+
+void CVoteOptionList::Update(std::vector<std::string> &&vOptions, CUpdate *pUpdate)
+{
+	pUpdate->m_Clear = false;
+	pUpdate->m_vRemove.clear();
+
+	// match the new list against the client's one, the earliest match
+	// keeps the longest prefix
+	std::vector<bool> vKeep(m_NumSent, false);
+	int NumKept = 0;
+	for(int i = 0; i < m_NumSent && NumKept < (int)vOptions.size(); i++)
+	{
+		if(m_vOptions[i] == vOptions[NumKept])
+		{
+			vKeep[i] = true;
+			NumKept++;
+		}
+	}
+
+	int RemoveBytes = 0;
+	for(int i = 0; i < m_NumSent; i++)
+	{
+		if(vKeep[i])
+			continue;
+		pUpdate->m_vRemove.push_back(m_vOptions[i]);
+		RemoveBytes += m_vOptions[i].size() + 1 + MSG_OVERHEAD;
+	}
+
+	int KeptBytes = 0;
+	for(int i = 0; i < NumKept; i++)
+		KeptBytes += vOptions[i].size() + 1;
+
+	// the client removes the first match, an earlier duplicate that we
+	// keep would go instead
+	bool Ordered = true;
+	if(!pUpdate->m_vRemove.empty())
+	{
+		std::vector<std::string> vClient(m_vOptions.begin(), m_vOptions.begin() + m_NumSent);
+		for(const auto &Remove : pUpdate->m_vRemove)
+		{
+			for(auto It = vClient.begin(); It != vClient.end(); ++It)
+			{
+				if(*It == Remove)
+				{
+					vClient.erase(It);
+					break;
+				}
+			}
+		}
+		for(int i = 0; i < NumKept && Ordered; i++)
+			Ordered = vClient[i] == vOptions[i];
+	}
+
+	// sending the kept options again is cheaper than removing the others
+	if(!Ordered || MSG_OVERHEAD + KeptBytes <= RemoveBytes)
+	{
+		pUpdate->m_Clear = m_NumSent > 0;
+		pUpdate->m_vRemove.clear();
+		NumKept = 0;
+	}
+
+	m_vOptions = std::move(vOptions);
+	m_NumSent = NumKept;
+}
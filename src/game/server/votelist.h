@@ -0,0 +1,47 @@
+#ifndef GAME_SERVER_VOTELIST_H
+#define GAME_SERVER_VOTELIST_H
+
+#include <string>
+#include <vector>
+
+// The vote options of one client. Clients append added options and remove
+// the first option with a matching description, so a new list is reached by
+// removing the options that are in the way and appending the missing ones.
+class CVoteOptionList
+{
+public:
+	enum
+	{
+		// rough size of a vital message without its strings
+		MSG_OVERHEAD = 4,
+	};
+
+	struct CUpdate
+	{
+		// the client has to clear its list, cheaper than the removals or the
+		// removals wouldn't leave the right order
+		bool m_Clear = false;
+		// descriptions to remove, in this order
+		std::vector<std::string> m_vRemove;
+	};
+
+private:
+	std::vector<std::string> m_vOptions;
+	// the client has the first `m_NumSent` options
+	int m_NumSent = 0;
+
+public:
+	// the client's list is empty
+	void Reset();
+	// replaces the list, the client keeps the longest prefix of the new list
+	// that it already has in that order
+	void Update(std::vector<std::string> &&vOptions, CUpdate *pUpdate);
+
+	int Num() const { return m_vOptions.size(); }
+	int NumSent() const { return m_NumSent; }
+	int NumPending() const { return m_vOptions.size() - m_NumSent; }
+	const char *Option(int Index) const { return m_vOptions[Index].c_str(); }
+	void OnSent(int Num) { m_NumSent += Num; }
+};
+
+#endif // GAME_SERVER_VOTELIST_H
@@ -98,5 +98,50 @@ void CWeapon::HandleFire(vec2 Direction)
 		m_ReloadTimer = m_FireDelay * Server()->TickSpeed() / 1000;
 }
 
+void CWeapon::FireProjectiles(const SProjectileWeapon &Weapon, vec2 Direction)
+{
+	int ClientID = Character()->GetPlayer()->GetCID();
+	int Lifetime = (Character()->CurrentTuning()->*Weapon.m_pLifetime) * Server()->TickSpeed();
+	float SpeedDiff = Weapon.m_pSpeedDiff ? (float)(GameServer()->Tuning()->*Weapon.m_pSpeedDiff) : 1.0f;
+
+	vec2 ProjStartPos = Pos() + Direction * GetProximityRadius() * 0.75f;
+	float Angle = angle(Direction);
+	int Center = Weapon.m_NumProjectiles / 2;
+
+	CMsgPacker Msg(NETMSGTYPE_SV_EXTRAPROJECTILE);
+	Msg.AddInt(Weapon.m_NumProjectiles);
+
+	for(int i = 0; i < Weapon.m_NumProjectiles; i++)
+	{
+		vec2 Dir = Direction;
+		if(Weapon.m_pSpreading)
+		{
+			float a = Angle + Weapon.m_pSpreading[i];
+			float v = Center ? 1 - (absolute(i - Center) / (float)Center) : 1.0f;
+			Dir = vec2(cosf(a), sinf(a)) * mix(SpeedDiff, 1.0f, v);
+		}
+		CProjectile *pProj = new CProjectile(
+			GameWorld(),
+			Weapon.m_Type, //Type
+			GetWeaponID(), //WeaponID
+			ClientID, //Owner
+			ProjStartPos, //Pos
+			Dir, //Dir
+			6.0f, // Radius
+			Lifetime, //Span
+			Weapon.m_Callback);
+
+		// pack the Projectile and send it to the client Directly
+		CNetObj_Projectile p;
+		pProj->FillInfo(&p);
+
+		for(unsigned j = 0; j < sizeof(CNetObj_Projectile) / sizeof(int); j++)
+			Msg.AddInt(((int *)&p)[j]);
+	}
+
+	Server()->SendMsg(&Msg, MSGFLAG_VITAL, ClientID);
+	GameWorld()->CreateSound(Pos(), Weapon.m_Sound);
+}
+
 vec2 CWeapon::Pos() { return Character()->m_Pos; }
 float CWeapon::GetProximityRadius() { return Character()->GetProximityRadius(); }
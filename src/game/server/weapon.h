@@ -2,8 +2,24 @@
 #define GAME_SERVER_WEAPON_H
 
 #include <game/server/entities/character.h>
+#include <game/server/entities/projectile.h>
 #include <game/server/player.h>
 
+// what one shot of a projectile weapon spawns, see `CWeapon::FireProjectiles`
+struct SProjectileWeapon
+{
+	int m_Type;
+	CTuneParam CTuningParams::*m_pLifetime;
+	// angle offsets of the projectiles, nullptr to fire one straight ahead
+	const float *m_pSpreading;
+	int m_NumProjectiles;
+	// speed of the outermost projectiles, the ones in between are mixed
+	// towards full speed, nullptr if all are equally fast
+	CTuneParam CTuningParams::*m_pSpeedDiff;
+	FProjectileImpactCallback m_Callback;
+	int m_Sound;
+};
+
 class CWeapon
 {
 private:
@@ -30,6 +46,10 @@ protected:
 
 	virtual void Fire(vec2 Direction) = 0;
 
+	// spawns the projectiles of one shot and sends them to the owner in
+	// one message
+	void FireProjectiles(const SProjectileWeapon &Weapon, vec2 Direction);
+
 public:
 	CWeapon(CCharacter *pOwnerChar);
 	virtual ~CWeapon(){};
@@ -22,33 +22,17 @@ bool CGrenade::GrenadeCollide(CProjectile *pProj, vec2 Pos, CCharacter *pHit, bo
 	return true;
 }
 
+const SProjectileWeapon CGrenade::ms_Projectile = {
+	WEAPON_GRENADE,
+	&CTuningParams::m_GrenadeLifetime,
+	nullptr,
+	1,
+	nullptr,
+	GrenadeCollide,
+	SOUND_GRENADE_FIRE,
+};
+
 void CGrenade::Fire(vec2 Direction)
 {
-	int ClientID = Character()->GetPlayer()->GetCID();
-	int Lifetime = Character()->CurrentTuning()->m_GrenadeLifetime * Server()->TickSpeed();
-
-	vec2 ProjStartPos = Pos() + Direction * GetProximityRadius() * 0.75f;
-
-	CProjectile *pProj = new CProjectile(
-		GameWorld(),
-		WEAPON_GRENADE, //Type
-		GetWeaponID(), //WeaponID
-		ClientID, //Owner
-		ProjStartPos, //Pos
-		Direction, //Dir
-		6.0f, // Radius
-		Lifetime, //Span
-		GrenadeCollide);
-
-	// pack the Projectile and send it to the client Directly
-	CNetObj_Projectile p;
-	pProj->FillInfo(&p);
-
-	CMsgPacker Msg(NETMSGTYPE_SV_EXTRAPROJECTILE);
-	Msg.AddInt(1);
-	for(unsigned i = 0; i < sizeof(CNetObj_Projectile) / sizeof(int); i++)
-		Msg.AddInt(((int *)&p)[i]);
-
-	Server()->SendMsg(&Msg, MSGFLAG_VITAL, ClientID);
-	GameWorld()->CreateSound(Character()->m_Pos, SOUND_GRENADE_FIRE);
-}
\ No newline at end of file
+	FireProjectiles(ms_Projectile, Direction);
+}
@@ -11,6 +11,9 @@ public:
 	void Fire(vec2 Direction) override;
 	int GetType() override { return WEAPON_GRENADE; }
 
+	// what one shot spawns, variants can fire their own definitions
+	static const SProjectileWeapon ms_Projectile;
+
 	// callback
 	static bool GrenadeCollide(class CProjectile *pProj, vec2 Pos, CCharacter *pHit, bool EndOfLife);
 };
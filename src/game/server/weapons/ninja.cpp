@@ -44,7 +44,9 @@ void CNinja::Tick()
 		// Set velocity
 		Character()->Core()->m_Vel = m_ActivationDir * g_pData->m_Weapons.m_Ninja.m_Velocity;
 		vec2 OldPos = Pos();
-		GameServer()->Collision()->MoveBox(&Character()->Core()->m_Pos, &Character()->Core()->m_Vel, vec2(GetProximityRadius(), GetProximityRadius()), 0.f);
+		vec2 NewPos = Character()->Core()->m_Pos;
+		GameServer()->Collision()->MoveBox(&NewPos, &Character()->Core()->m_Vel, vec2(GetProximityRadius(), GetProximityRadius()), 0.f);
+		Character()->Core()->SetPos(NewPos);
 
 		// reset velocity so the client doesn't predict stuff
 		Character()->Core()->m_Vel = vec2(0.f, 0.f);
@@ -23,33 +23,17 @@ bool CPistol::BulletCollide(CProjectile *pProj, vec2 Pos, CCharacter *pHit, bool
 	return true;
 }
 
+const SProjectileWeapon CPistol::ms_Projectile = {
+	WEAPON_GUN,
+	&CTuningParams::m_GunLifetime,
+	nullptr,
+	1,
+	nullptr,
+	BulletCollide,
+	SOUND_GUN_FIRE,
+};
+
 void CPistol::Fire(vec2 Direction)
 {
-	int ClientID = Character()->GetPlayer()->GetCID();
-	int Lifetime = Character()->CurrentTuning()->m_GunLifetime * Server()->TickSpeed();
-
-	vec2 ProjStartPos = Pos() + Direction * GetProximityRadius() * 0.75f;
-
-	CProjectile *pProj = new CProjectile(
-		GameWorld(),
-		WEAPON_GUN, //Type
-		GetWeaponID(), //WeaponID
-		ClientID, //Owner
-		ProjStartPos, //Pos
-		Direction, //Dir
-		6.0f, // Radius
-		Lifetime, //Span
-		BulletCollide);
-
-	// pack the Projectile and send it to the client Directly
-	CNetObj_Projectile p;
-	pProj->FillInfo(&p);
-
-	CMsgPacker Msg(NETMSGTYPE_SV_EXTRAPROJECTILE);
-	Msg.AddInt(1);
-	for(unsigned i = 0; i < sizeof(CNetObj_Projectile) / sizeof(int); i++)
-		Msg.AddInt(((int *)&p)[i]);
-
-	Server()->SendMsg(&Msg, MSGFLAG_VITAL, ClientID);
-	GameWorld()->CreateSound(Character()->m_Pos, SOUND_GUN_FIRE);
-}
\ No newline at end of file
+	FireProjectiles(ms_Projectile, Direction);
+}
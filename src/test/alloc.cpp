@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/alloc.h>
+
+#include <set>
+#include <vector>
+
+TEST(FixedPool, ReusesFreedBlocks)
+{
+	CFixedPool Pool(100, 4);
+	std::vector<void *> vpBlocks;
+	for(int i = 0; i < 10; i++)
+		vpBlocks.push_back(Pool.Allocate());
+	EXPECT_EQ(Pool.NumUsed(), 10);
+	EXPECT_EQ(Pool.NumChunks(), 3);
+
+	// distinct and aligned
+	std::set<void *> Distinct(vpBlocks.begin(), vpBlocks.end());
+	EXPECT_EQ(Distinct.size(), vpBlocks.size());
+	for(void *pBlock : vpBlocks)
+		EXPECT_EQ((uintptr_t)pBlock % alignof(std::max_align_t), 0u);
+
+	void *pFreed = vpBlocks[5];
+	Pool.Free(pFreed);
+	EXPECT_EQ(Pool.Allocate(), pFreed);
+
+	for(void *pBlock : vpBlocks)
+		Pool.Free(pBlock);
+	EXPECT_EQ(Pool.NumUsed(), 0);
+	for(int i = 0; i < 12; i++)
+		Pool.Allocate();
+	EXPECT_EQ(Pool.NumChunks(), 3);
+}
+
+TEST(Arena, ScopedAllocations)
+{
+	CArena *pArena = new CArena();
+	void *pHeap = CArena::Allocate(100);
+	EXPECT_EQ(pArena->NumUsed(), 0);
+
+	void *pSmall;
+	void *pLarge;
+	{
+		CArena::CScope Scope(pArena);
+		EXPECT_EQ(CArena::Current(), pArena);
+		pSmall = CArena::Allocate(100);
+		pLarge = CArena::Allocate(CArena::MAX_BLOCK_SIZE);
+		{
+			// nested scopes without an arena use the heap
+			CArena::CScope HeapScope(nullptr);
+			CArena::Free(CArena::Allocate(100));
+		}
+		EXPECT_EQ(CArena::Current(), pArena);
+	}
+	EXPECT_EQ(CArena::Current(), nullptr);
+	EXPECT_EQ(pArena->NumUsed(), 2);
+	EXPECT_EQ(pArena->UsedSize(), 100u + CArena::MAX_BLOCK_SIZE);
+	EXPECT_EQ((uintptr_t)pSmall % alignof(std::max_align_t), 0u);
+	EXPECT_EQ((uintptr_t)pLarge % alignof(std::max_align_t), 0u);
+
+	// blocks of the same size class are reused
+	CArena::Free(pSmall);
+	{
+		CArena::CScope Scope(pArena);
+		EXPECT_EQ(CArena::Allocate(110), pSmall);
+	}
+
+	// freeing the last block frees a released arena, no leaks under asan
+	pArena->Release();
+	CArena::Free(pLarge);
+	EXPECT_EQ(pArena->NumUsed(), 1);
+	CArena::Free(pSmall);
+	CArena::Free(pHeap);
+}
+
+TEST(Arena, ReleasedArenaUsesHeap)
+{
+	CArena *pArena = new CArena();
+	CArena::CScope Scope(pArena);
+	pArena->Release();
+	// the scope keeps the arena alive, new blocks don't
+	void *p = CArena::Allocate(100);
+	EXPECT_EQ(pArena->NumUsed(), 0);
+	CArena::Free(p);
+}
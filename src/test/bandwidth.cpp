@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <engine/server/bandwidth.h>
+
+static void Snap(CBandwidthStats *pStats, int ClientID, int Room, int Type, int Bytes, int DeltaBytes)
+{
+	pStats->SnapItemStats()[Type] += Bytes;
+	pStats->DeltaItemStats()[Type] += DeltaBytes;
+	pStats->CommitSnap(ClientID, Room);
+}
+
+static void ExpectSums(const CBandwidthStats &Stats, const CBandwidthCounters &Clients, const CBandwidthCounters &Rooms)
+{
+	EXPECT_EQ(mem_comp(&Clients, &Stats.Global(), sizeof(Clients)), 0);
+	EXPECT_EQ(Rooms.SnapTotal(), Stats.Global().SnapTotal());
+	EXPECT_EQ(Rooms.DeltaTotal(), Stats.Global().DeltaTotal());
+	EXPECT_EQ(Rooms.MsgTotal(), Stats.Global().MsgTotal());
+}
+
+TEST(Bandwidth, Sums)
+{
+	CBandwidthStats Stats;
+	Snap(&Stats, 0, 0, 1, 100, 10);
+	Snap(&Stats, 1, 0, 1, 100, 20);
+	Snap(&Stats, 2, 3, 2, 50, 5);
+	Stats.OnSendMsg(0, 0, true, 4, 7);
+	Stats.OnSendMsg(2, 3, false, 12, 30);
+	// uuid messages end up in the last bucket
+	Stats.OnSendMsg(2, 3, false, 1000, 3);
+
+	EXPECT_EQ(Stats.Global().SnapTotal(), 250);
+	EXPECT_EQ(Stats.Global().DeltaTotal(), 35);
+	EXPECT_EQ(Stats.Global().MsgTotal(), 40);
+	EXPECT_EQ(Stats.Global().m_aGameMsgBytes[CBandwidthCounters::NUM_MSG_TYPES - 1], 3);
+
+	EXPECT_EQ(Stats.Client(1).DeltaTotal(), 20);
+	EXPECT_EQ(Stats.Room(0).m_aSnapItemBytes[1], 200);
+	EXPECT_EQ(Stats.Room(3).MsgTotal(), 33);
+
+	CBandwidthCounters Clients, Rooms;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		Clients.Add(Stats.Client(i));
+		Rooms.Add(Stats.Room(i));
+	}
+	ExpectSums(Stats, Clients, Rooms);
+	EXPECT_EQ(mem_comp(&Rooms, &Stats.Global(), sizeof(Rooms)), 0);
+}
+
+TEST(Bandwidth, ResetRoom)
+{
+	CBandwidthStats Stats;
+	Snap(&Stats, 0, 0, 1, 100, 10);
+	Snap(&Stats, 1, 5, 1, 60, 6);
+	Stats.OnSendMsg(1, 5, false, 3, 9);
+
+	Stats.ResetRoom(5);
+	EXPECT_EQ(Stats.Room(5).SnapTotal(), 0);
+	EXPECT_EQ(Stats.Room(5).DeltaTotal(), 0);
+	EXPECT_EQ(Stats.Room(5).MsgTotal(), 0);
+	EXPECT_EQ(Stats.Room(0).SnapTotal(), 100);
+	// the clients and the server keep what they were sent
+	EXPECT_EQ(Stats.Client(1).SnapTotal(), 60);
+	EXPECT_EQ(Stats.Global().SnapTotal(), 160);
+
+	// the next room with the id starts from zero
+	Snap(&Stats, 2, 5, 2, 40, 4);
+	EXPECT_EQ(Stats.Room(5).SnapTotal(), 40);
+	EXPECT_EQ(Stats.Global().SnapTotal(), 200);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <game/server/catchchains.h>
+
+#include <random>
+#include <vector>
+
+// the hearts are numbered on their creation, 0 is no heart yet
+class CTestChains : public CCatchChains<int>
+{
+public:
+	int m_NumCreated = 0;
+
+	bool CatchWithHeart(int ClientID, int By)
+	{
+		if(!Catch(ClientID, By))
+			return false;
+		if(!Heart(ClientID))
+			Heart(ClientID) = ++m_NumCreated;
+		return true;
+	}
+
+	std::vector<int> Chain(int By) const
+	{
+		std::vector<int> vChain;
+		for(int i = First(By); i != -1; i = Next(i))
+			vChain.push_back(i);
+		return vChain;
+	}
+
+	std::vector<int> ChainBackwards(int By) const
+	{
+		std::vector<int> vChain;
+		for(int i = Last(By); i != -1; i = Prev(i))
+			vChain.insert(vChain.begin(), i);
+		return vChain;
+	}
+};
+
+TEST(CatchChains, HeartReuse)
+{
+	CTestChains Chains;
+	EXPECT_TRUE(Chains.CatchWithHeart(1, 0));
+	EXPECT_TRUE(Chains.CatchWithHeart(2, 0));
+	EXPECT_FALSE(Chains.CatchWithHeart(1, 3));
+	EXPECT_EQ(Chains.m_NumCreated, 2);
+	EXPECT_EQ(Chains.CaughtBy(1), 0);
+
+	// catching again takes the old hearts
+	EXPECT_EQ(Chains.Release(1, false), 0);
+	EXPECT_EQ(Chains.Release(2, false), 0);
+	EXPECT_EQ(Chains.Release(2, false), -1);
+	EXPECT_TRUE(Chains.CatchWithHeart(1, 3));
+	EXPECT_TRUE(Chains.CatchWithHeart(2, 1));
+	EXPECT_EQ(Chains.m_NumCreated, 2);
+
+	// the kill animation keeps the heart in place
+	EXPECT_EQ(Chains.Release(1, true), 3);
+	EXPECT_EQ(Chains.HeartID(1), 0);
+	Chains.ClearHeartID(1);
+	EXPECT_TRUE(Chains.CatchWithHeart(1, 2));
+	EXPECT_EQ(Chains.m_NumCreated, 2);
+
+	// so does a new round
+	Chains.Reset();
+	EXPECT_EQ(Chains.CaughtBy(1), -1);
+	EXPECT_TRUE(Chains.CatchWithHeart(1, 0));
+	EXPECT_TRUE(Chains.CatchWithHeart(2, 0));
+	EXPECT_TRUE(Chains.CatchWithHeart(3, 0));
+	EXPECT_EQ(Chains.m_NumCreated, 3);
+}
+
+TEST(CatchChains, ReleaseKeepsLinks)
+{
+	CTestChains Chains;
+	for(int i = 1; i <= 4; i++)
+		Chains.CatchWithHeart(i, 0);
+	int BHeart = Chains.Heart(2);
+
+	// the last one takes the place and the heart of the released one
+	EXPECT_EQ(Chains.Release(2, false), 0);
+	EXPECT_EQ(Chains.Chain(0), (std::vector<int>{1, 4, 3}));
+	EXPECT_EQ(Chains.ChainBackwards(0), (std::vector<int>{1, 4, 3}));
+	EXPECT_EQ(Chains.NumCaught(0), 3);
+	EXPECT_EQ(Chains.HeartID(1), 0);
+	EXPECT_EQ(Chains.HeartID(4), 1);
+	EXPECT_EQ(Chains.HeartID(3), 2);
+	EXPECT_EQ(Chains.HeartID(2), -1);
+	EXPECT_EQ(Chains.Heart(4), BHeart);
+	EXPECT_EQ(Chains.Prev(2), -1);
+	EXPECT_EQ(Chains.Next(2), -1);
+
+	// the ends
+	EXPECT_EQ(Chains.Release(3, false), 0);
+	EXPECT_EQ(Chains.Chain(0), (std::vector<int>{1, 4}));
+	EXPECT_EQ(Chains.Release(1, false), 0);
+	EXPECT_EQ(Chains.Chain(0), (std::vector<int>{4}));
+	EXPECT_EQ(Chains.ChainBackwards(0), (std::vector<int>{4}));
+	EXPECT_EQ(Chains.HeartID(4), 0);
+
+	// a kill leaves a gap for the animation
+	Chains.CatchWithHeart(1, 0);
+	Chains.CatchWithHeart(3, 0);
+	EXPECT_EQ(Chains.Release(1, true), 0);
+	EXPECT_EQ(Chains.Chain(0), (std::vector<int>{4, 3}));
+	EXPECT_EQ(Chains.ChainBackwards(0), (std::vector<int>{4, 3}));
+	EXPECT_EQ(Chains.HeartID(1), 1);
+	EXPECT_EQ(Chains.HeartID(3), 2);
+	EXPECT_EQ(Chains.Release(4, false), 0);
+	EXPECT_EQ(Chains.Release(3, false), 0);
+	EXPECT_EQ(Chains.First(0), -1);
+	EXPECT_EQ(Chains.Last(0), -1);
+	EXPECT_EQ(Chains.NumCaught(0), 0);
+}
+
+TEST(CatchChains, Random)
+{
+	CTestChains Chains;
+	std::mt19937 Rng(42);
+	for(int Step = 0; Step < 20000; Step++)
+	{
+		int ClientID = Rng() % MAX_CLIENTS;
+		if(Chains.CaughtBy(ClientID) == -1)
+			Chains.CatchWithHeart(ClientID, Rng() % 4);
+		else
+			Chains.Release(ClientID, false);
+
+		std::vector<bool> vSeen(Chains.m_NumCreated + 1, false);
+		for(int By = 0; By < MAX_CLIENTS; By++)
+		{
+			std::vector<int> vChain = Chains.Chain(By);
+			ASSERT_EQ(vChain, Chains.ChainBackwards(By));
+			ASSERT_EQ((int)vChain.size(), Chains.NumCaught(By));
+			for(int i = 0; i < (int)vChain.size(); i++)
+			{
+				ASSERT_EQ(Chains.CaughtBy(vChain[i]), By);
+				ASSERT_EQ(Chains.HeartID(vChain[i]), i);
+				int Heart = Chains.Heart(vChain[i]);
+				ASSERT_GT(Heart, 0);
+				ASSERT_FALSE(vSeen[Heart]);
+				vSeen[Heart] = true;
+			}
+		}
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(Chains.CaughtBy(i) == -1)
+			{
+				ASSERT_EQ(Chains.HeartID(i), -1);
+			}
+		}
+		ASSERT_LE(Chains.m_NumCreated, MAX_CLIENTS);
+	}
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/clientmask.h>
+
+#include <random>
+
+template<int NUM_CLIENTS>
+static void CheckOperations()
+{
+	typedef CGenericClientMask<NUM_CLIENTS> CMask;
+	std::mt19937 Rng(NUM_CLIENTS);
+	for(int Round = 0; Round < 100; Round++)
+	{
+		bool aA[NUM_CLIENTS], aB[NUM_CLIENTS];
+		CMask A, B;
+		for(int i = 0; i < NUM_CLIENTS; i++)
+		{
+			aA[i] = Rng() % 2;
+			aB[i] = Rng() % 2;
+			if(aA[i])
+				A.Set(i);
+			if(aB[i])
+				B.Set(i);
+		}
+		CMask Or = A | B;
+		CMask And = A & B;
+		CMask Not = ~A;
+		for(int i = 0; i < NUM_CLIENTS; i++)
+		{
+			ASSERT_EQ(A.IsSet(i), aA[i]);
+			ASSERT_EQ(Or.IsSet(i), aA[i] || aB[i]);
+			ASSERT_EQ(And.IsSet(i), aA[i] && aB[i]);
+			ASSERT_EQ(Not.IsSet(i), !aA[i]);
+		}
+		EXPECT_TRUE((A & Not).IsEmpty());
+		EXPECT_EQ(A | Not, CMask::All());
+	}
+
+	CMask Mask = CMask::One(NUM_CLIENTS - 1);
+	EXPECT_TRUE(Mask.IsSet(NUM_CLIENTS - 1));
+	EXPECT_FALSE(Mask.IsSet(0));
+	Mask.Unset(NUM_CLIENTS - 1);
+	EXPECT_TRUE(Mask.IsEmpty());
+	EXPECT_EQ(Mask, CMask());
+	EXPECT_NE(Mask, CMask::All());
+}
+
+TEST(ClientMask, Operations64)
+{
+	CheckOperations<64>();
+}
+
+TEST(ClientMask, Operations128)
+{
+	CheckOperations<128>();
+}
+
+TEST(ClientMask, Operations256)
+{
+	CheckOperations<256>();
+}
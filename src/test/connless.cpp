@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <engine/masterserver.h>
+#include <engine/shared/network.h>
+
+#include <memory>
+#include <vector>
+
+static std::vector<unsigned char> InfoRequest(bool Extended, int Token)
+{
+	std::vector<unsigned char> vPacket;
+	if(Extended)
+		vPacket = {'x', 'e', (unsigned char)(Token >> 16), (unsigned char)(Token >> 8), 0, 0};
+	else
+		vPacket.assign(6, 0xff);
+	vPacket.insert(vPacket.end(), SERVERBROWSE_GETINFO, SERVERBROWSE_GETINFO + sizeof(SERVERBROWSE_GETINFO));
+	vPacket.push_back(Token & 0xff);
+	return vPacket;
+}
+
+static int Classify(const std::vector<unsigned char> &vPacket, int *pToken = nullptr, int *pType = nullptr)
+{
+	int Token = -1, Type = -1;
+	int Kind = CNetConnlessFilter::Classify(vPacket.data(), vPacket.size(), &Token, &Type);
+	if(pToken)
+		*pToken = Token;
+	if(pType)
+		*pType = Type;
+	return Kind;
+}
+
+TEST(Connless, Classify)
+{
+	int Token, Type;
+	EXPECT_EQ(Classify(InfoRequest(false, 0x42), &Token, &Type), CNetConnlessFilter::KIND_INFO);
+	EXPECT_EQ(Token, 0x42);
+	EXPECT_EQ(Type, SERVERINFO_VANILLA);
+	EXPECT_EQ(Classify(InfoRequest(true, 0x123456), &Token, &Type), CNetConnlessFilter::KIND_INFO);
+	EXPECT_EQ(Token, 0x123456);
+	EXPECT_EQ(Type, SERVERINFO_EXTENDED);
+
+	// request without token
+	std::vector<unsigned char> vShort = InfoRequest(false, 0);
+	vShort.pop_back();
+	EXPECT_EQ(Classify(vShort), CNetConnlessFilter::KIND_OTHER);
+
+	// connected packets are left alone
+	EXPECT_EQ(Classify({0x10, 0x00, 0x01, 0x05}), CNetConnlessFilter::KIND_CONNECTED);
+
+	// too short or unknown connless header
+	EXPECT_EQ(Classify({0xff, 0xff}), CNetConnlessFilter::KIND_JUNK);
+	EXPECT_EQ(Classify({0xff, 0xff, 0xff, 0xff, 0xff}), CNetConnlessFilter::KIND_JUNK);
+	EXPECT_EQ(Classify({0xff, 0x00, 0xff, 0xff, 0xff, 0xff, 'a'}), CNetConnlessFilter::KIND_JUNK);
+	EXPECT_EQ(Classify(std::vector<unsigned char>(NET_MAX_PACKETSIZE + 1, 0xff)), CNetConnlessFilter::KIND_JUNK);
+
+	// 0.7 connless, tokens are checked later
+	EXPECT_EQ(Classify({0x21, 1, 2, 3, 4, 5, 6, 7, 8, 'x'}), CNetConnlessFilter::KIND_OTHER);
+	EXPECT_EQ(Classify({0x21, 1, 2, 3, 4}), CNetConnlessFilter::KIND_JUNK);
+}
+
+TEST(Connless, RateLimit)
+{
+	std::unique_ptr<CNetConnlessFilter> pFilter(new CNetConnlessFilter());
+	NETADDR Addr1, Addr2;
+	net_addr_from_str(&Addr1, "1.2.3.4:1000");
+	net_addr_from_str(&Addr2, "5.6.7.8:1000");
+
+	const int64 Start = time_freq() * 1000;
+	for(int i = 0; i < 5; i++)
+		EXPECT_TRUE(pFilter->Allow(&Addr1, Start, 2, 5));
+	EXPECT_FALSE(pFilter->Allow(&Addr1, Start, 2, 5));
+
+	// the port doesn't matter, other addresses have their own bucket
+	Addr1.port = 2000;
+	EXPECT_FALSE(pFilter->Allow(&Addr1, Start, 2, 5));
+	EXPECT_TRUE(pFilter->Allow(&Addr2, Start, 2, 5));
+	EXPECT_EQ(pFilter->NumLimited(), 2);
+
+	// refills with 2 packets per second
+	EXPECT_TRUE(pFilter->Allow(&Addr1, Start + time_freq() / 2, 2, 5));
+	EXPECT_FALSE(pFilter->Allow(&Addr1, Start + time_freq() / 2, 2, 5));
+	for(int i = 0; i < 5; i++)
+		EXPECT_TRUE(pFilter->Allow(&Addr1, Start + time_freq() * 100, 2, 5));
+	EXPECT_FALSE(pFilter->Allow(&Addr1, Start + time_freq() * 100, 2, 5));
+
+	// no limit
+	EXPECT_TRUE(pFilter->Allow(&Addr1, Start + time_freq() * 100, 0, 5));
+}
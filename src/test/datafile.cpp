@@ -5,6 +5,8 @@
 #include <engine/storage.h>
 #include <game/mapitems_ex.h>
 
+#include <vector>
+
 TEST(Datafile, ExtendedType)
 {
 	IStorage *pStorage = CreateLocalStorage();
@@ -59,3 +61,41 @@ TEST(Datafile, ExtendedType)
 
 	delete pStorage;
 }
+
+TEST(Datafile, CompressedData)
+{
+	IStorage *pStorage = CreateLocalStorage();
+	CTestInfo Info;
+
+	int aData[256];
+	for(int i = 0; i < 256; i++)
+		aData[i] = i % 7;
+	unsigned long CompressedSize = compressBound(sizeof(aData));
+	std::vector<unsigned char> vCompressed(CompressedSize);
+	ASSERT_EQ(compress2(vCompressed.data(), &CompressedSize, (const Bytef *)aData, sizeof(aData), Z_DEFAULT_COMPRESSION), Z_OK);
+
+	{
+		CDataFileWriter Writer;
+		Writer.Open(pStorage, Info.m_aFilename);
+		EXPECT_EQ(Writer.AddData(sizeof(aData), aData), 0);
+		EXPECT_EQ(Writer.AddDataCompressed(sizeof(aData), vCompressed.data(), CompressedSize), 1);
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage, Info.m_aFilename, IStorage::TYPE_ALL));
+		for(int Index = 0; Index < 2; Index++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(Index), (int)sizeof(aData));
+			EXPECT_EQ(mem_comp(Reader.GetData(Index), aData, sizeof(aData)), 0);
+		}
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+
+	delete pStorage;
+}
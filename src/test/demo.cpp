@@ -0,0 +1,114 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <cstddef>
+#include <vector>
+
+static void RecordDemo(IStorage *pStorage, const char *pFilename, int AsyncBufferSize, CDemoRecorder::CWriterStats *pStats)
+{
+	CSnapshotDelta SnapshotDelta;
+	CDemoRecorder Recorder(&SnapshotDelta, true);
+	Recorder.SetAsync(AsyncBufferSize);
+
+	SHA256_DIGEST Sha256 = {{0}};
+	unsigned char MapData = 0;
+	ASSERT_EQ(Recorder.Start(pStorage, 0, pFilename, "0.6 626fce9a778df4d4", "test", &Sha256, 0, "server", 0, &MapData), 0);
+	EXPECT_EQ(Recorder.IsAsync(), AsyncBufferSize > 0);
+
+	CSnapshotBuilder Builder;
+	char aData[CSnapshot::MAX_SIZE];
+	for(int Tick = 1; Tick <= 1000; Tick++)
+	{
+		Builder.Init();
+		for(int i = 0; i < 16; i++)
+		{
+			int *pItem = (int *)Builder.NewItem(1, i, 4 * sizeof(int));
+			pItem[0] = i;
+			pItem[1] = Tick / (i + 1);
+			pItem[2] = Tick % 7;
+			pItem[3] = 0;
+		}
+		int Size = Builder.Finish(aData);
+		Recorder.RecordSnapshot(Tick, aData, Size);
+
+		if(Tick % 10 == 0)
+		{
+			int aMsg[4] = {Tick, 1, 2, 3};
+			Recorder.RecordMessage(aMsg, sizeof(aMsg));
+		}
+		if(Tick % 100 == 0)
+			Recorder.AddDemoMarker();
+	}
+	EXPECT_EQ(Recorder.Length(), 999 / SERVER_TICK_SPEED);
+
+	if(pStats)
+		Recorder.GetWriterStats(pStats);
+	EXPECT_EQ(Recorder.Stop(), 0);
+}
+
+static std::vector<unsigned char> ReadDemo(IStorage *pStorage, const char *pFilename)
+{
+	std::vector<unsigned char> vData;
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	EXPECT_TRUE(File);
+	if(!File)
+		return vData;
+	vData.resize(io_length(File));
+	io_read(File, vData.data(), vData.size());
+	io_close(File);
+
+	// the timestamp may differ between two recordings
+	if(vData.size() >= sizeof(CDemoHeader))
+		mem_zero(&vData[offsetof(CDemoHeader, m_aTimestamp)], sizeof(CDemoHeader::m_aTimestamp));
+	return vData;
+}
+
+TEST(Demo, AsyncWriterMatchesSync)
+{
+	CNetBase::Init();
+	CTestInfo Info;
+	IStorage *pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+
+	RecordDemo(pStorage, "sync.demo", 0, 0);
+	CDemoRecorder::CWriterStats Stats;
+	RecordDemo(pStorage, "async.demo", 1024 * 1024, &Stats);
+	EXPECT_EQ(Stats.m_NumRecords, 1100);
+	EXPECT_EQ(Stats.m_NumSync, 0);
+	EXPECT_LE(Stats.m_PeakBytes, Stats.m_BufferSize);
+
+	std::vector<unsigned char> vSync = ReadDemo(pStorage, "sync.demo");
+	std::vector<unsigned char> vAsync = ReadDemo(pStorage, "async.demo");
+	EXPECT_GT(vSync.size(), sizeof(CDemoHeader));
+	EXPECT_TRUE(vSync == vAsync);
+
+	delete pStorage;
+	Info.DeleteTestStorageFilesOnSuccess();
+}
+
+TEST(Demo, AsyncWriterWritesSyncWhenFull)
+{
+	CNetBase::Init();
+	CTestInfo Info;
+	IStorage *pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+
+	// too small for a single snapshot, only the messages fit
+	RecordDemo(pStorage, "sync.demo", 0, 0);
+	CDemoRecorder::CWriterStats Stats;
+	RecordDemo(pStorage, "small.demo", 64, &Stats);
+	EXPECT_EQ(Stats.m_NumRecords, 1100);
+	EXPECT_GE(Stats.m_NumSync, 1000);
+	EXPECT_LE(Stats.m_PeakBytes, 64);
+
+	// nothing is lost and the order is kept
+	EXPECT_TRUE(ReadDemo(pStorage, "sync.demo") == ReadDemo(pStorage, "small.demo"));
+
+	delete pStorage;
+	Info.DeleteTestStorageFilesOnSuccess();
+}
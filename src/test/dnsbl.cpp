@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/engine.h>
+#include <engine/server/dnsbl.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <set>
+#include <string>
+
+// In-process stand-in for a dnsbl provider: lists the queries it was given,
+// answers only once released.
+class CFakeResolver : public IDnsblResolver
+{
+	std::mutex m_Lock;
+	std::condition_variable m_Released;
+	bool m_Release = false;
+	std::vector<std::string> m_vQueries;
+
+public:
+	std::set<std::string> m_Listed;
+
+	bool IsListed(const char *pQuery) override
+	{
+		std::unique_lock Lock(m_Lock);
+		m_vQueries.emplace_back(pQuery);
+		m_Released.wait(Lock, [&] { return m_Release; });
+		return m_Listed.count(pQuery) != 0;
+	}
+
+	void Release()
+	{
+		std::unique_lock Lock(m_Lock);
+		m_Release = true;
+		m_Released.notify_all();
+	}
+
+	int NumQueries()
+	{
+		std::unique_lock Lock(m_Lock);
+		return m_vQueries.size();
+	}
+
+	bool HasQuery(const char *pQuery)
+	{
+		std::unique_lock Lock(m_Lock);
+		return std::find(m_vQueries.begin(), m_vQueries.end(), pQuery) != m_vQueries.end();
+	}
+};
+
+static NETADDR Addr(const char *pStr)
+{
+	NETADDR Addr;
+	EXPECT_EQ(net_addr_from_str(&Addr, pStr), 0);
+	return Addr;
+}
+
+static int UpdateUntil(CDnsbl &Dnsbl, int Expected, std::vector<std::pair<std::string, bool>> &vVerdicts)
+{
+	int Num = 0;
+	for(int i = 0; i < 10000 && Num < Expected; i++)
+	{
+		Num += Dnsbl.Update(time_get(), [&](const NETADDR *pAddr, bool Listed) {
+			char aAddr[NETADDR_MAXSTRSIZE];
+			net_addr_str(pAddr, aAddr, sizeof(aAddr), false);
+			vVerdicts.emplace_back(aAddr, Listed);
+		});
+		thread_sleep(1000);
+	}
+	return Num;
+}
+
+TEST(Dnsbl, LookupAndCache)
+{
+	IEngine *pEngine = CreateEngine("dnsbl-test", true, 2);
+	auto pResolver = std::make_shared<CFakeResolver>();
+	pResolver->m_Listed.insert("4.3.2.1.dnsbl.test");
+
+	CDnsbl Dnsbl;
+	Dnsbl.Init(pEngine, pResolver);
+	Dnsbl.SetProvider("dnsbl.test", "", 60);
+
+	// nothing finished yet
+	std::vector<std::pair<std::string, bool>> vVerdicts;
+	EXPECT_EQ(Dnsbl.Update(time_get(), [](const NETADDR *, bool) {}), 0);
+
+	NETADDR Listed = Addr("1.2.3.4:8303");
+	NETADDR Clean = Addr("5.6.7.8:8303");
+	EXPECT_EQ(Dnsbl.Lookup(&Listed, time_get()), CDnsbl::VERDICT_PENDING);
+	EXPECT_EQ(Dnsbl.Lookup(&Clean, time_get()), CDnsbl::VERDICT_PENDING);
+
+	// a second client from the same address shares the lookup
+	NETADDR ListedOtherPort = Addr("1.2.3.4:9000");
+	EXPECT_EQ(Dnsbl.Lookup(&ListedOtherPort, time_get()), CDnsbl::VERDICT_PENDING);
+	EXPECT_EQ(Dnsbl.NumPending(), 2);
+
+	NETADDR Ipv6 = Addr("[::1]:8303");
+	EXPECT_EQ(Dnsbl.Lookup(&Ipv6, time_get()), CDnsbl::VERDICT_UNSUPPORTED);
+
+	pResolver->Release();
+	EXPECT_EQ(UpdateUntil(Dnsbl, 2, vVerdicts), 2);
+	EXPECT_EQ(pResolver->NumQueries(), 2);
+	EXPECT_EQ(Dnsbl.NumPending(), 0);
+	EXPECT_EQ(Dnsbl.NumCached(), 2);
+	std::sort(vVerdicts.begin(), vVerdicts.end());
+	ASSERT_EQ(vVerdicts.size(), 2u);
+	EXPECT_EQ(vVerdicts[0], std::make_pair(std::string("1.2.3.4"), true));
+	EXPECT_EQ(vVerdicts[1], std::make_pair(std::string("5.6.7.8"), false));
+
+	// answered from the cache without another query
+	EXPECT_EQ(Dnsbl.Lookup(&ListedOtherPort, time_get()), CDnsbl::VERDICT_LISTED);
+	EXPECT_EQ(Dnsbl.Lookup(&Clean, time_get()), CDnsbl::VERDICT_CLEAN);
+	EXPECT_EQ(pResolver->NumQueries(), 2);
+
+	// expired verdicts are looked up again
+	EXPECT_EQ(Dnsbl.Lookup(&Clean, time_get() + 61 * time_freq()), CDnsbl::VERDICT_PENDING);
+
+	// so are verdicts of a previous provider
+	EXPECT_FALSE(Dnsbl.SetProvider("dnsbl.test", "", 60));
+	EXPECT_TRUE(Dnsbl.SetProvider("dnsbl.test", "key", 60));
+	EXPECT_EQ(Dnsbl.NumCached(), 0);
+	EXPECT_EQ(Dnsbl.NumPending(), 0);
+	EXPECT_EQ(Dnsbl.Lookup(&Listed, time_get()), CDnsbl::VERDICT_PENDING);
+	vVerdicts.clear();
+	// the expired lookup of the previous provider finishes, but is dropped
+	EXPECT_EQ(UpdateUntil(Dnsbl, 2, vVerdicts), 2);
+	EXPECT_TRUE(pResolver->HasQuery("key.4.3.2.1.dnsbl.test"));
+	ASSERT_EQ(vVerdicts.size(), 1u);
+	EXPECT_EQ(vVerdicts[0], std::make_pair(std::string("1.2.3.4"), false));
+	EXPECT_EQ(Dnsbl.NumCached(), 1);
+	EXPECT_EQ(Dnsbl.Lookup(&Clean, time_get()), CDnsbl::VERDICT_PENDING);
+
+	delete pEngine;
+}
+
+TEST(Dnsbl, ProviderChangeDropsPending)
+{
+	IEngine *pEngine = CreateEngine("dnsbl-test", true, 2);
+	auto pResolver = std::make_shared<CFakeResolver>();
+	pResolver->m_Listed.insert("4.3.2.1.old.test");
+
+	CDnsbl Dnsbl;
+	Dnsbl.Init(pEngine, pResolver);
+	Dnsbl.SetProvider("old.test", "", 60);
+
+	NETADDR Listed = Addr("1.2.3.4:8303");
+	EXPECT_EQ(Dnsbl.Lookup(&Listed, time_get()), CDnsbl::VERDICT_PENDING);
+	EXPECT_EQ(Dnsbl.NumPending(), 1);
+
+	// the old lookup is still running, a new one is started for the new provider
+	EXPECT_TRUE(Dnsbl.SetProvider("new.test", "", 60));
+	EXPECT_EQ(Dnsbl.NumPending(), 0);
+	EXPECT_EQ(Dnsbl.Lookup(&Listed, time_get()), CDnsbl::VERDICT_PENDING);
+	EXPECT_EQ(Dnsbl.NumPending(), 1);
+
+	pResolver->Release();
+	std::vector<std::pair<std::string, bool>> vVerdicts;
+	EXPECT_EQ(UpdateUntil(Dnsbl, 2, vVerdicts), 2);
+	EXPECT_TRUE(pResolver->HasQuery("4.3.2.1.new.test"));
+	ASSERT_EQ(vVerdicts.size(), 1u);
+	EXPECT_EQ(vVerdicts[0], std::make_pair(std::string("1.2.3.4"), false));
+	EXPECT_EQ(Dnsbl.NumPending(), 0);
+	EXPECT_EQ(Dnsbl.Lookup(&Listed, time_get()), CDnsbl::VERDICT_CLEAN);
+
+	delete pEngine;
+}
@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/map.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/prng.h>
+#include <game/teamscore.h>
+
+#include <iterator>
+#include <random>
+#include <vector>
+
+// a walled box with a few platforms, held in memory
+class CTestMap : public IMap
+{
+	CMapItemGroup m_Group;
+	CMapItemLayerTilemap m_Layer;
+	std::vector<CTile> m_vTiles;
+
+public:
+	CTestMap(int Width, int Height)
+	{
+		mem_zero(&m_Group, sizeof(m_Group));
+		m_Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+		m_Group.m_NumLayers = 1;
+		mem_zero(&m_Layer, sizeof(m_Layer));
+		m_Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+		m_Layer.m_Width = Width;
+		m_Layer.m_Height = Height;
+		m_Layer.m_Flags = TILESLAYERFLAG_GAME;
+
+		CTile Air = {};
+		CTile Solid = {};
+		Solid.m_Index = TILE_SOLID;
+		m_vTiles.resize(Width * Height, Air);
+		for(int y = 0; y < Height; y++)
+		{
+			for(int x = 0; x < Width; x++)
+			{
+				bool Border = x == 0 || y == 0 || x == Width - 1 || y == Height - 1;
+				bool Platform = y % 8 == 0 && x % 16 < 10;
+				if(Border || Platform)
+					m_vTiles[y * Width + x] = Solid;
+			}
+		}
+	}
+
+	void *GetData(int Index) override { return m_vTiles.data(); }
+	int GetDataSize(int Index) override { return m_vTiles.size() * sizeof(CTile); }
+	void *GetDataSwapped(int Index) override { return GetData(Index); }
+	void UnloadData(int Index) override {}
+	void *GetItem(int Index, int *pType, int *pID) override
+	{
+		if(pType)
+			*pType = Index == 0 ? MAPITEMTYPE_GROUP : MAPITEMTYPE_LAYER;
+		if(pID)
+			*pID = 0;
+		return Index == 0 ? (void *)&m_Group : (void *)&m_Layer;
+	}
+	int GetItemSize(int Index) override { return Index == 0 ? sizeof(m_Group) : sizeof(m_Layer); }
+	void GetType(int Type, int *pStart, int *pNum) override
+	{
+		*pStart = Type == MAPITEMTYPE_LAYER ? 1 : 0;
+		*pNum = Type == MAPITEMTYPE_GROUP || Type == MAPITEMTYPE_LAYER ? 1 : 0;
+	}
+	void *FindItem(int Type, int ID) override { return nullptr; }
+	int NumItems() override { return 2; }
+};
+
+// recorded inputs of all characters, replayed into worlds with and without
+// the broadphase
+struct CRecording
+{
+	struct CTick
+	{
+		CNetObj_PlayerInput m_aInputs[MAX_CLIENTS];
+		// teleports this character in the middle of the tick, or -1
+		int m_Teleport;
+		vec2 m_TeleportPos;
+		// moves this character like a ninja dash later in the tick, or -1
+		int m_Dash;
+		vec2 m_DashDir;
+	};
+	std::vector<vec2> m_vSpawns;
+	std::vector<CTick> m_vTicks;
+};
+
+static CRecording Record(int NumCharacters, int NumTicks, float Spread, unsigned Seed)
+{
+	std::mt19937 Rng(Seed);
+	std::uniform_real_distribution<float> Coord(-Spread, Spread);
+	CRecording Recording;
+	vec2 Center(3200.0f, 1600.0f);
+	for(int i = 0; i < NumCharacters; i++)
+		Recording.m_vSpawns.emplace_back(Center.x + Coord(Rng), Center.y + Coord(Rng) / 2);
+
+	// zero targets give NaN hook directions until the first aim, the server
+	// prevents that but the physics have to match anyway
+	CNetObj_PlayerInput aInputs[MAX_CLIENTS] = {};
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		CRecording::CTick Entry;
+		for(int i = 0; i < NumCharacters; i++)
+		{
+			CNetObj_PlayerInput *pInput = &aInputs[i];
+			if(Rng() % 8 == 0)
+				pInput->m_Direction = (int)(Rng() % 3) - 1;
+			pInput->m_Jump = Rng() % 6 == 0;
+			if(Rng() % 10 == 0)
+				pInput->m_Hook = !pInput->m_Hook;
+			if(Rng() % 10 == 0)
+			{
+				// mostly aim at the spawn of another character
+				vec2 Target = Recording.m_vSpawns[Rng() % NumCharacters] - Recording.m_vSpawns[i];
+				pInput->m_TargetX = (int)Target.x + (int)(Rng() % 64) - 32;
+				pInput->m_TargetY = (int)Target.y + (int)(Rng() % 64) - 32;
+				if(pInput->m_TargetX == 0 && pInput->m_TargetY == 0)
+					pInput->m_TargetY = -1;
+			}
+			Entry.m_aInputs[i] = *pInput;
+		}
+		Entry.m_Teleport = Rng() % 20 == 0 ? Rng() % NumCharacters : -1;
+		Entry.m_TeleportPos = vec2(Center.x + Coord(Rng), Center.y + Coord(Rng) / 2);
+		Entry.m_Dash = Rng() % 5 == 0 ? Rng() % NumCharacters : -1;
+		Entry.m_DashDir = direction(Coord(Rng));
+		Recording.m_vTicks.push_back(Entry);
+	}
+	return Recording;
+}
+
+class CReplayWorld
+{
+	CTestMap m_Map;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CPrng m_Prng;
+	CTeamsCore m_Teams;
+	CWorldCore m_World;
+	CCharacterCore m_aCores[MAX_CLIENTS];
+	int m_NumCores;
+
+public:
+	int m_NumHookAttaches = 0;
+
+	CReplayWorld(const CRecording &Recording, bool Broadphase) :
+		m_Map(200, 100)
+	{
+		m_Layers.InitBackground(&m_Map);
+		uint64 aSeed[2] = {0, 0};
+		m_Prng.Seed(aSeed);
+		m_Collision.Init(&m_Layers, &m_Prng);
+		m_World.m_NoBroadphase = !Broadphase;
+		m_NumCores = Recording.m_vSpawns.size();
+		for(int i = 0; i < m_NumCores; i++)
+		{
+			m_aCores[i].Init(&m_World, &m_Collision, &m_Teams);
+			m_aCores[i].m_Id = i;
+			m_aCores[i].m_Pos = Recording.m_vSpawns[i];
+			// some characters can't interact with the others
+			m_Teams.Team(i, i % 7 == 0 ? 1 : 0);
+			m_World.SetCharacter(i, &m_aCores[i]);
+		}
+	}
+
+	void Tick(const CRecording::CTick &Tick)
+	{
+		for(int i = 0; i < m_NumCores; i++)
+		{
+			m_aCores[i].m_Input = Tick.m_aInputs[i];
+			m_aCores[i].Tick(true);
+			if(m_aCores[i].m_TriggeredEvents & COREEVENT_HOOK_ATTACH_PLAYER)
+				m_NumHookAttaches++;
+			if(i == m_NumCores / 2 && Tick.m_Teleport != -1)
+				m_aCores[Tick.m_Teleport].SetPos(Tick.m_TeleportPos);
+			if(i == m_NumCores * 3 / 4 && Tick.m_Dash != -1)
+			{
+				// as CNinja::Tick does it
+				CCharacterCore &Core = m_aCores[Tick.m_Dash];
+				vec2 Pos = Core.m_Pos;
+				vec2 Vel = Tick.m_DashDir * 50.0f;
+				m_Collision.MoveBox(&Pos, &Vel, vec2(28.0f, 28.0f), 0.f);
+				Core.SetPos(Pos);
+				Core.m_Vel = vec2(0.f, 0.f);
+			}
+		}
+		for(int i = 0; i < m_NumCores; i++)
+		{
+			m_aCores[i].AddDragVelocity();
+			m_aCores[i].ResetDragVelocity();
+			m_aCores[i].Move();
+			m_aCores[i].Quantize();
+		}
+	}
+
+	const CCharacterCore &Core(int i) const { return m_aCores[i]; }
+};
+
+static void ExpectSameCores(const CReplayWorld &A, const CReplayWorld &B, int NumCores, int Tick)
+{
+	for(int i = 0; i < NumCores; i++)
+	{
+		const CCharacterCore &a = A.Core(i);
+		const CCharacterCore &b = B.Core(i);
+		ASSERT_TRUE(mem_comp(&a.m_Pos, &b.m_Pos, sizeof(vec2)) == 0 && mem_comp(&a.m_Vel, &b.m_Vel, sizeof(vec2)) == 0 && mem_comp(&a.m_HookPos, &b.m_HookPos, sizeof(vec2)) == 0) << "character " << i << " tick " << Tick;
+		ASSERT_EQ(a.m_HookState, b.m_HookState) << "character " << i << " tick " << Tick;
+		ASSERT_EQ(a.m_HookedPlayer, b.m_HookedPlayer) << "character " << i << " tick " << Tick;
+	}
+}
+
+TEST(GameCore, BroadphaseReplayMatches)
+{
+	for(float Spread : {150.0f, 1500.0f})
+	{
+		CRecording Recording = Record(MAX_CLIENTS, 1500, Spread, 1);
+		CReplayWorld Broadphase(Recording, true);
+		CReplayWorld AllPairs(Recording, false);
+		for(int Tick = 0; Tick < (int)Recording.m_vTicks.size(); Tick++)
+		{
+			Broadphase.Tick(Recording.m_vTicks[Tick]);
+			AllPairs.Tick(Recording.m_vTicks[Tick]);
+			ExpectSameCores(Broadphase, AllPairs, MAX_CLIENTS, Tick);
+			if(HasFatalFailure())
+				return;
+		}
+		EXPECT_GT(Broadphase.m_NumHookAttaches, 0);
+	}
+}
+
+TEST(GameCore, TuningValuesMatchParams)
+{
+	CTuningParams Params;
+	Params.Set("gravity", 0.7f);
+	Params.Set("hook_length", 420.0f);
+	CTuningValues Values(Params);
+
+	float aValues[sizeof(CTuningValues) / sizeof(float)];
+	mem_copy(aValues, &Values, sizeof(aValues));
+	ASSERT_EQ((int)std::size(aValues), CTuningParams::Num());
+	for(int i = 0; i < CTuningParams::Num(); i++)
+	{
+		float Expected;
+		ASSERT_TRUE(Params.Get(i, &Expected));
+		EXPECT_EQ(aValues[i], Expected) << CTuningParams::ms_apNames[i];
+	}
+}
@@ -0,0 +1,85 @@
+#include "http_stub.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/http.h>
+#include <engine/shared/json.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+static void DrainUntil(CHttpCompletionQueue &Queue, int Expected)
+{
+	int Drained = 0;
+	auto Timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while(Drained < Expected && std::chrono::steady_clock::now() < Timeout)
+	{
+		Drained += Queue.Drain();
+		thread_sleep(1000);
+	}
+	EXPECT_EQ(Drained, Expected);
+}
+
+TEST(Http, CompletionQueue)
+{
+	CHttpStub Stub;
+	ASSERT_TRUE(Stub.Start("{\"status\":200,\"name\":\"stub\"}"));
+
+	// the stub doesn't speak tls, a copy keeps the default for the other tests
+	CConfig Config = g_Config;
+	Config.m_HttpAllowInsecure = 1;
+	CHttp Http;
+	ASSERT_TRUE(Http.Init(std::chrono::seconds{0}, &Config));
+
+	char aUrl[128];
+	str_format(aUrl, sizeof(aUrl), "http://127.0.0.1:%d/login", Stub.m_Port);
+
+	CHttpCompletionQueue Queue;
+	std::thread::id CallbackThread;
+	int Status = 0;
+	std::string Name;
+
+	const char *pBody = "{\"token\":\"abc\"}";
+	std::shared_ptr<CHttpRequest> pRequest = HttpPost(aUrl, &Config, (const unsigned char *)pBody, str_length(pBody));
+	pRequest->LogProgress(HTTPLOG::NONE);
+	Queue.Run(&Http, std::move(pRequest), [&](CHttpRequest *pDone) {
+		CallbackThread = std::this_thread::get_id();
+		ASSERT_EQ(pDone->State(), EHttpState::DONE);
+		json_value *pJson = pDone->ResultJson();
+		ASSERT_TRUE(pJson);
+		Status = json_int_get(json_object_get(pJson, "status"));
+		Name = json_string_get(json_object_get(pJson, "name"));
+		json_value_free(pJson);
+	});
+	EXPECT_EQ(Queue.NumPending(), 1);
+
+	DrainUntil(Queue, 1);
+	EXPECT_EQ(Queue.NumPending(), 0);
+	EXPECT_EQ(CallbackThread, std::this_thread::get_id());
+	EXPECT_EQ(Status, 200);
+	EXPECT_EQ(Name, "stub");
+	EXPECT_EQ(Stub.NumRequests(), 1);
+	EXPECT_EQ(Stub.LastBody(), pBody);
+}
+
+TEST(Http, CompletionQueueError)
+{
+	CConfig Config = g_Config;
+	Config.m_HttpAllowInsecure = 1;
+	CHttp Http;
+	ASSERT_TRUE(Http.Init(std::chrono::seconds{0}, &Config));
+
+	CHttpCompletionQueue Queue;
+	EHttpState State = EHttpState::QUEUED;
+
+	// nothing listens on the port
+	std::shared_ptr<CHttpRequest> pRequest = HttpGet("http://127.0.0.1:1/", &Config);
+	pRequest->LogProgress(HTTPLOG::NONE);
+	Queue.Run(&Http, std::move(pRequest), [&](CHttpRequest *pDone) {
+		State = pDone->State();
+	});
+	DrainUntil(Queue, 1);
+	EXPECT_EQ(State, EHttpState::ERROR);
+}
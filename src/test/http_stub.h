@@ -0,0 +1,128 @@
+#ifndef TEST_HTTP_STUB_H
+#define TEST_HTTP_STUB_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Minimal HTTP server on localhost that answers every request with the same
+// JSON body and records the last request body.
+class CHttpStub
+{
+	NETSOCKET m_Socket;
+	void *m_pThread = nullptr;
+	std::atomic<bool> m_Shutdown{false};
+	std::string m_Response;
+	std::mutex m_Lock;
+	std::string m_LastBody;
+	int m_NumRequests = 0;
+
+	void Serve(NETSOCKET Client)
+	{
+		std::string Request;
+		char aBuf[1024];
+		size_t HeaderEnd = std::string::npos;
+		size_t ContentLength = 0;
+		while(!m_Shutdown)
+		{
+			if(HeaderEnd != std::string::npos && Request.size() >= HeaderEnd + 4 + ContentLength)
+				break;
+			if(net_socket_read_wait(Client, 100000) <= 0)
+				continue;
+			int Bytes = net_tcp_recv(Client, aBuf, sizeof(aBuf));
+			if(Bytes <= 0)
+				return;
+			Request.append(aBuf, Bytes);
+			if(HeaderEnd == std::string::npos && (HeaderEnd = Request.find("\r\n\r\n")) != std::string::npos)
+			{
+				const char *pLength = str_find_nocase(Request.c_str(), "Content-Length:");
+				if(pLength && pLength < Request.c_str() + HeaderEnd)
+					ContentLength = str_toint(pLength + str_length("Content-Length:"));
+			}
+		}
+		if(HeaderEnd == std::string::npos)
+			return;
+
+		{
+			std::unique_lock Lock(m_Lock);
+			m_LastBody = Request.substr(HeaderEnd + 4, ContentLength);
+			m_NumRequests++;
+		}
+
+		char aHeader[256];
+		str_format(aHeader, sizeof(aHeader), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", (int)m_Response.size());
+		std::string Response = aHeader + m_Response;
+		net_tcp_send(Client, Response.c_str(), Response.size());
+	}
+
+	void Run()
+	{
+		while(!m_Shutdown)
+		{
+			if(net_socket_read_wait(m_Socket, 100000) <= 0)
+				continue;
+			NETSOCKET Client;
+			NETADDR ClientAddr;
+			if(net_tcp_accept(m_Socket, &Client, &ClientAddr) < 0)
+				continue;
+			Serve(Client);
+			net_tcp_close(Client);
+		}
+	}
+
+	static void ThreadMain(void *pUser)
+	{
+		((CHttpStub *)pUser)->Run();
+	}
+
+public:
+	int m_Port = 0;
+
+	bool Start(const char *pResponse)
+	{
+		m_Response = pResponse;
+		for(int Port = 18700; Port < 18800; Port++)
+		{
+			NETADDR Addr;
+			net_addr_from_str(&Addr, "127.0.0.1");
+			Addr.port = Port;
+			m_Socket = net_tcp_create(Addr);
+			if(!(m_Socket.type & NETTYPE_IPV4))
+				continue;
+			if(net_tcp_listen(m_Socket, 16) != 0)
+			{
+				net_tcp_close(m_Socket);
+				continue;
+			}
+			m_Port = Port;
+			m_pThread = thread_init(ThreadMain, this, "http stub");
+			return true;
+		}
+		return false;
+	}
+
+	~CHttpStub()
+	{
+		if(!m_pThread)
+			return;
+		m_Shutdown = true;
+		thread_wait(m_pThread);
+		net_tcp_close(m_Socket);
+	}
+
+	std::string LastBody()
+	{
+		std::unique_lock Lock(m_Lock);
+		return m_LastBody;
+	}
+
+	int NumRequests()
+	{
+		std::unique_lock Lock(m_Lock);
+		return m_NumRequests;
+	}
+};
+
+#endif // TEST_HTTP_STUB_H
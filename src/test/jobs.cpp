@@ -35,8 +35,8 @@ class CJob : public IJob
 	void Run() { m_JobFunction(); }
 
 public:
-	CJob(std::function<void()> &&JobFunction) :
-		m_JobFunction(JobFunction) {}
+	CJob(std::function<void()> &&JobFunction, EJobPriority Priority = PRIORITY_LATENCY) :
+		m_JobFunction(JobFunction) { IJob::Priority(Priority); }
 };
 
 TEST_F(Jobs, Constructor)
@@ -76,7 +76,7 @@ TEST_F(Jobs, LookupHost)
 	EXPECT_EQ(pJob->m_Nettype, NETTYPE);
 
 	Add(pJob);
-	while(pJob->Status() != IJob::STATE_DONE)
+	while(pJob->State() != IJob::STATE_DONE)
 	{
 		// yay, busy loop...
 		thread_yield();
@@ -103,7 +103,7 @@ TEST_F(Jobs, Many)
 				sphore_signal(&sphore);
 			}
 		});
-		EXPECT_EQ(pJob->Status(), IJob::STATE_PENDING);
+		EXPECT_EQ(pJob->State(), IJob::STATE_QUEUED);
 		apJobs.push_back(pJob);
 	}
 	for(auto &pJob : apJobs)
@@ -115,7 +115,71 @@ TEST_F(Jobs, Many)
 	m_Pool.~CJobPool();
 	for(auto &pJob : apJobs)
 	{
-		EXPECT_EQ(pJob->Status(), IJob::STATE_DONE);
+		EXPECT_EQ(pJob->State(), IJob::STATE_DONE);
 	}
 	new(&m_Pool) CJobPool();
 }
+
+TEST(JobPool, Priorities)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+
+	// keep the only worker busy while the queue fills up
+	SEMAPHORE Started;
+	SEMAPHORE Release;
+	sphore_init(&Started);
+	sphore_init(&Release);
+	Pool.Add(std::make_shared<CJob>([&] {
+		sphore_signal(&Started);
+		sphore_wait(&Release);
+	}));
+	sphore_wait(&Started);
+
+	std::vector<int> vOrder;
+	for(int i = 0; i < 3; i++)
+		Pool.Add(std::make_shared<CJob>([&vOrder, i] { vOrder.push_back(100 + i); }, IJob::PRIORITY_BULK));
+	for(int i = 0; i < 3; i++)
+		Pool.Add(std::make_shared<CJob>([&vOrder, i] { vOrder.push_back(i); }));
+	EXPECT_EQ(Pool.NumQueued(), 6);
+
+	sphore_signal(&Release);
+	Pool.Shutdown();
+	sphore_destroy(&Started);
+	sphore_destroy(&Release);
+
+	EXPECT_EQ(vOrder, (std::vector<int>{0, 1, 2, 100, 101, 102}));
+	EXPECT_EQ(Pool.NumQueued(), 0);
+
+	CJobPool::CStats Stats;
+	Pool.GetStats(&Stats);
+	EXPECT_EQ(Stats.m_aNumDone[IJob::PRIORITY_LATENCY], 4);
+	EXPECT_EQ(Stats.m_aNumDone[IJob::PRIORITY_BULK], 3);
+	EXPECT_GT(Stats.m_aMaxRunTime[IJob::PRIORITY_LATENCY], 0);
+}
+
+TEST(JobPool, SetNumThreads)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+	Pool.SetNumThreads(3);
+	EXPECT_EQ(Pool.NumThreads(), 3);
+	// never shrinks
+	Pool.SetNumThreads(2);
+	EXPECT_EQ(Pool.NumThreads(), 3);
+
+	std::atomic<int> Running(0);
+	SEMAPHORE AllRunning;
+	sphore_init(&AllRunning);
+	for(int i = 0; i < 3; i++)
+		Pool.Add(std::make_shared<CJob>([&] {
+			if(Running.fetch_add(1) == 2)
+				sphore_signal(&AllRunning);
+			// only returns once all three workers are busy
+			while(Running < 3)
+				thread_yield();
+		}));
+	sphore_wait(&AllRunning);
+	Pool.Shutdown();
+	sphore_destroy(&AllRunning);
+}
@@ -0,0 +1,228 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+#include <game/mapitems.h>
+#include <game/mapmerge.h>
+
+#include <string>
+#include <vector>
+
+class MapMerge : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	IStorage *m_pStorage;
+
+	MapMerge()
+	{
+		m_pStorage = m_Info.CreateTestStorage();
+	}
+
+	~MapMerge()
+	{
+		// the cache has a file per data, more than the test storage removes,
+		// and it can't remove nested folders
+		if(m_pStorage && !HasFailure())
+		{
+			for(const std::string &File : CacheFiles())
+				m_pStorage->RemoveFile(("mega.map.cache/" + File).c_str(), IStorage::TYPE_SAVE);
+			char aCacheDir[IO_MAX_PATH_LENGTH];
+			m_pStorage->GetCompletePath(IStorage::TYPE_SAVE, "mega.map.cache", aCacheDir, sizeof(aCacheDir));
+			EXPECT_FALSE(fs_removedir(aCacheDir));
+		}
+		delete m_pStorage;
+		m_Info.DeleteTestStorageFilesOnSuccess();
+	}
+
+	// a game layer with a spawn and a design layer that differs by `Seed`
+	void WriteMap(const char *pName, int Width, int Height, int Seed)
+	{
+		std::vector<CTile> vGame(Width * Height);
+		std::vector<CTile> vDesign(Width * Height);
+		mem_zero(vGame.data(), vGame.size() * sizeof(CTile));
+		mem_zero(vDesign.data(), vDesign.size() * sizeof(CTile));
+		for(int x = 0; x < Width; x++)
+			vGame[(Height - 1) * Width + x].m_Index = TILE_SOLID;
+		vGame[Width + 1].m_Index = ENTITY_OFFSET + ENTITY_SPAWN;
+		for(int i = 0; i < Width * Height; i++)
+			vDesign[i].m_Index = (i * 7 + Seed) % 256;
+
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(m_pStorage, pName));
+
+		CMapItemLayerTilemap Layer;
+		mem_zero(&Layer, sizeof(Layer));
+		Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+		Layer.m_Version = 3;
+		Layer.m_Width = Width;
+		Layer.m_Height = Height;
+		Layer.m_Color = {255, 255, 255, 255};
+		Layer.m_ColorEnv = -1;
+		Layer.m_Image = -1;
+		Layer.m_Tele = Layer.m_Speedup = Layer.m_Front = Layer.m_Switch = Layer.m_Tune = -1;
+		Layer.m_Data = Writer.AddData(vDesign.size() * sizeof(CTile), vDesign.data());
+		Writer.AddItem(MAPITEMTYPE_LAYER, 0, sizeof(Layer), &Layer);
+		Layer.m_Flags = TILESLAYERFLAG_GAME;
+		Layer.m_Data = Writer.AddData(vGame.size() * sizeof(CTile), vGame.data());
+		Writer.AddItem(MAPITEMTYPE_LAYER, 1, sizeof(Layer), &Layer);
+
+		CMapItemGroup Group;
+		mem_zero(&Group, sizeof(Group));
+		Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+		Group.m_ParallaxX = 100;
+		Group.m_ParallaxY = 100;
+		Group.m_StartLayer = 0;
+		Group.m_NumLayers = 2;
+		Writer.AddItem(MAPITEMTYPE_GROUP, 0, sizeof(Group), &Group);
+		Writer.Finish();
+	}
+
+	bool Merge(const std::vector<const char *> &vpNames, SMapMergeStats *pStats)
+	{
+		std::vector<std::string> vPaths;
+		std::vector<const char *> vpPaths;
+		for(const char *pName : vpNames)
+			vPaths.push_back(std::string(m_Info.m_aFilename) + "/" + pName);
+		for(const std::string &Path : vPaths)
+			vpPaths.push_back(Path.c_str());
+		return MergeMaps(m_pStorage, "mega.map", vpPaths.data(), vpPaths.size(), pStats);
+	}
+
+	std::string ReadFile(const char *pFilename)
+	{
+		void *pData;
+		unsigned Size;
+		if(!m_pStorage->ReadFile(pFilename, IStorage::TYPE_SAVE, &pData, &Size))
+			return "";
+		std::string Content((char *)pData, Size);
+		free(pData);
+		return Content;
+	}
+
+	// the layout line of a map
+	std::string Place(const char *pName)
+	{
+		std::string Layout = ReadFile("mega.map.layout");
+		std::string Suffix = std::string("/") + pName;
+		size_t Start = 0;
+		while(Start < Layout.size())
+		{
+			size_t End = Layout.find('\n', Start);
+			std::string Line = Layout.substr(Start, End - Start);
+			if(!Line.empty() && Line.back() == '\r')
+				Line.pop_back();
+			if(Line.size() >= Suffix.size() && Line.compare(Line.size() - Suffix.size(), Suffix.size(), Suffix) == 0)
+				return Line;
+			if(End == std::string::npos)
+				break;
+			Start = End + 1;
+		}
+		return "";
+	}
+
+	static int ListCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+	{
+		if(!IsDir)
+			((std::vector<std::string> *)pUser)->push_back(pName);
+		return 0;
+	}
+
+	std::vector<std::string> CacheFiles()
+	{
+		std::vector<std::string> vFiles;
+		m_pStorage->ListDirectory(IStorage::TYPE_SAVE, "mega.map.cache", ListCallback, &vFiles);
+		return vFiles;
+	}
+};
+
+TEST_F(MapMerge, KeepsPlacesAndCache)
+{
+	ASSERT_TRUE(m_pStorage);
+	WriteMap("a.map", 20, 10, 1);
+	WriteMap("b.map", 30, 15, 2);
+
+	SMapMergeStats Stats;
+	ASSERT_TRUE(Merge({"a.map", "b.map"}, &Stats));
+	EXPECT_EQ(Stats.m_NumKept, 0);
+	EXPECT_EQ(Stats.m_NumCached, 0);
+	EXPECT_GT(Stats.m_NumDatas, 0);
+	std::string MegaMap = ReadFile("mega.map");
+	std::string PlaceA = Place("a.map");
+	std::string PlaceB = Place("b.map");
+	EXPECT_NE(PlaceA, "");
+	EXPECT_NE(PlaceB, "");
+
+	// nothing changed, everything is cached and the map is the same
+	ASSERT_TRUE(Merge({"a.map", "b.map"}, &Stats));
+	EXPECT_EQ(Stats.m_NumKept, 2);
+	EXPECT_EQ(Stats.m_NumCached, Stats.m_NumDatas);
+	EXPECT_EQ(ReadFile("mega.map"), MegaMap);
+	std::vector<std::string> vFiles = CacheFiles();
+	EXPECT_EQ((int)vFiles.size(), Stats.m_NumDatas);
+	for(const std::string &File : vFiles)
+		EXPECT_FALSE(str_endswith(File.c_str(), ".tmp")) << File;
+
+	// a new map goes below, the others keep their places and datas
+	WriteMap("c.map", 10, 10, 3);
+	ASSERT_TRUE(Merge({"b.map", "a.map", "c.map"}, &Stats));
+	EXPECT_EQ(Stats.m_NumKept, 2);
+	EXPECT_EQ(Place("a.map"), PlaceA);
+	EXPECT_EQ(Place("b.map"), PlaceB);
+	EXPECT_NE(Place("c.map"), "");
+	EXPECT_GE(Stats.m_NumCached, 2);
+	EXPECT_LT(Stats.m_NumCached, Stats.m_NumDatas);
+
+	// a grown map moves
+	WriteMap("a.map", 40, 10, 1);
+	ASSERT_TRUE(Merge({"b.map", "a.map", "c.map"}, &Stats));
+	EXPECT_EQ(Stats.m_NumKept, 2);
+	EXPECT_NE(Place("a.map"), PlaceA);
+	EXPECT_EQ(Place("b.map"), PlaceB);
+}
+
+TEST_F(MapMerge, BrokenCache)
+{
+	ASSERT_TRUE(m_pStorage);
+	WriteMap("a.map", 20, 10, 1);
+	WriteMap("b.map", 30, 15, 2);
+
+	SMapMergeStats Stats;
+	ASSERT_TRUE(Merge({"a.map", "b.map"}, &Stats));
+	std::string MegaMap = ReadFile("mega.map");
+
+	// cut a cache file short, as if the last merge was interrupted
+	std::vector<std::string> vFiles = CacheFiles();
+	ASSERT_FALSE(vFiles.empty());
+	std::string Path = "mega.map.cache/" + vFiles[0];
+	std::string Content = ReadFile(Path.c_str());
+	IOHANDLE File = m_pStorage->OpenFile(Path.c_str(), IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, Content.data(), Content.size() / 2);
+	io_close(File);
+
+	ASSERT_TRUE(Merge({"a.map", "b.map"}, &Stats));
+	EXPECT_EQ(Stats.m_NumCached, Stats.m_NumDatas - 1);
+	EXPECT_EQ(ReadFile("mega.map"), MegaMap);
+	EXPECT_EQ(ReadFile(Path.c_str()), Content);
+
+	ASSERT_TRUE(Merge({"a.map", "b.map"}, &Stats));
+	EXPECT_EQ(Stats.m_NumCached, Stats.m_NumDatas);
+}
+
+TEST_F(MapMerge, MissingMap)
+{
+	ASSERT_TRUE(m_pStorage);
+	WriteMap("a.map", 20, 10, 1);
+
+	// fails before the output is opened, without leaking the opened maps
+	EXPECT_FALSE(Merge({"a.map", "missing.map"}, nullptr));
+	IOHANDLE File = m_pStorage->OpenFile("mega.map", IOFLAG_READ, IStorage::TYPE_SAVE);
+	EXPECT_FALSE(File);
+	if(File)
+		io_close(File);
+
+	EXPECT_TRUE(Merge({"a.map"}, nullptr));
+}
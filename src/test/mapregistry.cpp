@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/mapitems.h>
+#include <game/server/mapregistry.h>
+
+TEST(MapRegistry, Find)
+{
+	CMapRegistry Maps;
+	EXPECT_EQ(Maps.Add("Kobra"), 1);
+	EXPECT_EQ(Maps.Add("Kobra 2"), 2);
+	EXPECT_EQ(Maps.Add("Multeasymap"), 3);
+	EXPECT_EQ(Maps.Add("ÄÖÜ"), 4);
+
+	EXPECT_EQ(Maps.Find("kobra"), 1);
+	EXPECT_EQ(Maps.Find("KOBRA 2"), 2);
+	EXPECT_EQ(Maps.Find("äöü"), 4);
+	EXPECT_EQ(Maps.Find("kob"), 0);
+	EXPECT_STREQ(Maps.Name(3), "Multeasymap");
+
+	// ambiguous prefixes don't match
+	EXPECT_EQ(Maps.FindPrefix("kob"), 0);
+	EXPECT_EQ(Maps.FindPrefix("kobra "), 2);
+	EXPECT_EQ(Maps.FindPrefix("MULT"), 3);
+	EXPECT_EQ(Maps.FindPrefix(""), 0);
+
+	Maps.Clear();
+	EXPECT_EQ(Maps.Find("kobra"), 0);
+	EXPECT_EQ(Maps.Add("Kobra"), 1);
+}
+
+TEST(MapRegistry, Suggest)
+{
+	CMapRegistry Maps;
+	Maps.Add("Kobra");
+	Maps.Add("Kobra 2");
+	Maps.Add("Multeasymap");
+	Maps.Add("Tutorial");
+
+	int aIndices[4];
+	ASSERT_EQ(Maps.Suggest("kob", aIndices, 4), 2);
+	EXPECT_EQ(aIndices[0], 1);
+	EXPECT_EQ(aIndices[1], 2);
+
+	// typos, the closest first
+	ASSERT_EQ(Maps.Suggest("kbora", aIndices, 4), 1);
+	EXPECT_EQ(aIndices[0], 1);
+	ASSERT_EQ(Maps.Suggest("multeasymop", aIndices, 4), 1);
+	EXPECT_EQ(aIndices[0], 3);
+	EXPECT_EQ(Maps.Suggest("dm1", aIndices, 4), 0);
+}
+
+TEST(MapRegistry, ManyMaps)
+{
+	CMapRegistry Maps;
+	char aName[32];
+	for(int i = 0; i < 1000; i++)
+	{
+		str_format(aName, sizeof(aName), "map%d", i);
+		ASSERT_EQ(Maps.Add(aName), i + 1);
+	}
+	EXPECT_EQ(Maps.NumNamed(), 1000);
+	for(int i = 0; i < 1000; i++)
+	{
+		str_format(aName, sizeof(aName), "MAP%d", i);
+		ASSERT_EQ(Maps.Find(aName), i + 1);
+	}
+	EXPECT_EQ(Maps.FindPrefix("map999"), 1000);
+}
+
+TEST(MapRegistry, Layout)
+{
+	CMapRegistry Maps;
+	Maps.Add("Kobra");
+	Maps.OnTile(1, 10, 20);
+	Maps.OnTile(1, 4, 30);
+	Maps.OnTile(1, 12, 25);
+	Maps.OnEntity(1, 0, ENTITY_SPAWN);
+	Maps.OnEntity(1, 2, ENTITY_SPAWN_RED);
+	Maps.OnEntity(1, 3, ENTITY_ARMOR_1);
+	// unnamed maps still get their layout
+	Maps.OnTile(3, 0, 0);
+	Maps.OnEntity(3, 1, ENTITY_SPAWN);
+
+	EXPECT_EQ(Maps.NumNamed(), 1);
+	ASSERT_EQ(Maps.Num(), 3);
+	const CMapRegistry::CMapInfo *pInfo = Maps.Info(1);
+	EXPECT_EQ(pInfo->m_MinX, 4);
+	EXPECT_EQ(pInfo->m_MinY, 20);
+	EXPECT_EQ(pInfo->m_MaxX, 12);
+	EXPECT_EQ(pInfo->m_MaxY, 30);
+	EXPECT_EQ(pInfo->m_NumTiles, 3);
+	EXPECT_EQ(pInfo->m_aNumSpawns[0], 1);
+	EXPECT_EQ(pInfo->m_aNumSpawns[1], 1);
+	EXPECT_EQ(pInfo->m_aNumSpawns[2], 0);
+	EXPECT_EQ(pInfo->m_vEntities, (std::vector<int>{0, 2, 3}));
+	EXPECT_EQ(Maps.Info(2)->m_NumTiles, 0);
+	EXPECT_EQ(Maps.Info(3)->m_vEntities, (std::vector<int>{1}));
+	EXPECT_EQ(Maps.Info(0), nullptr);
+	EXPECT_EQ(Maps.Info(4), nullptr);
+
+	// names fill the maps that only had tiles
+	EXPECT_EQ(Maps.Add("Kobra 2"), 2);
+	EXPECT_EQ(Maps.Add("Kobra 3"), 3);
+	EXPECT_EQ(Maps.Info(3)->m_NumTiles, 1);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <engine/shared/metrics.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(Metrics, CounterAndGauge)
+{
+	CMetrics Metrics;
+	CMetricCounter *pCounter = Metrics.Counter("test_events_total", "Events");
+	CMetricGauge *pGauge = Metrics.Gauge("test_level", "Level");
+
+	std::vector<std::thread> vThreads;
+	for(int i = 0; i < 4; i++)
+		vThreads.emplace_back([pCounter]() {
+			for(int j = 0; j < 1000; j++)
+				pCounter->Add();
+		});
+	for(auto &Thread : vThreads)
+		Thread.join();
+	EXPECT_EQ(pCounter->Value(), 4000);
+
+	pGauge->Set(7);
+	pGauge->Add(-2);
+	EXPECT_EQ(pGauge->Value(), 5);
+
+	std::string Out;
+	Metrics.Render(Out);
+	EXPECT_EQ(Out,
+		"# HELP test_events_total Events\n"
+		"# TYPE test_events_total counter\n"
+		"test_events_total 4000\n"
+		"# HELP test_level Level\n"
+		"# TYPE test_level gauge\n"
+		"test_level 5\n");
+}
+
+TEST(Metrics, Histogram)
+{
+	CMetrics Metrics;
+	CMetricHistogram *pHistogram = Metrics.Histogram("test_duration_seconds", "Duration", {1000, 10000}, 1e-6);
+	pHistogram->Observe(500);
+	pHistogram->Observe(1000);
+	pHistogram->Observe(5000);
+	pHistogram->Observe(20000);
+
+	std::string Out;
+	Metrics.Render(Out);
+	EXPECT_EQ(Out,
+		"# HELP test_duration_seconds Duration\n"
+		"# TYPE test_duration_seconds histogram\n"
+		"test_duration_seconds_bucket{le=\"0.001\"} 2\n"
+		"test_duration_seconds_bucket{le=\"0.01\"} 3\n"
+		"test_duration_seconds_bucket{le=\"+Inf\"} 4\n"
+		"test_duration_seconds_sum 0.0265\n"
+		"test_duration_seconds_count 4\n");
+}
+
+TEST(Metrics, RegisterTwice)
+{
+	CMetrics Metrics;
+	CMetricCounter *pFirst = Metrics.Counter("test_total", "First");
+	CMetricCounter *pSecond = Metrics.Counter("test_total", "Second");
+	EXPECT_EQ(pFirst, pSecond);
+	pSecond->Add(3);
+
+	std::string Out;
+	Metrics.Render(Out);
+	EXPECT_EQ(Out, "# HELP test_total First\n# TYPE test_total counter\ntest_total 3\n");
+}
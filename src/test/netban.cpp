@@ -0,0 +1,245 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+#include <engine/shared/nettrie.h>
+#include <engine/storage.h>
+
+#include <string>
+#include <vector>
+
+static NETADDR Addr(const char *pStr)
+{
+	NETADDR Addr;
+	EXPECT_EQ(net_addr_from_str(&Addr, pStr), 0);
+	return Addr;
+}
+
+static void Insert(CNetPrefixTrie<int> &Trie, const char *pAddr, int PrefixLength, int Value)
+{
+	NETADDR Key = Addr(pAddr);
+	Trie.Insert(Key.type, Key.ip, PrefixLength, Value);
+}
+
+static bool Remove(CNetPrefixTrie<int> &Trie, const char *pAddr, int PrefixLength, int Value)
+{
+	NETADDR Key = Addr(pAddr);
+	return Trie.Remove(Key.type, Key.ip, PrefixLength, Value);
+}
+
+static int Lookup(const CNetPrefixTrie<int> &Trie, const char *pAddr)
+{
+	NETADDR Key = Addr(pAddr);
+	return Trie.Lookup(&Key);
+}
+
+static std::vector<std::string> Prefixes(const char *pLB, const char *pUB)
+{
+	NETADDR LB = Addr(pLB);
+	NETADDR UB = Addr(pUB);
+	std::vector<std::string> vResult;
+	NetRangeToPrefixes(&LB, &UB, [&](const unsigned char *pKey, int PrefixLength) {
+		NETADDR Prefix = LB;
+		mem_copy(Prefix.ip, pKey, sizeof(Prefix.ip));
+		char aAddr[NETADDR_MAXSTRSIZE];
+		net_addr_str(&Prefix, aAddr, sizeof(aAddr), false);
+		char aBuf[NETADDR_MAXSTRSIZE + 8];
+		str_format(aBuf, sizeof(aBuf), "%s/%d", aAddr, PrefixLength);
+		vResult.emplace_back(aBuf);
+		return true;
+	});
+	return vResult;
+}
+
+TEST(NetBan, TrieLongestPrefix)
+{
+	CNetPrefixTrie<int> Trie;
+	Insert(Trie, "10.0.0.0", 8, 1);
+	Insert(Trie, "10.1.0.0", 16, 2);
+	Insert(Trie, "10.1.2.3", 32, 3);
+	Insert(Trie, "192.168.0.0", 24, 4);
+
+	EXPECT_EQ(Lookup(Trie, "10.2.3.4"), 1);
+	EXPECT_EQ(Lookup(Trie, "10.1.3.4"), 2);
+	EXPECT_EQ(Lookup(Trie, "10.1.2.3"), 3);
+	EXPECT_EQ(Lookup(Trie, "10.1.2.4"), 2);
+	EXPECT_EQ(Lookup(Trie, "192.168.0.255"), 4);
+	EXPECT_EQ(Lookup(Trie, "192.168.1.0"), 0);
+	EXPECT_EQ(Lookup(Trie, "11.0.0.0"), 0);
+
+	// families don't mix
+	EXPECT_EQ(Lookup(Trie, "[a00::1]"), 0);
+	Insert(Trie, "[2001:db8::]", 32, 5);
+	EXPECT_EQ(Lookup(Trie, "[2001:db8:1::1]"), 5);
+	EXPECT_EQ(Lookup(Trie, "[2001:db9::1]"), 0);
+}
+
+TEST(NetBan, TrieRemovePrunes)
+{
+	CNetPrefixTrie<int> Trie;
+	Insert(Trie, "10.1.2.3", 32, 1);
+	const int Nodes = Trie.NumNodes();
+	Insert(Trie, "10.1.2.4", 32, 2);
+	Insert(Trie, "10.1.0.0", 16, 3);
+	Insert(Trie, "10.1.0.0", 16, 4);
+	EXPECT_EQ(Trie.Find(NETTYPE_IPV4, Addr("10.1.0.0").ip, 16)->size(), 2u);
+
+	EXPECT_FALSE(Remove(Trie, "10.1.2.4", 32, 1));
+	EXPECT_TRUE(Remove(Trie, "10.1.0.0", 16, 3));
+	EXPECT_EQ(Lookup(Trie, "10.1.9.9"), 4);
+	EXPECT_TRUE(Remove(Trie, "10.1.0.0", 16, 4));
+	EXPECT_EQ(Lookup(Trie, "10.1.9.9"), 0);
+	EXPECT_EQ(Trie.Find(NETTYPE_IPV4, Addr("10.1.0.0").ip, 16), nullptr);
+	EXPECT_TRUE(Remove(Trie, "10.1.2.4", 32, 2));
+	EXPECT_EQ(Trie.NumNodes(), Nodes);
+	EXPECT_EQ(Lookup(Trie, "10.1.2.3"), 1);
+}
+
+TEST(NetBan, RangeToPrefixes)
+{
+	EXPECT_EQ(Prefixes("10.0.0.0", "10.0.0.255"), std::vector<std::string>({"10.0.0.0/24"}));
+	EXPECT_EQ(Prefixes("10.0.0.5", "10.0.0.5"), std::vector<std::string>({"10.0.0.5/32"}));
+	EXPECT_EQ(Prefixes("10.0.0.1", "10.0.0.6"), std::vector<std::string>({"10.0.0.1/32", "10.0.0.2/31", "10.0.0.4/31", "10.0.0.6/32"}));
+	EXPECT_EQ(Prefixes("10.0.0.255", "10.0.1.0"), std::vector<std::string>({"10.0.0.255/32", "10.0.1.0/32"}));
+	EXPECT_EQ(Prefixes("0.0.0.0", "255.255.255.255"), std::vector<std::string>({"0.0.0.0/0"}));
+	EXPECT_EQ(Prefixes("[2001:db8::]", "[2001:db8:ffff:ffff:ffff:ffff:ffff:ffff]"), std::vector<std::string>({"[2001:db8:0:0:0:0:0:0]/32"}));
+}
+
+class CTestNetBan
+{
+public:
+	IConsole *m_pConsole;
+	CTestInfo m_Info;
+	IStorage *m_pStorage;
+	CNetBan m_Ban;
+
+	CTestNetBan()
+	{
+		m_pConsole = CreateConsole(CFGFLAG_SERVER);
+		m_pStorage = m_Info.CreateTestStorage();
+		m_Ban.Init(m_pConsole, m_pStorage);
+	}
+	~CTestNetBan()
+	{
+		m_Ban.UnbanAll();
+		delete m_pStorage;
+		delete m_pConsole;
+	}
+
+	bool IsBanned(const char *pAddr)
+	{
+		NETADDR Address = Addr(pAddr);
+		char aReason[256];
+		return m_Ban.IsBanned(&Address, aReason, sizeof(aReason));
+	}
+
+	void WriteFile(const char *pFilename, const char *pContents)
+	{
+		IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		io_write(File, pContents, str_length(pContents));
+		io_close(File);
+	}
+};
+
+TEST(NetBan, IsBannedRange)
+{
+	CTestNetBan Test;
+	CNetRange Range;
+	Range.m_LB = Addr("10.0.0.250");
+	Range.m_UB = Addr("10.0.1.5");
+	EXPECT_EQ(Test.m_Ban.BanRange(&Range, 0, "range"), 0);
+	NETADDR Single = Addr("192.168.0.1");
+	EXPECT_EQ(Test.m_Ban.BanAddr(&Single, 0, "single"), 0);
+
+	EXPECT_TRUE(Test.IsBanned("10.0.0.250"));
+	EXPECT_TRUE(Test.IsBanned("10.0.0.255"));
+	EXPECT_TRUE(Test.IsBanned("10.0.1.0"));
+	EXPECT_TRUE(Test.IsBanned("10.0.1.5"));
+	EXPECT_TRUE(Test.IsBanned("10.0.1.5:8303"));
+	EXPECT_FALSE(Test.IsBanned("10.0.0.249"));
+	EXPECT_FALSE(Test.IsBanned("10.0.1.6"));
+	EXPECT_FALSE(Test.IsBanned("11.0.0.0"));
+	EXPECT_TRUE(Test.IsBanned("192.168.0.1"));
+	EXPECT_FALSE(Test.IsBanned("192.168.0.2"));
+
+	EXPECT_EQ(Test.m_Ban.UnbanByRange(&Range), 0);
+	EXPECT_FALSE(Test.IsBanned("10.0.1.0"));
+	EXPECT_TRUE(Test.IsBanned("192.168.0.1"));
+	Test.m_Info.DeleteTestStorageFilesOnSuccess();
+}
+
+TEST(NetBan, Expiry)
+{
+	CTestNetBan Test;
+	const int Now = time_timestamp();
+	NETADDR Short = Addr("1.2.3.4");
+	NETADDR Long = Addr("1.2.3.5");
+	NETADDR Permanent = Addr("1.2.3.6");
+	CNetRange Range;
+	Range.m_LB = Addr("2.0.0.0");
+	Range.m_UB = Addr("2.0.0.255");
+	Test.m_Ban.BanAddr(&Short, 60, "short");
+	Test.m_Ban.BanAddr(&Long, 600, "long");
+	Test.m_Ban.BanAddr(&Permanent, 0, "permanent");
+	Test.m_Ban.BanRange(&Range, 60, "range");
+
+	Test.m_Ban.Expire(Now + 30);
+	EXPECT_TRUE(Test.IsBanned("1.2.3.4"));
+	EXPECT_TRUE(Test.IsBanned("2.0.0.7"));
+
+	Test.m_Ban.Expire(Now + 62);
+	EXPECT_FALSE(Test.IsBanned("1.2.3.4"));
+	EXPECT_FALSE(Test.IsBanned("2.0.0.7"));
+	EXPECT_TRUE(Test.IsBanned("1.2.3.5"));
+
+	// banning again moves the ban to a later slot
+	Test.m_Ban.BanAddr(&Long, 6000, "longer");
+	Test.m_Ban.Expire(Now + 602);
+	EXPECT_TRUE(Test.IsBanned("1.2.3.5"));
+
+	// a pause longer than the wheel still finds every due ban
+	Test.m_Ban.Expire(Now + 20000);
+	EXPECT_FALSE(Test.IsBanned("1.2.3.5"));
+	EXPECT_TRUE(Test.IsBanned("1.2.3.6"));
+	Test.m_Info.DeleteTestStorageFilesOnSuccess();
+}
+
+TEST(NetBan, Import)
+{
+	CTestNetBan Test;
+	Test.WriteFile("bans.txt",
+		"# comment\n"
+		"1.2.3.4\n"
+		"  5.6.7.8   # trailing comment\n"
+		"\n"
+		"10.0.0.0/24\n"
+		"20.0.0.1 - 20.0.0.3\n"
+		"30.0.0.1-30.0.0.1\n"
+		"2001:db8::/32\n"
+		"1.2.3.4\n"
+		"not an address\n"
+		"1.2.3.4/33\n"
+		"9.9.9.9 - 8.8.8.8\n"
+		"1.2.3.4:8303\n");
+
+	// 6 added, one updated and the last 4 skipped
+	EXPECT_EQ(Test.m_Ban.ImportBans("bans.txt", 0, "listed"), 7);
+	EXPECT_TRUE(Test.IsBanned("1.2.3.4"));
+	EXPECT_TRUE(Test.IsBanned("5.6.7.8"));
+	EXPECT_TRUE(Test.IsBanned("10.0.0.0"));
+	EXPECT_TRUE(Test.IsBanned("10.0.0.255"));
+	EXPECT_FALSE(Test.IsBanned("10.0.1.0"));
+	EXPECT_TRUE(Test.IsBanned("20.0.0.2"));
+	EXPECT_FALSE(Test.IsBanned("20.0.0.4"));
+	EXPECT_TRUE(Test.IsBanned("30.0.0.1"));
+	EXPECT_TRUE(Test.IsBanned("[2001:db8:ffff::1]"));
+	EXPECT_FALSE(Test.IsBanned("[2001:db9::1]"));
+	EXPECT_FALSE(Test.IsBanned("8.8.8.8"));
+	EXPECT_FALSE(Test.IsBanned("9.9.9.9"));
+
+	EXPECT_EQ(Test.m_Ban.ImportBans("missing.txt", 0, "listed"), -1);
+	Test.m_Info.DeleteTestStorageFilesOnSuccess();
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/map.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+#include <game/server/proximatetiles.h>
+
+#include <vector>
+
+static const int TILE_SPIKE = 200;
+
+// a game layer with a spike and a solid tile, held in memory
+class CSpikeMap : public IMap
+{
+	CMapItemGroup m_Group;
+	CMapItemLayerTilemap m_Layer;
+	std::vector<CTile> m_vTiles;
+
+public:
+	enum
+	{
+		WIDTH = 20,
+		HEIGHT = 10,
+		SPIKE_INDEX = 5 * WIDTH + 10,
+		SOLID_INDEX = 5 * WIDTH + 15,
+	};
+
+	CSpikeMap()
+	{
+		mem_zero(&m_Group, sizeof(m_Group));
+		m_Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+		m_Group.m_NumLayers = 1;
+		mem_zero(&m_Layer, sizeof(m_Layer));
+		m_Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+		m_Layer.m_Width = WIDTH;
+		m_Layer.m_Height = HEIGHT;
+		m_Layer.m_Flags = TILESLAYERFLAG_GAME;
+		m_vTiles.resize(WIDTH * HEIGHT, CTile{});
+		m_vTiles[SPIKE_INDEX].m_Index = TILE_SPIKE;
+		m_vTiles[SOLID_INDEX].m_Index = TILE_SOLID;
+	}
+
+	void *GetData(int Index) override { return m_vTiles.data(); }
+	int GetDataSize(int Index) override { return m_vTiles.size() * sizeof(CTile); }
+	void *GetDataSwapped(int Index) override { return GetData(Index); }
+	void UnloadData(int Index) override {}
+	void *GetItem(int Index, int *pType, int *pID) override
+	{
+		if(pType)
+			*pType = Index == 0 ? MAPITEMTYPE_GROUP : MAPITEMTYPE_LAYER;
+		if(pID)
+			*pID = 0;
+		return Index == 0 ? (void *)&m_Group : (void *)&m_Layer;
+	}
+	int GetItemSize(int Index) override { return Index == 0 ? sizeof(m_Group) : sizeof(m_Layer); }
+	void GetType(int Type, int *pStart, int *pNum) override
+	{
+		*pStart = Type == MAPITEMTYPE_LAYER ? 1 : 0;
+		*pNum = Type == MAPITEMTYPE_GROUP || Type == MAPITEMTYPE_LAYER ? 1 : 0;
+	}
+	void *FindItem(int Type, int ID) override { return nullptr; }
+	int NumItems() override { return 2; }
+};
+
+static vec2 TileCenter(int MapIndex)
+{
+	return vec2((MapIndex % CSpikeMap::WIDTH) * 32 + 16, (MapIndex / CSpikeMap::WIDTH) * 32 + 16);
+}
+
+TEST(ProximateTiles, OnlyNearDeclaredTiles)
+{
+	CSpikeMap Map;
+	CLayers Layers;
+	Layers.InitBackground(&Map);
+	CPrng Prng;
+	uint64 aSeed[2] = {0, 0};
+	Prng.Seed(aSeed);
+	CCollision Collision;
+	Collision.Init(&Layers, &Prng);
+
+	bool aTiles[256] = {};
+	aTiles[TILE_SPIKE] = true;
+	CProximateTileMap TileMap(&Collision, aTiles);
+	EXPECT_TRUE(TileMap.SameTiles(aTiles));
+	for(int i = 0; i < CSpikeMap::WIDTH * CSpikeMap::HEIGHT; i++)
+		EXPECT_EQ(TileMap.IsProximate(i), i == CSpikeMap::SPIKE_INDEX) << i;
+
+	// the same corners HandleTiles checks for a character
+	const float Radius = 28.0f;
+	int aIndices[4];
+	ASSERT_EQ(TileMap.FindNear(&Collision, TileCenter(CSpikeMap::SPIKE_INDEX), Radius, aIndices), 4);
+	for(int Index : aIndices)
+		EXPECT_EQ(Index, CSpikeMap::SPIKE_INDEX);
+
+	// only the left corners reach the spike
+	ASSERT_EQ(TileMap.FindNear(&Collision, TileCenter(CSpikeMap::SPIKE_INDEX) + vec2(24.0f, 0.0f), Radius, aIndices), 2);
+	EXPECT_EQ(aIndices[0], CSpikeMap::SPIKE_INDEX);
+	EXPECT_EQ(aIndices[1], CSpikeMap::SPIKE_INDEX);
+
+	// next to it, on an undeclared tile and far away
+	EXPECT_EQ(TileMap.FindNear(&Collision, TileCenter(CSpikeMap::SPIKE_INDEX + 1) + vec2(8.0f, 0.0f), Radius, aIndices), 0);
+	EXPECT_EQ(TileMap.FindNear(&Collision, TileCenter(CSpikeMap::SOLID_INDEX), Radius, aIndices), 0);
+	EXPECT_EQ(TileMap.FindNear(&Collision, vec2(40.0f, 40.0f), Radius, aIndices), 0);
+
+	aTiles[TILE_SOLID] = true;
+	EXPECT_FALSE(TileMap.SameTiles(aTiles));
+	CProximateTileMap BothMap(&Collision, aTiles);
+	EXPECT_EQ(BothMap.FindNear(&Collision, TileCenter(CSpikeMap::SOLID_INDEX), Radius, aIndices), 4);
+}
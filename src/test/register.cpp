@@ -0,0 +1,131 @@
+#include "http_stub.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/engine.h>
+#include <engine/server/register.h>
+#include <engine/server/register_info.h>
+#include <engine/shared/config.h>
+#include <engine/shared/http.h>
+#include <engine/shared/json.h>
+
+#include <chrono>
+#include <string>
+
+static CRegisterInfo::CClient Client(const char *pName, int Score)
+{
+	CRegisterInfo::CClient Client;
+	str_copy(Client.m_aName, pName, sizeof(Client.m_aName));
+	str_copy(Client.m_aClan, "clan", sizeof(Client.m_aClan));
+	Client.m_Score = Score;
+	Client.m_IsPlayer = true;
+	Client.m_HasPlayerInfo = true;
+	str_copy(Client.m_PlayerInfo.m_aSkinName, "default", sizeof(Client.m_PlayerInfo.m_aSkinName));
+	return Client;
+}
+
+static std::string Encode(CRegisterInfo *pInfo, IEngine *pEngine)
+{
+	std::string Result;
+	EXPECT_TRUE(pInfo->Encode(pEngine));
+	auto Timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while(!pInfo->PollResult(&Result) && std::chrono::steady_clock::now() < Timeout)
+		thread_sleep(1000);
+	return Result;
+}
+
+// checks the names and scores of the encoded clients
+static void ExpectClients(const std::string &Info, const std::vector<std::pair<std::string, int>> &vExpected)
+{
+	json_value *pJson = json_parse(Info.c_str(), Info.size());
+	ASSERT_TRUE(pJson);
+	const json_value *pClients = json_object_get(pJson, "clients");
+	ASSERT_EQ(json_array_length(pClients), (int)vExpected.size());
+	for(int i = 0; i < (int)vExpected.size(); i++)
+	{
+		const json_value *pClient = json_array_get(pClients, i);
+		EXPECT_STREQ(json_string_get(json_object_get(pClient, "name")), vExpected[i].first.c_str());
+		EXPECT_EQ(json_int_get(json_object_get(pClient, "score")), vExpected[i].second);
+		EXPECT_STREQ(json_string_get(json_object_get(json_object_get(pClient, "skin"), "name")), "default");
+	}
+	EXPECT_STREQ(json_string_get(json_object_get(pJson, "game_type")), "DDraceNetwork");
+	json_value_free(pJson);
+}
+
+TEST(RegisterInfo, EncodesChangedClients)
+{
+	IEngine *pEngine = CreateEngine("register-test", true, 1);
+	CRegisterInfo Info;
+	CRegisterInfo::CInfo ServerInfo;
+	str_copy(ServerInfo.m_aGameType, "DDraceNetwork", sizeof(ServerInfo.m_aGameType));
+	Info.SetInfo(ServerInfo);
+
+	Info.SetClient(0, Client("a", 1));
+	Info.SetClient(3, Client("b", 2));
+	Info.SetClient(7, Client("c", 3));
+	ExpectClients(Encode(&Info, pEngine), {{"a", 1}, {"b", 2}, {"c", 3}});
+	EXPECT_EQ(Info.NumEncodedClients(), 3);
+
+	// nothing changed, no job
+	Info.SetClient(3, Client("b", 2));
+	EXPECT_FALSE(Info.Encode(pEngine));
+
+	Info.SetClient(3, Client("b", 5));
+	ExpectClients(Encode(&Info, pEngine), {{"a", 1}, {"b", 5}, {"c", 3}});
+	EXPECT_EQ(Info.NumEncodedClients(), 1);
+
+	Info.RemoveClient(0);
+	ExpectClients(Encode(&Info, pEngine), {{"b", 5}, {"c", 3}});
+	EXPECT_EQ(Info.NumEncodedClients(), 0);
+
+	// a new client in a slot the cache still has an old entry for
+	Info.SetClient(0, Client("d", 4));
+	ExpectClients(Encode(&Info, pEngine), {{"d", 4}, {"b", 5}, {"c", 3}});
+	EXPECT_EQ(Info.NumEncodedClients(), 1);
+
+	delete pEngine;
+}
+
+TEST(RegisterInfo, PostsToMaster)
+{
+	CHttpStub Stub;
+	ASSERT_TRUE(Stub.Start("{\"status\":\"success\"}"));
+
+	char aUrl[128];
+	str_format(aUrl, sizeof(aUrl), "http://127.0.0.1:%d/register", Stub.m_Port);
+	// a copy, the other tests keep the defaults
+	CConfig Config = g_Config;
+	str_copy(Config.m_SvRegisterUrl, aUrl, sizeof(Config.m_SvRegisterUrl));
+	str_copy(Config.m_SvRegister, "tw0.6/ipv4", sizeof(Config.m_SvRegister));
+	Config.m_HttpAllowInsecure = 1;
+
+	IEngine *pEngine = CreateEngine("register-test", true, 2);
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	CHttp Http;
+	ASSERT_TRUE(Http.Init(std::chrono::seconds{0}, &Config));
+	IRegister *pRegister = CreateRegister(&Config, pConsole, pEngine, &Http, 8303, 0);
+	pRegister->OnConfigChange();
+	pRegister->Update();
+
+	CRegisterInfo Info;
+	CRegisterInfo::CInfo ServerInfo;
+	str_copy(ServerInfo.m_aGameType, "DDraceNetwork", sizeof(ServerInfo.m_aGameType));
+	Info.SetInfo(ServerInfo);
+	Info.SetClient(1, Client("a", 1));
+	Info.SetClient(2, Client("b", 2));
+	pRegister->OnNewInfo(Encode(&Info, pEngine).c_str());
+
+	auto Timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while(Stub.NumRequests() == 0 && std::chrono::steady_clock::now() < Timeout)
+	{
+		pRegister->Update();
+		thread_sleep(1000);
+	}
+	ASSERT_EQ(Stub.NumRequests(), 1);
+	ExpectClients(Stub.LastBody(), {{"a", 1}, {"b", 2}});
+
+	delete pRegister;
+	delete pEngine;
+	delete pConsole;
+}
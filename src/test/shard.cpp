@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/shard.h>
+#include <engine/shared/json.h>
+#include <engine/shared/network.h>
+
+#include <string>
+#include <vector>
+
+static NETADDR Addr(const char *pStr)
+{
+	NETADDR Addr;
+	EXPECT_EQ(net_addr_from_str(&Addr, pStr), 0);
+	return Addr;
+}
+
+TEST(Shard, Tunnel)
+{
+	NETADDR Client = Addr("[2001:db8::1]:8303");
+	unsigned char aBuffer[NET_MAX_DATAGRAMSIZE];
+	int Size = CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_PACKET, &Client, "abc", 3);
+	ASSERT_EQ(Size, NET_TUNNEL_HEADERSIZE + 3);
+
+	int Type;
+	NETADDR Unpacked;
+	const unsigned char *pPayload;
+	ASSERT_EQ(CNetTunnel::Unpack(aBuffer, Size, &Type, &Unpacked, &pPayload), 3);
+	EXPECT_EQ(Type, CNetTunnel::TYPE_PACKET);
+	EXPECT_EQ(net_addr_comp(&Unpacked, &Client), 0);
+	EXPECT_EQ(mem_comp(pPayload, "abc", 3), 0);
+
+	// a whole game packet fits, but not more
+	unsigned char aPacket[NET_MAX_PACKETSIZE + 1] = {0};
+	EXPECT_EQ(CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_PACKET, &Client, aPacket, NET_MAX_PACKETSIZE), NET_MAX_DATAGRAMSIZE);
+	EXPECT_EQ(CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_PACKET, &Client, aPacket, NET_MAX_PACKETSIZE + 1), -1);
+
+	// client packets need an address
+	Size = CNetTunnel::Pack(aBuffer, sizeof(aBuffer), CNetTunnel::TYPE_PACKET, nullptr, "abc", 3);
+	EXPECT_EQ(CNetTunnel::Unpack(aBuffer, Size, &Type, &Unpacked, &pPayload), -1);
+	EXPECT_EQ(CNetTunnel::Unpack(aBuffer, NET_TUNNEL_HEADERSIZE - 1, &Type, &Unpacked, &pPayload), -1);
+}
+
+// the shard an ip goes to when all shards are available
+static int Preferred(const char *pAddr, int NumShards)
+{
+	CShardRoutes Routes;
+	Routes.Init(NumShards);
+	return Routes.Route(Addr(pAddr), 0);
+}
+
+TEST(Shard, Routes)
+{
+	CShardRoutes Routes;
+	Routes.Init(3);
+	int Shard = Routes.Route(Addr("1.2.3.4:1"), 1);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:2"), 1), Shard);
+	EXPECT_EQ(Routes.NumRoutes(Shard), 2);
+
+	// the routes expire, but the ip comes back to the same shard
+	Routes.Expire(2, 2);
+	EXPECT_EQ(Routes.NumRoutes(), 0);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:3"), 6), Shard);
+
+	// ips spread over all shards
+	int aCounts[3] = {0, 0, 0};
+	for(int i = 0; i < 300; i++)
+	{
+		char aAddr[NETADDR_MAXSTRSIZE];
+		str_format(aAddr, sizeof(aAddr), "10.0.%d.%d:8303", i / 256, i % 256);
+		aCounts[Routes.Route(Addr(aAddr), 6)]++;
+	}
+	for(int Count : aCounts)
+		EXPECT_GT(Count, 50);
+}
+
+TEST(Shard, RoutesAvoidFullAndDead)
+{
+	CShardRoutes Routes;
+	Routes.Init(3);
+	const int Shard = Preferred("1.2.3.4", 3);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:1"), 1), Shard);
+
+	// known addresses stay on a full shard, new ones go elsewhere
+	Routes.SetFull(Shard, true);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:1"), 2), Shard);
+	const int Other = Routes.Route(Addr("1.2.3.4:2"), 2);
+	EXPECT_NE(Other, Shard);
+
+	// a dead shard loses its routes
+	Routes.SetAlive(Other, false);
+	const int Last = Routes.Route(Addr("1.2.3.4:2"), 3);
+	EXPECT_NE(Last, Shard);
+	EXPECT_NE(Last, Other);
+	EXPECT_EQ(Routes.NumRoutes(Other), 0);
+
+	// full shards are still better than a dead one
+	Routes.SetFull(Last, true);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:3"), 3), Shard);
+
+	Routes.SetFull(Shard, false);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:4"), 3), Shard);
+}
+
+TEST(Shard, RoutesKeepBans)
+{
+	CShardRoutes Routes;
+	Routes.Init(2);
+	const int Shard = Preferred("1.2.3.4", 2);
+	const int Banning = 1 - Shard;
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:1"), 1), Shard);
+
+	// the client is moved to the child that banned it
+	Routes.Pin(Addr("1.2.3.0"), Addr("1.2.3.255"), Banning, 100);
+	EXPECT_EQ(Routes.NumPins(), 1);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:1"), 2), Banning);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:2"), 2), Banning);
+	EXPECT_EQ(Routes.Route(Addr("1.2.4.0:1"), 2), Preferred("1.2.4.0", 2));
+
+	// even if it's full or the route expired
+	Routes.SetFull(Banning, true);
+	Routes.Expire(50, 50);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:1"), 60), Banning);
+
+	// banning again extends the pin
+	Routes.Pin(Addr("1.2.3.0"), Addr("1.2.3.255"), Banning, 200);
+	Routes.Expire(0, 150);
+	EXPECT_EQ(Routes.NumPins(), 1);
+	Routes.Pin(Addr("[2001:db8::1]"), Addr("[2001:db8::1]"), Banning, -1);
+	Routes.Expire(0, 250);
+	EXPECT_EQ(Routes.NumPins(), 1);
+	Routes.SetFull(Banning, false);
+	EXPECT_EQ(Routes.Route(Addr("1.2.3.4:5"), 250), Shard);
+	EXPECT_EQ(Routes.Route(Addr("[2001:db8::1]:5"), 250), Banning);
+
+	// invalid ranges are ignored
+	Routes.Pin(Addr("1.2.3.5"), Addr("1.2.3.4"), Banning, -1);
+	Routes.Pin(Addr("1.2.3.4"), Addr("[::1]"), Banning, -1);
+	EXPECT_EQ(Routes.NumPins(), 1);
+}
+
+TEST(Shard, InfoFull)
+{
+	EXPECT_TRUE(CShardFront::InfoFull("{\"max_clients\":2,\"clients\":[{},{}]}"));
+	EXPECT_FALSE(CShardFront::InfoFull("{\"max_clients\":3,\"clients\":[{},{}]}"));
+	EXPECT_FALSE(CShardFront::InfoFull("{\"max_clients\":2}"));
+	EXPECT_FALSE(CShardFront::InfoFull("not json"));
+	EXPECT_FALSE(CShardFront::InfoFull(""));
+}
+
+TEST(Shard, InfoParts)
+{
+	std::string Info(3 * CNetTunnel::MAX_INFO_PART + 10, 'x');
+	for(size_t i = 0; i < Info.size(); i++)
+		Info[i] = 'a' + i % 26;
+
+	auto Part = [&](int Serial, int Index) {
+		int Offset = Index * CNetTunnel::MAX_INFO_PART;
+		int Size = std::min((int)Info.size() - Offset, (int)CNetTunnel::MAX_INFO_PART);
+		std::vector<unsigned char> vPart = {(unsigned char)Serial, (unsigned char)Index, 4};
+		vPart.insert(vPart.end(), Info.begin() + Offset, Info.begin() + Offset + Size);
+		return vPart;
+	};
+
+	CShardInfoParts Parts;
+	std::string Result;
+	for(int Index : {2, 0, 3})
+	{
+		std::vector<unsigned char> vPart = Part(1, Index);
+		EXPECT_FALSE(Parts.Add(vPart.data(), vPart.size(), &Result));
+	}
+	// a newer info drops the old parts
+	std::vector<unsigned char> vNewer = Part(2, 1);
+	EXPECT_FALSE(Parts.Add(vNewer.data(), vNewer.size(), &Result));
+	for(int Index : {3, 0})
+	{
+		std::vector<unsigned char> vPart = Part(2, Index);
+		EXPECT_FALSE(Parts.Add(vPart.data(), vPart.size(), &Result));
+	}
+	std::vector<unsigned char> vLast = Part(2, 2);
+	ASSERT_TRUE(Parts.Add(vLast.data(), vLast.size(), &Result));
+	EXPECT_EQ(Result, Info);
+}
+
+TEST(Shard, MergeInfos)
+{
+	std::vector<std::string> vInfos = {
+		"{\"max_clients\":64,\"max_players\":64,\"name\":\"shards\",\"map\":{\"name\":\"a\",\"size\":1},\"clients\":[{\"name\":\"a\",\"afk\":false}]}",
+		"not json",
+		"{\"max_clients\":64,\"max_players\":32,\"name\":\"shards\",\"map\":{\"name\":\"a\",\"size\":1},\"clients\":[{\"name\":\"b\",\"afk\":true},{\"name\":\"c\",\"afk\":false}]}",
+	};
+	std::string Merged;
+	ASSERT_TRUE(CShardFront::MergeInfos(vInfos, &Merged));
+
+	json_value *pJson = json_parse(Merged.c_str(), Merged.size());
+	ASSERT_TRUE(pJson);
+	EXPECT_EQ(json_int_get(json_object_get(pJson, "max_clients")), 128);
+	EXPECT_EQ(json_int_get(json_object_get(pJson, "max_players")), 96);
+	EXPECT_STREQ(json_string_get(json_object_get(pJson, "name")), "shards");
+	EXPECT_EQ(json_int_get(json_object_get(json_object_get(pJson, "map"), "size")), 1);
+	const json_value *pClients = json_object_get(pJson, "clients");
+	ASSERT_EQ(json_array_length(pClients), 3);
+	EXPECT_STREQ(json_string_get(json_object_get(json_array_get(pClients, 2), "name")), "c");
+	EXPECT_TRUE(json_boolean_get(json_object_get(json_array_get(pClients, 1), "afk")));
+	json_value_free(pJson);
+
+	EXPECT_FALSE(CShardFront::MergeInfos({"", "[]"}, &Merged));
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/snapgrid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+struct CBox
+{
+	vec2 m_TL;
+	vec2 m_BR;
+};
+
+static bool Overlaps(const CBox &a, const CBox &b)
+{
+	return a.m_TL.x <= b.m_BR.x && b.m_TL.x <= a.m_BR.x && a.m_TL.y <= b.m_BR.y && b.m_TL.y <= a.m_BR.y;
+}
+
+static std::vector<CBox> RandomBoxes(std::mt19937 &Rng, int Num, float Size)
+{
+	// some outside of the grid, some long like lasers
+	std::uniform_real_distribution<float> Coord(-1000.0f, Size + 1000.0f);
+	std::uniform_real_distribution<float> Extent(0.0f, 1.0f);
+	std::vector<CBox> vBoxes;
+	for(int i = 0; i < Num; i++)
+	{
+		vec2 TL(Coord(Rng), Coord(Rng));
+		float Length = Rng() % 10 == 0 ? 3000.0f : 50.0f;
+		vBoxes.push_back({TL, TL + vec2(Extent(Rng), Extent(Rng)) * Length});
+	}
+	return vBoxes;
+}
+
+TEST(SnapGrid, FindsOverlappingBoxes)
+{
+	std::mt19937 Rng(1);
+	const float Size = 6400.0f;
+	CSnapGrid Grid;
+	Grid.Init(Size, Size / 2);
+	std::vector<CBox> vBoxes = RandomBoxes(Rng, 2000, Size);
+	for(int i = 0; i < (int)vBoxes.size(); i++)
+		Grid.Add(i, vBoxes[i].m_TL, vBoxes[i].m_BR);
+	Grid.AddAlways(vBoxes.size());
+
+	std::vector<int> vItems;
+	for(const CBox &View : RandomBoxes(Rng, 200, Size))
+	{
+		Grid.Query(View.m_TL, View.m_BR, &vItems);
+		ASSERT_TRUE(std::is_sorted(vItems.begin(), vItems.end()));
+		ASSERT_EQ(std::adjacent_find(vItems.begin(), vItems.end()), vItems.end());
+		ASSERT_EQ(vItems.back(), (int)vBoxes.size());
+		for(int i = 0; i < (int)vBoxes.size(); i++)
+		{
+			if(Overlaps(vBoxes[i], View))
+			{
+				ASSERT_TRUE(std::binary_search(vItems.begin(), vItems.end(), i)) << "box " << i;
+			}
+		}
+	}
+
+	// no bounds, no view
+	Grid.Clear();
+	Grid.Add(0, vec2(NAN, 0.0f), vec2(NAN, 0.0f));
+	Grid.Add(1, vec2(100.0f, 100.0f), vec2(100.0f, 100.0f));
+	Grid.Query(vec2(NAN, NAN), vec2(NAN, NAN), &vItems);
+	EXPECT_EQ(vItems, std::vector<int>({0, 1}));
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/snapshot.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+static const int NUM_ITEMS = 900;
+static const int ITEM_SIZE = 10 * sizeof(int);
+static const int FROM_TICK = 100;
+
+// a world of mostly resting items, some of which change between the ticks
+class CSnapshotPair
+{
+public:
+	std::unique_ptr<CSnapshotBuilder> m_pBuilder = std::make_unique<CSnapshotBuilder>();
+	std::vector<char> m_vFrom = std::vector<char>(CSnapshot::MAX_SIZE);
+	std::vector<char> m_vTo = std::vector<char>(CSnapshot::MAX_SIZE);
+	std::vector<int> m_vUnchangedSince;
+
+	CSnapshot *From() { return (CSnapshot *)m_vFrom.data(); }
+	CSnapshot *To() { return (CSnapshot *)m_vTo.data(); }
+
+	CSnapshotPair(unsigned Seed, int ChangedPercent)
+	{
+		std::mt19937 Rng(Seed);
+		std::vector<int> vData(NUM_ITEMS * ITEM_SIZE / sizeof(int));
+		for(auto &Data : vData)
+			Data = Rng() % 4096;
+
+		m_pBuilder->Init();
+		for(int i = 0; i < NUM_ITEMS; i++)
+			mem_copy(m_pBuilder->NewItem(1 + i % 8, i, ITEM_SIZE), &vData[i * 10], ITEM_SIZE);
+		m_pBuilder->Finish(From());
+
+		m_pBuilder->Init();
+		for(int i = 0; i < NUM_ITEMS; i++)
+		{
+			int UnchangedSince = FROM_TICK - (int)(Rng() % 50);
+			if((int)(Rng() % 100) < ChangedPercent)
+			{
+				vData[i * 10 + Rng() % 10]++;
+				// some know they changed, the others are just not hinted
+				UnchangedSince = Rng() % 2 ? FROM_TICK + 1 : -1;
+			}
+			// unchanged, but retained after the delta's base
+			else if(Rng() % 10 == 0)
+				UnchangedSince = FROM_TICK + 1;
+			mem_copy(m_pBuilder->NewItem(1 + i % 8, i, ITEM_SIZE, UnchangedSince), &vData[i * 10], ITEM_SIZE);
+		}
+		m_pBuilder->Finish(To());
+		m_vUnchangedSince.assign(m_pBuilder->UnchangedSince(), m_pBuilder->UnchangedSince() + To()->NumItems());
+	}
+};
+
+TEST(SnapshotDelta, UnchangedHintsKeepDelta)
+{
+	auto pDelta = std::make_unique<CSnapshotDelta>();
+	for(int ChangedPercent : {0, 5, 50})
+	{
+		CSnapshotPair Pair(ChangedPercent, ChangedPercent);
+		std::vector<char> vFull(CSnapshot::MAX_SIZE);
+		std::vector<char> vHinted(CSnapshot::MAX_SIZE);
+		int FullSize = pDelta->CreateDelta(Pair.From(), Pair.To(), vFull.data());
+		int HintedSize = pDelta->CreateDelta(Pair.From(), Pair.To(), vHinted.data(), Pair.m_vUnchangedSince.data(), FROM_TICK);
+		ASSERT_EQ(FullSize, HintedSize);
+		EXPECT_EQ(mem_comp(vFull.data(), vHinted.data(), FullSize), 0);
+
+		// the client gets the new snapshot back
+		if(FullSize)
+		{
+			std::vector<char> vUnpacked(CSnapshot::MAX_SIZE);
+			CSnapshot *pUnpacked = (CSnapshot *)vUnpacked.data();
+			int UnpackedSize = pDelta->UnpackDelta(Pair.From(), pUnpacked, vHinted.data(), HintedSize);
+			ASSERT_GT(UnpackedSize, 0);
+			EXPECT_EQ(pUnpacked->Crc(), Pair.To()->Crc());
+		}
+	}
+}
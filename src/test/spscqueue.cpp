@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/spscqueue.h>
+
+TEST(SpscQueue, Empty)
+{
+	CSpscQueue<int, 4> Queue;
+	EXPECT_TRUE(Queue.Empty());
+	EXPECT_EQ(Queue.Front(), nullptr);
+}
+
+TEST(SpscQueue, Full)
+{
+	CSpscQueue<int, 4> Queue;
+	for(int i = 0; i < 4; i++)
+	{
+		int *pSlot = Queue.Back();
+		ASSERT_NE(pSlot, nullptr);
+		*pSlot = i;
+		Queue.Push();
+	}
+	EXPECT_EQ(Queue.Back(), nullptr);
+	EXPECT_EQ(Queue.Size(), 4u);
+
+	for(int i = 0; i < 4; i++)
+	{
+		int *pSlot = Queue.Front();
+		ASSERT_NE(pSlot, nullptr);
+		EXPECT_EQ(*pSlot, i);
+		Queue.Pop();
+	}
+	EXPECT_TRUE(Queue.Empty());
+}
+
+static const int NUM_TRANSFERS = 100000;
+
+static void Produce(void *pUser)
+{
+	CSpscQueue<int, 64> *pQueue = static_cast<CSpscQueue<int, 64> *>(pUser);
+	for(int i = 0; i < NUM_TRANSFERS; i++)
+	{
+		int *pSlot;
+		while(!(pSlot = pQueue->Back()))
+			thread_yield();
+		*pSlot = i;
+		pQueue->Push();
+	}
+}
+
+TEST(SpscQueue, Threaded)
+{
+	CSpscQueue<int, 64> Queue;
+	void *pThread = thread_init(Produce, &Queue, "spsc producer");
+	// takes everything before asserting, the producer uses the queue until
+	// it's done
+	int FirstWrong = -1;
+	for(int i = 0; i < NUM_TRANSFERS; i++)
+	{
+		int *pSlot;
+		while(!(pSlot = Queue.Front()))
+			thread_yield();
+		if(*pSlot != i && FirstWrong == -1)
+			FirstWrong = i;
+		Queue.Pop();
+	}
+	thread_wait(pThread);
+	EXPECT_EQ(FirstWrong, -1);
+	EXPECT_TRUE(Queue.Empty());
+}
@@ -0,0 +1,232 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+#include <engine/server/databases/connection_pool.h>
+
+#include <atomic>
+#include <chrono>
+
+struct CPointsResult : ISqlResult
+{
+	int m_NumPlayers = 0;
+	int m_TotalPoints = 0;
+};
+
+struct CPointsRequest : ISqlData
+{
+	CPointsRequest(std::shared_ptr<ISqlResult> pResult, const char *pName, int Points) :
+		ISqlData(std::move(pResult)), m_Points(Points)
+	{
+		str_copy(m_aName, pName, sizeof(m_aName));
+	}
+
+	char m_aName[32];
+	int m_Points;
+};
+
+static bool AddPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize)
+{
+	const CPointsRequest *pData = dynamic_cast<const CPointsRequest *>(pGameData);
+	return pSqlServer->AddPoints(pData->m_aName, pData->m_Points, pError, ErrorSize);
+}
+
+static bool BrokenWrite(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize)
+{
+	return pSqlServer->PrepareStatement("INSERT INTO no_such_table VALUES (1)", pError, ErrorSize);
+}
+
+// blocks the write worker until the test lets it go, and holds the
+// transaction of its batch open until a read finished
+struct CHoldRequest : ISqlData
+{
+	CHoldRequest(std::shared_ptr<ISqlResult> pResult, std::atomic<int> *pState, const std::atomic_bool *pRelease) :
+		ISqlData(std::move(pResult)), m_pState(pState), m_pRelease(pRelease)
+	{
+	}
+
+	std::atomic<int> *m_pState;
+	const std::atomic_bool *m_pRelease;
+};
+
+static bool HoldWrite(IDbConnection *pSqlServer, const ISqlData *pGameData, bool Failure, char *pError, int ErrorSize)
+{
+	const CHoldRequest *pData = dynamic_cast<const CHoldRequest *>(pGameData);
+	if(pSqlServer->AddPoints("holder", 1, pError, ErrorSize))
+		return true;
+	pData->m_pState->fetch_add(1);
+	auto Timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while(!pData->m_pRelease->load() && std::chrono::steady_clock::now() < Timeout)
+		thread_sleep(1000);
+	return false;
+}
+
+static bool SumPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	CPointsResult *pResult = dynamic_cast<CPointsResult *>(pGameData->m_pResult.get());
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "SELECT COUNT(*), SUM(Points) FROM %s_points", pSqlServer->GetPrefix());
+	if(pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+		return true;
+	bool End;
+	if(pSqlServer->Step(&End, pError, ErrorSize) || End)
+		return true;
+	pResult->m_NumPlayers = pSqlServer->GetInt(1);
+	pResult->m_TotalPoints = pSqlServer->IsNull(2) ? 0 : pSqlServer->GetInt(2);
+	return false;
+}
+
+class DbConnectionPool : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	char m_aFilename[128];
+
+	DbConnectionPool()
+	{
+		str_format(m_aFilename, sizeof(m_aFilename), "%s.sqlite", m_Info.m_aFilename);
+	}
+
+	~DbConnectionPool()
+	{
+		char aBuf[160];
+		for(const char *pSuffix : {"-wal", "-shm"})
+		{
+			str_format(aBuf, sizeof(aBuf), "%s%s", m_aFilename, pSuffix);
+			fs_remove(aBuf);
+		}
+		fs_remove(m_aFilename);
+	}
+
+	void Start(CDbConnectionPool *pPool, int WriteBatchSize)
+	{
+		std::unique_ptr<IDbConnection> pDb(CreateSqliteConnection(m_aFilename, true));
+		std::unique_ptr<IDbConnection> pCopy(pDb->Copy());
+		pPool->RegisterDatabase(std::move(pDb), CDbConnectionPool::READ);
+		pPool->RegisterDatabase(std::move(pCopy), CDbConnectionPool::WRITE);
+		pPool->Start(1, 1, WriteBatchSize);
+	}
+
+	std::shared_ptr<CPointsResult> Sum(CDbConnectionPool *pPool)
+	{
+		auto pResult = std::make_shared<CPointsResult>();
+		pPool->Execute(SumPoints, std::make_unique<CPointsRequest>(pResult, "", 0), "sum points");
+		while(!pResult->m_Completed)
+			thread_sleep(1000);
+		return pResult;
+	}
+};
+
+TEST_F(DbConnectionPool, BatchedWrites)
+{
+	CDbConnectionPool Pool;
+	Start(&Pool, 16);
+
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 200; i++)
+	{
+		char aName[32];
+		str_format(aName, sizeof(aName), "player%d", i % 50);
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		Pool.ExecuteWrite(AddPoints, std::make_unique<CPointsRequest>(vpResults.back(), aName, 1), "add points");
+	}
+	// in the middle of a batch, must not take the other writes down
+	auto pBrokenResult = std::make_shared<ISqlResult>();
+	Pool.ExecuteWrite(BrokenWrite, std::make_unique<CPointsRequest>(pBrokenResult, "", 0), "broken write");
+	vpResults.push_back(std::make_shared<ISqlResult>());
+	Pool.ExecuteWrite(AddPoints, std::make_unique<CPointsRequest>(vpResults.back(), "player0", 1), "add points");
+
+	for(auto &pResult : vpResults)
+	{
+		while(!pResult->m_Completed)
+			thread_sleep(1000);
+		EXPECT_TRUE(pResult->m_Success);
+	}
+	while(!pBrokenResult->m_Completed)
+		thread_sleep(1000);
+	EXPECT_FALSE(pBrokenResult->m_Success);
+
+	// the same statements run again from the cache
+	for(int i = 0; i < 2; i++)
+	{
+		std::shared_ptr<CPointsResult> pSum = Sum(&Pool);
+		EXPECT_TRUE(pSum->m_Success);
+		EXPECT_EQ(pSum->m_NumPlayers, 50);
+		EXPECT_EQ(pSum->m_TotalPoints, 201);
+	}
+
+	Pool.OnShutdown();
+	EXPECT_EQ(Pool.NumQueued(), 0);
+}
+
+TEST_F(DbConnectionPool, ShutdownDrainsQueue)
+{
+	CDbConnectionPool Pool;
+	Start(&Pool, 4);
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 20; i++)
+	{
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		Pool.ExecuteWrite(AddPoints, std::make_unique<CPointsRequest>(vpResults.back(), "player", 1), "add points");
+	}
+	Pool.OnShutdown();
+	for(auto &pResult : vpResults)
+	{
+		EXPECT_TRUE(pResult->m_Completed);
+		EXPECT_TRUE(pResult->m_Success);
+	}
+}
+
+TEST_F(DbConnectionPool, ReadsDuringWriteBatch)
+{
+	CDbConnectionPool Pool;
+	Start(&Pool, 16);
+	EXPECT_TRUE(Sum(&Pool)->m_Success);
+
+	// the first write keeps the worker busy until the batch is queued
+	std::atomic<int> State{0};
+	std::atomic_bool ReleaseFirst{false};
+	std::atomic_bool ReleaseBatch{false};
+	auto pFirstResult = std::make_shared<ISqlResult>();
+	Pool.ExecuteWrite(HoldWrite, std::make_unique<CHoldRequest>(pFirstResult, &State, &ReleaseFirst), "hold first");
+	while(State.load() < 1)
+		thread_sleep(1000);
+
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 4; i++)
+	{
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		Pool.ExecuteWrite(AddPoints, std::make_unique<CPointsRequest>(vpResults.back(), "player", 1), "add points");
+	}
+	vpResults.push_back(std::make_shared<ISqlResult>());
+	Pool.ExecuteWrite(HoldWrite, std::make_unique<CHoldRequest>(vpResults.back(), &State, &ReleaseBatch), "hold batch");
+	ReleaseFirst.store(true);
+	while(State.load() < 2)
+		thread_sleep(1000);
+
+	// the batch is still open, reads see the last commit
+	for(int i = 0; i < 2; i++)
+	{
+		std::shared_ptr<CPointsResult> pSum = Sum(&Pool);
+		EXPECT_TRUE(pSum->m_Success);
+		EXPECT_EQ(pSum->m_NumPlayers, 1);
+		EXPECT_EQ(pSum->m_TotalPoints, 1);
+	}
+	EXPECT_FALSE(vpResults.back()->m_Completed);
+	ReleaseBatch.store(true);
+
+	EXPECT_TRUE(pFirstResult->m_Success);
+	for(auto &pResult : vpResults)
+	{
+		while(!pResult->m_Completed)
+			thread_sleep(1000);
+		EXPECT_TRUE(pResult->m_Success);
+	}
+	std::shared_ptr<CPointsResult> pSum = Sum(&Pool);
+	EXPECT_TRUE(pSum->m_Success);
+	EXPECT_EQ(pSum->m_NumPlayers, 2);
+	EXPECT_EQ(pSum->m_TotalPoints, 6);
+
+	Pool.OnShutdown();
+}
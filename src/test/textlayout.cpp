@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/textlayout.h>
+
+#include <set>
+#include <utility>
+
+static const int GAP_SIZE = 10;
+
+TEST(TextLayout, SegmentsCoverDots)
+{
+	char aText[96];
+	for(int i = 0; i < 95; i++)
+		aText[i] = ' ' + i;
+	aText[95] = '\0';
+	CTextLayout Layout(aText, GAP_SIZE);
+
+	std::set<std::pair<int, int>> Dots;
+	for(const auto &Dot : Layout.m_vDots)
+		Dots.emplace(Dot.x, Dot.y);
+	EXPECT_EQ(Dots.size(), Layout.m_vDots.size());
+
+	std::set<std::pair<int, int>> Covered;
+	for(const auto &Segment : Layout.m_vSegments)
+	{
+		vec2 Step = Segment.m_To - Segment.m_From;
+		int Num = maximum(absolute(Step.x), absolute(Step.y)) / GAP_SIZE;
+		if(Num > 0)
+			Step /= Num;
+		for(int i = 0; i <= Num; i++)
+		{
+			vec2 Pos = Segment.m_From + Step * i;
+			std::pair<int, int> Dot(Pos.x, Pos.y);
+			// segments only pass through dots of the text
+			ASSERT_TRUE(Dots.count(Dot)) << Pos.x << " " << Pos.y;
+			Covered.insert(Dot);
+		}
+	}
+	EXPECT_EQ(Covered, Dots);
+	EXPECT_LT(Layout.m_vSegments.size(), Layout.m_vDots.size());
+}
+
+TEST(TextLayout, Shared)
+{
+	auto pA = CTextLayout::Get("+1", GAP_SIZE);
+	auto pB = CTextLayout::Get("+1", GAP_SIZE);
+	auto pC = CTextLayout::Get("+1", GAP_SIZE + 1);
+	EXPECT_EQ(pA, pB);
+	EXPECT_NE(pA, pC);
+}
+
+// texts need fewer laser items than the one per dot before
+TEST(TextLayout, LaserItems)
+{
+	const char *apTexts[] = {"+1", "FIRST BLOOD!", "Hello World", "0123456789", "#$%&*"};
+	for(const char *pText : apTexts)
+	{
+		CTextLayout Layout(pText, GAP_SIZE);
+		EXPECT_GT(Layout.m_vSegments.size(), 0u) << pText;
+		EXPECT_LT(Layout.m_vSegments.size(), Layout.m_vDots.size()) << pText;
+	}
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/votelist.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// behaves like a client, counts the bytes of the vote messages
+class CVoteClient
+{
+public:
+	std::vector<std::string> m_vOptions;
+	int m_Bytes = 0;
+
+	void Clear()
+	{
+		m_vOptions.clear();
+		m_Bytes += CVoteOptionList::MSG_OVERHEAD;
+	}
+
+	void Remove(const std::string &Description)
+	{
+		for(auto It = m_vOptions.begin(); It != m_vOptions.end(); ++It)
+		{
+			if(*It == Description)
+			{
+				m_vOptions.erase(It);
+				break;
+			}
+		}
+		m_Bytes += CVoteOptionList::MSG_OVERHEAD + Description.size() + 1;
+	}
+
+	// a list add message always carries 15 strings
+	void ListAdd(const std::vector<std::string> &vDescriptions)
+	{
+		m_Bytes += CVoteOptionList::MSG_OVERHEAD + 1 + 15 - vDescriptions.size();
+		for(const auto &Description : vDescriptions)
+		{
+			m_vOptions.push_back(Description);
+			m_Bytes += Description.size() + 1;
+		}
+	}
+};
+
+static const int VOTES_PER_TICK = 5;
+
+static void Sync(CVoteOptionList *pList, std::vector<std::string> vOptions, CVoteClient *pClient)
+{
+	CVoteOptionList::CUpdate Update;
+	pList->Update(std::move(vOptions), &Update);
+	if(Update.m_Clear)
+		pClient->Clear();
+	for(const auto &Remove : Update.m_vRemove)
+		pClient->Remove(Remove);
+	while(pList->NumPending())
+	{
+		std::vector<std::string> vAdd;
+		for(int i = 0; i < VOTES_PER_TICK && pList->NumPending(); i++)
+		{
+			vAdd.emplace_back(pList->Option(pList->NumSent()));
+			pList->OnSent(1);
+		}
+		pClient->ListAdd(vAdd);
+	}
+}
+
+// what the server did before, clear and send everything again
+static void Resend(const std::vector<std::string> &vOptions, CVoteClient *pClient)
+{
+	pClient->Clear();
+	for(size_t i = 0; i < vOptions.size(); i += VOTES_PER_TICK)
+		pClient->ListAdd(std::vector<std::string>(vOptions.begin() + i, vOptions.begin() + std::min(vOptions.size(), i + VOTES_PER_TICK)));
+}
+
+TEST(VoteOptionList, ClientMatchesList)
+{
+	std::mt19937 Rng(1);
+	CVoteOptionList List;
+	CVoteClient Client;
+	for(int i = 0; i < 2000; i++)
+	{
+		// few distinct descriptions to get duplicates
+		std::vector<std::string> vOptions;
+		int Num = Rng() % 20;
+		for(int j = 0; j < Num; j++)
+			vOptions.push_back("option " + std::to_string(Rng() % 8));
+		Sync(&List, vOptions, &Client);
+		ASSERT_EQ(Client.m_vOptions, vOptions);
+	}
+}
+
+TEST(VoteOptionList, KeepsUnchanged)
+{
+	CVoteOptionList List;
+	CVoteClient Client;
+	Sync(&List, {"title", "room 0: 1/8", "room 1: 2/8", "a", "b", "c"}, &Client);
+
+	CVoteOptionList::CUpdate Update;
+	List.Update({"title", "room 0: 1/8", "room 1: 2/8", "a", "b", "c"}, &Update);
+	EXPECT_FALSE(Update.m_Clear);
+	EXPECT_TRUE(Update.m_vRemove.empty());
+	EXPECT_EQ(List.NumPending(), 0);
+
+	// a removed option at the end
+	List.Update({"title", "room 0: 1/8", "room 1: 2/8", "a", "b"}, &Update);
+	EXPECT_FALSE(Update.m_Clear);
+	ASSERT_EQ(Update.m_vRemove.size(), 1u);
+	EXPECT_EQ(Update.m_vRemove[0], "c");
+	EXPECT_EQ(List.NumPending(), 0);
+}
+
+// the diffs cost fewer bytes than resending the list while rooms come and go
+TEST(VoteOptionList, ChurnBytes)
+{
+	static const int NUM_CLIENTS = 16;
+	static const int NUM_GLOBAL = 30;
+	std::mt19937 Rng(2);
+
+	std::vector<int> vRooms = {0};
+	std::vector<int> vPlayers = {NUM_CLIENTS};
+	auto Options = [&](int ClientID) {
+		std::vector<std::string> vOptions = {"Rooms"};
+		for(size_t i = 0; i < vRooms.size(); i++)
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "⨀ Room %d: ♙%d/16 [ddnet] ♔creator%s", vRooms[i], vPlayers[i], ClientID % (int)vRooms.size() == (int)i ? " ⬅" : "");
+			vOptions.emplace_back(aBuf);
+		}
+		for(int i = 0; i < NUM_GLOBAL; i++)
+			vOptions.push_back("☐ global option " + std::to_string(i));
+		return vOptions;
+	};
+
+	CVoteOptionList aLists[NUM_CLIENTS];
+	CVoteClient aDiffClients[NUM_CLIENTS];
+	CVoteClient aResendClients[NUM_CLIENTS];
+	int NextRoom = 1;
+	for(int Step = 0; Step < 500; Step++)
+	{
+		int Event = Rng() % 4;
+		if(Event == 0 && vRooms.size() < 12)
+		{
+			vRooms.push_back(NextRoom++);
+			vPlayers.push_back(1);
+		}
+		else if(Event == 1 && vRooms.size() > 1)
+		{
+			int Room = 1 + Rng() % (vRooms.size() - 1);
+			vRooms.erase(vRooms.begin() + Room);
+			vPlayers.erase(vPlayers.begin() + Room);
+		}
+		else
+		{
+			int Room = Rng() % vRooms.size();
+			vPlayers[Room] = 1 + Rng() % 16;
+		}
+
+		for(int i = 0; i < NUM_CLIENTS; i++)
+		{
+			std::vector<std::string> vOptions = Options(i);
+			Sync(&aLists[i], vOptions, &aDiffClients[i]);
+			Resend(vOptions, &aResendClients[i]);
+			ASSERT_EQ(aDiffClients[i].m_vOptions, vOptions);
+		}
+	}
+
+	long long DiffBytes = 0, ResendBytes = 0;
+	for(int i = 0; i < NUM_CLIENTS; i++)
+	{
+		DiffBytes += aDiffClients[i].m_Bytes;
+		ResendBytes += aResendClients[i].m_Bytes;
+	}
+	EXPECT_LT(DiffBytes, ResendBytes);
+}